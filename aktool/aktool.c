@@ -79,11 +79,8 @@
   if( aktool_check_command( "test", argv[1] )) return aktool_test( argc, argv );
   if( aktool_check_command( "k", argv[1] )) return aktool_key( argc, argv );
   if( aktool_check_command( "key", argv[1] )) return aktool_key( argc, argv );
-
-/*
-    if( aktool_check_command( "i", argv[1] )) return aktool_icode( argc, argv );
-    if( aktool_check_command( "icode", argv[1] )) return aktool_icode( argc, argv );
- */
+  if( aktool_check_command( "i", argv[1] )) return aktool_icode( argc, argv );
+  if( aktool_check_command( "icode", argv[1] )) return aktool_icode( argc, argv );
 
  /* ничего не подошло, выводим сообщение об ошибке */
   ak_log_set_function( ak_function_log_stderr );
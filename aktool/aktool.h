@@ -60,6 +60,7 @@
  int aktool_test( int argc, tchar *argv[] );
  int aktool_asn1( int argc, tchar *argv[] );
  int aktool_key( int argc, tchar *argv[] );
+ int aktool_icode( int argc, tchar *argv[] );
 
  #endif
 /* ----------------------------------------------------------------------------------------------- */
@@ -0,0 +1,138 @@
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <aktool.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+ int aktool_icode_help( void );
+ int aktool_icode_files( int argc, tchar *argv[], ak_oid );
+
+/* ----------------------------------------------------------------------------------------------- */
+ int aktool_icode( int argc, tchar *argv[] )
+{
+  ak_oid oid = NULL;
+  char *hashname = "streebog256";
+  int next_option = 0, exitcode = EXIT_SUCCESS;
+
+  const struct option long_options[] = {
+    /* сначала уникальные */
+     { "algorithm",        1, NULL, 'a' },
+     { "tree",             0, NULL, 255 },
+
+    /* потом общие */
+     { "openssl-style",    0, NULL,   5  },
+     { "audit",            1, NULL,   4  },
+     { "dont-use-colors",  0, NULL,   3  },
+     { "audit-file",       1, NULL,   2  },
+     { "help",             0, NULL,   1  },
+     { NULL,               0, NULL,   0  },
+  };
+
+ /* разбираем опции командной строки */
+  do {
+       next_option = getopt_long( argc, argv, "a:", long_options, NULL );
+       switch( next_option )
+      {
+       /* сначала обработка стандартных опций */
+        case  1  :   return aktool_icode_help();
+        case  2  : /* получили от пользователя имя файла для вывода аудита */
+                     aktool_set_audit( optarg );
+                     break;
+        case  3  : /* установка флага запрета вывода символов смены цветовой палитры */
+                     ak_error_set_color_output( ak_false );
+                     ak_libakrypt_set_option( "use_color_output", 0 );
+                     break;
+        case  4  : /* устанавливаем уровень аудита */
+                     aktool_log_level = atoi( optarg );
+                     break;
+        case  5  : /* переходим к стилю openssl */
+                     aktool_openssl_compability = ak_true;
+                     break;
+
+       /* теперь опции, уникальные для icode */
+        case 'a' :   hashname = optarg;
+                     break;
+        case 255 : /* древовидный режим для алгоритма, используемого по умолчанию */
+                     hashname = "streebog256-tree";
+                     break;
+
+       /* обрабатываем ошибочные параметры */
+         default:
+                     break;
+       }
+  } while( next_option != -1 );
+
+ /* после разбора опций argv[optind] содержит имя команды, а следующие за ним параметры
+    являются именами файлов; если файлы не заданы, то выходим */
+  if( optind + 1 >= argc ) return aktool_icode_help();
+
+ /* начинаем работу с криптографическими примитивами */
+  if( !aktool_create_libakrypt( )) return EXIT_FAILURE;
+
+  if((( oid = ak_oid_find_by_ni( hashname )) == NULL ) || ( oid->engine != hash_function ) ||
+     (( oid->mode != algorithm ) && ( oid->mode != hash_tree ))) {
+    aktool_error(_("using unsupported hash function \"%s\""), hashname );
+    exitcode = EXIT_FAILURE;
+  }
+   else if( aktool_icode_files( argc, argv, oid ) != ak_error_ok ) exitcode = EXIT_FAILURE;
+
+ /* завершаем работы с библиотекой */
+  aktool_destroy_libakrypt();
+
+ return exitcode;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \return Функция возвращает \ref ak_error_ok, если коды целостности вычислены для всех
+    заданных файлов. В противном случае возвращается код последней возникшей ошибки.             */
+/* ----------------------------------------------------------------------------------------------- */
+ int aktool_icode_files( int argc, tchar *argv[], ak_oid oid )
+{
+  ak_hash ctx = NULL;
+  ak_uint8 icode[64];
+  int idx = 0, error = ak_error_ok, result = ak_error_ok;
+
+  if(( ctx = ak_oid_new_object( oid )) == NULL ) {
+    aktool_error( _("incorrect creation of hash function context (code: %d)" ), ak_error_get_value());
+    return ak_error_get_value();
+  }
+
+  for( idx = optind + 1; idx < argc; idx++ ) {
+     if( ak_file_or_directory( argv[idx] ) != DT_REG ) {
+       aktool_error( _("%s is not a regular file"), argv[idx] );
+       result = ak_error_access_file;
+       continue;
+     }
+     if( oid->mode == hash_tree ) error = ak_hash_file_tree( ctx, argv[idx], icode, sizeof( icode ));
+       else error = ak_hash_file( ctx, argv[idx], icode, sizeof( icode ));
+     if( error != ak_error_ok ) {
+       aktool_error( _("incorrect integrity code calculation for file %s (code: %d)"),
+                                                                                 argv[idx], error );
+       result = error;
+     }
+      else printf( "%s %s\n",
+                      ak_ptr_to_hexstr( icode, ak_hash_get_tag_size( ctx ), ak_false ), argv[idx] );
+  }
+  ak_oid_delete_object( oid, ctx );
+
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int aktool_icode_help( void )
+{
+  printf(
+   _("aktool icode [options] [files] - calculation of integrity codes\n\n"
+     "available options:\n"
+     " -a, --algorithm         set the name or identifier of hash function [ default value: \"streebog256\" ]\n"
+     "                         one can use tree modes \"streebog256-tree\" or \"streebog512-tree\"\n"
+     "                         to hash large files in parallel\n"
+     "     --tree              use the tree mode of default hash function (short form of \"-a streebog256-tree\")\n"
+  ));
+
+ return aktool_print_common_options();
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                                                                                 aktool_icode.c  */
+/* ----------------------------------------------------------------------------------------------- */
@@ -205,7 +205,8 @@
 
  /* 3. Основной фрагмент - запуск функции на выполнение */
   if( !aktool_test_verbose ) {
-    printf(_("[%s: 16MB "), oid->mode == algorithm ? _("ecb mode") : oid->name[0] );
+    if( oid->mode == algorithm ) printf(_("[%s ecb mode: 16MB "), oid->name[0] );
+      else printf(_("[%s: 16MB "), oid->name[0] );
     fflush( stdout );
   }
 
@@ -312,8 +313,8 @@
       goto exit;
     }
     if( aktool_test_verbose )
-      printf(_(" %3uMB: %s time = %fs, per 1MB = %fs, speed = %f MBs\n"), (unsigned int)i,
-               oid->mode == algorithm ? _("ecb mode") : oid->name[0],
+      printf(_(" %3uMB: %s%s time = %fs, per 1MB = %fs, speed = %f MBs\n"), (unsigned int)i,
+               oid->name[0], oid->mode == algorithm ? _(" ecb mode") : "",
                (double) timea / (double) CLOCKS_PER_SEC,
                (double) timea / ( (double) CLOCKS_PER_SEC*i ),
                (double) CLOCKS_PER_SEC*i / (double) timea );
@@ -334,13 +335,12 @@
    if( authenticationKey != NULL ) ak_oid_delete_second_object( oid, authenticationKey );
 
  /* теперь запускаем перебор всех доступных режимов для блочного шифра,
-    и выполняем для них тестирование скорости, помимо режима простой замены */
+    и выполняем для них тестирование скорости; помимо режимов, тестируются и
+    другие реализации того же алгоритма (например, magma-batch для алгоритма magma) */
    if( oid->mode == algorithm ) {
      ak_oid joid = ak_oid_findnext_by_engine( oid, block_cipher );
      while( joid != NULL ) {
-       if( strstr( joid->name[0], oid->name[0] ) != NULL ) {
-         if( joid->mode != algorithm ) aktool_test_speed_block_cipher( joid );
-       }
+       if( strstr( joid->name[0], oid->name[0] ) != NULL ) aktool_test_speed_block_cipher( joid );
        joid = ak_oid_findnext_by_engine( joid, block_cipher );
      }
    }
@@ -358,7 +358,7 @@
   int i, error = ak_error_ok, exit_status = EXIT_FAILURE;
   ak_pointer ctx;
 
-  if( oid->mode != algorithm ) {
+  if(( oid->mode != algorithm ) && ( oid->mode != hash_tree )) {
     printf(_("hash function's mode \"%s\" is not supported yet for testing, sorry ... \n"),
                                                            ak_libakrypt_get_mode_name( oid->mode ));
     return EXIT_SUCCESS;
@@ -380,7 +380,8 @@
     memset( data, (ak_uint8)i+13, size );
 
     timea = clock();
-    error = ak_hash_ptr( ctx, data, size, icode, sizeof( icode ));
+    if( oid->mode == hash_tree ) error = ak_hash_ptr_tree( ctx, data, size, icode, sizeof( icode ));
+      else error = ak_hash_ptr( ctx, data, size, icode, sizeof( icode ));
     timea = clock() - timea;
 
     free( data );
@@ -53,3 +53,82 @@ check_c_source_compiles("
 if( AK_HAVE_BUILTIN_MM256_SLL )
     set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAK_HAVE_BUILTIN_MM256_SLL" )
 endif()
+
+# -------------------------------------------------------------------------------------------------- #
+check_c_source_compiles("
+  int main( void ) {
+   long int value = 1, expected = 1;
+   __atomic_compare_exchange_n( &value, &expected, 0, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED );
+  return ( int )__atomic_add_fetch( &value, 1, __ATOMIC_RELAXED );
+ }" AK_HAVE_BUILTIN_ATOMIC_GCC )
+
+if( AK_HAVE_BUILTIN_ATOMIC_GCC )
+    set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAK_HAVE_BUILTIN_ATOMIC_GCC" )
+endif()
+
+# -------------------------------------------------------------------------------------------------- #
+# векторные расширения, используемые реализациями алгоритмов с выбором во время выполнения;
+# проверки используют атрибут target, поэтому не требуют указания флагов -mssse3, -mavx2 и т.п.
+# -------------------------------------------------------------------------------------------------- #
+check_c_source_compiles("
+  int main( void ) {
+   __builtin_cpu_init();
+  return __builtin_cpu_supports( \"avx2\" ) ? 0 : 1;
+ }" AK_HAVE_BUILTIN_CPU_SUPPORTS )
+
+if( AK_HAVE_BUILTIN_CPU_SUPPORTS )
+    set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAK_HAVE_BUILTIN_CPU_SUPPORTS" )
+endif()
+
+# -------------------------------------------------------------------------------------------------- #
+check_c_source_compiles("
+  #include <immintrin.h>
+  __attribute__(( target( \"ssse3\" )))
+  static __m128i ak_test_ssse3( __m128i a, __m128i b ) {
+   return _mm_adds_epu8( _mm_shuffle_epi8( a, b ), b );
+  }
+  int main( void ) {
+   __m128i a = _mm_set1_epi8( 1 );
+   a = ak_test_ssse3( a, a );
+  return 0;
+ }" AK_HAVE_BUILTIN_SSSE3 )
+
+if( AK_HAVE_BUILTIN_SSSE3 )
+    set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAK_HAVE_BUILTIN_SSSE3" )
+endif()
+
+# -------------------------------------------------------------------------------------------------- #
+check_c_source_compiles("
+  #include <immintrin.h>
+  __attribute__(( target( \"avx2\" )))
+  static __m256i ak_test_avx2( __m128i a ) {
+   __m256i b = _mm256_broadcastsi128_si256( a );
+   b = _mm256_inserti128_si256( _mm256_shuffle_epi8( b, b ), _mm256_extracti128_si256( b, 1 ), 0 );
+   return b;
+  }
+  int main( void ) {
+   __m256i b = ak_test_avx2( _mm_set1_epi8( 1 ));
+  return 0;
+ }" AK_HAVE_BUILTIN_AVX2 )
+
+if( AK_HAVE_BUILTIN_AVX2 )
+    set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAK_HAVE_BUILTIN_AVX2" )
+endif()
+
+# -------------------------------------------------------------------------------------------------- #
+check_c_source_compiles("
+  #include <immintrin.h>
+  __attribute__(( target( \"avx512f,avx512bw\" )))
+  static __m512i ak_test_avx512( __m128i a ) {
+   __m512i b = _mm512_broadcast_i32x4( a );
+   b = _mm512_inserti32x4( _mm512_shuffle_epi8( b, b ), _mm512_extracti32x4_epi32( b, 3 ), 1 );
+   return _mm512_adds_epu8( b, _mm512_set1_epi8( 0x70 ));
+  }
+  int main( void ) {
+   __m512i b = ak_test_avx512( _mm_set1_epi8( 1 ));
+  return 0;
+ }" AK_HAVE_BUILTIN_AVX512 )
+
+if( AK_HAVE_BUILTIN_AVX512 )
+    set( CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -DAK_HAVE_BUILTIN_AVX512" )
+endif()
@@ -7,6 +7,7 @@
  int bckey_test( ak_oid );
  int hmac_test( ak_oid );
  int signkey_test( ak_oid );
+ int mhkdf_bounds_test( void );
 
 /* определяем функцию, которая будет имитировать чтение пароля пользователя */
  int get_user_password( char *password, size_t psize )
@@ -34,6 +35,14 @@
   if(( result = hmac_test( ak_oid_find_by_name( "hmac-streebog256" ))) != EXIT_SUCCESS ) goto lab1;
   if(( result = hmac_test( ak_oid_find_by_name( "hmac-streebog512" ))) != EXIT_SUCCESS ) goto lab1;
 
+ /* повторяем тесты, используя для выработки производных ключей алгоритм mhkdf */
+  ak_libakrypt_set_option( "key_container_kdf", 1 );
+  ak_libakrypt_set_option( "mhkdf_memory_size", 1024 );
+  if(( result = bckey_test( ak_oid_find_by_name( "kuznechik" ))) != EXIT_SUCCESS ) goto lab1;
+  if(( result = hmac_test( ak_oid_find_by_name( "hmac-streebog512" ))) != EXIT_SUCCESS ) goto lab1;
+  if(( result = mhkdf_bounds_test()) != EXIT_SUCCESS ) goto lab1;
+  ak_libakrypt_set_option( "key_container_kdf", 0 );
+
  /* тестируем ключи алгоритма ЭП для нескольких кривых */
   oid = ak_oid_find_by_mode( wcurve_params );
   while( oid != NULL ) {
@@ -176,6 +185,46 @@
  return result;
 }
 
+/* --------------------------------------------------------------------------------------------- */
+/* контейнер, параметры mhkdf которого выходят за допустимые границы, не должен считываться */
+ int mhkdf_bounds_test( void )
+{
+  struct bckey bkey;
+  char filename[128];
+  ak_pointer key = NULL;
+  ak_uint8 testkey[32] = {
+    0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10,
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+  ak_int64 memory = ak_libakrypt_get_option_by_name( "mhkdf_memory_size" ),
+           time = ak_libakrypt_get_option_by_name( "mhkdf_time_cost" ),
+           lanes = ak_libakrypt_get_option_by_name( "mhkdf_parallelism" );
+
+ /* функция установки опций не проверяет границы, поэтому такой контейнер можно создать */
+  ak_libakrypt_set_option( "mhkdf_memory_size", 128 );
+  ak_libakrypt_set_option( "mhkdf_time_cost", 65 );
+  ak_libakrypt_set_option( "mhkdf_parallelism", 1 );
+
+  ak_bckey_create_kuznechik( &bkey );
+  ak_bckey_set_key( &bkey, testkey, sizeof( testkey ));
+  ak_skey_export_to_file_with_password( &bkey,
+                                 "password", 8, filename, sizeof( filename ), asn1_der_format );
+  ak_bckey_destroy( &bkey );
+
+  ak_libakrypt_set_option( "mhkdf_memory_size", memory );
+  ak_libakrypt_set_option( "mhkdf_time_cost", time );
+  ak_libakrypt_set_option( "mhkdf_parallelism", lanes );
+
+  if(( key = ak_skey_load_from_file( filename )) != NULL ) {
+    printf("container with mhkdf time cost 65: Wrong (key was loaded)\n\n");
+    ak_oid_delete_object(((ak_skey)key)->oid, key );
+    return EXIT_FAILURE;
+  }
+  ak_error_set_value( ak_error_ok );
+  printf("container with mhkdf time cost 65: Ok (key was rejected)\n\n");
+
+ return EXIT_SUCCESS;
+}
+
 /* --------------------------------------------------------------------------------------------- */
  int signkey_test( ak_oid curvoid )
 {
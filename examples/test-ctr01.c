@@ -0,0 +1,288 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тестовый пример, иллюстрирующий произвольный доступ к данным, зашифрованным
+   в режиме гаммирования, а также одновременное использование одного ключа несколькими потоками.
+
+   test-ctr01.c                                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
+ static ak_uint8 key[32] = {
+     0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+     0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10, 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef };
+
+ static ak_uint8 iv[8] = { 0xf0, 0xce, 0xab, 0x90, 0x78, 0x56, 0x34, 0x12 };
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_offsets( ak_bckey bkey )
+{
+  ak_uint8 plain[1031], etalon[1040], out[1040];
+  size_t i, offset, size, count = 0, sizes[] = { 1, 3, 16, 17, 63, 512 };
+  int result = ak_error_ok;
+
+  for( i = 0; i < sizeof( plain ); i++ ) plain[i] = ( ak_uint8 )( 7*i + 3 );
+
+ /* зашифровываем фрагменты с произвольными смещениями; эталонное значение вычисляем
+    функцией ak_bckey_ctr() для последовательности, заканчивающейся вместе с фрагментом,
+    поскольку неполный последний блок гаммируется по-разному в зависимости от режима */
+  for( offset = 0; offset < 400; offset += 37 )
+    for( i = 0; i < sizeof( sizes )/sizeof( size_t ); i++ ) {
+       size = ak_min( sizes[i], 1024 - offset );
+       ak_bckey_ctr( bkey, plain, etalon, offset + size, iv, bkey->bsize >> 1 );
+       memset( out, 0, sizeof( out ));
+       ak_bckey_ctr_at_offset( bkey, plain + offset, out, size, iv, bkey->bsize >> 1, offset );
+       if( memcmp( out, etalon + offset, size )) {
+         printf("%s: wrong result for offset %u and length %u\n", bkey->key.oid->name[0],
+                                                        (unsigned int) offset, (unsigned int) size );
+         result = ak_error_not_equal_data;
+       }
+       count++;
+  }
+
+ /* после произвольного доступа продолжаем последовательное шифрование */
+  ak_bckey_ctr( bkey, plain, etalon, 1024, iv, bkey->bsize >> 1 );
+  ak_bckey_ctr( bkey, plain, out, 64, iv, bkey->bsize >> 1 );
+  ak_bckey_ctr_at_offset( bkey, plain + 500, out + 500, 11, iv, bkey->bsize >> 1, 500 );
+  ak_bckey_ctr( bkey, plain + 64, out + 64, 64, NULL, 0 );
+  if( memcmp( out, etalon, 128 )) {
+    printf("%s: internal counter is changed by random access\n", bkey->key.oid->name[0] );
+    result = ak_error_not_equal_data;
+  }
+
+ /* неполный хвост последовательности, зашифрованной за один вызов функции ak_bckey_ctr(),
+    расшифровывается по смещению */
+  ak_bckey_ctr( bkey, plain, etalon, sizeof( plain ), iv, bkey->bsize >> 1 );
+  for( offset = 1020; offset < sizeof( plain ); offset += 5 ) {
+     memcpy( out, etalon + offset, size = sizeof( plain ) - offset );
+     ak_bckey_ctr_at_offset( bkey, out, out, size, iv, bkey->bsize >> 1, offset );
+     if( memcmp( out, plain + offset, size )) {
+       printf("%s: wrong decryption of the tail from offset %u\n", bkey->key.oid->name[0],
+                                                                         (unsigned int) offset );
+       result = ak_error_not_equal_data;
+     }
+     count++;
+  }
+
+  printf("%s: %u fragments tested\n", bkey->key.oid->name[0], (unsigned int) count );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* количество потоков и ресурс ключа (в блоках), используемые для проверки разделяемого ключа */
+ #define shared_threads      (4)
+ #define shared_resource  (1000)
+
+ typedef struct shared_worker {
+   ak_bckey bkey;
+   ak_uint8 *etalon;
+   size_t calls;
+   int result;
+ } *ak_shared_worker;
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void *shared_worker_thread( void *ptr )
+{
+  ak_uint8 out[48];
+  ak_shared_worker wr = ( ak_shared_worker ) ptr;
+  size_t offset = 0, size = 3*wr->bkey->bsize;
+
+ /* каждый вызов расходует три блока ресурса ключа; потоки работают до исчерпания ресурса */
+  for( ;; ) {
+     memset( out, 0, sizeof( out ));
+     if( ak_bckey_ctr_at_offset( wr->bkey, out, out, size,
+                                         iv, wr->bkey->bsize >> 1, offset ) != ak_error_ok ) break;
+     if( memcmp( out, wr->etalon + offset, size )) wr->result = ak_error_not_equal_data;
+     offset = ( offset + wr->bkey->bsize )%( 8*wr->bkey->bsize );
+     wr->calls++;
+  }
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_shared_key( ak_bckey bkey )
+{
+  ak_uint8 plain[256], etalon[256];
+  struct shared_worker workers[shared_threads];
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_t threads[shared_threads];
+  size_t started = 0;
+#endif
+  size_t i, calls = 0;
+  ssize_t resource = 0;
+  int result = ak_error_ok;
+
+  memset( plain, 0, sizeof( plain ));
+  ak_bckey_ctr( bkey, plain, etalon, sizeof( etalon ), iv, bkey->bsize >> 1 );
+
+ /* ключ разделяется всеми потоками; ресурс ключа должен быть израсходован в точности */
+  bkey->key.resource.value.counter = shared_resource;
+  ak_skey_set_shared( &bkey->key, ak_true );
+  for( i = 0; i < shared_threads; i++ ) {
+     workers[i].bkey = bkey;
+     workers[i].etalon = etalon;
+     workers[i].calls = 0;
+     workers[i].result = ak_error_ok;
+  }
+#ifdef AK_HAVE_PTHREAD_H
+  for( i = 0; i < shared_threads; i++, started++ )
+     if( pthread_create( threads+i, NULL, shared_worker_thread, workers+i ) != 0 ) break;
+  for( i = started; i < shared_threads; i++ ) shared_worker_thread( workers+i );
+  for( i = 0; i < started; i++ ) pthread_join( threads[i], NULL );
+#else
+  for( i = 0; i < shared_threads; i++ ) shared_worker_thread( workers+i );
+#endif
+  ak_skey_set_shared( &bkey->key, ak_false );
+
+  for( i = 0; i < shared_threads; i++ ) {
+     calls += workers[i].calls;
+     if( workers[i].result != ak_error_ok ) result = workers[i].result;
+  }
+  resource = bkey->key.resource.value.counter;
+  if( result != ak_error_ok )
+    printf("%s: wrong encryption with shared key\n", bkey->key.oid->name[0] );
+  if(( calls != shared_resource/3 ) || ( resource != shared_resource%3 )) {
+    printf("%s: wrong resource of shared key (%u calls, %d blocks left)\n",
+                            bkey->key.oid->name[0], (unsigned int) calls, (int) resource );
+    result = ak_error_low_key_resource;
+  }
+  printf("%s: %u calls with shared key\n", bkey->key.oid->name[0], (unsigned int) calls );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* размер сектора и количество секторов, при котором зашифрование выполняется несколькими потоками */
+ #define xts_sector_size  (512)
+ #define xts_sectors     (1024)
+
+ typedef struct xts_worker {
+   ak_bckey ekey, akey;
+   ak_uint8 *in, *out, *etalon;
+   int result;
+ } *ak_xts_worker;
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void *xts_worker_thread( void *ptr )
+{
+  size_t i;
+  ak_xts_worker wr = ( ak_xts_worker ) ptr;
+
+  for( i = 0; i < 4; i++ ) {
+     memset( wr->out, 0, xts_sector_size*xts_sectors );
+     if( ak_bckey_encrypt_xts_sectors( wr->ekey, wr->akey, wr->in, wr->out,
+                                        xts_sector_size, 7, xts_sectors ) != ak_error_ok )
+       wr->result = ak_error_low_key_resource;
+     if( memcmp( wr->out, wr->etalon, xts_sector_size*xts_sectors ))
+       wr->result = ak_error_not_equal_data;
+  }
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* разделяемые ключи не копируются при многопоточном зашифровании секторов в режиме XTS */
+ int test_shared_xts( ak_bckey bkey )
+{
+  struct bckey akey;
+  ak_uint8 akvalue[32], masked[64];
+  struct xts_worker workers[2];
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_t thread;
+#endif
+  size_t i, size = xts_sector_size*xts_sectors;
+  int result = ak_error_ok;
+  ak_uint8 *in = malloc( size ), *etalon = malloc( size ),
+           *out0 = malloc( size ), *out1 = malloc( size );
+
+  if(( in == NULL ) || ( etalon == NULL ) || ( out0 == NULL ) || ( out1 == NULL )) {
+    result = ak_error_out_of_memory;
+    goto labex;
+  }
+  for( i = 0; i < size; i++ ) in[i] = ( ak_uint8 )( 3*i + ( i >> 9 ));
+  ak_bckey_set_key( bkey, key, sizeof( key )); /* восстанавливаем ресурс ключа */
+  for( i = 0; i < sizeof( akvalue ); i++ ) akvalue[i] = key[i]^0x5a;
+  ak_bckey_create_oid( &akey, bkey->key.oid );
+  ak_bckey_set_key( &akey, akvalue, sizeof( akvalue ));
+  ak_bckey_encrypt_xts_sectors( bkey, &akey, in, etalon, xts_sector_size, 7, xts_sectors );
+
+  ak_libakrypt_set_option( "block_cipher_threads", shared_threads );
+  ak_skey_set_shared( &bkey->key, ak_true );
+  ak_skey_set_shared( &akey.key, ak_true );
+  memcpy( masked, bkey->key.key, 2*bkey->key.key_size );
+  for( i = 0; i < 2; i++ ) {
+     workers[i].ekey = bkey;
+     workers[i].akey = &akey;
+     workers[i].in = in;
+     workers[i].out = i ? out1 : out0;
+     workers[i].etalon = etalon;
+     workers[i].result = ak_error_ok;
+  }
+#ifdef AK_HAVE_PTHREAD_H
+  if( pthread_create( &thread, NULL, xts_worker_thread, workers+1 ) != 0 ) {
+    xts_worker_thread( workers+1 );
+    xts_worker_thread( workers );
+  } else {
+     xts_worker_thread( workers );
+     pthread_join( thread, NULL );
+    }
+#else
+  for( i = 0; i < 2; i++ ) xts_worker_thread( workers+i );
+#endif
+ /* маска разделяемого ключа не изменяется, в том числе при создании копий ключа */
+  if( memcmp( masked, bkey->key.key, 2*bkey->key.key_size )) result = ak_error_not_equal_data;
+  ak_skey_set_shared( &akey.key, ak_false );
+  ak_skey_set_shared( &bkey->key, ak_false );
+  ak_libakrypt_set_option( "block_cipher_threads", 0 );
+  ak_bckey_destroy( &akey );
+
+  for( i = 0; i < 2; i++ ) if( workers[i].result != ak_error_ok ) result = workers[i].result;
+  if( result != ak_error_ok )
+    printf("%s: wrong xts encryption of sectors with shared keys\n", bkey->key.oid->name[0] );
+   else printf("%s: xts encryption of sectors with shared keys is Ok\n", bkey->key.oid->name[0] );
+
+  labex:
+  if( in ) free( in );
+  if( etalon ) free( etalon );
+  if( out0 ) free( out0 );
+  if( out1 ) free( out1 );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  struct bckey kuznechik, magma;
+  int oc, result = ak_error_ok;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  for( oc = 0; oc < 2; oc++ ) {
+     ak_libakrypt_set_openssl_compability( oc );
+     printf("openssl compability: %d\n", oc );
+
+     ak_bckey_create_kuznechik( &kuznechik );
+     ak_bckey_set_key( &kuznechik, key, sizeof( key ));
+     if( test_offsets( &kuznechik ) != ak_error_ok ) result = ak_error_not_equal_data;
+     if( test_shared_key( &kuznechik ) != ak_error_ok ) result = ak_error_not_equal_data;
+     if( test_shared_xts( &kuznechik ) != ak_error_ok ) result = ak_error_not_equal_data;
+     ak_bckey_destroy( &kuznechik );
+
+     ak_bckey_create_magma( &magma );
+     ak_bckey_set_key( &magma, key, sizeof( key ));
+     if( test_offsets( &magma ) != ak_error_ok ) result = ak_error_not_equal_data;
+     if( test_shared_key( &magma ) != ak_error_ok ) result = ak_error_not_equal_data;
+     ak_bckey_destroy( &magma );
+  }
+  ak_libakrypt_set_openssl_compability( ak_false );
+
+  if( result == ak_error_ok ) printf("result is Ok\n");
+  ak_libakrypt_destroy();
+
+ if( result == ak_error_ok ) return EXIT_SUCCESS;
+  else return EXIT_FAILURE;
+}
@@ -0,0 +1,213 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тестовый пример, иллюстрирующий работу менеджера контекстов: получение объектов по дескрипторам,
+   повторное использование ключей и контекстов функций хеширования после их возврата в менеджер,
+   а также одновременное получение и возврат объектов несколькими потоками.
+
+   test-handle01.c                                                                                 */
+/* ----------------------------------------------------------------------------------------------- */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
+ #define handle_threads (4)
+ #define handle_calls (500)
+
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_uint8 key[32] = {
+  0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01, 0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe,
+  0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11, 0x00, 0xff, 0xee, 0xdd, 0xcc, 0xbb, 0xaa, 0x99, 0x88 };
+ static ak_uint8 iv[8] = { 0xf0, 0xce, 0xab, 0x90, 0x78, 0x56, 0x34, 0x12 };
+ static ak_uint8 plain[64] = { 0 };
+ static ak_uint8 etalon[64];
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_bckey( void )
+{
+  ak_uint8 out[64], number[32];
+  struct bckey bkey;
+  ak_handle handle, second;
+  ak_bckey hkey = NULL;
+  int result = ak_error_ok;
+  oid_engines_t engine = undefined_engine;
+  ak_oid oid = ak_oid_find_by_name( "kuznechik" );
+
+  ak_bckey_create_kuznechik( &bkey );
+  ak_bckey_set_key( &bkey, key, sizeof( key ));
+  ak_bckey_ctr( &bkey, plain, etalon, sizeof( etalon ), iv, sizeof( iv ));
+  ak_bckey_destroy( &bkey );
+
+  if(( handle = ak_handle_new( oid )) < 0 ) return handle;
+  if(( hkey = ak_handle_get_context( handle, &engine )) == NULL ) return ak_error_get_value();
+  if( engine != block_cipher ) result = ak_error_not_equal_data;
+  ak_bckey_set_key( hkey, key, sizeof( key ));
+  ak_bckey_ctr( hkey, plain, out, sizeof( out ), iv, sizeof( iv ));
+  if( memcmp( out, etalon, sizeof( out ))) result = ak_error_not_equal_data;
+  memcpy( number, hkey->key.number, sizeof( number ));
+  ak_handle_delete( handle );
+
+ /* возвращенный ключ используется повторно, но его значение уже уничтожено,
+    а номер ключа выработан заново */
+  if(( second = ak_handle_new( oid )) == handle ) result = ak_error_not_equal_data;
+  if( ak_handle_get_context( second, NULL ) != hkey ) result = ak_error_not_equal_data;
+ /* дескриптор прежнего владельца не дает доступа к объекту, выданному повторно */
+  if( ak_handle_get_context( handle, NULL ) != NULL ) result = ak_error_not_equal_data;
+  if( ak_handle_delete( handle ) == ak_error_ok ) result = ak_error_not_equal_data;
+  if( ak_handle_get_context( second, NULL ) != hkey ) result = ak_error_not_equal_data;
+  if( hkey->key.flags&ak_key_flag_set_key ) result = ak_error_not_equal_data;
+  if( !memcmp( number, hkey->key.number, sizeof( number ))) result = ak_error_not_equal_data;
+  memset( number, 0, sizeof( number ));
+  if( !memcmp( number, hkey->key.number, sizeof( number ))) result = ak_error_not_equal_data;
+  if( ak_bckey_ctr( hkey, plain, out, sizeof( out ), iv, sizeof( iv )) == ak_error_ok )
+    result = ak_error_not_equal_data;
+  ak_bckey_set_key( hkey, key, sizeof( key ));
+  memset( out, 0, sizeof( out ));
+  ak_bckey_ctr( hkey, plain, out, sizeof( out ), iv, sizeof( iv ));
+  if( memcmp( out, etalon, sizeof( out ))) result = ak_error_not_equal_data;
+  ak_handle_delete( second );
+
+ /* повторный возврат объекта и использование неверных дескрипторов */
+  if( ak_handle_delete( second ) == ak_error_ok ) result = ak_error_not_equal_data;
+  if( ak_handle_get_context( second, NULL ) != NULL ) result = ak_error_not_equal_data;
+  if( ak_handle_delete( 1 << 20 ) == ak_error_ok ) result = ak_error_not_equal_data;
+  ak_error_set_value( ak_error_ok );
+
+  if( result != ak_error_ok ) printf("kuznechik: wrong reusing of block cipher key\n");
+   else printf("kuznechik: reusing of block cipher key is Ok\n");
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_mac( const char *name )
+{
+  ak_uint8 data[256], out[64], out2[64];
+  ak_handle handle;
+  ak_pointer ctx = NULL;
+  oid_engines_t engine = undefined_engine;
+  int i, result = ak_error_ok;
+  ak_oid oid = ak_oid_find_by_name( name );
+
+  for( i = 0; i < ( int )sizeof( data ); i++ ) data[i] = ( ak_uint8 )( 7*i + 3 );
+  memset( out, 0, sizeof( out ));
+  memset( out2, 0, sizeof( out2 ));
+
+ /* вычисляем код целостности дважды, возвращая объект в менеджер после каждого вычисления */
+  for( i = 0; i < 2; i++ ) {
+     if(( handle = ak_handle_new( oid )) < 0 ) return handle;
+     ctx = ak_handle_get_context( handle, &engine );
+     if( engine == hmac_function ) {
+      /* данные, оставшиеся в контексте при возврате объекта, должны быть уничтожены */
+       if( i && ((ak_hmac)ctx)->mctx.length ) result = ak_error_not_equal_data;
+       ak_hmac_set_key( ctx, key, sizeof( key ));
+       ak_hmac_update( ctx, data, 64 );
+       ak_hmac_finalize( ctx, data+64, sizeof( data ) - 64, i ? out2 : out, sizeof( out ));
+       ak_hmac_update( ctx, data, 10 );
+     } else {
+        ak_hash_update( ctx, data, 64 );
+        ak_hash_finalize( ctx, data+64, sizeof( data ) - 64, i ? out2 : out, sizeof( out ));
+       }
+     ak_handle_delete( handle );
+  }
+  if( memcmp( out, out2, sizeof( out ))) result = ak_error_not_equal_data;
+
+  if( result != ak_error_ok ) printf("%s: wrong reusing of context\n", name );
+   else printf("%s: reusing of context is Ok\n", name );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_many_handles( void )
+{
+  size_t i;
+  ak_handle handles[100];
+  int result = ak_error_ok;
+  ak_oid oid = ak_oid_find_by_name( "magma" ), lcg = ak_oid_find_by_name( "lcg" );
+
+ /* количество дескрипторов превышает начальный размер менеджера контекстов */
+  for( i = 0; i < 100; i++ ) {
+     if(( handles[i] = ak_handle_new( i%2 ? oid : lcg )) < 0 ) result = ak_error_not_equal_data;
+  }
+  for( i = 0; i < 100; i++ ) {
+     if( ak_handle_delete( handles[i] ) != ak_error_ok ) result = ak_error_not_equal_data;
+  }
+
+  if( result != ak_error_ok ) printf("wrong allocation of 100 handles\n");
+   else printf("allocation of 100 handles is Ok\n");
+ return result;
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+ static void *handle_worker_thread( void *ptr )
+{
+  size_t i;
+  ak_uint8 out[64];
+  ak_handle handle;
+  ak_bckey hkey = NULL;
+  int *result = ( int * )ptr;
+  ak_oid oid = ak_oid_find_by_name( "kuznechik" );
+
+  for( i = 0; i < handle_calls; i++ ) {
+     if(( handle = ak_handle_new( oid )) < 0 ) { *result = handle; break; }
+     hkey = ak_handle_get_context( handle, NULL );
+     ak_bckey_set_key( hkey, key, sizeof( key ));
+     memset( out, 0, sizeof( out ));
+     ak_bckey_ctr( hkey, plain, out, sizeof( out ), iv, sizeof( iv ));
+     if( memcmp( out, etalon, sizeof( out ))) *result = ak_error_not_equal_data;
+     ak_handle_delete( handle );
+  }
+ return NULL;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_threads( void )
+{
+  size_t i;
+  pthread_t threads[handle_threads];
+  bool_t started[handle_threads];
+  int results[handle_threads], result = ak_error_ok;
+
+  for( i = 0; i < handle_threads; i++ ) {
+     results[i] = ak_error_ok;
+     started[i] = ( pthread_create( &threads[i], NULL,
+                                 handle_worker_thread, &results[i] ) == 0 ) ? ak_true : ak_false;
+  }
+ /* если поток не был запущен, выполняем его работу в текущем потоке */
+  for( i = 0; i < handle_threads; i++ ) {
+     if( started[i] ) pthread_join( threads[i], NULL );
+      else handle_worker_thread( &results[i] );
+     if( results[i] != ak_error_ok ) result = results[i];
+  }
+
+  if( result != ak_error_ok ) printf("wrong concurrent usage of context manager\n");
+   else printf("concurrent usage of context manager is Ok\n");
+ return result;
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  int result = ak_error_ok;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  if( test_bckey() != ak_error_ok ) result = ak_error_not_equal_data;
+  if( test_mac( "streebog256" ) != ak_error_ok ) result = ak_error_not_equal_data;
+  if( test_mac( "hmac-streebog512" ) != ak_error_ok ) result = ak_error_not_equal_data;
+  if( test_many_handles() != ak_error_ok ) result = ak_error_not_equal_data;
+#ifdef AK_HAVE_PTHREAD_H
+  if( test_threads() != ak_error_ok ) result = ak_error_not_equal_data;
+#endif
+
+  if( result == ak_error_ok ) printf("result is Ok\n");
+  ak_libakrypt_destroy();
+
+ if( result == ak_error_ok ) return EXIT_SUCCESS;
+  else return EXIT_FAILURE;
+}
@@ -0,0 +1,316 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тестовый пример, иллюстрирующий одновременное хеширование нескольких независимых сообщений,
+   хеширование сообщений, составленных из несвязных фрагментов, сохранение и восстановление
+   промежуточного состояния, хеширование в древовидном режиме, а также хеширование файлов.
+
+   test-hash01.c                                                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+
+ #define messages_count (67)
+ #define leaf_size (65536)
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_multi( ak_hash hctx )
+{
+  ak_uint8 data[4096], hashes[messages_count][64], etalon[64];
+  ak_pointer in[messages_count], out[messages_count];
+  size_t i, size[messages_count];
+  int result = ak_error_ok;
+
+ /* сообщения различной длины, в том числе пустые и кратные длине блока */
+  for( i = 0; i < sizeof( data ); i++ ) data[i] = ( ak_uint8 )( 11*i + 5 );
+  for( i = 0; i < messages_count; i++ ) {
+     size[i] = ( i*i*13 )%( sizeof( data ) - 64 );
+     if( i%5 == 0 ) size[i] = 64*( i%7 );
+     in[i] = data + ( i%64 );
+     out[i] = hashes[i];
+  }
+  memset( hashes, 0, sizeof( hashes ));
+  if( ak_hash_ptr_multi( hctx, messages_count, in, size, out, sizeof( hashes[0] )) != ak_error_ok )
+    return ak_error_get_value();
+
+  for( i = 0; i < messages_count; i++ ) {
+     ak_hash_ptr( hctx, in[i], size[i], etalon, sizeof( etalon ));
+     if( memcmp( etalon, hashes[i], ak_hash_get_tag_size( hctx ))) {
+       printf("%s: wrong hash for message %u (length %u)\n", hctx->oid->name[0],
+                                                         (unsigned int) i, (unsigned int) size[i] );
+       result = ak_error_not_equal_data;
+     }
+  }
+  printf("%s: %u messages tested\n", hctx->oid->name[0], (unsigned int) messages_count );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* хеширование сообщения, разбитого на фрагменты различной длины */
+ int test_vectors( ak_hash hctx )
+{
+  struct iovector iov[messages_count];
+  ak_uint8 data[4096], etalon[64], out[64];
+  size_t i, offset = 0;
+  int result = ak_error_ok;
+
+  for( i = 0; i < sizeof( data ); i++ ) data[i] = ( ak_uint8 )( 3*i + 1 );
+  for( i = 0; i < messages_count; i++ ) {
+     iov[i].data = data + offset;
+     iov[i].size = ( i*i*7 )%97;
+     if( i%9 == 0 ) iov[i].size = 64*( i%4 );
+     offset += iov[i].size;
+  }
+  ak_hash_ptr( hctx, data, offset, etalon, sizeof( etalon ));
+
+ /* после вызова ak_hash_ptr() состояние контекста сохраняется */
+  memset( out, 0, sizeof( out ));
+  ak_hash_finalize( hctx, NULL, 0, out, sizeof( out ));
+  if( memcmp( etalon, out, ak_hash_get_tag_size( hctx ))) {
+    printf("%s: state is changed by ak_hash_ptr()\n", hctx->oid->name[0] );
+    result = ak_error_not_equal_data;
+  }
+
+ /* фрагменты обрабатываются одним вызовом, результат вычисляется без копирования состояния */
+  memset( out, 0, sizeof( out ));
+  ak_hash_clean( hctx );
+  ak_hash_updatev( hctx, iov, messages_count );
+  ak_hash_finalize_inplace( hctx, NULL, 0, out, sizeof( out ));
+  if( memcmp( etalon, out, ak_hash_get_tag_size( hctx ))) {
+    printf("%s: wrong hash for vector of fragments\n", hctx->oid->name[0] );
+    result = ak_error_not_equal_data;
+  }
+
+ /* фрагменты обрабатываются по одному, состояние контекста сохраняется */
+  memset( out, 0, sizeof( out ));
+  ak_hash_clean( hctx );
+  for( i = 0; i < messages_count; i++ ) ak_hash_updatev( hctx, iov+i, 1 );
+  ak_hash_finalize( hctx, NULL, 0, out, sizeof( out ));
+  ak_hash_finalize( hctx, NULL, 0, out, sizeof( out ));
+  if( memcmp( etalon, out, ak_hash_get_tag_size( hctx ))) {
+    printf("%s: wrong hash for sequence of fragments\n", hctx->oid->name[0] );
+    result = ak_error_not_equal_data;
+  }
+  printf("%s: %u bytes in %u fragments tested\n", hctx->oid->name[0],
+                                               (unsigned int) offset, (unsigned int) messages_count );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* вычисления прерываются после обработки части сообщения и продолжаются в другом контексте */
+ int test_state( ak_hash hctx )
+{
+  struct hash sx;
+  struct hmac hx, hy;
+  ak_uint8 data[1000], key[32], etalon[64], out[64];
+  ak_uint8 state[ak_hmac_state_size];
+  size_t i, parts[] = { 0, 1, 63, 64, 65, 500, 1000 };
+  int result = ak_error_ok;
+
+  for( i = 0; i < sizeof( data ); i++ ) data[i] = ( ak_uint8 )( 5*i + 3 );
+  for( i = 0; i < sizeof( key ); i++ ) key[i] = ( ak_uint8 )( i + 0x10 );
+  ak_hash_ptr( hctx, data, sizeof( data ), etalon, sizeof( etalon ));
+  ak_hash_create_oid( &sx, hctx->oid );
+
+  for( i = 0; i < sizeof( parts )/sizeof( size_t ); i++ ) {
+     ak_hash_clean( hctx );
+     ak_hash_update( hctx, data, parts[i] );
+     if( ak_hash_export_state( hctx, state, sizeof( state )) != ak_error_ok )
+       return ak_error_get_value();
+     memset( out, 0, sizeof( out ));
+     if( ak_hash_import_state( &sx, state, ak_hash_state_size ) != ak_error_ok )
+       return ak_error_get_value();
+     ak_hash_finalize( &sx, data + parts[i], sizeof( data ) - parts[i], out, sizeof( out ));
+     if( memcmp( etalon, out, ak_hash_get_tag_size( hctx ))) {
+       printf("%s: wrong hash for state exported after %u bytes\n",
+                                                     hctx->oid->name[0], (unsigned int) parts[i] );
+       result = ak_error_not_equal_data;
+     }
+  }
+  ak_hash_destroy( &sx );
+
+ /* ключи двух контекстов HMAC устанавливаются независимо */
+  if( ak_hash_get_tag_size( hctx ) == 32 ) {
+    ak_hmac_create_streebog256( &hx );
+    ak_hmac_create_streebog256( &hy );
+  } else {
+    ak_hmac_create_streebog512( &hx );
+    ak_hmac_create_streebog512( &hy );
+  }
+  ak_hmac_set_key( &hx, key, sizeof( key ));
+  ak_hmac_set_key( &hy, key, sizeof( key ));
+  ak_hmac_ptr( &hx, data, sizeof( data ), etalon, sizeof( etalon ));
+
+  for( i = 0; i < sizeof( parts )/sizeof( size_t ); i++ ) {
+     ak_hmac_clean( &hx );
+     ak_hmac_update( &hx, data, parts[i] );
+     ak_hmac_export_state( &hx, state, sizeof( state ));
+     memset( out, 0, sizeof( out ));
+     if( ak_hmac_import_state( &hy, state, sizeof( state )) != ak_error_ok )
+       return ak_error_get_value();
+     ak_hmac_finalize( &hy, data + parts[i], sizeof( data ) - parts[i], out, sizeof( out ));
+     if( memcmp( etalon, out, ak_hmac_get_tag_size( &hx ))) {
+       printf("hmac-%s: wrong mac for state exported after %u bytes\n",
+                                                     hctx->oid->name[0], (unsigned int) parts[i] );
+       result = ak_error_not_equal_data;
+     }
+  }
+ /* состояние не может быть восстановлено с другим ключом */
+  key[0] ^= 1;
+  ak_hmac_set_key( &hy, key, sizeof( key ));
+  if( ak_hmac_import_state( &hy, state, sizeof( state )) != ak_error_key_value ) {
+    printf("hmac-%s: state imported with wrong key\n", hctx->oid->name[0] );
+    result = ak_error_not_equal_data;
+  }
+  ak_hmac_destroy( &hx );
+  ak_hmac_destroy( &hy );
+
+  if( result == ak_error_ok ) printf("%s: state export tested\n", hctx->oid->name[0] );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* непосредственное вычисление корня хеш-дерева: левое поддерево содержит
+   наибольшее количество листьев, являющееся степенью двойки и меньшее n */
+ void tree_root( ak_hash hctx, ak_uint8 *data, size_t size, size_t n, ak_uint8 *out )
+{
+  ak_uint8 node[129];
+  size_t k = 1, hsize = ak_hash_get_tag_size( hctx );
+
+  if( n == 1 ) {
+    ak_uint8 *leaf = malloc( size+1 );
+    leaf[0] = 0;
+    memcpy( leaf+1, data, size );
+    ak_hash_ptr( hctx, leaf, size+1, out, hsize );
+    free( leaf );
+    return;
+  }
+  while( 2*k < n ) k <<= 1;
+  node[0] = 1;
+  tree_root( hctx, data, k*leaf_size, k, node+1 );
+  tree_root( hctx, data + k*leaf_size, size - k*leaf_size, n-k, node+1+hsize );
+  ak_hash_ptr( hctx, node, 1+2*hsize, out, hsize );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_tree( ak_hash hctx )
+{
+  ak_uint8 *data, etalon[64], out[64];
+  size_t i, size, sizes[] = { 0, 17, leaf_size, leaf_size+1, 3*leaf_size+5, 37*leaf_size };
+  int result = ak_error_ok;
+
+  if(( data = malloc( 37*leaf_size )) == NULL ) return ak_error_out_of_memory;
+  for( i = 0; i < 37*leaf_size; i++ ) data[i] = ( ak_uint8 )( 7*i + ( i >> 11 ));
+
+  for( i = 0; i < sizeof( sizes )/sizeof( size_t ); i++ ) {
+     size = sizes[i];
+     tree_root( hctx, data, size, size ? ( size + leaf_size - 1 )/leaf_size : 1, etalon );
+     memset( out, 0, sizeof( out ));
+     ak_hash_ptr_tree( hctx, data, size, out, sizeof( out ));
+     if( memcmp( etalon, out, ak_hash_get_tag_size( hctx ))) {
+       printf("%s: wrong tree hash for length %u\n", hctx->oid->name[0], (unsigned int) size );
+       result = ak_error_not_equal_data;
+     }
+  }
+  printf("%s: tree mode tested\n", hctx->oid->name[0] );
+  free( data );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_file( ak_hash hctx )
+{
+  FILE *fp = NULL;
+  struct hash ctx[3];
+  char names[5][32];
+  const char *filenames[5];
+  ak_pointer ptr[3] = { ctx, ctx+1, ctx+2 };
+  ak_uint8 *data, etalon[5][64], out[5][64];
+  size_t i, mmap, size, sizes[5] = { 1, 63, 4097, 1048576, 2*1048576+33 };
+  int errors[5], result = ak_error_ok;
+
+  if(( data = malloc( 2*1048576+33 )) == NULL ) return ak_error_out_of_memory;
+  for( i = 0; i < 2*1048576+33; i++ ) data[i] = ( ak_uint8 )( 5*i + ( i >> 9 ));
+
+  for( i = 0; i < 5; i++ ) {
+     size = sizes[i];
+     ak_snprintf( names[i], sizeof( names[i] ), "test-hash01-%u.bin", (unsigned int) i );
+     filenames[i] = names[i];
+     if(( fp = fopen( names[i], "wb" )) == NULL ) { result = ak_error_create_file; break; }
+     fwrite( data, 1, size, fp );
+     fclose( fp );
+     ak_hash_ptr( hctx, data, size, etalon[i], 64 );
+    /* хешируем файл, отображая его в память и считывая его фрагментами */
+     for( mmap = 0; mmap < 2; mmap++ ) {
+        ak_libakrypt_set_option( "mac_file_use_mmap", mmap );
+        memset( out[i], 0, 64 );
+        ak_hash_file( hctx, names[i], out[i], 64 );
+        if( memcmp( etalon[i], out[i], ak_hash_get_tag_size( hctx ))) {
+          printf("%s: wrong file hash for length %u (mmap: %u)\n", hctx->oid->name[0],
+                                                    (unsigned int) size, (unsigned int) mmap );
+          result = ak_error_not_equal_data;
+        }
+     }
+  }
+  ak_libakrypt_set_option( "mac_file_use_mmap", 1 );
+
+ /* хешируем все файлы одновременно тремя потоками */
+  if( result == ak_error_ok ) {
+    for( i = 0; i < 3; i++ ) ak_hash_create_oid( ctx+i, hctx->oid );
+    memset( out, 0, sizeof( out ));
+    ak_file_async(( ak_function_file_async *) ak_hash_file, ptr, 3, filenames, 5,
+                                                                  out[0], 64, errors );
+    for( i = 0; i < 5; i++ )
+       if(( errors[i] != ak_error_ok ) ||
+                                 memcmp( etalon[i], out[i], ak_hash_get_tag_size( hctx ))) {
+         printf("%s: wrong async file hash for length %u\n", hctx->oid->name[0],
+                                                                      (unsigned int) sizes[i] );
+         result = ak_error_not_equal_data;
+       }
+    for( i = 0; i < 3; i++ ) ak_hash_destroy( ctx+i );
+  }
+
+  for( i = 0; i < 5; i++ ) remove( names[i] );
+  printf("%s: file hashing tested\n", hctx->oid->name[0] );
+  free( data );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  struct hash hctx;
+  int backend, result = ak_error_ok;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  for( backend = 0; backend < 3; backend++ ) {
+     ak_libakrypt_set_option( "streebog_simd_backend", backend );
+     printf("streebog simd backend: %d\n", backend );
+
+     ak_hash_create_streebog256( &hctx );
+     if( test_multi( &hctx ) != ak_error_ok ) result = ak_error_not_equal_data;
+     if( test_vectors( &hctx ) != ak_error_ok ) result = ak_error_not_equal_data;
+     if( test_state( &hctx ) != ak_error_ok ) result = ak_error_not_equal_data;
+     if( test_tree( &hctx ) != ak_error_ok ) result = ak_error_not_equal_data;
+     if( test_file( &hctx ) != ak_error_ok ) result = ak_error_not_equal_data;
+     ak_hash_destroy( &hctx );
+
+     ak_hash_create_streebog512( &hctx );
+     if( test_multi( &hctx ) != ak_error_ok ) result = ak_error_not_equal_data;
+     if( test_vectors( &hctx ) != ak_error_ok ) result = ak_error_not_equal_data;
+     if( test_state( &hctx ) != ak_error_ok ) result = ak_error_not_equal_data;
+     if( test_tree( &hctx ) != ak_error_ok ) result = ak_error_not_equal_data;
+     if( test_file( &hctx ) != ak_error_ok ) result = ak_error_not_equal_data;
+     ak_hash_destroy( &hctx );
+  }
+  ak_libakrypt_set_option( "streebog_simd_backend", 1 );
+
+  if( result == ak_error_ok ) printf("result is Ok\n");
+  ak_libakrypt_destroy();
+
+ if( result == ak_error_ok ) return EXIT_SUCCESS;
+  else return EXIT_FAILURE;
+}
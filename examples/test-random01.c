@@ -58,6 +58,9 @@
    if( test_function( ak_random_create_lcg,
       "47b7ef2b729133a3e9853e0f4ffe040154a7622b7827e71bc6e48dff98c27f61" ) != ak_true )
      error = EXIT_FAILURE;
+   if( test_function( ak_random_create_chacha20,
+      "690de65236f9241bda6a33c2245e0f580505404c4f4837ca6cec9e2f24018f72" ) != ak_true )
+     error = EXIT_FAILURE;
 
 #ifdef _WIN32
  if( test_function( ak_random_create_winrtl, NULL ) != ak_true ) error = EXIT_FAILURE;
@@ -10,8 +10,13 @@
 
  int main( int argc, char *argv[] )
 {
-  struct signkey sk;
+  size_t i;
+  struct signkey sk, ak[2];
   struct verifykey pk;
+  ak_pointer ptr[2] = { ak, ak+1 };
+  const char *filenames[3];
+  ak_uint8 signs[3][128];
+  int errors[3];
   struct random generator;
   int result = EXIT_SUCCESS;
   ak_uint8 sign[128];
@@ -54,6 +59,21 @@
     printf("verify: Ok\n");
    else { printf("verify: Wrong\n"); result = EXIT_FAILURE; }
 
+ /* подписываем файл несколько раз одновременно, используя две копии секретного ключа */
+  for( i = 0; i < 2; i++ ) {
+     ak_signkey_create_str( ak+i, "cspa" );
+     ak_signkey_set_key( ak+i, testkey, 32 );
+  }
+  for( i = 0; i < 3; i++ ) filenames[i] = argv[0];
+  memset( signs, 0, sizeof( signs ));
+  ak_file_async( ak_signkey_sign_file_async, ptr, 2, filenames, 3, signs[0], 128, errors );
+  for( i = 0; i < 3; i++ ) {
+     if(( errors[i] == ak_error_ok ) && ak_verifykey_verify_file( &pk, argv[0], signs[i] ))
+       printf("async verify: Ok\n");
+      else { printf("async verify: Wrong\n"); result = EXIT_FAILURE; }
+  }
+  for( i = 0; i < 2; i++ ) ak_signkey_destroy( ak+i );
+
   ak_signkey_destroy( &sk );
   ak_verifykey_destroy( &pk );
 
@@ -0,0 +1,161 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тестовый пример, иллюстрирующий периодическую проверку контрольной суммы секретного ключа,
+   смену его маски, а также размещение ключей в защищенной области памяти.
+
+   test-skey01.c                                                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+
+ static ak_uint8 key[32] = {
+     0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+     0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10, 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef };
+
+ static ak_uint8 iv[8] = { 0xf0, 0xce, 0xab, 0x90, 0x78, 0x56, 0x34, 0x12 };
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_icode_period( ak_bckey bkey )
+{
+  ak_uint8 plain[16], out[16];
+  size_t i, first = 0, fails = 0;
+  int result = ak_error_ok;
+
+  memset( plain, 0, sizeof( plain ));
+  ak_skey_set_icode_check_period( &bkey->key, 8 );
+  ak_bckey_ctr( bkey, plain, out, sizeof( plain ), iv, bkey->bsize >> 1 );
+
+ /* искажаем ключ и проверяем, что искажение обнаруживается не позднее, чем через 8 вызовов,
+    а все последующие вызовы завершаются с ошибкой */
+  bkey->key.key[0] ^= 0x01;
+  for( i = 1; i <= 16; i++ ) {
+     if( ak_bckey_ctr( bkey, plain, out, sizeof( plain ), iv,
+                                                        bkey->bsize >> 1 ) != ak_error_wrong_key_icode )
+       continue;
+     if( !first ) first = i;
+     fails++;
+  }
+  if(( first == 0 ) || ( first > 8 ) || ( fails != 17 - first )) {
+    printf("%s: key corruption is not detected\n", bkey->key.oid->name[0] );
+    result = ak_error_not_equal_data;
+  }
+  bkey->key.key[0] ^= 0x01;
+  printf("%s: key corruption detected after %u calls\n", bkey->key.oid->name[0],
+                                                                         (unsigned int) first );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_remask_policy( ak_bckey bkey )
+{
+  ak_uint8 plain[64], etalon[64], out[64], masked[32];
+  size_t i, changes = 0;
+  int result = ak_error_ok;
+
+  memset( plain, 0, sizeof( plain ));
+  ak_bckey_ctr( bkey, plain, etalon, sizeof( etalon ), iv, bkey->bsize >> 1 );
+
+ /* маска должна меняться после каждого четвертого использования ключа */
+  ak_skey_set_remask_policy( &bkey->key, key_remask_by_calls, 4 );
+  for( i = 1; i <= 16; i++ ) {
+     memcpy( masked, bkey->key.key, sizeof( masked ));
+     memset( out, 0, sizeof( out ));
+     ak_bckey_ctr( bkey, plain, out, sizeof( out ), iv, bkey->bsize >> 1 );
+     if( memcmp( out, etalon, sizeof( out ))) result = ak_error_not_equal_data;
+     if( memcmp( masked, bkey->key.key, sizeof( masked ))) {
+       if( i%4 ) result = ak_error_not_equal_data;
+       changes++;
+     }
+  }
+  if( changes != 4 ) result = ak_error_not_equal_data;
+
+ /* маска должна меняться после обработки не менее 256 октетов */
+  ak_skey_set_remask_policy( &bkey->key, key_remask_by_bytes, 256 );
+  for( i = 1, changes = 0; i <= 16; i++ ) {
+     memcpy( masked, bkey->key.key, sizeof( masked ));
+     ak_bckey_ctr( bkey, plain, out, sizeof( out ), iv, bkey->bsize >> 1 );
+     if( memcmp( masked, bkey->key.key, sizeof( masked ))) changes++;
+  }
+  if( changes != 4 ) result = ak_error_not_equal_data;
+  ak_skey_set_remask_policy( &bkey->key, key_remask_every_call, 0 );
+
+  if( result != ak_error_ok )
+    printf("%s: wrong remasking policy\n", bkey->key.oid->name[0] );
+   else printf("%s: remasking policy is Ok\n", bkey->key.oid->name[0] );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_secure_arena( ak_bckey bkey )
+{
+  struct bckey skey;
+  ak_uint8 plain[64], etalon[64], out[64], *ptr = NULL, *qtr = NULL;
+  size_t i;
+  int result = ak_error_ok;
+
+  memset( plain, 0, sizeof( plain ));
+  ak_bckey_ctr( bkey, plain, etalon, sizeof( etalon ), iv, bkey->bsize >> 1 );
+
+ /* ячейки защищенной области выделяются обнуленными и повторно используются после очистки */
+  if(( ptr = ak_secure_arena_malloc( 64 )) == NULL ) result = ak_error_out_of_memory;
+   else {
+     for( i = 0; i < 64; i++ ) if( ptr[i] != 0 ) result = ak_error_not_equal_data;
+     if( (( size_t )ptr )%64 ) result = ak_error_not_equal_data;
+     memset( ptr, 0xa5, 64 );
+     ak_secure_arena_free( ptr );
+     if(( qtr = ak_secure_arena_malloc( 48 )) != ptr ) result = ak_error_not_equal_data;
+     for( i = 0; i < 64; i++ ) if( ptr[i] != 0 ) result = ak_error_not_equal_data;
+     ak_secure_arena_free( qtr );
+   }
+  if(( ptr = ak_secure_arena_malloc( 4096 )) != NULL ) result = ak_error_not_equal_data;
+  if( ak_secure_arena_free( plain ) != ak_false ) result = ak_error_not_equal_data;
+
+ /* ключ, размещенный в защищенной области, должен давать тот же результат */
+  ak_libakrypt_set_option( "key_memory_policy", 1 );
+  if( bkey->bsize == 16 ) ak_bckey_create_kuznechik( &skey );
+   else ak_bckey_create_magma( &skey );
+  ak_libakrypt_set_option( "key_memory_policy", 0 );
+  ak_bckey_set_key( &skey, key, sizeof( key ));
+  if( skey.key.policy != secure_arena_policy ) result = ak_error_not_equal_data;
+  memset( out, 0, sizeof( out ));
+  ak_bckey_ctr( &skey, plain, out, sizeof( out ), iv, skey.bsize >> 1 );
+  if( memcmp( out, etalon, sizeof( out ))) result = ak_error_not_equal_data;
+  ak_bckey_destroy( &skey );
+
+  if( result != ak_error_ok )
+    printf("%s: wrong secure arena allocation\n", bkey->key.oid->name[0] );
+   else printf("%s: secure arena allocation is Ok\n", bkey->key.oid->name[0] );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  struct bckey kuznechik, magma;
+  int result = ak_error_ok;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  ak_bckey_create_kuznechik( &kuznechik );
+  ak_bckey_set_key( &kuznechik, key, sizeof( key ));
+  if( test_remask_policy( &kuznechik ) != ak_error_ok ) result = ak_error_not_equal_data;
+  if( test_secure_arena( &kuznechik ) != ak_error_ok ) result = ak_error_not_equal_data;
+  if( test_icode_period( &kuznechik ) != ak_error_ok ) result = ak_error_not_equal_data;
+  ak_bckey_destroy( &kuznechik );
+
+  ak_bckey_create_magma( &magma );
+  ak_bckey_set_key( &magma, key, sizeof( key ));
+  if( test_remask_policy( &magma ) != ak_error_ok ) result = ak_error_not_equal_data;
+  if( test_secure_arena( &magma ) != ak_error_ok ) result = ak_error_not_equal_data;
+  if( test_icode_period( &magma ) != ak_error_ok ) result = ak_error_not_equal_data;
+  ak_bckey_destroy( &magma );
+
+  if( result == ak_error_ok ) printf("result is Ok\n");
+  ak_libakrypt_destroy();
+
+ if( result == ak_error_ok ) return EXIT_SUCCESS;
+  else return EXIT_FAILURE;
+}
@@ -0,0 +1,183 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тестовый пример, иллюстрирующий многопоточное расшифрование данных в режимах простой замены
+   с зацеплением и гаммирования с обратной связью по шифртексту, а также многопоточное
+   шифрование в режимах гаммирования и CTR-ACPKM: результат, полученный несколькими потоками,
+   сравнивается с результатом однопоточного преобразования.
+
+   test-threads01.c                                                                                */
+/* ----------------------------------------------------------------------------------------------- */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+
+/* объем данных выбран так, чтобы на каждый из четырех потоков приходилось не менее 256 Кб,
+   а количество блоков не делилось на количество потоков */
+ #define threads_count (4)
+ #define data_size (1048576 + 80)
+
+ static ak_uint8 key[32] = {
+     0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+     0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10, 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef };
+
+ static ak_uint8 iv[32] = {
+     0x12, 0x34, 0x56, 0x78, 0x90, 0xab, 0xce, 0xf0, 0xa1, 0xb2, 0xc3, 0xd4, 0xe5, 0xf0, 0x01, 0x12,
+     0x23, 0x34, 0x45, 0x56, 0x67, 0x78, 0x89, 0x90, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19 };
+
+ typedef int ( ak_function_mode )( ak_bckey , ak_pointer , ak_pointer , size_t ,
+                                                                             ak_pointer , size_t );
+
+/* ----------------------------------------------------------------------------------------------- */
+/* Функция зашифровывает данные в одном потоке, после чего расшифровывает их сначала
+   в одном потоке, а потом в нескольких потоках, в том числе на месте. */
+/* ----------------------------------------------------------------------------------------------- */
+ int test_decrypt( ak_bckey bkey, const char *mode, ak_function_mode *encrypt,
+                  ak_function_mode *decrypt, ak_uint8 *plain, ak_uint8 *cipher, ak_uint8 *etalon,
+                                                                  ak_uint8 *out, size_t iv_size )
+{
+  int result = ak_error_ok;
+
+  ak_libakrypt_set_option( "block_cipher_threads", 1 );
+  encrypt( bkey, plain, cipher, data_size, iv, iv_size );
+  decrypt( bkey, cipher, etalon, data_size, iv, iv_size );
+  if( memcmp( etalon, plain, data_size )) result = ak_error_not_equal_data;
+
+  ak_libakrypt_set_option( "block_cipher_threads", threads_count );
+  memset( out, 0, data_size );
+  decrypt( bkey, cipher, out, data_size, iv, iv_size );
+  if( memcmp( out, etalon, data_size )) result = ak_error_not_equal_data;
+
+  memcpy( out, cipher, data_size );
+  decrypt( bkey, out, out, data_size, iv, iv_size );
+  if( memcmp( out, etalon, data_size )) result = ak_error_not_equal_data;
+  ak_libakrypt_set_option( "block_cipher_threads", 0 );
+
+  printf("%s (%s, iv: %u bytes): ", bkey->key.oid->name[0], mode, (unsigned int) iv_size );
+  if( result == ak_error_ok ) printf("Ok\n");
+   else printf("Wrong\n");
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* Функция зашифровывает в режиме гаммирования данные, длина которых не кратна длине блока,
+   сначала в одном потоке, а потом в нескольких потоках, в том числе на месте. */
+/* ----------------------------------------------------------------------------------------------- */
+ int test_ctr( ak_bckey bkey, ak_uint8 *plain, ak_uint8 *etalon, ak_uint8 *out )
+{
+  int result = ak_error_ok;
+  const size_t size = data_size - 3;
+
+  ak_libakrypt_set_option( "block_cipher_threads", 1 );
+  ak_bckey_ctr( bkey, plain, etalon, size, iv, bkey->bsize >> 1 );
+
+  ak_libakrypt_set_option( "block_cipher_threads", threads_count );
+  memset( out, 0, size );
+  ak_bckey_ctr( bkey, plain, out, size, iv, bkey->bsize >> 1 );
+  if( memcmp( out, etalon, size )) result = ak_error_not_equal_data;
+
+  memcpy( out, plain, size );
+  ak_bckey_ctr_parallel( bkey, out, out, size, iv, bkey->bsize >> 1, threads_count );
+  if( memcmp( out, etalon, size )) result = ak_error_not_equal_data;
+  ak_libakrypt_set_option( "block_cipher_threads", 0 );
+
+  printf("%s (ctr): ", bkey->key.oid->name[0] );
+  if( result == ak_error_ok ) printf("Ok\n");
+   else printf("Wrong\n");
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/* Функция зашифровывает данные в режиме CTR-ACPKM сначала в одном потоке,
+   а потом в нескольких потоках, в том числе на месте. */
+/* ----------------------------------------------------------------------------------------------- */
+ int test_acpkm( ak_bckey bkey, ak_uint8 *plain, ak_uint8 *etalon, ak_uint8 *out )
+{
+  int result = ak_error_ok;
+  const size_t size = data_size - 3, section_size = 1024;
+
+  ak_bckey_ctr_acpkm( bkey, plain, etalon, size, section_size, iv, bkey->bsize >> 1 );
+
+  memset( out, 0, size );
+  ak_bckey_ctr_acpkm_parallel( bkey, plain, out, size, section_size,
+                                                             iv, bkey->bsize >> 1, threads_count );
+  if( memcmp( out, etalon, size )) result = ak_error_not_equal_data;
+
+  ak_libakrypt_set_option( "block_cipher_threads", threads_count );
+  memcpy( out, plain, size );
+  ak_bckey_ctr_acpkm_parallel( bkey, out, out, size, section_size, iv, bkey->bsize >> 1, 0 );
+  if( memcmp( out, etalon, size )) result = ak_error_not_equal_data;
+  ak_libakrypt_set_option( "block_cipher_threads", 0 );
+
+  printf("%s (ctr-acpkm): ", bkey->key.oid->name[0] );
+  if( result == ak_error_ok ) printf("Ok\n");
+   else printf("Wrong\n");
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_bckey( ak_bckey bkey, ak_uint8 *plain, ak_uint8 *cipher, ak_uint8 *etalon, ak_uint8 *out )
+{
+  size_t iv_size;
+  int result = ak_error_ok;
+
+  ak_bckey_set_key( bkey, key, sizeof( key ));
+  for( iv_size = bkey->bsize; iv_size <= 2*bkey->bsize; iv_size += bkey->bsize ) {
+     if( test_decrypt( bkey, "cbc", ak_bckey_encrypt_cbc, ak_bckey_decrypt_cbc,
+                                  plain, cipher, etalon, out, iv_size ) != ak_error_ok )
+       result = ak_error_not_equal_data;
+     if( test_decrypt( bkey, "cfb", ak_bckey_encrypt_cfb, ak_bckey_decrypt_cfb,
+                                  plain, cipher, etalon, out, iv_size ) != ak_error_ok )
+       result = ak_error_not_equal_data;
+  }
+  if( test_ctr( bkey, plain, etalon, out ) != ak_error_ok ) result = ak_error_not_equal_data;
+
+ /* режим CTR-ACPKM изменяет тип ресурса ключа, поэтому значение ключа устанавливается заново */
+  ak_bckey_set_key( bkey, key, sizeof( key ));
+  if( test_acpkm( bkey, plain, etalon, out ) != ak_error_ok ) result = ak_error_not_equal_data;
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  size_t i;
+  struct bckey bkey;
+  int result = ak_error_ok;
+  ak_uint8 *plain = NULL, *cipher = NULL, *etalon = NULL, *out = NULL;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  plain = malloc( data_size ); cipher = malloc( data_size );
+  etalon = malloc( data_size ); out = malloc( data_size );
+  if(( plain == NULL ) || ( cipher == NULL ) || ( etalon == NULL ) || ( out == NULL )) {
+    result = ak_error_out_of_memory;
+    goto labex;
+  }
+  for( i = 0; i < data_size; i++ ) plain[i] = ( ak_uint8 )( 7*i + 3 );
+
+ /* ресурса ключа по умолчанию не хватает для многократной обработки данных алгоритмом Магма */
+  ak_libakrypt_set_option( "magma_cipher_resource", 16*data_size );
+
+  ak_bckey_create_magma( &bkey );
+  if( test_bckey( &bkey, plain, cipher, etalon, out ) != ak_error_ok )
+    result = ak_error_not_equal_data;
+  ak_bckey_destroy( &bkey );
+
+  ak_bckey_create_kuznechik( &bkey );
+  if( test_bckey( &bkey, plain, cipher, etalon, out ) != ak_error_ok )
+    result = ak_error_not_equal_data;
+  ak_bckey_destroy( &bkey );
+
+  labex:
+  if( plain ) free( plain );
+  if( cipher ) free( cipher );
+  if( etalon ) free( etalon );
+  if( out ) free( out );
+  if( result == ak_error_ok ) printf("result is Ok\n");
+  ak_libakrypt_destroy();
+
+ if( result == ak_error_ok ) return EXIT_SUCCESS;
+  else return EXIT_FAILURE;
+}
@@ -1,35 +1,75 @@
 /* ----------------------------------------------------------------------------------------------- */
-/*                 Тестирование алгоритма блочного шифрования TwoFish (128-bit)                    */
+/* Тестовый пример, иллюстрирующий работу алгоритма блочного шифрования TwoFish
+   в базовых режимах шифрования.
+
+   test-twofish.c                                                                                  */
 /* ----------------------------------------------------------------------------------------------- */
 
-#include <stdio.h>
-#include <libakrypt.h>
-
-int main(){
-    ak_uint32 plain[4] = {0, 0, 0, 0};
-    ak_uint8 M[16] = {0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0,  0, 0, 0, 0};
-    /*
-     * Mute BYTE-MASSIVE M to UINT-MASSIVE
-     */
-    ak_uint32 gM[4] = {ak_uint8_to_uint32(M[0], M[1], M[2], M[3]),
-                       ak_uint8_to_uint32(M[4], M[5], M[6], M[7]),
-                       ak_uint8_to_uint32(M[8], M[9], M[10], M[11]),
-                       ak_uint8_to_uint32(M[12], M[13], M[14], M[15])};
-    ak_key_shedule key_shedule;
-
-    printf("Creating Key Shedule \n");
-    ak_create_key_shedule((const ak_uint8 *) M, key_shedule);
-    for(int j = 0; j < 40; j++){
-        printf("Key Shedule [%i] K-key = %lu\n", j, key_shedule.Kkey[j]);
-    }
-    printf("Finished Key SHedule creating, start encryption\n");
-
-    ak_uint32 chipher[4];
-    ak_twofish_encrypt(plain, key_shedule, chipher);
-    printf("CHIPHER: \n");
-    for(int j = 0; j < 4; j++){
-        printf("%i pos - %i \n", j, (ak_uint32) chipher[j]);
-    }
-
-    return 0
-}
\ No newline at end of file
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+
+/* Kлюч и шифртекст нулевого блока из описания алгоритма TwoFish */
+ static ak_uint8 key[32] = {
+     0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10,
+     0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+
+ static ak_uint8 cipher[16] = {
+     0x37, 0x52, 0x7b, 0xe0, 0x05, 0x23, 0x34, 0xb8, 0x9f, 0x0c, 0xfc, 0xca, 0xe8, 0x7c, 0xfa, 0x20 };
+
+ static ak_uint8 iv[16] = {
+     0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x00, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11 };
+
+ int main( void )
+{
+  size_t i;
+  struct bckey bkey;
+  int result = ak_error_ok;
+  ak_uint8 plain[77], out[80], out2[80];
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+ /* инициализируем ключ */
+  ak_bckey_create_twofish( &bkey );
+  ak_bckey_set_key( &bkey, key, sizeof( key ));
+  printf("using cipher: %s (%s)\n", bkey.key.oid->name[0], bkey.key.oid->id[0] );
+
+ /* 1. проверяем зашифрование нулевого блока */
+  memset( out2, 0, sizeof( out2 ));
+  ak_bckey_encrypt_ecb( &bkey, out2, out, 16 );
+  printf("ecb:   %s\n", ak_ptr_to_hexstr( out, 16, ak_false ));
+  if( !ak_ptr_is_equal_with_log( out, cipher, 16 )) {
+    printf("ecb encryption is wrong\n");
+    result = ak_error_not_equal_data;
+  }
+
+ /* 2. режим гаммирования (данные произвольной длины) */
+  for( i = 0; i < sizeof( plain ); i++ ) plain[i] = ( ak_uint8 )( 3*i + 1 );
+  ak_bckey_ctr( &bkey, plain, out, sizeof( plain ), iv, 8 );
+  ak_bckey_ctr( &bkey, out, out2, sizeof( plain ), iv, 8 );
+  printf("ctr:   %s\n", ak_ptr_to_hexstr( out, sizeof( plain ), ak_false ));
+  if( !ak_ptr_is_equal_with_log( out2, plain, sizeof( plain ))) {
+    printf("ctr mode is wrong\n");
+    result = ak_error_not_equal_data;
+  }
+
+ /* 3. режим простой замены с зацеплением (данные кратны длине блока) */
+  ak_bckey_encrypt_cbc( &bkey, plain, out, 64, iv, sizeof( iv ));
+  ak_bckey_decrypt_cbc( &bkey, out, out2, 64, iv, sizeof( iv ));
+  printf("cbc:   %s\n", ak_ptr_to_hexstr( out, 64, ak_false ));
+  if( !ak_ptr_is_equal_with_log( out2, plain, 64 )) {
+    printf("cbc mode is wrong\n");
+    result = ak_error_not_equal_data;
+  }
+
+  if( result == ak_error_ok ) printf("result is Ok\n");
+
+ /* уничтожаем контекст ключа */
+  ak_bckey_destroy( &bkey );
+  ak_libakrypt_destroy();
+
+ if( result == ak_error_ok ) return EXIT_SUCCESS;
+  else return EXIT_FAILURE;
+}
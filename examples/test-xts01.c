@@ -0,0 +1,102 @@
+/* ----------------------------------------------------------------------------------------------- */
+/* Тестовый пример, иллюстрирующий зашифрование последовательности секторов в режиме XTS.
+   Результат сравнивается с посекторным зашифрованием функцией ak_bckey_encrypt_xts().
+   Последовательность секторов пересекает границу 2^64, поэтому проверяется перенос
+   в старшую половину 128-ми битного номера сектора.
+
+   test-xts01.c                                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+
+ #include <stdio.h>
+ #include <stdlib.h>
+ #include <string.h>
+ #include <libakrypt.h>
+
+ static ak_uint8 ekey[32] = {
+     0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff, 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+     0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10, 0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef };
+
+ static ak_uint8 akey[32] = {
+     0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10,
+     0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+
+/* ----------------------------------------------------------------------------------------------- */
+ int test_sectors( ak_bckey ek, ak_bckey ak, size_t sector_size, size_t nsectors )
+{
+  size_t i, size = sector_size*nsectors;
+  ak_uint64 first = 0xfffffffffffffff0LL;
+  ak_uint8 *plain = malloc( size ), *etalon = malloc( size ), *out = malloc( size ), iv[16];
+  int result = ak_error_ok;
+
+  for( i = 0; i < size; i++ ) plain[i] = ( ak_uint8 )( 5*i + i/253 );
+
+ /* эталон: каждый сектор зашифровывается отдельно, синхропосылка - номер сектора */
+  for( i = 0; i < nsectors; i++ ) {
+     ak_uint64 number = first + i, high = ( number < first ); /* 128-ми битный номер сектора */
+     size_t j;
+     memset( iv, 0, sizeof( iv ));
+     for( j = 0; j < 8; j++ ) {
+        iv[j] = ( ak_uint8 )( number >> 8*j );
+        iv[8+j] = ( ak_uint8 )( high >> 8*j );
+     }
+     ak_bckey_encrypt_xts( ek, ak, plain + i*sector_size, etalon + i*sector_size,
+                                                                   sector_size, iv, sizeof( iv ));
+  }
+
+ /* зашифрование всей последовательности за один вызов */
+  ak_bckey_encrypt_xts_sectors( ek, ak, plain, out, sector_size, first, nsectors );
+  if( memcmp( out, etalon, size )) {
+    printf("%s: wrong encryption of %u sectors\n", ek->key.oid->name[0], (unsigned int) nsectors );
+    result = ak_error_not_equal_data;
+  }
+
+ /* расшифрование на месте */
+  ak_bckey_decrypt_xts_sectors( ek, ak, out, out, sector_size, first, nsectors );
+  if( memcmp( out, plain, size )) {
+    printf("%s: wrong decryption of %u sectors\n", ek->key.oid->name[0], (unsigned int) nsectors );
+    result = ak_error_not_equal_data;
+  }
+
+  printf("%s: %u sectors of %u bytes: %s\n", ek->key.oid->name[0], (unsigned int) nsectors,
+                       (unsigned int) sector_size, result == ak_error_ok ? "Ok" : "Wrong" );
+  free( plain ); free( etalon ); free( out );
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ int main( void )
+{
+  struct bckey ek, ak;
+  int result = ak_error_ok;
+
+ /* инициализируем библиотеку */
+  if( !ak_libakrypt_create( ak_function_log_stderr )) return ak_libakrypt_destroy();
+
+  ak_bckey_create_kuznechik( &ek );
+  ak_bckey_set_key( &ek, ekey, sizeof( ekey ));
+  ak_bckey_create_kuznechik( &ak );
+  ak_bckey_set_key( &ak, akey, sizeof( akey ));
+  if( test_sectors( &ek, &ak, 512, 67 ) != ak_error_ok ) result = ak_error_not_equal_data;
+  if( test_sectors( &ek, &ak, 4096, 33 ) != ak_error_ok ) result = ak_error_not_equal_data;
+ /* при достаточном объеме данных сектора обрабатываются несколькими потоками */
+  ak_libakrypt_set_option( "block_cipher_threads", 4 );
+  if( test_sectors( &ek, &ak, 4096, 131 ) != ak_error_ok ) result = ak_error_not_equal_data;
+  ak_libakrypt_set_option( "block_cipher_threads", 0 );
+  ak_bckey_destroy( &ek );
+  ak_bckey_destroy( &ak );
+
+  ak_bckey_create_magma( &ek );
+  ak_bckey_set_key( &ek, ekey, sizeof( ekey ));
+  ak_bckey_create_magma( &ak );
+  ak_bckey_set_key( &ak, akey, sizeof( akey ));
+  if( test_sectors( &ek, &ak, 520, 67 ) != ak_error_ok ) result = ak_error_not_equal_data;
+  if( test_sectors( &ek, &ak, 4096, 9 ) != ak_error_ok ) result = ak_error_not_equal_data;
+  ak_bckey_destroy( &ek );
+  ak_bckey_destroy( &ak );
+
+  if( result == ak_error_ok ) printf("result is Ok\n");
+  ak_libakrypt_destroy();
+
+ if( result == ak_error_ok ) return EXIT_SUCCESS;
+  else return EXIT_FAILURE;
+}
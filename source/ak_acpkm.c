@@ -7,6 +7,11 @@
 /* ----------------------------------------------------------------------------------------------- */
  #include <libakrypt-internal.h>
 
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \details Функция вычисляет новое значение секретного ключа в соответствии с соотношениями
     из раздела 4.1, см. Р 1323565.1.017—2018.
@@ -36,7 +41,7 @@
   if( bkey->key.key_size != 32 ) return ak_error_message_fmt( ak_error_wrong_length, __func__,
                                  "using block cipher key with unexpected length %u", bkey->bsize );
  /* целостность ключа */
-  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+  if( ak_skey_check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode,
                                         __func__, "incorrect integrity code of secret key value" );
  /* выработка нового значения */
@@ -69,41 +74,48 @@
 }
 
 /* ----------------------------------------------------------------------------------------------- */
-#ifdef AK_LITTLE_ENDIAN
-  #define acpkm_block64 {\
-              nkey.encrypt( &nkey.key, ctr, yaout );\
-              ctr[0] += 1;\
-              ((ak_uint64 *) outptr)[0] = yaout[0] ^ ((ak_uint64 *) inptr)[0];\
-              outptr++; inptr++;\
-           }
-
-  #define acpkm_block128 {\
-              nkey.encrypt( &nkey.key, ctr, yaout );\
-              if(( ctr[0] += 1 ) == 0 ) ctr[1]++;\
-              ((ak_uint64 *) outptr)[0] = yaout[0] ^ ((ak_uint64 *) inptr)[0];\
-              ((ak_uint64 *) outptr)[1] = yaout[1] ^ ((ak_uint64 *) inptr)[1];\
-              outptr += 2; inptr += 2;\
-           }
-
-#else
-  #define acpkm_block64 {\
-              nkey.encrypt( &nkey.key, ctr, yaout );\
-              ctr[0] = bswap_64( ctr[0] ); ctr[0] += 1; ctr[0] = bswap_64( ctr[0] );\
-              ((ak_uint64 *) outptr)[0] = yaout[0] ^ ((ak_uint64 *) inptr)[0];\
-              outptr++; inptr++;\
-           }
-
-  #define acpkm_block128 {\
-              nkey.encrypt( &nkey.key, ctr, yaout );\
-              ctr[0] = bswap_64( ctr[0] ); ctr[0] += 1; ctr[0] = bswap_64( ctr[0] );\
-              if( ctr[0] == 0 ) { \
-                ctr[1] = bswap_64( ctr[0] ); ctr[1] += 1; ctr[1] = bswap_64( ctr[0] );\
-              }\
-              ((ak_uint64 *) outptr)[0] = yaout[0] ^ ((ak_uint64 *) inptr)[0];\
-              ((ak_uint64 *) outptr)[1] = yaout[1] ^ ((ak_uint64 *) inptr)[1];\
-              outptr += 2; inptr += 2;\
-           }
-#endif
+/*! \brief Функция гаммирует заданное количество блоков данных, используя последовательные
+    значения счетчика `ctr`. Значения счетчика формируются группами и зашифровываются
+    за один вызов функции ak_bckey_encrypt_blocks().
+
+    @param nkey Контекст ключа алгоритма блочного шифрования.
+    @param ctr Текущее значение счетчика (изменяется функцией).
+    @param inptr Указатель на входные данные.
+    @param outptr Указатель на выходные данные.
+    @param blocks Количество обрабатываемых блоков.                                                */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_acpkm_gamma( ak_bckey nkey, ak_uint64 *ctr,
+                                       ak_uint64 *inptr, ak_uint64 *outptr, ssize_t blocks )
+{
+  ssize_t j, count, words = ( ssize_t )( nkey->bsize >> 3 );
+  ak_uint64 cbuf[128], gbuf[128];
+
+  while( blocks > 0 ) {
+    count = ak_min( blocks, ( ssize_t )( sizeof( cbuf )/nkey->bsize ));
+    for( j = 0; j < count; j++ ) {
+       if( words == 1 ) {
+         cbuf[j] = ctr[0];
+        #ifdef AK_LITTLE_ENDIAN
+         ctr[0] += 1;
+        #else
+         ctr[0] = bswap_64( bswap_64( ctr[0] ) + 1 );
+        #endif
+       } else {
+          cbuf[2*j] = ctr[0]; cbuf[2*j+1] = ctr[1];
+        #ifdef AK_LITTLE_ENDIAN
+          if(( ctr[0] += 1 ) == 0 ) ctr[1]++;
+        #else
+          ctr[0] = bswap_64( bswap_64( ctr[0] ) + 1 );
+          if( ctr[0] == 0 ) ctr[1] = bswap_64( bswap_64( ctr[1] ) + 1 );
+        #endif
+         }
+    }
+    ak_bckey_encrypt_blocks( nkey, cbuf, gbuf, ( size_t ) count );
+    for( j = 0; j < count*words; j++ ) outptr[j] = inptr[j] ^ gbuf[j];
+    inptr += count*words; outptr += count*words;
+    blocks -= count;
+  }
+}
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! В режиме `ACPKM` для шифрования используется операция гаммирования - операция сложения
@@ -143,18 +155,134 @@
 /* ----------------------------------------------------------------------------------------------- */
  int ak_bckey_ctr_acpkm( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
                                                  size_t section_size, ak_pointer iv, size_t iv_size)
+{
+  return ak_bckey_ctr_acpkm_parallel( bkey, in, out, size, section_size, iv, iv_size, 1 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифровывает заданное количество полных секций, вычисляя после каждой
+    секции следующий производный ключ.
+
+    @param nkey Контекст ключа первой обрабатываемой секции (изменяется функцией).
+    @param ctr Текущее значение счетчика (изменяется функцией).
+    @param inptr Указатель на входные данные.
+    @param outptr Указатель на выходные данные.
+    @param sections Количество секций.
+    @param seclen Длина секции в блоках.
+    @return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_acpkm_sections( ak_bckey nkey, ak_uint64 *ctr,
+                          ak_uint64 *inptr, ak_uint64 *outptr, ssize_t sections, ssize_t seclen )
+{
+  int error = ak_error_ok;
+  ssize_t idx = 0, step = seclen*(ssize_t)( nkey->bsize >> 3 );
+
+  for( idx = 0; idx < sections; idx++ ) {
+    /* обрабатываем одну секцию */
+     ak_bckey_acpkm_gamma( nkey, ctr, inptr, outptr, seclen );
+     inptr += step; outptr += step;
+    /* вычисляем следующий ключ */
+     if(( error = ak_bckey_next_acpkm_key( nkey )) != ak_error_ok )
+       return ak_error_message_fmt( error, __func__, "incorrect key generation after %u sections",
+                                                                       (unsigned int)( idx+1 ));
+  }
+ return error;
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция увеличивает значение счетчика, используемого функцией ak_bckey_acpkm_gamma(),
+    на величину n. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_acpkm_ctr_add( ak_bckey nkey, ak_uint64 *ctr, ak_uint64 n )
+{
+ #ifdef AK_LITTLE_ENDIAN
+  ak_uint64 x = ctr[0];
+  ctr[0] += n;
+  if(( nkey->bsize == 16 ) && ( ctr[0] < x )) ctr[1]++;
+ #else
+  ak_uint64 x = bswap_64( ctr[0] );
+  ctr[0] = bswap_64( x + n );
+  if(( nkey->bsize == 16 ) && ( x + n < x )) ctr[1] = bswap_64( bswap_64( ctr[1] ) + 1 );
+ #endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Контекст потока, зашифровывающего последовательность секций в режиме `CTR-ACPKM`. */
+ typedef struct acpkm_fragment {
+  /*! \brief Ключ первой секции фрагмента. */
+   struct bckey key;
+  /*! \brief Значение счетчика для первого блока фрагмента. */
+   ak_uint64 ctr[2];
+  /*! \brief Указатель на входные данные. */
+   ak_uint64 *in;
+  /*! \brief Указатель на выходные данные. */
+   ak_uint64 *out;
+  /*! \brief Количество секций во фрагменте. */
+   ssize_t sections;
+  /*! \brief Длина секции в блоках. */
+   ssize_t seclen;
+  /*! \brief Код ошибки, возникшей при обработке фрагмента. */
+   int error;
+  /*! \brief Дескриптор потока. */
+   pthread_t thread;
+ } *ak_acpkm_fragment;
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_bckey_acpkm_thread( void *ptr )
+{
+  ak_acpkm_fragment fr = ( ak_acpkm_fragment ) ptr;
+  fr->error = ak_bckey_acpkm_sections( &fr->key, fr->ctr, fr->in, fr->out, fr->sections, fr->seclen );
+ return NULL;
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция реализует режим `CTR-ACPKM`, описанный в ak_bckey_ctr_acpkm(), и дает тот же
+    самый результат. Последовательность полных секций разбивается на nthreads непрерывных
+    фрагментов, которые зашифровываются одновременно.
+
+    Ключ секции с номером \f$ k \f$ получается из ключа предыдущей секции зашифрованием
+    константы, поэтому цепочка производных ключей вычисляется последовательно, в вызывающем потоке.
+    Как только вычислен ключ первой секции очередного фрагмента, создается его копия и запускается
+    поток, обрабатывающий фрагмент; вызывающий поток, тем временем, продолжает вычисление цепочки.
+    Поскольку выработка ключа требует зашифрования всего двух (четырех) блоков, потоки
+    запускаются практически одновременно. Последний фрагмент и хвост сообщения обрабатываются
+    вызывающим потоком. Ресурс ключа уменьшается один раз, до начала шифрования.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на входные данные.
+    @param out Указатель на выходные данные (может совпадать с in).
+    @param size Размер данных (в байтах).
+    @param section_size Размер одной секции в байтах.
+    @param iv Синхропосылка.
+    @param iv_size Длина синхропосылки (в байтах).
+    @param nthreads Количество потоков; при нулевом значении количество потоков
+    определяется опцией `block_cipher_threads` и объемом данных.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_ctr_acpkm_parallel( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
+                             size_t section_size, ak_pointer iv, size_t iv_size, size_t nthreads )
 {
   struct bckey nkey;
   int error = ak_error_ok;
   ssize_t j = 0, sections = 0, tail = 0, seclen = 0, maxseclen = 0, mcount = 0;
   ak_uint64 yaout[2], *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out, ctr[2] = { 0, 0 };
+#ifdef AK_HAVE_PTHREAD_H
+  size_t idx = 0, started = 0;
+  ak_acpkm_fragment frs = NULL;
+  ssize_t per = 0;
+#endif
 
  /* выполняем проверку размера входных данных */
   if( section_size%bkey->bsize != 0 )
     return ak_error_message( ak_error_wrong_block_cipher_length,
                                __func__ , "the length of section is not divided by block length" );
  /* проверяем целостность ключа */
-  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+  if( ak_skey_check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode, __func__,
                                                   "incorrect integrity code of secret key value" );
  /* проверяем размер синхропосылки */
@@ -195,10 +323,9 @@
     bkey->key.resource.value.counter = mcount; /* здесь находится максимальное число сообщений,
                                                   которые могут быть зашифрованы на данном ключе */
   } else {
-      if( bkey->key.resource.value.counter < 1 )
+      if( ak_skey_reserve_resource( &bkey->key, 1 ) != ak_error_ok )
         return ak_error_message( ak_error_low_key_resource,
                                 __func__ , "low key using resource for block cipher key context" );
-       else bkey->key.resource.value.counter--;
      }
 
  /* теперь размножаем исходный ключ */
@@ -210,31 +337,60 @@
  /* дальнейшие криптографические действия применяются к новому экземпляру ключа */
   sections = ( ssize_t )( size/section_size );
   tail = ( ssize_t )( size - ( size_t )( sections*seclen )*nkey.bsize );
-  if( sections > 0 ) {
-    do{
-       switch( nkey.bsize ) { /* обрабатываем одну секцию */
-         case 8: for( j = 0; j < seclen; j++ ) acpkm_block64; break;
-         case 16: for( j = 0; j < seclen; j++ ) acpkm_block128; break;
-         default: ak_error_message( ak_error_wrong_block_cipher,
-                                           __func__ , "incorrect block size of block cipher key" );
+
+#ifdef AK_HAVE_PTHREAD_H
+ /* распределяем секции между потоками: каждый фрагмент, кроме последнего,
+    обрабатывается отдельным потоком на копии ключа своей первой секции */
+  if( nthreads == 0 ) nthreads = ak_bckey_get_threads_count( size );
+  nthreads = ak_min( ak_min( nthreads, ak_bckey_max_threads ), ( size_t )sections );
+  if(( nthreads > 1 ) &&
+     (( frs = calloc( nthreads - 1, sizeof( struct acpkm_fragment ))) != NULL )) {
+    per = sections/( ssize_t )nthreads;
+    for( idx = 0; idx < nthreads - 1; idx++ ) {
+       ak_acpkm_fragment fr = frs + idx;
+       if( ak_bckey_create_and_set_bckey( &fr->key, &nkey ) != ak_error_ok ) break;
+       memcpy( fr->ctr, ctr, sizeof( ctr ));
+       fr->in = inptr; fr->out = outptr;
+       fr->sections = per; fr->seclen = seclen;
+       if( pthread_create( &fr->thread, NULL, ak_bckey_acpkm_thread, fr ) != 0 ) {
+         ak_bckey_destroy( &fr->key );
+         break;
        }
-      /* вычисляем следующий ключ */
-       if(( error = ak_bckey_next_acpkm_key( &nkey )) != ak_error_ok ) {
-         ak_error_message_fmt( error, __func__, "incorrect key generation after %u sections",
-                                                                         (unsigned int) sections );
-         goto labex;
+       started++;
+
+      /* вычисляем ключ и счетчик для первой секции следующего фрагмента */
+       for( j = 0; j < per; j++ ) {
+          if(( error = ak_bckey_next_acpkm_key( &nkey )) != ak_error_ok ) {
+            ak_error_message( error, __func__, "incorrect generation of acpkm key sequence" );
+            goto labex;
+          }
        }
-    } while( --sections > 0 );
-  } /* конец обработки случая, когда sections > 0 */
+       ak_bckey_acpkm_ctr_add( &nkey, ctr, ( ak_uint64 )( per*seclen ));
+       inptr += per*seclen*(ssize_t)( nkey.bsize >> 3 );
+       outptr += per*seclen*(ssize_t)( nkey.bsize >> 3 );
+       sections -= per;
+    }
+  }
+#else
+  (void)nthreads;
+#endif
+
+ /* оставшиеся секции обрабатываем в текущем потоке */
+  if( sections > 0 ) {
+    if(( error = ak_bckey_acpkm_sections( &nkey, ctr,
+                                             inptr, outptr, sections, seclen )) != ak_error_ok ) {
+      ak_error_message( error, __func__, "incorrect encryption of data sections" );
+      goto labex;
+    }
+    inptr += sections*seclen*(ssize_t)( nkey.bsize >> 3 );
+    outptr += sections*seclen*(ssize_t)( nkey.bsize >> 3 );
+  }
 
   if( tail ) { /* теперь обрабатываем фрагмент данных, не кратный длине секции */
     if(( seclen = tail/(ssize_t)( nkey.bsize )) > 0 ) {
-       switch( nkey.bsize ) { /* обрабатываем данные, кратные длине блока */
-         case 8: for( j = 0; j < seclen; j++ ) acpkm_block64; break;
-         case 16: for( j = 0; j < seclen; j++ ) acpkm_block128; break;
-         default: ak_error_message( ak_error_wrong_block_cipher,
-                                            __func__ , "incorrect block size of block cipher key" );
-       }
+      /* обрабатываем данные, кратные длине блока */
+       ak_bckey_acpkm_gamma( &nkey, ctr, inptr, outptr, seclen );
+       inptr += seclen*(ssize_t)( nkey.bsize >> 3 ); outptr += seclen*(ssize_t)( nkey.bsize >> 3 );
     }
   /* остался последний фрагмент, длина которого меньше длины блока
                       в качестве гаммы мы используем старшие байты */
@@ -245,7 +401,18 @@
     }
   }
 
-  labex: ak_bckey_destroy( &nkey );
+  labex:
+#ifdef AK_HAVE_PTHREAD_H
+  if( frs != NULL ) {
+    for( idx = 0; idx < started; idx++ ) {
+       pthread_join( frs[idx].thread, NULL );
+       if(( frs[idx].error != ak_error_ok ) && ( error == ak_error_ok )) error = frs[idx].error;
+       ak_bckey_destroy( &frs[idx].key );
+    }
+    free( frs );
+  }
+#endif
+  ak_bckey_destroy( &nkey );
  return error;
 }
 
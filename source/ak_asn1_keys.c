@@ -45,6 +45,38 @@
 
 /* ----------------------------------------------------------------------------------------------- */
                   /* Функции выработки и сохранения производных ключей */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция создает ключи шифрования и имитозащиты из 64-х октетов производного
+    ключевого материала и уничтожает этот материал.
+
+    Ключ шифрования принимает значение первых 32-х октетов, ключ имитозащиты -- последних.     */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_create_key_pair_from_derived_key( ak_bckey ekey, ak_bckey ikey,
+                                                          ak_oid oid, ak_uint8 *derived_key )
+{
+  int error = ak_error_ok;
+
+   if(( error = ak_bckey_create_oid( ekey, oid )) != ak_error_ok )
+     return ak_error_message( error, __func__, "incorrect creation of encryption cipher key" );
+   if(( error = ak_bckey_set_key( ekey, derived_key, 32 )) != ak_error_ok ) {
+     ak_bckey_destroy( ekey );
+     return ak_error_message( error, __func__, "incorrect assigning a value to encryption key" );
+   }
+   if(( error = ak_bckey_create_oid( ikey, oid )) != ak_error_ok ) {
+     ak_bckey_destroy( ekey );
+     return ak_error_message( error, __func__, "incorrect creation of integrity key" );
+   }
+   if(( error = ak_bckey_set_key( ikey, derived_key+32, 32 )) != ak_error_ok ) {
+     ak_bckey_destroy( ikey );
+     ak_bckey_destroy( ekey );
+     return ak_error_message( error, __func__, "incorrect assigning a value to integrity key" );
+   }
+  /* очищаем использованную память */
+   ak_ptr_wipe( derived_key, 64, &ikey->key.generator );
+
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \param ekey контекст создаваемого ключа шифрования
     \param ikey контекст создаваемого ключа имитозащиты
@@ -83,25 +115,43 @@
       return ak_error_message( error, __func__, "incorrect creation of derived key" );
 
  /* 2. инициализируем контексты ключа шифрования контента и ключа имитозащиты */
-   if(( error = ak_bckey_create_oid( ekey, oid )) != ak_error_ok )
-     return ak_error_message( error, __func__, "incorrect creation of encryption cipher key" );
-   if(( error = ak_bckey_set_key( ekey, derived_key, 32 )) != ak_error_ok ) {
-     ak_bckey_destroy( ekey );
-     return ak_error_message( error, __func__, "incorrect assigning a value to encryption key" );
-   }
-   if(( error = ak_bckey_create_oid( ikey, oid )) != ak_error_ok ) {
-     ak_bckey_destroy( ekey );
-     return ak_error_message( error, __func__, "incorrect creation of integrity key" );
-   }
-   if(( error = ak_bckey_set_key( ikey, derived_key+32, 32 )) != ak_error_ok ) {
-     ak_bckey_destroy( ikey );
-     ak_bckey_destroy( ekey );
-     return ak_error_message( error, __func__, "incorrect assigning a value to integrity key" );
-   }
-  /* очищаем использованную память */
-   ak_ptr_wipe( derived_key, sizeof( derived_key ), &ikey->key.generator );
+ return ak_bckey_create_key_pair_from_derived_key( ekey, ikey, oid, derived_key );
+}
 
- return error;
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция аналогична функции ak_bckey_create_key_pair_from_password(), однако
+    для выработки производного ключевого материала использует алгоритм mhkdf
+    (см. ak_hmac_mhkdf_streebog512()).
+
+    \param ekey контекст создаваемого ключа шифрования
+    \param ikey контекст создаваемого ключа имитозащиты
+    \param oid идентификатор алгоритма блочного шифрования, для которого создается ключевая пара
+    \param password пароль
+    \param pass_size длина пароля (в октетах)
+    \param salt последовательность случайных чисел
+    \param salt_size длина последовательности случайных чисел (в октетах)
+    \param memory объем памяти алгоритма mhkdf (в килобайтах)
+    \param time количество проходов по памяти
+    \param lanes количество полос
+    \return Функция возвращает \ref ak_error_ok (ноль) в случае успеха, в случае неудачи
+   возвращается код ошибки.                                                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_create_key_pair_from_password_mhkdf( ak_bckey ekey, ak_bckey ikey, ak_oid oid,
+                 const char *password, const size_t pass_size, ak_uint8 *salt,
+                 const size_t salt_size, const size_t memory, const size_t time, const size_t lanes )
+{
+  int error = ak_error_ok;
+  ak_uint8 derived_key[64];
+
+  if( salt == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                               "using null pointer to salt value");
+  if( !salt_size ) return ak_error_message( ak_error_zero_length, __func__,
+                                                             "using zero length for salt buffer" );
+  if(( error = ak_hmac_mhkdf_streebog512( (ak_pointer) password, pass_size, salt, salt_size,
+                                memory, time, lanes, 64, derived_key )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect creation of derived key" );
+
+ return ak_bckey_create_key_pair_from_derived_key( ekey, ikey, oid, derived_key );
 }
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -120,6 +170,10 @@
  - `count` это значение опции `pbkdf2_iteration_count`,
  - константа 64 означает длину вырабатываемого ключа в октетах
 
+ Если значение опции `key_container_kdf` равно единице, то вместо PBKDF2 используется
+ алгоритм mhkdf (см. ak_hmac_mhkdf_streebog512()) c параметрами, определяемыми
+ опциями `mhkdf_memory_size`, `mhkdf_time_cost` и `mhkdf_parallelism`
+
  Далее, функция определяет производные ключи шифрования и имитозащиты равенствами
 
 \code
@@ -161,6 +215,20 @@
     }
 \endcode
 
+При использовании алгоритма mhkdf поле `method` принимает значение 1.2.643.2.52.1.127.2.4,
+а вместо структуры `PBKDF2Parameters` используется структура `MHKDFParameters`.
+
+\code
+    MHKDFParameters ::= SEQUENCE {
+      algorithmID OBJECT IDENTIFIER,   -- идентификатор алгоритма mhkdf-streebog512
+                                       -- (1.2.643.2.52.1.9.1)
+      salt OCTET STRING,               -- инициализационный вектор
+      memorySize INTEGER,              -- объем используемой памяти (в килобайтах)
+      timeCost INTEGER,                -- количество проходов по памяти
+      parallelism INTEGER              -- количество полос
+    }
+\endcode
+
  \param root уровень ASN.1 дерева, к которому добавляется структура BasicKeyMetaData
  \param oid идентификатор алгоритма блочного шифрования,
  для которого вырабатываются производные ключи шифрования и имитозащиты
@@ -179,16 +247,23 @@
   struct random generator; /* генератор ПДСЧ */
   int error = ak_error_ok;
   ak_asn1 asn1 = NULL, asn2 = NULL, asn3 = NULL;
+  size_t mhkdf = ( size_t ) ak_libakrypt_get_option_by_name( "key_container_kdf" ),
+         memory = ( size_t ) ak_libakrypt_get_option_by_name( "mhkdf_memory_size" ),
+         time = ( size_t ) ak_libakrypt_get_option_by_name( "mhkdf_time_cost" ),
+         lanes = ( size_t ) ak_libakrypt_get_option_by_name( "mhkdf_parallelism" );
 
   if(( error = ak_random_create_lcg(  &generator )) != ak_error_ok )
     return ak_error_message( error, __func__, "incorrect creation of random generator");
 
   memset( salt, 0, sizeof( salt ));
   ak_random_ptr( &generator, salt, sizeof( salt ));
+  ak_random_destroy( &generator );
 
-  if(( error = ak_bckey_create_key_pair_from_password( ekey, ikey, oid, password, pass_size,
-      salt, sizeof( salt ), (size_t) ak_libakrypt_get_option_by_name( "pbkdf2_iteration_count" )))
-                                                                                  != ak_error_ok )
+  if( mhkdf ) error = ak_bckey_create_key_pair_from_password_mhkdf( ekey, ikey, oid,
+                                       password, pass_size, salt, sizeof( salt ), memory, time, lanes );
+    else error = ak_bckey_create_key_pair_from_password( ekey, ikey, oid, password, pass_size,
+      salt, sizeof( salt ), (size_t) ak_libakrypt_get_option_by_name( "pbkdf2_iteration_count" ));
+  if( error != ak_error_ok )
     return ak_error_message( error, __func__, "incorrect creation of derived key pairs");
 
  /* собираем ASN.1 дерево - снизу вверх */
@@ -198,10 +273,18 @@
      return ak_error_message( error, __func__,
                                          "incorrect creation of PBKDF2Parameters asn1 structure" );
    }
-   ak_asn1_add_oid( asn3, ak_oid_find_by_name( "hmac-streebog512" )->id[0] );
-   ak_asn1_add_octet_string( asn3, salt, sizeof( salt ));
-   ak_asn1_add_uint32( asn3,
+   if( mhkdf ) {
+     ak_asn1_add_oid( asn3, ak_oid_find_by_name( "mhkdf-streebog512" )->id[0] );
+     ak_asn1_add_octet_string( asn3, salt, sizeof( salt ));
+     ak_asn1_add_uint32( asn3, ( ak_uint32 )memory );
+     ak_asn1_add_uint32( asn3, ( ak_uint32 )time );
+     ak_asn1_add_uint32( asn3, ( ak_uint32 )lanes );
+   } else {
+     ak_asn1_add_oid( asn3, ak_oid_find_by_name( "hmac-streebog512" )->id[0] );
+     ak_asn1_add_octet_string( asn3, salt, sizeof( salt ));
+     ak_asn1_add_uint32( asn3,
                          ( ak_uint32 )ak_libakrypt_get_option_by_name( "pbkdf2_iteration_count" ));
+   }
 
    if(( ak_asn1_create( asn2 = malloc( sizeof( struct asn1 )))) != ak_error_ok ) {
      ak_bckey_destroy( ikey );
@@ -220,7 +303,8 @@
      return ak_error_message( error, __func__,
                                          "incorrect creation of BasicKeyMetaData asn1 structure" );
    }
-   ak_asn1_add_oid( asn1, ak_oid_find_by_name( "pbkdf2-basic-key" )->id[0] );
+   ak_asn1_add_oid( asn1,
+             ak_oid_find_by_name( mhkdf ? "mhkdf-basic-key" : "pbkdf2-basic-key" )->id[0] );
    ak_asn1_add_asn1( asn1, TSEQUENCE, asn2 );
 
   /* помещаем в основное ASN.1 дерево структуру BasicKeyMetaData */
@@ -243,8 +327,9 @@
 /* ----------------------------------------------------------------------------------------------- */
  static int ak_asn1_get_derived_keys( ak_asn1 akey, ak_bckey ekey, ak_bckey ikey )
 {
-  size_t size = 0;
-  ak_uint32 u32 = 0;
+  size_t size = 0, idx = 0;
+  ak_uint32 u32[3] = { 0, 0, 0 };
+  bool_t mhkdf = ak_false;
   ak_asn1 asn = NULL;
   char password[256];
   ak_pointer ptr = NULL;
@@ -259,10 +344,14 @@
   if(( DATA_STRUCTURE( akey->current->tag ) != PRIMITIVE ) ||
      ( TAG_NUMBER( akey->current->tag ) != TOBJECT_IDENTIFIER )) return ak_error_invalid_asn1_tag;
   ak_tlv_get_oid( akey->current, &ptr );
-  oid = ak_oid_find_by_name( "pbkdf2-basic-key" );
-  if( strncmp( oid->id[0], ptr, strlen( oid->id[0] )) != 0 )
-    return ak_error_invalid_asn1_content;
-   /* в дальнейшем, здесь вместо if должен появиться switch,
+  oid = ak_oid_find_by_name( "mhkdf-basic-key" );
+  if( strncmp( oid->id[0], ptr, strlen( oid->id[0] )) == 0 ) mhkdf = ak_true;
+   else {
+     oid = ak_oid_find_by_name( "pbkdf2-basic-key" );
+     if( strncmp( oid->id[0], ptr, strlen( oid->id[0] )) != 0 )
+       return ak_error_invalid_asn1_content;
+   }
+   /* в дальнейшем, здесь должен появиться switch,
       который разделяет все три возможных способа генерации производных ключей
       сейчас поддерживается только способ генерации из пароля */
 
@@ -292,27 +381,46 @@
   if(( DATA_STRUCTURE( asn->current->tag ) != PRIMITIVE ) ||
      ( TAG_NUMBER( asn->current->tag ) != TOBJECT_IDENTIFIER )) return ak_error_invalid_asn1_tag;
   ak_tlv_get_oid( asn->current, &ptr );
-  oid = ak_oid_find_by_name( "hmac-streebog512" );
+  oid = ak_oid_find_by_name( mhkdf ? "mhkdf-streebog512" : "hmac-streebog512" );
   if( strncmp( oid->id[0], ptr, strlen( oid->id[0] )) != 0 )
     return ak_error_invalid_asn1_content;
+  if( asn->count != ( mhkdf ? 5 : 3 )) return ak_error_invalid_asn1_count;
 
   ak_asn1_next( asn );
   if(( DATA_STRUCTURE( asn->current->tag ) != PRIMITIVE ) ||
      ( TAG_NUMBER( asn->current->tag ) != TOCTET_STRING )) return ak_error_invalid_asn1_tag;
   ak_tlv_get_octet_string( asn->current, &ptr, &size ); /* инициализационный вектор */
 
-  ak_asn1_next( asn );
-  if(( DATA_STRUCTURE( asn->current->tag ) != PRIMITIVE ) ||
-     ( TAG_NUMBER( asn->current->tag ) != TINTEGER )) return ak_error_invalid_asn1_tag;
-  ak_tlv_get_uint32( asn->current, &u32 ); /* число циклов */
+ /* число циклов (для mhkdf - объем памяти, количество проходов и количество полос) */
+  for( idx = 0; idx < ( mhkdf ? 3 : 1 ); idx++ ) {
+     ak_asn1_next( asn );
+     if(( DATA_STRUCTURE( asn->current->tag ) != PRIMITIVE ) ||
+        ( TAG_NUMBER( asn->current->tag ) != TINTEGER )) return ak_error_invalid_asn1_tag;
+     ak_tlv_get_uint32( asn->current, u32+idx );
+  }
+
+ /* параметры алгоритма mhkdf считываются из контейнера и должны лежать в допустимых границах */
+  if( mhkdf ) {
+    if( !ak_libakrypt_check_option_bounds( "mhkdf_memory_size", u32[0] ))
+      return ak_error_message_fmt( ak_error_invalid_asn1_content, __func__,
+                                          "unsupported mhkdf memory size (%u)", (unsigned int)u32[0] );
+    if( !ak_libakrypt_check_option_bounds( "mhkdf_time_cost", u32[1] ))
+      return ak_error_message_fmt( ak_error_invalid_asn1_content, __func__,
+                                            "unsupported mhkdf time cost (%u)", (unsigned int)u32[1] );
+    if( !ak_libakrypt_check_option_bounds( "mhkdf_parallelism", u32[2] ))
+      return ak_error_message_fmt( ak_error_invalid_asn1_content, __func__,
+                                 "unsupported mhkdf number of lanes (%u)", (unsigned int)u32[2] );
+  }
 
  /* вырабатываем производную ключевую информацию */
   if(( error = ak_function_default_password_read( password, sizeof( password ))) != ak_error_ok )
     return ak_error_message( error, __func__, "incorrect password reading" );
 
  /* 1. получаем пользовательский пароль и вырабатываем производную ключевую информацию */
-   error = ak_bckey_create_key_pair_from_password( ekey, ikey, eoid,
-                                                password, strlen( password ), ptr, size, u32 );
+   if( mhkdf ) error = ak_bckey_create_key_pair_from_password_mhkdf( ekey, ikey, eoid,
+                           password, strlen( password ), ptr, size, u32[0], u32[1], u32[2] );
+     else error = ak_bckey_create_key_pair_from_password( ekey, ikey, eoid,
+                                             password, strlen( password ), ptr, size, u32[0] );
    memset( password, 0, sizeof( password ));
 
  return error;
@@ -1093,7 +1201,7 @@
    ak_mpzn_set_little_endian( (ak_uint64 *)(skey->key),
                                               (skey->key_size >>2), ptr+ivsize, keysize, ak_true );
   /* меняем значение флага */
-   skey->flags |= ak_key_flag_set_mask;
+   skey->flags = ( skey->flags&( ~ak_key_flag_precomputed ))|ak_key_flag_set_mask;
 
   /* вычисляем контрольную сумму */
    if(( error = skey->set_icode( skey )) != ak_error_ok ) return ak_error_message( error,
@@ -1328,7 +1436,10 @@
   lab1:
    if( error != ak_error_ok ) {
     /* удаляем объект */
-     if( engine == undefined_engine ) ak_oid_delete_object( ((ak_skey)*key)->oid, *key );
+     if( engine == undefined_engine ) {
+       ak_oid_delete_object( ((ak_skey)*key)->oid, *key );
+       *key = NULL;
+     }
    }
 
  return error;
@@ -4,7 +4,22 @@
 /*  Файл ak_bckey.c                                                                                */
 /*  - содержит реализацию общих функций для алгоритмов блочного шифрования.                        */
 /* ----------------------------------------------------------------------------------------------- */
- #include <libakrypt.h>
+ #include <libakrypt-internal.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef AK_HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество блоков, обрабатываемых за один вызов многоблочного метода шифрования
+    при реализации режимов с зацеплением. */
+ #define ak_bckey_fragment_blocks  (64)
+/*! \brief Минимальный объем данных (в байтах), обрабатываемых одним потоком. */
+ #define ak_bckey_thread_min_size  (262144)
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция устанавливает параметры алгоритма блочного шифрования, передаваемые в качестве
@@ -13,6 +28,7 @@
 
     - bkey.encrypt -- алгоритм зашифрования одного блока
     - bkey.decrypt -- алгоритм расшифрования одного блока
+    - bkey.encrypt_blocks -- алгоритм зашифрования нескольких независимых блоков (необязателен)
     - bkey.shedule_keys -- алгоритм развертки ключа и генерации раундовых ключей
     - bkey.delete_keys -- функция удаления раундовых ключей
 
@@ -52,6 +68,8 @@
   bkey->ivector_size =  0;
   bkey->encrypt =       NULL;
   bkey->decrypt =       NULL;
+  bkey->encrypt_blocks = NULL;
+  bkey->decrypt_blocks = NULL;
   bkey->schedule_keys = NULL;
   bkey->delete_keys =   NULL;
 
@@ -86,6 +104,8 @@
   bkey->bsize =            0;
   bkey->encrypt =       NULL;
   bkey->decrypt =       NULL;
+  bkey->encrypt_blocks = NULL;
+  bkey->decrypt_blocks = NULL;
   bkey->schedule_keys = NULL;
   bkey->delete_keys =   NULL;
 
@@ -330,10 +350,22 @@
     ak_error_message( error, __func__, "incorrect unmasking block cipher context" );
     goto  labex;
   }
-  if(( error = ak_bckey_set_key( bkey, rkey->key.key, rkey->key.key_size )) != ak_error_ok ) {
+  if(( ak_libakrypt_get_option_by_name( "openssl_compability" ) == 1 ) &&
+                                        ( strncmp( rkey->key.oid->name[0], "magma", 5 ) == 0 )) {
+   /* ключ алгоритма Магма хранится в перевернутом виде, а функция ak_bckey_set_key()
+      переворачивает его еще раз, поэтому передаем ей исходное значение ключа */
+    size_t i = 0;
+    ak_uint8 revkey[32];
+
+    for( i = 0; i < 32; i++ ) revkey[i] = rkey->key.key[31-i];
+    error = ak_bckey_set_key( bkey, revkey, sizeof( revkey ));
+    ak_ptr_wipe( revkey, sizeof( revkey ), &rkey->key.generator );
+  } else error = ak_bckey_set_key( bkey, rkey->key.key, rkey->key.key_size );
+  rkey->key.set_mask( &rkey->key );
+  if( error != ak_error_ok ) {
     ak_error_message( error, __func__, "incorrect assigning a new key value" );
+    goto labex;
   }
-  rkey->key.set_mask( &rkey->key );
 
  return error;
 
@@ -342,6 +374,309 @@
  return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вызывает метод bkey->encrypt_blocks, если он определен для данного алгоритма
+    блочного шифрования. В противном случае блоки зашифровываются последовательно
+    с помощью метода bkey->encrypt.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на последовательность зашифровываемых блоков.
+    @param out Указатель на область памяти, куда помещаются зашифрованные блоки
+    (этот указатель может совпадать с in).
+    @param blocks Количество блоков.                                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_bckey_encrypt_blocks( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint8 *inptr = (ak_uint8 *)in, *outptr = (ak_uint8 *)out;
+
+  if( bkey->encrypt_blocks != NULL ) {
+    bkey->encrypt_blocks( &bkey->key, in, out, blocks );
+    return;
+  }
+  while( blocks-- > 0 ) {
+    bkey->encrypt( &bkey->key, inptr, outptr );
+    inptr += bkey->bsize; outptr += bkey->bsize;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вызывает метод bkey->decrypt_blocks, если он определен для данного алгоритма
+    блочного шифрования. В противном случае блоки расшифровываются последовательно
+    с помощью метода bkey->decrypt.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на последовательность расшифровываемых блоков.
+    @param out Указатель на область памяти, куда помещаются расшифрованные блоки
+    (этот указатель может совпадать с in).
+    @param blocks Количество блоков.                                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_bckey_decrypt_blocks( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_uint8 *inptr = (ak_uint8 *)in, *outptr = (ak_uint8 *)out;
+
+  if( bkey->decrypt_blocks != NULL ) {
+    bkey->decrypt_blocks( &bkey->key, in, out, blocks );
+    return;
+  }
+  while( blocks-- > 0 ) {
+    bkey->decrypt( &bkey->key, inptr, outptr );
+    inptr += bkey->bsize; outptr += bkey->bsize;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                 функции для многопоточной обработки последовательностей блоков                  */
+/* ----------------------------------------------------------------------------------------------- */
+/*! Количество потоков определяется опцией библиотеки `block_cipher_threads`: нулевое значение
+    опции означает использование всех доступных процессоров. При этом на каждый поток приходится
+    не менее 256 Кб данных. Если библиотека собрана без поддержки pthreads, функция всегда
+    возвращает единицу.
+
+    @param size Объем обрабатываемых данных (в байтах).
+    @return Количество потоков, которые целесообразно использовать для обработки данных.           */
+/* ----------------------------------------------------------------------------------------------- */
+ size_t ak_bckey_get_threads_count( size_t size )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  size_t count = ( size_t ) ak_libakrypt_get_option_by_name( "block_cipher_threads" );
+
+  if( count == 0 ) {
+   #if defined( AK_HAVE_UNISTD_H ) && defined( _SC_NPROCESSORS_ONLN )
+    long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+    count = ( cpus > 0 ) ? ( size_t ) cpus : 1;
+   #else
+    count = 1;
+   #endif
+  }
+  count = ak_min( count, size/ak_bckey_thread_min_size );
+ return ak_max( 1, ak_min( count, ak_bckey_max_threads ));
+#else
+  (void)size;
+ return 1;
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция рассматривает последовательность блоков \f$ S = R \| in \f$, где регистр \f$ R \f$
+    содержит z блоков, и помещает в result блоки \f$ S_{index}, \ldots, S_{index+z-1} \f$.
+    Эти значения образуют начальное состояние регистра для фрагмента данных, начинающегося
+    с блока с номером index, в режимах простой замены с зацеплением и гаммирования
+    с обратной связью по шифртексту.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param reg Начальное значение регистра (z блоков).
+    @param z Количество блоков в регистре.
+    @param in Указатель на последовательность блоков шифртекста.
+    @param index Номер блока, с которого начинается фрагмент данных.
+    @param result Область памяти, куда помещается значение регистра (z блоков).                    */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_bckey_chain_seek( ak_bckey bkey, ak_uint8 *reg, size_t z,
+                                                  ak_uint8 *in, size_t index, ak_uint8 *result )
+{
+  size_t count = 0;
+
+  if( index < z ) {
+    memcpy( result, reg + index*bkey->bsize, count = ( z - index )*bkey->bsize );
+    memcpy( result + count, in, index*bkey->bsize );
+  } else memcpy( result, in + ( index - z )*bkey->bsize, z*bkey->bsize );
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Контекст потока, обрабатывающего фрагмент последовательности блоков. */
+ typedef struct bckey_fragment {
+  /*! \brief Копия ключа, используемая потоком. */
+   struct bckey key;
+  /*! \brief Функция обработки фрагмента. */
+   ak_function_bckey_fragment *fragment;
+  /*! \brief Указатель на входные данные фрагмента. */
+   ak_uint8 *in;
+  /*! \brief Указатель на выходные данные фрагмента. */
+   ak_uint8 *out;
+  /*! \brief Количество блоков во фрагменте. */
+   size_t blocks;
+  /*! \brief Начальное значение регистра для фрагмента. */
+   ak_uint8 reg[64];
+  /*! \brief Количество блоков в регистре. */
+   size_t z;
+  /*! \brief Дескриптор потока. */
+   pthread_t thread;
+ } *ak_bckey_fragment;
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_bckey_fragment_thread( void *ptr )
+{
+  ak_bckey_fragment fr = ( ak_bckey_fragment ) ptr;
+  fr->fragment( &fr->key, fr->in, fr->out, fr->blocks, fr->reg, fr->z );
+ return NULL;
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция разбивает последовательность блоков на nthreads непрерывных фрагментов и
+    обрабатывает их одновременно. Начальное значение регистра для каждого фрагмента
+    вычисляется функцией seek до запуска потоков, поэтому входные и выходные данные
+    могут совпадать. Каждый дополнительный поток использует собственную копию ключа,
+    первый фрагмент обрабатывается вызывающим потоком с исходным ключом.
+    Ресурс ключа функцией не изменяется и должен быть уменьшен вызывающей стороной.
+
+    Если библиотека собрана без поддержки pthreads, создать копию ключа не удалось или
+    ключ используется несколькими потоками (установлен флаг \ref ak_key_flag_shared),
+    данные обрабатываются последовательно.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param fragment Функция последовательной обработки фрагмента.
+    @param seek Функция вычисления значения регистра для блока с заданным номером.
+    @param in Указатель на входные данные.
+    @param out Указатель на область памяти для выходных данных.
+    @param blocks Количество обрабатываемых блоков.
+    @param reg Значение регистра; после обработки данных содержит значение регистра,
+    соответствующее блоку, следующему за последним обработанным.
+    @param z Количество блоков в регистре (не более 64 байт).
+    @param nthreads Количество потоков.                                                            */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_bckey_process_fragments( ak_bckey bkey, ak_function_bckey_fragment *fragment,
+                        ak_function_bckey_fragment_seek *seek, ak_uint8 *in, ak_uint8 *out,
+                                     size_t blocks, ak_uint8 *reg, size_t z, size_t nthreads )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  ak_uint8 last[64];
+  ak_bckey_fragment frs = NULL;
+  size_t i, count, start, done = 1;
+
+  nthreads = ak_min( nthreads, ak_bckey_max_threads );
+  if(( nthreads < 2 ) || ( blocks < 2*nthreads ) || ( bkey->key.flags&ak_key_flag_shared ) ||
+     (( frs = calloc( nthreads, sizeof( struct bckey_fragment ))) == NULL )) {
+    fragment( bkey, in, out, blocks, reg, z );
+    return;
+  }
+
+ /* определяем границы фрагментов и начальные значения регистров */
+  count = blocks/nthreads;
+  for( i = 0, start = 0; i < nthreads; i++, start += count ) {
+     frs[i].fragment = fragment;
+     frs[i].in = in + start*bkey->bsize;
+     frs[i].out = out + start*bkey->bsize;
+     frs[i].blocks = ( i == nthreads - 1 ) ? blocks - start : count;
+     frs[i].z = z;
+     seek( bkey, reg, z, in, start, frs[i].reg );
+  }
+  seek( bkey, reg, z, in, blocks, last );
+
+ /* запускаем потоки, обрабатывающие все фрагменты, кроме первого */
+  for( i = 1; i < nthreads; i++, done++ ) {
+     if( ak_bckey_create_and_set_bckey( &frs[i].key, bkey ) != ak_error_ok ) break;
+     if( pthread_create( &frs[i].thread, NULL, ak_bckey_fragment_thread, frs+i ) != 0 ) {
+       ak_bckey_destroy( &frs[i].key );
+       break;
+     }
+  }
+ /* первый фрагмент, а также фрагменты, для которых не удалось создать поток,
+    обрабатываем в текущем потоке */
+  fragment( bkey, frs[0].in, frs[0].out, frs[0].blocks, frs[0].reg, z );
+  for( i = done; i < nthreads; i++ )
+     fragment( bkey, frs[i].in, frs[i].out, frs[i].blocks, frs[i].reg, z );
+
+  for( i = 1; i < done; i++ ) {
+     pthread_join( frs[i].thread, NULL );
+     ak_bckey_destroy( &frs[i].key );
+  }
+  memcpy( reg, last, z*bkey->bsize );
+
+  ak_ptr_wipe( frs, nthreads*sizeof( struct bckey_fragment ), &bkey->key.generator );
+  ak_ptr_wipe( last, sizeof( last ), &bkey->key.generator );
+  free( frs );
+#else
+  (void)seek;
+  (void)nthreads;
+  fragment( bkey, in, out, blocks, reg, z );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление блоков \f$ out = a \oplus b \f$. */
+ static inline void ak_bckey_xor_blocks( ak_bckey bkey, ak_uint8 *out,
+                                                     ak_uint8 *a, ak_uint8 *b, size_t blocks )
+{
+  size_t i, words = ( blocks*bkey->bsize ) >> 3;
+  for( i = 0; i < words; i++ )
+     (( ak_uint64 *)out)[i] = (( ak_uint64 *)a)[i]^(( ak_uint64 *)b)[i];
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция расшифровывает фрагмент данных в режиме простой замены с зацеплением.
+    Расшифрование каждого блока зависит только от шифртекста, поэтому блоки расшифровываются
+    группами с помощью многоблочного метода ключа, после чего на них накладываются
+    значения регистра. Наложение выполняется от последнего блока группы к первому,
+    что позволяет входным и выходным данным совпадать.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на шифртекст.
+    @param out Указатель на область памяти для открытого текста (может совпадать с in).
+    @param blocks Количество блоков.
+    @param reg Значение регистра (z блоков); после расшифрования содержит последние z
+    блоков шифртекста.
+    @param z Количество блоков в регистре.                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_decrypt_cbc_fragment( ak_bckey bkey, ak_uint8 *in, ak_uint8 *out,
+                                                          size_t blocks, ak_uint8 *reg, size_t z )
+{
+  size_t j, count;
+  const size_t bs = bkey->bsize;
+  ak_uint64 buffer[ak_bckey_fragment_blocks*2], next[8];
+
+  while( blocks > 0 ) {
+    count = ak_min( blocks, ak_bckey_fragment_blocks );
+    ak_bckey_decrypt_blocks( bkey, in, buffer, count );
+    ak_bckey_chain_seek( bkey, reg, z, in, count, ( ak_uint8 *)next );
+
+    for( j = count; j > z; j-- ) /* блоки, зацепленные с шифртекстом текущей группы */
+       ak_bckey_xor_blocks( bkey, out + ( j-1 )*bs,
+                                  ( ak_uint8 *)buffer + ( j-1 )*bs, in + ( j-1-z )*bs, 1 );
+    ak_bckey_xor_blocks( bkey, out, ( ak_uint8 *)buffer, reg, ak_min( count, z ));
+
+    memcpy( reg, next, z*bs );
+    in += count*bs; out += count*bs; blocks -= count;
+  }
+  ak_ptr_wipe( buffer, sizeof( buffer ), &bkey->key.generator );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция расшифровывает фрагмент данных в режиме гаммирования с обратной связью
+    по шифртексту. Значения, подаваемые на вход алгоритма блочного шифрования, являются
+    блоками шифртекста (или регистра), поэтому гамма для группы блоков вырабатывается
+    одним вызовом многоблочного метода ключа.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на шифртекст.
+    @param out Указатель на область памяти для открытого текста (может совпадать с in).
+    @param blocks Количество блоков.
+    @param reg Значение регистра (z блоков); после расшифрования содержит последние z
+    блоков шифртекста.
+    @param z Количество блоков в регистре.                                                         */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_decrypt_cfb_fragment( ak_bckey bkey, ak_uint8 *in, ak_uint8 *out,
+                                                          size_t blocks, ak_uint8 *reg, size_t z )
+{
+  size_t count;
+  const size_t bs = bkey->bsize;
+  ak_uint64 buffer[ak_bckey_fragment_blocks*2], next[8];
+
+  while( blocks > 0 ) {
+    count = ak_min( blocks, ak_bckey_fragment_blocks );
+    memcpy( buffer, reg, ak_min( count, z )*bs );
+    if( count > z ) memcpy(( ak_uint8 *)buffer + z*bs, in, ( count - z )*bs );
+    ak_bckey_encrypt_blocks( bkey, buffer, buffer, count );
+    ak_bckey_chain_seek( bkey, reg, z, in, count, ( ak_uint8 *)next );
+
+    ak_bckey_xor_blocks( bkey, out, in, ( ak_uint8 *)buffer, count );
+
+    memcpy( reg, next, z*bs );
+    in += count*bs; out += count*bs; blocks -= count;
+  }
+  ak_ptr_wipe( buffer, sizeof( buffer ), &bkey->key.generator );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*                             теперь реализация режимов шифрования                                */
 /* ----------------------------------------------------------------------------------------------- */
@@ -359,7 +694,6 @@
 {
   size_t blocks = 0;
   int error = ak_error_ok;
-  ak_uint64 *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
 
  /* выполняем проверку размера входных данных */
   if( size%bkey->bsize != 0 )
@@ -367,35 +701,27 @@
                             __func__ , "the length of input data is not divided by block length" );
 
  /* проверяем целостность ключа */
-  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+  if( ak_skey_check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode,
                                         __func__, "incorrect integrity code of secret key value" );
  /* уменьшаем значение ресурса ключа */
   blocks = size/bkey->bsize;
-  if( bkey->key.resource.value.counter < (ssize_t)blocks )
+  if( ak_skey_reserve_resource( &bkey->key, ( ssize_t )blocks ) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource,
                                                    __func__ , "low resource of block cipher key" );
-   else bkey->key.resource.value.counter -= blocks;
 
- /* теперь приступаем к зашифрованию данных */
+ /* теперь приступаем к зашифрованию данных:
+    блоки независимы, поэтому обрабатываем их все за один вызов */
   switch( bkey->bsize ) {
     case  8: /* шифр с длиной блока 64 бита */
-      do {
-        bkey->encrypt( &bkey->key, inptr++, outptr++ );
-      } while( --blocks > 0 );
-    break;
-
     case 16: /* шифр с длиной блока 128 бит */
-      do {
-        bkey->encrypt( &bkey->key, inptr, outptr );
-        inptr+=2; outptr+=2;
-      } while( --blocks > 0 );
+      ak_bckey_encrypt_blocks( bkey, in, out, blocks );
     break;
     default: return ak_error_message( ak_error_wrong_block_cipher,
                                           __func__ , "incorrect block size of block cipher key" );
   }
  /* перемаскируем ключ */
-  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+  if(( error = ak_skey_remask( &bkey->key, size )) != ak_error_ok )
     ak_error_message( error, __func__ , "wrong remasking of secret key" );
 
  return ak_error_ok;
@@ -416,7 +742,6 @@
 {
   size_t blocks = 0;
   int error = ak_error_ok;
-  ak_uint64 *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
 
  /* выполняем проверку размера входных данных */
   if( size%bkey->bsize != 0 )
@@ -424,40 +749,114 @@
                             __func__ , "the length of input data is not divided by block length" );
 
  /* проверяем целостность ключа */
-  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+  if( ak_skey_check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode,
                                         __func__, "incorrect integrity code of secret key value" );
  /* уменьшаем значение ресурса ключа */
   blocks = size/bkey->bsize;
-  if( bkey->key.resource.value.counter < (ssize_t) blocks )
+  if( ak_skey_reserve_resource( &bkey->key, ( ssize_t )blocks ) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource,
                                                    __func__ , "low resource of block cipher key" );
-   else bkey->key.resource.value.counter -= blocks;
 
- /* теперь приступаем к расшифрованию данных */
+ /* теперь приступаем к расшифрованию данных:
+    блоки независимы, поэтому обрабатываем их все за один вызов */
   switch( bkey->bsize ) {
     case  8: /* шифр с длиной блока 64 бита */
-      do {
-        bkey->decrypt( &bkey->key, inptr++, outptr++ );
-      } while( --blocks > 0 );
-    break;
-
     case 16: /* шифр с длиной блока 128 бит */
-      do {
-        bkey->decrypt( &bkey->key, inptr, outptr );
-        inptr+=2; outptr+=2;
-      } while( --blocks > 0 );
+      ak_bckey_decrypt_blocks( bkey, in, out, blocks );
     break;
     default: return ak_error_message( ak_error_wrong_block_cipher,
                                           __func__ , "incorrect block size of block cipher key" );
   }
  /* перемаскируем ключ */
-  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+  if(( error = ak_skey_remask( &bkey->key, size )) != ak_error_ok )
     ak_error_message( error, __func__ , "wrong remasking of secret key" );
 
  return ak_error_ok;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование 64-х битного слова счетчика режима гаммирования из представления,
+    хранящегося в памяти, в целое число и обратно (в режиме совместимости с openssl
+    счетчик хранится в формате big endian). */
+#ifdef AK_LITTLE_ENDIAN
+ #define ak_bckey_ctr_value( v, oc ) (( oc ) ? bswap_64( v ) : ( v ))
+#else
+ #define ak_bckey_ctr_value( v, oc ) (( oc ) ? ( v ) : bswap_64( v ))
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция гаммирует фрагмент данных в режиме гаммирования из ГОСТ Р 34.13-2015.
+    Последовательные значения счетчика формируются группами и зашифровываются за один вызов
+    функции ak_bckey_encrypt_blocks().
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на входные данные.
+    @param out Указатель на выходные данные (может совпадать с in).
+    @param blocks Количество блоков.
+    @param reg Значение счетчика (один блок); после обработки содержит значение счетчика
+    для следующего блока.
+    @param z Не используется.                                                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_ctr_fragment( ak_bckey bkey, ak_uint8 *in, ak_uint8 *out,
+                                                          size_t blocks, ak_uint8 *reg, size_t z )
+{
+  size_t j, count, words = bkey->bsize >> 3;
+  int oc = (int) ak_libakrypt_get_option_by_name( "openssl_compability" );
+  ak_uint64 x, cbuf[128], gbuf[128], *ctr = ( ak_uint64 *)reg,
+                                         *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+ /* для Магмы счетчик занимает весь блок, для Кузнечика - одну из его половин
+    (старшую или младшую, в зависимости от режима совместимости с openssl) */
+  size_t w = ( words == 2 ) ? ( size_t )oc : 0;
+
+  (void)z;
+  x = ak_bckey_ctr_value( ctr[w], oc );
+  while( blocks > 0 ) {
+   /* формируем несколько последовательных значений счетчика и зашифровываем их за один вызов */
+    count = ak_min( blocks, sizeof( cbuf )/bkey->bsize );
+    if( words == 1 ) {
+      for( j = 0; j < count; j++ ) {
+         cbuf[j] = ctr[0];
+         ctr[0] = ak_bckey_ctr_value( ++x, oc );
+      }
+    } else {
+       for( j = 0; j < count; j++ ) {
+          cbuf[2*j] = ctr[0];
+          cbuf[2*j+1] = ctr[1];
+          ctr[w] = ak_bckey_ctr_value( ++x, oc ); /* здесь мы не учитываем знак переноса
+                                      потому что объем данных на одном ключе не должен
+                                      превышать 2^64 блоков (контролируется через ресурс ключа) */
+       }
+      }
+    ak_bckey_encrypt_blocks( bkey, cbuf, gbuf, count );
+    for( j = 0; j < words*count; j++ ) outptr[j] = inptr[j] ^ gbuf[j];
+    outptr += words*count; inptr += words*count;
+    blocks -= count;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет значение счетчика режима гаммирования для блока с номером index.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param reg Начальное значение счетчика.
+    @param z Не используется.
+    @param in Не используется.
+    @param index Номер блока.
+    @param result Область памяти, куда помещается значение счетчика (один блок).                   */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_bckey_ctr_seek( ak_bckey bkey, ak_uint8 *reg, size_t z,
+                                                  ak_uint8 *in, size_t index, ak_uint8 *result )
+{
+  int oc = (int) ak_libakrypt_get_option_by_name( "openssl_compability" );
+  size_t w = ( bkey->bsize == 16 ) ? ( size_t )oc : 0;
+
+  (void)z; (void)in;
+  memcpy( result, reg, bkey->bsize );
+  (( ak_uint64 *)result)[w] =
+            ak_bckey_ctr_value( ak_bckey_ctr_value( (( ak_uint64 *)reg)[w], oc ) + index, oc );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Поскольку в режиме гаммирования операцией шифрования является сложение открытого текста по
     модулю два с последовательностью, вырабатываемой блочным шифром из заданной синхропосылки,
@@ -510,10 +909,40 @@
 /* ----------------------------------------------------------------------------------------------- */
  int ak_bckey_ctr( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
                                                                      ak_pointer iv, size_t iv_size )
+{
+  return ak_bckey_ctr_parallel( bkey, in, out, size, iv, iv_size, 1 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция реализует режим гаммирования, описанный в ak_bckey_ctr(), и дает тот же самый
+    результат. Поскольку значение счетчика для блока с номером \f$ i \f$ равно \f$ iv + i \f$,
+    данные разбиваются на nthreads непрерывных фрагментов, для каждого из которых
+    вычисляется начальное значение счетчика, после чего фрагменты зашифровываются одновременно
+    на копиях ключа. Ресурс ключа уменьшается один раз, в вызывающем потоке, до начала
+    шифрования.
+
+    Вызов функции с нулевым указателем на синхропосылку продолжает шифрование
+    на внутреннем значении счетчика, как и в случае функции ak_bckey_ctr().
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на область памяти, где хранятся входные (открытые) данные.
+    @param out Указатель на область памяти, куда помещаются зашифрованные данные
+    (этот указатель может совпадать с `in`).
+    @param size Размер зашировываемых данных (в байтах).
+    @param iv Указатель на синхропосылку.
+    @param iv_size Длина синхропосылки в байтах.
+    @param nthreads Количество потоков; при нулевом значении количество потоков
+    определяется опцией `block_cipher_threads` и объемом данных.
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_ctr_parallel( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
+                                                 ak_pointer iv, size_t iv_size, size_t nthreads )
 {
   ak_int64 blocks = (ak_int64)( size/bkey->bsize ),
              tail = (ak_int64)( size%bkey->bsize );
-  ak_uint64 x, yaout[2], *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
+  ak_uint64 yaout[2], *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
   int error = ak_error_ok, oc = (int) ak_libakrypt_get_option_by_name( "openssl_compability" );
 
   if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
@@ -524,14 +953,13 @@
                                     __func__, "using secret key context with undefined key value" );
 
  /* проверяем целостность ключа */
-  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+  if( ak_skey_check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode, __func__,
                                                    "incorrect integrity code of secret key value" );
  /* уменьшаем значение ресурса ключа */
-  if( bkey->key.resource.value.counter < ( blocks + ( tail > 0 )))
+  if( ak_skey_reserve_resource( &bkey->key, blocks + ( tail > 0 )) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource,
                                                     __func__ , "low resource of block cipher key" );
-   else bkey->key.resource.value.counter -= ( blocks + ( tail > 0 ));
 
  /* выбираем, как вычислять синхропосылку проверяем флаг
     флаг поднимается при вызове функции с заданным значением синхропосылки и
@@ -563,47 +991,12 @@
  /* обработка основного массива данных (кратного длине блока) */
   switch( bkey->bsize ) {
     case  8: /* шифр с длиной блока 64 бита (Магма) */
-      while( blocks > 0 ) {
-        #ifndef AK_LITTLE_ENDIAN
-          x = oc ? ((ak_uint64 *)bkey->ivector)[0] : bswap_64( ((ak_uint64 *)bkey->ivector)[0] );
-        #else
-          x = oc ? bswap_64( ((ak_uint64 *)bkey->ivector)[0] ) : ((ak_uint64 *)bkey->ivector)[0];
-        #endif
-          bkey->encrypt( &bkey->key, bkey->ivector, yaout );
-          *outptr = *inptr ^ yaout[0];
-          outptr++; inptr++;
-
-        #ifndef AK_LITTLE_ENDIAN
-          ((ak_uint64 *)bkey->ivector)[0] = oc ? ++x : bswap_64( ++x );
-        #else
-          ((ak_uint64 *)bkey->ivector)[0] = oc ? bswap_64( ++x ) : ++x;
-        #endif
-        --blocks;
-      }
-    break;
-
     case 16: /* шифр с длиной блока 128 бит (Кузнечик) */
-     #ifndef AK_LITTLE_ENDIAN
-      x = bswap_64( ((ak_uint64 *)bkey->ivector)[oc] );
-     #else
-      x = ((ak_uint64 *)bkey->ivector)[oc];
-     #endif
-
-      while( blocks > 0 ) {
-          bkey->encrypt( &bkey->key, bkey->ivector, yaout );
-          *outptr = *inptr ^ yaout[0]; outptr++; inptr++;
-          *outptr = *inptr ^ yaout[1]; outptr++; inptr++;
-
-       /* за элементарное сложение с единицей приходится платить одним разворотом */
-        #ifdef AK_LITTLE_ENDIAN
-         ((ak_uint64 *)bkey->ivector)[oc] = oc ? bswap_64(++x) : ++x;
-        #else
-          ((ak_uint64 *)bkey->ivector)[oc] = oc ? ++x : bswap_64( ++x );
-        #endif                    /* здесь мы не учитываем знак переноса
-                                     потому что объем данных на одном ключе не должен
-                                     превышать 2^64 блоков (контролируется через ресурс ключа) */
-        --blocks;
-      }
+      if( nthreads == 0 ) nthreads = ak_bckey_get_threads_count( size );
+      ak_bckey_process_fragments( bkey, ak_bckey_ctr_fragment, ak_bckey_ctr_seek,
+                             in, out, ( size_t )blocks, bkey->ivector, 1, nthreads );
+      inptr += blocks*( bkey->bsize >> 3 );
+      outptr += blocks*( bkey->bsize >> 3 );
     break;
 
     default: return ak_error_message( ak_error_wrong_block_cipher,
@@ -633,7 +1026,115 @@
   }
 
  /* перемаскируем ключ */
-  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+  if(( error = ak_skey_remask( &bkey->key, size )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of secret key" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция зашифровывает (расшифровывает) фрагмент данных, расположенный в гаммируемой
+    последовательности со смещением `offset` байт от ее начала. Значение счетчика для первого
+    обрабатываемого блока вычисляется непосредственно по синхропосылке, поэтому для изменения
+    участка зашифрованного файла не требуется обрабатывать предшествующие ему данные.
+    Смещение и длина фрагмента могут быть не кратны длине блока.
+
+    В отличие от ak_bckey_ctr(), функция не изменяет внутреннее значение синхропосылки
+    `bkey->ivector` и флаги ключа, поэтому после ее вызова контекст ключа может использоваться
+    как для произвольного доступа, так и для последовательного шифрования.
+
+    Результат совпадает с фрагментом результата функции ak_bckey_ctr(), примененной
+    к первым `offset + size` байтам последовательности. Если конец фрагмента не совпадает
+    с границей блока, то последний неполный блок фрагмента, как и в функции ak_bckey_ctr(),
+    считается последним блоком последовательности: при выключенном режиме совместимости
+    с openssl он гаммируется старшими байтами зашифрованного счетчика. Поэтому в этом режиме
+    фрагменты из середины последовательности должны заканчиваться на границе блока,
+    а неполный хвост последовательности, зашифрованной функцией ak_bckey_ctr(),
+    расшифровывается вызовом, фрагмент которого заканчивается вместе с последовательностью.
+
+    @param bkey Контекст ключа алгоритма блочного шифрования.
+    @param in Указатель на область памяти, где хранятся входные данные.
+    @param out Указатель на область памяти, куда помещаются выходные данные
+    (этот указатель может совпадать с `in`).
+    @param size Размер обрабатываемого фрагмента (в байтах).
+    @param iv Указатель на синхропосылку, с которой начинается гаммируемая последовательность.
+    @param iv_size Длина синхропосылки в байтах.
+    @param offset Смещение фрагмента относительно начала последовательности (в байтах).
+
+    @return В случае возникновения ошибки функция возвращает ее код, в противном случае
+    возвращается \ref ak_error_ok (ноль)                                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_ctr_at_offset( ak_bckey bkey, ak_pointer in, ak_pointer out, size_t size,
+                                                   ak_pointer iv, size_t iv_size, size_t offset )
+{
+  size_t i, halfsize = 0, lead = 0, blocks = 0, tail = 0;
+  ak_uint64 ctr[2], yaout[2];
+  ak_uint8 *inptr = ( ak_uint8 *)in, *outptr = ( ak_uint8 *)out, *gamma = ( ak_uint8 *)yaout;
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option_by_name( "openssl_compability" );
+
+  if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
+                                                "wrong value for \"openssl_compability\" option" );
+  if(( bkey->bsize != 8 ) && ( bkey->bsize != 16 ))
+    return ak_error_message( ak_error_wrong_block_cipher,
+                                          __func__ , "incorrect block size of block cipher key" );
+ /* проверяем, установлен ли ключ */
+  if(( bkey->key.flags&ak_key_flag_set_key ) == 0 ) return ak_error_message( ak_error_key_value,
+                                    __func__, "using secret key context with undefined key value" );
+ /* проверяем целостность ключа */
+  if( ak_skey_check_icode( &bkey->key ) != ak_true )
+    return ak_error_message( ak_error_wrong_key_icode, __func__,
+                                                   "incorrect integrity code of secret key value" );
+ /* проверяем синхропосылку */
+  halfsize = bkey->bsize >> 1;
+  if( iv == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                   "using null pointer to initialization vector" );
+  if( iv_size < halfsize ) return ak_error_message( ak_error_wrong_iv_length, __func__,
+                                                              "incorrect length of initial value" );
+  if( size == 0 ) return ak_error_ok;
+
+ /* определяем количество блоков гаммы, которые будут использованы */
+  lead = offset%bkey->bsize;
+  blocks = ( lead + size + bkey->bsize - 1 )/bkey->bsize;
+  if( ak_skey_reserve_resource( &bkey->key, ( ssize_t )blocks ) != ak_error_ok )
+    return ak_error_message( ak_error_low_key_resource,
+                                                    __func__ , "low resource of block cipher key" );
+
+ /* формируем начальное значение счетчика так же, как это делает функция ak_bckey_ctr(),
+    и вычисляем значение счетчика для блока, содержащего первый обрабатываемый байт */
+  memset( yaout, 0, sizeof( yaout ));
+  memcpy( gamma + halfsize*((unsigned int)(1-oc)), iv, halfsize );
+  ak_bckey_ctr_seek( bkey, gamma, 1, NULL, offset/bkey->bsize, ( ak_uint8 *)ctr );
+
+ /* начальный неполный блок */
+  if( lead ) {
+    size_t len = ak_min( bkey->bsize - lead, size ),
+           shift = (( oc == 0 ) && ( lead + len < bkey->bsize )) ? bkey->bsize - lead - len : 0;
+    bkey->encrypt( &bkey->key, ctr, yaout );
+    for( i = 0; i < len; i++ ) outptr[i] = inptr[i]^gamma[lead+shift+i];
+    ak_bckey_ctr_seek( bkey, ( ak_uint8 *)ctr, 1, NULL, 1, gamma );
+    memcpy( ctr, yaout, bkey->bsize );
+    inptr += len; outptr += len; size -= len;
+  }
+
+ /* полные блоки */
+  blocks = size/bkey->bsize;
+  tail = size%bkey->bsize;
+  if( blocks ) {
+    ak_bckey_process_fragments( bkey, ak_bckey_ctr_fragment, ak_bckey_ctr_seek, inptr, outptr,
+                blocks, ( ak_uint8 *)ctr, 1, ak_bckey_get_threads_count( blocks*bkey->bsize ));
+    inptr += blocks*bkey->bsize; outptr += blocks*bkey->bsize;
+  }
+
+ /* завершающий неполный блок */
+  if( tail ) {
+    size_t shift = ( oc == 0 ) ? bkey->bsize - tail : 0;
+    bkey->encrypt( &bkey->key, ctr, yaout );
+    for( i = 0; i < tail; i++ ) outptr[i] = inptr[i]^gamma[shift+i];
+  }
+
+ /* перемаскируем ключ */
+  if(( error = ak_skey_remask( &bkey->key,
+                                   ( size_t )( inptr - ( ak_uint8 *)in ) + tail )) != ak_error_ok )
     ak_error_message( error, __func__ , "wrong remasking of secret key" );
 
  return error;
@@ -657,15 +1158,14 @@
                              __func__ , "the length of input data is not divided by block length" );
 
   /* проверяем целостность ключа */
-   if( bkey->key.check_icode( &bkey->key ) != ak_true )
+   if( ak_skey_check_icode( &bkey->key ) != ak_true )
      return ak_error_message( ak_error_wrong_key_icode,
                                          __func__, "incorrect integrity code of secret key value" );
   /* уменьшаем значение ресурса ключа */
    blocks = ( ak_int64 ) (size/bkey->bsize);
-   if( bkey->key.resource.value.counter < blocks )
+   if( ak_skey_reserve_resource( &bkey->key, blocks ) != ak_error_ok )
      return ak_error_message( ak_error_low_key_resource,
                                                     __func__ , "low resource of block cipher key" );
-    else bkey->key.resource.value.counter -= blocks;
 
   /* проверяем длину синхропосылки */
    if(( iv_size < bkey->bsize ) ||                              /* если меньше  блока */
@@ -707,7 +1207,7 @@
                                            __func__ , "incorrect block size of block cipher key" );
    }
   /* перемаскируем ключ */
-   if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+   if(( error = ak_skey_remask( &bkey->key, size )) != ak_error_ok )
      ak_error_message( error, __func__ , "wrong remasking of secret key" );
 
   return ak_error_ok;
@@ -718,8 +1218,6 @@
                                                                     ak_pointer iv, size_t iv_size )
  {
   ak_int64 blocks = 0;
-  ak_uint64 yaout[2], z = iv_size / bkey->bsize;
-  ak_uint64 *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out, *ivector = (ak_uint64 *)bkey->ivector;
   int error = ak_error_ok, oc = (int) ak_libakrypt_get_option_by_name( "openssl_compability" );
 
   if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
@@ -731,15 +1229,14 @@
                             __func__ , "the length of input data is not divided by block length" );
 
  /* проверяем целостность ключа */
-  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+  if( ak_skey_check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode,
                                         __func__, "incorrect integrity code of secret key value" );
  /* уменьшаем значение ресурса ключа */
   blocks = (ak_int64 ) (size/bkey->bsize);
-  if( bkey->key.resource.value.counter < blocks )
+  if( ak_skey_reserve_resource( &bkey->key, blocks ) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource,
                                                    __func__ , "low resource of block cipher key" );
-   else bkey->key.resource.value.counter -= blocks;
 
  /* проверяем длину синхропосылки */
   if(( iv_size < bkey->bsize ) ||                              /* если меньше  блока */
@@ -749,40 +1246,21 @@
                                                              "incorrect length of initial value" );
    memcpy(bkey->ivector, iv, iv_size);
 
- /* теперь приступаем к расшифрованию данных */
+ /* теперь приступаем к расшифрованию данных:
+    расшифрование блока зависит только от шифртекста, поэтому данные разбиваются
+    на фрагменты, которые расшифровываются одновременно */
   switch( bkey->bsize ) {
     case  8: /* шифр с длиной блока 64 бита */
-      while( blocks > 0 ) {
-          bkey->decrypt( &bkey->key, inptr, yaout );
-          if( z == 0 ) {
-              ivector = (ak_uint64 *)in;
-          }
-          *outptr = yaout[0] ^ *ivector; outptr++; ivector++;
-          inptr++;
-          --blocks;
-          --z;
-      }
-    break;
-
     case 16: /* шифр с длиной блока 128 бит */
-      while( blocks > 0 ) {
-          bkey->decrypt( &bkey->key, inptr, yaout );
-          if( z == 0 ) {
-              ivector = (ak_uint64 *)in;
-          }
-          *outptr = yaout[0] ^ *ivector; outptr++; ivector++;
-          *outptr = yaout[1] ^ *ivector; outptr++; ivector++;
-          inptr+=2;
-          --blocks;
-          --z;
-      }
-
+      ak_bckey_process_fragments( bkey, ak_bckey_decrypt_cbc_fragment, ak_bckey_chain_seek,
+                                     in, out, ( size_t )blocks, bkey->ivector, iv_size/bkey->bsize,
+                                                                  ak_bckey_get_threads_count( size ));
     break;
     default: return ak_error_message( ak_error_wrong_block_cipher,
                                           __func__ , "incorrect block size of block cipher key" );
   }
  /* перемаскируем ключ */
-  if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+  if(( error = ak_skey_remask( &bkey->key, size )) != ak_error_ok )
     ak_error_message( error, __func__ , "wrong remasking of secret key" );
 
  return ak_error_ok;
@@ -802,14 +1280,13 @@
   if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
                                                "wrong value for \"openssl_compability\" option" );
  /* проверяем целостность ключа */
-  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+  if( ak_skey_check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode, __func__,
                                                    "incorrect integrity code of secret key value" );
  /* уменьшаем значение ресурса ключа */
-  if( bkey->key.resource.value.counter < ( blocks + ( tail > 0 )))
+  if( ak_skey_reserve_resource( &bkey->key, blocks + ( tail > 0 )) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource,
                                                      __func__ , "low resource of block cipher key" );
-   else bkey->key.resource.value.counter -= ( blocks + ( tail > 0 ));
 
   /* проверяем длину синхропосылки */
   if(( iv == NULL ) || ( iv_size == 0 )) { /* запрос на использование внутреннего значения */
@@ -880,7 +1357,7 @@
    }
 
   /* перемаскируем ключ */
-   if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+   if(( error = ak_skey_remask( &bkey->key, size )) != ak_error_ok )
      ak_error_message( error, __func__ , "wrong remasking of secret key" );
 
   return error;
@@ -900,14 +1377,13 @@
    if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
                                                  "wrong value for \"openssl_compability\" option" );
   /* проверяем целостность ключа */
-   if( bkey->key.check_icode( &bkey->key ) != ak_true )
+   if( ak_skey_check_icode( &bkey->key ) != ak_true )
      return ak_error_message( ak_error_wrong_key_icode, __func__,
                                                     "incorrect integrity code of secret key value" );
   /* уменьшаем значение ресурса ключа */
-   if( bkey->key.resource.value.counter < ( blocks + ( tail > 0 )))
+   if( ak_skey_reserve_resource( &bkey->key, blocks + ( tail > 0 )) != ak_error_ok )
      return ak_error_message( ak_error_low_key_resource,
                                                      __func__ , "low resource of block cipher key" );
-    else bkey->key.resource.value.counter -= ( blocks + ( tail > 0 ));
 
   /* выбираем, как вычислять синхропосылку проверяем флаг
      флаг поднимается при вызове функции с заданным значением синхропосылки и
@@ -974,7 +1450,7 @@
      memset( bkey->ivector, 0, sizeof( bkey->ivector ));
      bkey->key.flags = bkey->key.flags&( ~ak_key_flag_not_ctr );
      /* перемаскируем ключ */
-     if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+     if(( error = ak_skey_remask( &bkey->key, size )) != ak_error_ok )
         ak_error_message( error, __func__ , "wrong remasking of secret key" );
    }
    return error;
@@ -986,7 +1462,7 @@
  {
    ak_int64 blocks = (ak_int64)( size/bkey->bsize ),
               tail = (ak_int64)( size%bkey->bsize );
-   ak_uint8 *vecptr = NULL;
+   ak_uint8 *vecptr = NULL, reg[64];
    ak_uint64 yaout[2], *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
    int error = ak_error_ok, oc = (int) ak_libakrypt_get_option_by_name( "openssl_compability" );
    unsigned long i = 0, z = iv_size / bkey->bsize; // во сколько раз синхрпосылка длиннее блока
@@ -994,14 +1470,13 @@
    if(( oc < 0 ) || ( oc > 1 )) return ak_error_message( ak_error_wrong_option, __func__,
                                                  "wrong value for \"openssl_compability\" option" );
   /* проверяем целостность ключа */
-   if( bkey->key.check_icode( &bkey->key ) != ak_true )
+   if( ak_skey_check_icode( &bkey->key ) != ak_true )
      return ak_error_message( ak_error_wrong_key_icode, __func__,
                                                     "incorrect integrity code of secret key value" );
   /* уменьшаем значение ресурса ключа */
-   if( bkey->key.resource.value.counter < ( blocks + ( tail > 0 )))
+   if( ak_skey_reserve_resource( &bkey->key, blocks + ( tail > 0 )) != ak_error_ok )
      return ak_error_message( ak_error_low_key_resource,
                                                      __func__ , "low resource of block cipher key" );
-    else bkey->key.resource.value.counter -= ( blocks + ( tail > 0 ));
 
   /* выбираем, как вычислять синхропосылку проверяем флаг
      флаг поднимается при вызове функции с заданным значением синхропосылки и
@@ -1025,31 +1500,27 @@
       bkey->key.flags = ( bkey->key.flags&( ~ak_key_flag_not_ctr ))^ak_key_flag_not_ctr;
      }
 
-  /* обработка основного массива данных (кратного длине блока) */
+  /* обработка основного массива данных (кратного длине блока):
+     на вход алгоритма блочного шифрования подаются блоки шифртекста, поэтому данные
+     разбиваются на фрагменты, которые расшифровываются одновременно */
+   z = ak_min( z, sizeof( bkey->ivector )/bkey->bsize );
+   if( z == 0 ) z = 1;
    switch( bkey->bsize ) {
      case  8: /* шифр с длиной блока 64 бита */
-       while( blocks > 0 ) {
-           vecptr = (bkey->ivector + i*bkey->bsize);
-           bkey->encrypt( &bkey->key, vecptr, yaout );
-           *outptr = *inptr ^ yaout[0];
-           ((ak_uint64 *)vecptr)[0] = *inptr;
-           outptr++; inptr++;
-           if (++i == z) i = 0;
-           --blocks;
-       }
-     break;
-
      case 16: /* шифр с длиной блока 128 бит */
-       while( blocks > 0 ) {
-           vecptr = (bkey->ivector + i*bkey->bsize );
-           bkey->encrypt( &bkey->key, vecptr, yaout );
-           *outptr = *inptr ^ yaout[0];
-           ((ak_uint64 *)vecptr)[0] = *inptr; ++outptr; ++inptr;
-           *outptr = *inptr ^ yaout[1];
-           ((ak_uint64 *)vecptr)[1] = *inptr; ++outptr; ++inptr;
-           if (++i == z) i = 0;
-           --blocks;
-       }
+       memcpy( reg, bkey->ivector, z*bkey->bsize );
+       ak_bckey_process_fragments( bkey, ak_bckey_decrypt_cfb_fragment, ak_bckey_chain_seek,
+                                                   in, out, ( size_t )blocks, reg, z,
+                                                                  ak_bckey_get_threads_count( size ));
+      /* возвращаем значение регистра во внутренний буффер так,
+         как если бы блоки обрабатывались последовательно */
+       for( i = 0; i < z; i++ )
+          memcpy( bkey->ivector + (( blocks + i )%z )*bkey->bsize,
+                                                         reg + i*bkey->bsize, bkey->bsize );
+       ak_ptr_wipe( reg, sizeof( reg ), &bkey->key.generator );
+       i = blocks%z;
+       inptr += blocks*( bkey->bsize >> 3 );
+       outptr += blocks*( bkey->bsize >> 3 );
      break;
 
      default: return ak_error_message( ak_error_wrong_block_cipher,
@@ -1058,7 +1529,7 @@
 
   /* обрабатываем хвост сообщения */
    if( tail ) {
-     vecptr = (bkey->ivector + bkey->bsize * (i % (int)(iv_size / bkey->bsize)));
+     vecptr = ( bkey->ivector + bkey->bsize*i );
      bkey->encrypt( &bkey->key, vecptr, yaout );
      for( i = 0; i < (unsigned long)tail; i++ )
         ( (ak_uint8*)outptr)[i] = ( (ak_uint8*)inptr )[i]^( (ak_uint8 *)yaout)[i];
@@ -1068,7 +1539,7 @@
      memset( bkey->ivector, 0, sizeof( bkey->ivector ));
      bkey->key.flags = bkey->key.flags&( ~ak_key_flag_not_ctr );
      /* перемаскируем ключ */
-     if(( error = bkey->key.set_mask( &bkey->key )) != ak_error_ok )
+     if(( error = ak_skey_remask( &bkey->key, size )) != ak_error_ok )
         ak_error_message( error, __func__ , "wrong remasking of secret key" );
    }
    return error;
@@ -44,15 +44,14 @@
   if( !out_size ) return ak_error_message( ak_error_zero_length, __func__,
                                                             "using zero length of result buffer" );
  /* проверяем целостность ключа */
-  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+  if( ak_skey_check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode, __func__,
                                                   "incorrect integrity code of secret key value" );
 
  /* уменьшаем значение ресурса ключа */
-  if( bkey->key.resource.value.counter < ( blocks + ( tail > 0 )))
+  if( ak_skey_reserve_resource( &bkey->key, blocks + ( tail > 0 )) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource, __func__ ,
                                                               "low resource of block cipher key" );
-   else bkey->key.resource.value.counter -= ( blocks + ( tail > 0 )); /* уменьшаем ресурс ключа */
 
   memset( akey, 0, sizeof( akey ));
   memset( yaout, 0, sizeof( yaout ));
@@ -199,16 +198,15 @@
   if(( size%bkey->bsize ) != 0 ) return ak_error_message( ak_error_wrong_length, __func__,
                                                                 "using a data with wrong length" );
  /* проверяем целостность ключа */
-  if( bkey->key.check_icode( &bkey->key ) != ak_true )
+  if( ak_skey_check_icode( &bkey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode, __func__,
                                                   "incorrect integrity code of secret key value" );
 
  /* уменьшаем значение ресурса ключа */
   blocks = (ak_int64)size/bkey->bsize;
-  if( bkey->key.resource.value.counter < ( blocks + 1 ))
+  if( ak_skey_reserve_resource( &bkey->key, blocks ) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource, __func__ ,
                                                               "low resource of block cipher key" );
-   else bkey->key.resource.value.counter -= blocks; /* уменьшаем ресурс ключа */
 
  /* основной цикл */
   yaout = (ak_uint64 *) bkey->ivector;
@@ -286,7 +284,9 @@
   if( !out_size ) return ak_error_message( ak_error_zero_length, __func__,
                                                             "using zero length of result buffer" );
  /* уменьшаем значение ресурса ключа */
-  bkey->key.resource.value.counter--; /* уменьшаем ресурс ключа */
+  if( ak_skey_reserve_resource( &bkey->key, 1 ) != ak_error_ok )
+    return ak_error_message( ak_error_low_key_resource, __func__ ,
+                                                              "low resource of block cipher key" );
 
   memset( akey, 0, sizeof( akey ));
   yaout = ( ak_uint64 * )bkey->ivector;
@@ -0,0 +1,453 @@
+/* ----------------------------------------------------------------------------------------------- */
+/*  Copyright (c) 2014 - 2020 by Axel Kenzo, axelkenzo@mail.ru                                     */
+/*                                                                                                 */
+/*  Файл ak_context_manager.c                                                                      */
+/*  - содержит реализацию менеджера контекстов - пула заранее созданных объектов, доступ к которым */
+/*    осуществляется при помощи дескрипторов.                                                      */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <libakrypt-internal.h>
+
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef AK_HAVE_STDLIB_H
+ #include <stdlib.h>
+#else
+ #error Library cannot be compiled without stdlib.h header
+#endif
+#ifdef AK_HAVE_STRING_H
+ #include <string.h>
+#else
+ #error Library cannot be compiled without string.h header
+#endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество младших битов дескриптора, содержащих индекс элемента менеджера контекстов;
+    старшие биты дескриптора содержат номер поколения элемента. */
+ #define ak_context_handle_index_bits   (24)
+/*! \brief Маска индекса элемента в дескрипторе. */
+ #define ak_context_handle_index_mask   ((( size_t )1 << ak_context_handle_index_bits ) - 1 )
+/*! \brief Маска номера поколения элемента (дескриптор всегда неотрицателен). */
+ #define ak_context_handle_generation_mask \
+                                    ((( size_t )( ~( size_t )0 ) >> 1 ) >> ak_context_handle_index_bits )
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Состояние элемента менеджера контекстов. */
+ typedef enum {
+  /*! \brief Элемент не содержит объекта. */
+   node_is_empty,
+  /*! \brief Элемент содержит объект, готовый к повторному использованию. */
+   node_is_ready,
+  /*! \brief Объект используется владельцем дескриптора. */
+   node_is_used
+} context_node_status_t;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Элемент менеджера контекстов. */
+ typedef struct context_node {
+  /*! \brief Указатель на объект. */
+   ak_pointer ctx;
+  /*! \brief Идентификатор, определяющий тип объекта. */
+   ak_oid oid;
+  /*! \brief Индекс следующего элемента в списке свободных элементов
+      или в списке объектов, готовых к использованию (-1 для последнего элемента списка). */
+   ssize_t next;
+  /*! \brief Состояние элемента. */
+   context_node_status_t status;
+  /*! \brief Номер поколения элемента; увеличивается при каждом возврате объекта в менеджер,
+      что делает недействительными все ранее выданные дескрипторы этого элемента. */
+   size_t generation;
+} *ak_context_node;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Менеджер контекстов. */
+/*! \details Менеджер содержит массив элементов. Младшие биты дескриптора объекта содержат
+    индекс элемента в массиве, старшие -- номер поколения элемента, поэтому дескриптор,
+    возвращенный в менеджер, не может быть использован для доступа к объекту, выданному
+    позднее другому владельцу. Элементы, не содержащие объектов, образуют односвязный список; элементы, содержащие
+    готовые к использованию объекты, образуют отдельный список для каждого идентификатора
+    библиотеки. Поэтому получение и возврат объекта выполняются за фиксированное время.
+
+    Начальное количество элементов определяется опцией `context_manager_size`; при исчерпании
+    элементов их количество удваивается, но не превышает значения опции
+    `context_manager_max_size` и \f$ 2^{24} \f$.                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static struct context_manager {
+  /*! \brief Массив элементов. */
+   struct context_node *list;
+  /*! \brief Количество элементов массива. */
+   size_t size;
+  /*! \brief Индекс первого элемента в списке элементов, не содержащих объектов. */
+   ssize_t empty;
+  /*! \brief Индексы первых элементов в списках готовых объектов (по одному на каждый oid). */
+   ssize_t *ready;
+  /*! \brief Количество идентификаторов библиотеки. */
+   size_t count;
+} libakrypt_context_manager = { NULL, 0, -1, NULL, 0 };
+
+#ifdef AK_HAVE_PTHREAD_H
+ static pthread_mutex_t context_manager_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Блокировка менеджера контекстов. */
+ static inline void ak_context_manager_lock( void )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &context_manager_mutex );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Разблокировка менеджера контекстов. */
+ static inline void ak_context_manager_unlock( void )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &context_manager_mutex );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Включение элементов массива с индексами от `start` до `size-1` в список
+    элементов, не содержащих объектов. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_context_manager_link_empty( size_t start, size_t size )
+{
+  size_t i;
+  struct context_manager *cm = &libakrypt_context_manager;
+
+  for( i = start; i < size; i++ ) {
+     cm->list[i].ctx = NULL;
+     cm->list[i].oid = NULL;
+     cm->list[i].status = node_is_empty;
+     cm->list[i].generation = 0;
+     cm->list[i].next = ( i+1 < size ) ? ( ssize_t )( i+1 ) : cm->empty;
+  }
+  cm->empty = ( ssize_t )start;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Создание менеджера контекстов; функция вызывается при заблокированном мьютексе.
+    \return В случае успеха возвращается \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_context_manager_create( void )
+{
+  size_t i;
+  struct context_manager *cm = &libakrypt_context_manager;
+
+  cm->count = ak_libakrypt_oids_count();
+  if(( cm->ready = malloc( cm->count*sizeof( ssize_t ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__,
+                                              "incorrect memory allocation for context manager" );
+  for( i = 0; i < cm->count; i++ ) cm->ready[i] = -1;
+
+  cm->size = ( size_t ) ak_libakrypt_get_option_by_name( "context_manager_size" );
+  if(( cm->list = malloc( cm->size*sizeof( struct context_node ))) == NULL ) {
+    free( cm->ready );
+    memset( cm, 0, sizeof( struct context_manager ));
+    cm->empty = -1;
+    return ak_error_message( ak_error_out_of_memory, __func__,
+                                              "incorrect memory allocation for context manager" );
+  }
+  cm->empty = -1;
+  ak_context_manager_link_empty( 0, cm->size );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Увеличение количества элементов менеджера контекстов; функция вызывается
+    при заблокированном мьютексе.
+    \return В случае успеха возвращается \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_context_manager_grow( void )
+{
+  struct context_node *list = NULL;
+  struct context_manager *cm = &libakrypt_context_manager;
+  size_t size = ak_min(( size_t ) ak_libakrypt_get_option_by_name( "context_manager_max_size" ),
+                                                              ak_context_handle_index_mask + 1 );
+
+  if( cm->size >= size ) return ak_error_message( ak_error_out_of_memory, __func__,
+                                                   "context manager has no free elements" );
+  size = ak_min( size, cm->size << 1 );
+  if(( list = realloc( cm->list, size*sizeof( struct context_node ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__,
+                                              "incorrect memory allocation for context manager" );
+  cm->list = list;
+  ak_context_manager_link_empty( cm->size, size );
+  cm->size = size;
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Формирование дескриптора по индексу элемента; функция вызывается
+    при заблокированном мьютексе. */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline ak_handle ak_context_manager_make_handle( size_t idx )
+{
+ return ( ak_handle )(( libakrypt_context_manager.list[idx].generation
+                                                        << ak_context_handle_index_bits ) | idx );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Проверка корректности дескриптора; функция вызывается при заблокированном мьютексе.
+    \return Функция возвращает индекс элемента менеджера контекстов или -1, если дескриптор
+    не соответствует используемому объекту (в том числе, если объект уже был возвращен
+    в менеджер и выдан повторно).                                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline ssize_t ak_context_manager_check_handle( ak_handle handle )
+{
+  size_t idx = 0;
+  struct context_manager *cm = &libakrypt_context_manager;
+
+  if( handle < 0 ) return -1;
+  if(( idx = (( size_t )handle )&ak_context_handle_index_mask ) >= cm->size ) return -1;
+  if( cm->list[idx].status != node_is_used ) return -1;
+  if(( ( size_t )handle >> ak_context_handle_index_bits ) != cm->list[idx].generation ) return -1;
+ return ( ssize_t )idx;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Приведение объекта в состояние, допускающее его повторное использование.
+
+    Для ключей алгоритмов блочного шифрования и HMAC уничтожаются значения ключей и развернутые
+    ключи, для функций хеширования восстанавливается начальное состояние. Объекты остальных типов
+    повторно не используются.
+
+    \return Функция возвращает \ref ak_true, если объект может быть использован повторно.          */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_context_manager_reset_object( ak_oid oid, ak_pointer ctx )
+{
+  int error = ak_error_ok;
+
+  switch( oid->engine ) {
+    case block_cipher: {
+      ak_bckey bkey = ( ak_bckey )ctx;
+      if( bkey->delete_keys != NULL ) {
+        if(( error = bkey->delete_keys( &bkey->key )) != ak_error_ok ) break;
+      }
+      if(( error = ak_ptr_wipe( bkey->ivector, sizeof( bkey->ivector ),
+                                                      &bkey->key.generator )) != ak_error_ok ) break;
+      bkey->ivector_size = 0;
+      error = ak_skey_reset( &bkey->key );
+    } break;
+
+    case hmac_function: {
+      ak_hmac hctx = ( ak_hmac )ctx;
+     /* буфер контекста итерационного сжатия очищается до вызова функции очистки алгоритма hmac,
+        которая загружает в контекст хеширования состояние после обработки K xor ipad;
+        поэтому контекст хеширования очищается после контекста итерационного сжатия */
+      if( hctx->key.flags&ak_key_flag_set_key ) ak_mac_clean( &hctx->mctx );
+      if(( error = ak_hash_clean( &hctx->ctx )) != ak_error_ok ) break;
+      if(( error = ak_ptr_wipe( hctx->pads, sizeof( hctx->pads ),
+                                                      &hctx->key.generator )) != ak_error_ok ) break;
+      error = ak_skey_reset( &hctx->key );
+    } break;
+
+    case hash_function:
+      error = ak_hash_clean( ( ak_hash )ctx );
+      break;
+
+    default: return ak_false;
+  }
+
+  if( error != ak_error_ok ) {
+    ak_error_message_fmt( error, __func__, "incorrect reset of %s object",
+                                                      ak_libakrypt_get_engine_name( oid->engine ));
+    return ak_false;
+  }
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Если менеджер контекстов содержит готовый к использованию объект с заданным идентификатором,
+    то функция возвращает его дескриптор без выделения памяти и вызова конструктора объекта.
+    В противном случае объект создается функцией ak_oid_new_object().
+
+    Повторно используются ключи алгоритмов блочного шифрования, ключи алгоритмов HMAC и контексты
+    функций хеширования; полученный ключ требует присвоения нового значения.
+
+    Пример использования:
+    \code
+      ak_handle handle = ak_handle_new( ak_oid_find_by_name( "kuznechik" ));
+      ak_bckey key = ak_handle_get_context( handle, NULL );
+
+      ak_bckey_set_key( key, keyvalue, 32 );
+      ak_bckey_ctr( key, in, out, size, iv, 8 );
+      ak_handle_delete( handle );
+    \endcode
+
+    \param oid Идентификатор объекта
+    \return Функция возвращает дескриптор объекта. В случае возникновения ошибки возвращается
+    ее код (отрицательное значение).                                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ ak_handle ak_handle_new( ak_oid oid )
+{
+  size_t idx = 0;
+  ssize_t node = -1;
+  ak_pointer ctx = NULL;
+  ak_handle handle = ak_error_ok;
+  struct context_manager *cm = &libakrypt_context_manager;
+
+  if( oid == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                         "using null pointer to oid context" );
+  if(( oid < ak_oid_find_by_index( 0 )) ||
+                              ( oid >= ak_oid_find_by_index( 0 ) + ak_libakrypt_oids_count()))
+    return ak_error_message( ak_error_oid_id, __func__, "using unexpected oid" );
+  idx = ( size_t )( oid - ak_oid_find_by_index( 0 ));
+
+  ak_context_manager_lock();
+  if( cm->list == NULL ) {
+    if(( handle = ak_context_manager_create()) != ak_error_ok ) goto exit;
+  }
+ /* используем готовый объект */
+  if(( node = cm->ready[idx] ) >= 0 ) {
+    cm->ready[idx] = cm->list[node].next;
+    cm->list[node].next = -1;
+    cm->list[node].status = node_is_used;
+    handle = ak_context_manager_make_handle(( size_t )node );
+    goto exit;
+  }
+ /* резервируем элемент для нового объекта */
+  if( cm->empty < 0 ) {
+    if(( handle = ak_context_manager_grow()) != ak_error_ok ) goto exit;
+  }
+  node = cm->empty;
+  cm->empty = cm->list[node].next;
+  cm->list[node].next = -1;
+  cm->list[node].oid = oid;
+  cm->list[node].status = node_is_used;
+  ak_context_manager_unlock();
+
+ /* создаем объект без блокировки менеджера */
+  ctx = ak_oid_new_object( oid );
+
+  ak_context_manager_lock();
+  if( ctx == NULL ) {
+    cm->list[node].oid = NULL;
+    cm->list[node].status = node_is_empty;
+    cm->list[node].next = cm->empty;
+    cm->empty = node;
+    if(( handle = ak_error_get_value()) == ak_error_ok ) handle = ak_error_out_of_memory;
+  } else {
+      cm->list[node].ctx = ctx;
+      handle = ak_context_manager_make_handle(( size_t )node );
+    }
+
+  exit:
+   ak_context_manager_unlock();
+ return handle;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param handle Дескриптор объекта
+    \param engine Указатель, по которому помещается тип объекта; может принимать значение `NULL`.
+    \return Функция возвращает указатель на объект. В случае ошибки возвращается `NULL`
+    и устанавливается код ошибки.                                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ ak_pointer ak_handle_get_context( ak_handle handle, oid_engines_t *engine )
+{
+  ssize_t node = -1;
+  ak_pointer ctx = NULL;
+
+  ak_context_manager_lock();
+  if(( node = ak_context_manager_check_handle( handle )) >= 0 ) {
+    ctx = libakrypt_context_manager.list[node].ctx;
+    if( engine != NULL ) *engine = libakrypt_context_manager.list[node].oid->engine;
+  }
+  ak_context_manager_unlock();
+
+  if( ctx == NULL ) ak_error_message( ak_error_wrong_index, __func__, "using wrong handle" );
+ return ctx;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Ключевая информация, содержащаяся в объекте, уничтожается, после чего объект становится
+    доступным для повторного использования функцией ak_handle_new(). Объекты, которые не могут
+    быть использованы повторно, уничтожаются функцией ak_oid_delete_object().
+    После вызова функции дескриптор не может использоваться: дескриптор, который будет выдан
+    функцией ak_handle_new() для того же элемента менеджера, отличается от возвращенного.
+
+    \param handle Дескриптор объекта
+    \return В случае успеха возвращается значение \ref ak_error_ok. В случае возникновения
+     ошибки возвращается ее код.                                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_handle_delete( ak_handle handle )
+{
+  ak_oid oid = NULL;
+  ak_pointer ctx = NULL;
+  size_t idx = 0;
+  ssize_t node = -1;
+  struct context_manager *cm = &libakrypt_context_manager;
+
+  ak_context_manager_lock();
+  if(( node = ak_context_manager_check_handle( handle )) < 0 ) {
+    ak_context_manager_unlock();
+    return ak_error_message( ak_error_wrong_index, __func__, "using wrong handle" );
+  }
+ /* элемент исключается из использования, но не помещается ни в один из списков;
+    смена поколения делает возвращаемый дескриптор недействительным */
+  oid = cm->list[node].oid;
+  ctx = cm->list[node].ctx;
+  cm->list[node].status = node_is_ready;
+  cm->list[node].generation =
+                          ( cm->list[node].generation + 1 )&ak_context_handle_generation_mask;
+  ak_context_manager_unlock();
+
+  if( ak_context_manager_reset_object( oid, ctx ) != ak_true )
+    ctx = ak_oid_delete_object( oid, ctx );
+
+  ak_context_manager_lock();
+  if( ctx != NULL ) {
+    idx = ( size_t )( oid - ak_oid_find_by_index( 0 ));
+    cm->list[node].next = cm->ready[idx];
+    cm->ready[idx] = node;
+  } else {
+      cm->list[node].ctx = NULL;
+      cm->list[node].oid = NULL;
+      cm->list[node].status = node_is_empty;
+      cm->list[node].next = cm->empty;
+      cm->empty = node;
+    }
+  ak_context_manager_unlock();
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вызывается при завершении работы с библиотекой и уничтожает все объекты,
+    в том числе и те, дескрипторы которых не были возвращены функцией ak_handle_delete().
+
+    \return Функция возвращает \ref ak_error_ok.                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_libakrypt_destroy_context_manager( void )
+{
+  size_t i, used = 0;
+  struct context_manager *cm = &libakrypt_context_manager;
+
+  ak_context_manager_lock();
+  if( cm->list != NULL ) {
+    for( i = 0; i < cm->size; i++ ) {
+       if( cm->list[i].status == node_is_used ) used++;
+       if( cm->list[i].ctx != NULL ) ak_oid_delete_object( cm->list[i].oid, cm->list[i].ctx );
+    }
+    if(( used > 0 ) && ( ak_log_get_level() >= ak_log_maximum ))
+      ak_error_message_fmt( ak_error_ok, __func__,
+                                 "context manager holds %u objects in use", (unsigned int)used );
+    free( cm->list );
+    free( cm->ready );
+    memset( cm, 0, sizeof( struct context_manager ));
+    cm->empty = -1;
+  }
+  ak_context_manager_unlock();
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                                                                          ak_context_manager.c   */
+/* ----------------------------------------------------------------------------------------------- */
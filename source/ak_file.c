@@ -24,6 +24,9 @@
 #ifdef AK_HAVE_FNMATCH_H
  #include <fnmatch.h>
 #endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \param filename Имя, для которого проводится проверка
@@ -291,7 +294,13 @@
     return ak_error_open_file;
   }
   file->blksize = ( ak_int64 )st.st_blksize;
+ /* файлы библиотекой всегда считываются последовательно */
+  #ifdef POSIX_FADV_SEQUENTIAL
+   posix_fadvise( file->fd, 0, 0, POSIX_FADV_SEQUENTIAL );
+  #endif
  #endif
+  file->mmaped = NULL;
+  file->mmaped_size = 0;
 
  return ak_error_ok;
 }
@@ -308,6 +317,8 @@
     return ak_error_message( ak_error_null_pointer, __func__, "using null pointer" );
 
   file->size = 0;
+  file->mmaped = NULL;
+  file->mmaped_size = 0;
  #ifdef AK_HAVE_WINDOWS_H
   if(( file->hFile = CreateFile( filename,   /* name of the write */
                      GENERIC_WRITE,          /* open for writing */
@@ -338,6 +349,7 @@
 /* ----------------------------------------------------------------------------------------------- */
  int ak_file_close( ak_file file )
 {
+   if( file->mmaped != NULL ) ak_file_unmap( file, NULL );
    file->size = 0;
    file->blksize = 0;
   #ifdef AK_HAVE_WINDOWS_H
@@ -413,20 +425,307 @@
 
 /* ----------------------------------------------------------------------------------------------- */
                    /* Отображение файлов в память (обертка вокруг mmap) */
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция отображает в память содержимое файла, начиная с октета с номером `offset`
+    и до конца файла. Если указатель `filename` отличен от `NULL`, то функция
+    предварительно открывает файл с заданным именем, в противном случае предполагается,
+    что контекст `file` уже содержит дескриптор открытого файла
+    (например, созданный функцией ak_file_open_to_read()).
+
+    Поскольку отображаемые файлы обычно обрабатываются последовательно, функция сообщает
+    об этом операционной системе (вызов `madvise( MADV_SEQUENTIAL )`).
+    Отображение отменяется функцией ak_file_unmap() или при закрытии файла ak_file_close().
+
+    \param file Контекст файла.
+    \param filename Имя файла или `NULL`.
+    \param state Режим доступа к отображаемой памяти; допускаются значения \ref readonly
+    и \ref readwrite.
+    \param offset Смещение (в октетах) от начала файла; должно быть меньше длины файла.
+    \return Функция возвращает указатель на октет с номером `offset` в случае успеха.
+    В случае ошибки возвращается `NULL`, а код ошибки может быть получен
+    с помощью функции ak_error_get_value().                                                        */
 /* ----------------------------------------------------------------------------------------------- */
  ak_pointer ak_file_mmap( ak_file file, const char *filename,
                                                      const filestate_t state, const size_t offset )
 {
  /* в ситуациях, когда mmap не определена, сразу выходим */
-#ifndef AK_HAVE_WINDOWS_H
- #ifndef AK_HAVE_SYSMMAN_H
-   return ak_error_undefined_function;
+#if defined( AK_HAVE_WINDOWS_H ) || !defined( AK_HAVE_SYSMMAN_H )
+  (void)file; (void)filename; (void)state; (void)offset;
+  ak_error_message( ak_error_undefined_function, __func__,
+                                               "memory mapping is not supported on this platform" );
+ return NULL;
+#else
+  struct stat st;
+  ak_uint8 *ptr = NULL;
+  size_t delta = 0, page = 4096;
+
+  if( file == NULL ) {
+    ak_error_message( ak_error_null_pointer, __func__, "using null pointer to file context" );
+    return NULL;
+  }
+  if( state == writeonly ) {
+    ak_error_message( ak_error_undefined_value, __func__,
+                                                  "write only memory mapping is not supported" );
+    return NULL;
+  }
+ /* открываем файл */
+  if( filename != NULL ) {
+    if(( file->fd = open( filename, ( state == readonly ) ? O_RDONLY : O_RDWR )) < 0 ) {
+      ak_error_message_fmt( ak_error_open_file, __func__ ,
+                                     "wrong opening a file %s [%s]", filename, strerror( errno ));
+      return NULL;
+    }
+    if( fstat( file->fd, &st )) {
+      ak_error_message_fmt( ak_error_access_file,  __func__,
+                                "incorrect access to file %s [%s]", filename, strerror( errno ));
+      close( file->fd );
+      return NULL;
+    }
+    file->size = ( ak_int64 )st.st_size;
+    file->blksize = ( ak_int64 )st.st_blksize;
+    file->mmaped = NULL;
+    file->mmaped_size = 0;
+  }
+  if( file->mmaped != NULL ) {
+    ak_error_message( ak_error_mmap_file, __func__, "file is already mapped to memory" );
+    return NULL;
+  }
+  if(( ak_uint64 )offset >= ( ak_uint64 )file->size ) {
+    ak_error_message( ak_error_wrong_length, __func__, "offset exceeds the length of file" );
+    goto lab_exit;
+  }
+  if(( ak_uint64 )file->size > ( ak_uint64 )(((size_t)-1) >> 1 )) {
+    ak_error_message( ak_error_wrong_length, __func__, "file is too large to be mapped" );
+    goto lab_exit;
+  }
+
+ /* смещение отображения должно быть кратно размеру страницы */
+ #ifdef _SC_PAGESIZE
+  if( sysconf( _SC_PAGESIZE ) > 0 ) page = ( size_t ) sysconf( _SC_PAGESIZE );
+ #endif
+  delta = offset%page;
+  file->mmaped_size = ( size_t )file->size - offset + delta;
+  if(( file->mmaped = mmap( NULL, file->mmaped_size,
+                      ( state == readonly ) ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED,
+                                        file->fd, ( off_t )( offset - delta ))) == MAP_FAILED ) {
+    ak_error_message_fmt( ak_error_mmap_file, __func__,
+                                          "wrong mapping a file to memory [%s]", strerror( errno ));
+    file->mmaped = NULL;
+    file->mmaped_size = 0;
+    goto lab_exit;
+  }
+ #ifdef MADV_SEQUENTIAL
+  madvise( file->mmaped, file->mmaped_size, MADV_SEQUENTIAL );
  #endif
+  ptr = ( ak_uint8 * )file->mmaped + delta;
+
+  lab_exit:
+   if(( ptr == NULL ) && ( filename != NULL )) ak_file_close( file );
+ return ptr;
 #endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param file Контекст файла, ранее отображенного в память функцией ak_file_mmap().
+    \param ptr Указатель, возвращенный функцией ak_file_mmap(); может принимать значение `NULL`.
+    \return Функция возвращает \ref ak_error_ok в случае успеха, в противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_file_unmap( ak_file file, ak_pointer ptr )
+{
+  if( file == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to file context" );
+  if( file->mmaped == NULL ) return ak_error_ok;
+  if(( ptr != NULL ) && (( ( ak_uint8 *)ptr < ( ak_uint8 *)file->mmaped ) ||
+                    (( ak_uint8 *)ptr >= ( ak_uint8 *)file->mmaped + file->mmaped_size )))
+    return ak_error_message( ak_error_mmap_file, __func__,
+                                            "pointer does not belong to the file mapped memory" );
+#if !defined( AK_HAVE_WINDOWS_H ) && defined( AK_HAVE_SYSMMAN_H )
+  if( munmap( file->mmaped, file->mmaped_size ) != 0 ) return ak_error_message_fmt(
+                 ak_error_mmap_file, __func__, "wrong unmapping a file [%s]", strerror( errno ));
+#endif
+  file->mmaped = NULL;
+  file->mmaped_size = 0;
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+                   /* Одновременная обработка большого количества файлов */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Очередь файлов, обрабатываемых функцией ak_file_async(). */
+ typedef struct file_async_queue {
+  /*! \brief Функция обработки одного файла. */
+   ak_function_file_async *function;
+  /*! \brief Массив имен файлов. */
+   const char **filenames;
+  /*! \brief Количество файлов. */
+   size_t count;
+  /*! \brief Индекс следующего необработанного файла. */
+   size_t next;
+  /*! \brief Область памяти для результатов обработки. */
+   ak_uint8 *out;
+  /*! \brief Размер результата обработки одного файла. */
+   size_t out_size;
+  /*! \brief Массив кодов ошибок (может быть равен NULL). */
+   int *errors;
+  /*! \brief Код последней возникшей ошибки. */
+   int error;
+ #ifdef AK_HAVE_PTHREAD_H
+  /*! \brief Мьютекс, защищающий индекс следующего файла и код ошибки. */
+   pthread_mutex_t mutex;
+ #endif
+ } *ak_file_async_queue;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Поток, обрабатывающий файлы из очереди с использованием собственного контекста. */
+ typedef struct file_async_worker {
+  /*! \brief Общая для всех потоков очередь файлов. */
+   ak_file_async_queue queue;
+  /*! \brief Контекст, передаваемый функции обработки. */
+   ak_pointer ctx;
+ #ifdef AK_HAVE_PTHREAD_H
+  /*! \brief Поток. */
+   pthread_t thread;
+ #endif
+ } *ak_file_async_worker;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Последовательное извлечение файлов из очереди и их обработка. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_file_async_process( ak_file_async_worker worker )
+{
+  int error = ak_error_ok;
+  size_t idx = 0;
+  ak_file_async_queue queue = worker->queue;
+
+  for( ;; ) {
+   #ifdef AK_HAVE_PTHREAD_H
+    pthread_mutex_lock( &queue->mutex );
+   #endif
+    idx = queue->next++;
+   #ifdef AK_HAVE_PTHREAD_H
+    pthread_mutex_unlock( &queue->mutex );
+   #endif
+    if( idx >= queue->count ) break;
+
+    error = queue->function( worker->ctx, queue->filenames[idx],
+                                        queue->out + idx*queue->out_size, queue->out_size );
+    if( queue->errors != NULL ) queue->errors[idx] = error;
+    if( error != ak_error_ok ) {
+     #ifdef AK_HAVE_PTHREAD_H
+      pthread_mutex_lock( &queue->mutex );
+     #endif
+      queue->error = error;
+     #ifdef AK_HAVE_PTHREAD_H
+      pthread_mutex_unlock( &queue->mutex );
+     #endif
+    }
+  }
+}
 
- ak_error_message( ak_error_undefined_function, __func__, "this function is'nt well developed" );
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_file_async_thread( void *ptr )
+{
+  ak_file_async_process(( ak_file_async_worker ) ptr );
  return NULL;
 }
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция применяет заданную функцию `function` к каждому файлу из массива `filenames`.
+    Файлы обрабатываются одновременно `ctx_count` потоками, каждый из которых использует
+    собственный контекст из массива `ctx` (например, независимые контексты функции хеширования
+    или копии ключа HMAC); очередной поток берет следующий необработанный файл сразу после
+    завершения обработки предыдущего. Тем самым задержки, связанные с открытием файлов
+    и чтением небольших объемов данных, перекрываются вычислениями других потоков.
+
+    Результат обработки файла с индексом `i` помещается в область памяти `out + i*out_size`,
+    код ошибки -- в `errors[i]`. Пример использования для хеширования файлов:
+
+\code
+    struct hash ctx[4];
+    ak_pointer ptr[4] = { ctx, ctx+1, ctx+2, ctx+3 };
+
+    for( i = 0; i < 4; i++ ) ak_hash_create_streebog256( ctx+i );
+    ak_file_async(( ak_function_file_async *) ak_hash_file, ptr, 4,
+                                                         filenames, count, out, 32, errors );
+\endcode
+
+    Параллельно обрабатываются только разные файлы: каждый файл считывается последовательно
+    одним потоком, поэтому для одного файла в каждый момент времени выполняется не более
+    одной операции чтения.
+
+    Если библиотека собрана без поддержки pthreads, все файлы обрабатываются
+    последовательно с использованием контекста `ctx[0]`.
+
+    \param function Функция обработки одного файла, например, ak_hash_file(), ak_hmac_file()
+    или ak_signkey_sign_file_async().
+    \param ctx Массив контекстов, передаваемых функции обработки.
+    \param ctx_count Количество контекстов, равное количеству используемых потоков.
+    \param filenames Массив имен файлов.
+    \param count Количество файлов.
+    \param out Область памяти для результатов, размером не менее `count*out_size` октетов.
+    \param out_size Размер результата обработки одного файла (в октетах).
+    \param errors Массив из `count` кодов ошибок обработки файлов; может быть равен `NULL`.
+    \return Функция возвращает \ref ak_error_ok, если все файлы обработаны успешно.
+    В противном случае возвращается код одной из возникших ошибок.                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_file_async( ak_function_file_async *function, ak_pointer *ctx, const size_t ctx_count,
+                         const char **filenames, const size_t count, ak_uint8 *out,
+                                                              const size_t out_size, int *errors )
+{
+  size_t idx = 0, threads = 1;
+ #ifdef AK_HAVE_PTHREAD_H
+  size_t done = 1;
+ #endif
+  struct file_async_queue queue;
+  ak_file_async_worker workers = NULL;
+
+  if( function == NULL ) return ak_error_message( ak_error_undefined_function, __func__,
+                                                         "using null pointer to file function" );
+  if(( ctx == NULL ) || ( filenames == NULL ) || ( out == NULL ))
+    return ak_error_message( ak_error_null_pointer, __func__, "using null pointer" );
+  if( !ctx_count ) return ak_error_message( ak_error_zero_length, __func__,
+                                                                "using zero number of contexts" );
+  if( !count ) return ak_error_ok;
+
+  queue.function = function;
+  queue.filenames = filenames;
+  queue.count = count;
+  queue.next = 0;
+  queue.out = out;
+  queue.out_size = out_size;
+  queue.errors = errors;
+  queue.error = ak_error_ok;
+
+ #ifdef AK_HAVE_PTHREAD_H
+  threads = ak_min( ctx_count, count );
+ #endif
+  if(( workers = malloc( threads*sizeof( struct file_async_worker ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__,
+                                                          "incorrect memory allocation for workers" );
+  for( idx = 0; idx < threads; idx++ ) {
+     workers[idx].queue = &queue;
+     workers[idx].ctx = ctx[idx];
+  }
+
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_init( &queue.mutex, NULL );
+ /* запускаем потоки, кроме первого; потоки, которые не удалось создать, не используются */
+  for( idx = 1; idx < threads; idx++, done++ )
+     if( pthread_create( &workers[idx].thread, NULL, ak_file_async_thread, workers+idx ) != 0 )
+       break;
+#endif
+  ak_file_async_process( workers );
+#ifdef AK_HAVE_PTHREAD_H
+  for( idx = 1; idx < done; idx++ ) pthread_join( workers[idx].thread, NULL );
+  pthread_mutex_destroy( &queue.mutex );
+#endif
+
+  free( workers );
+ return queue.error;
+}
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \example example-file.c                                                                        */
@@ -279,6 +279,89 @@
 #endif
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет произведение двух элементов конечного поля \f$ \mathbb F_{2^{64}}\f$ и
+    прибавляет его к значению аккумулятора `r`. Аккумулятор представляет собой массив из двух
+    64-х битных слов, содержащий сумму произведений без приведения по модулю;
+    для получения элемента поля используется функция ak_gf64_reduce().
+
+    Данная реализация вычисляет произведение с приведением, поэтому старшее слово
+    аккумулятора не изменяется.                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_gf64_mul_acc_uint64( ak_pointer r, ak_pointer x, ak_pointer y )
+{
+  ak_uint64 t;
+  ak_gf64_mul_uint64( &t, x, y );
+#ifdef AK_LITTLE_ENDIAN
+  ((ak_uint64 *)r)[0] ^= t;
+#else
+  ((ak_uint64 *)r)[0] ^= bswap_64( t );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет произведение двух элементов конечного поля \f$ \mathbb F_{2^{128}}\f$ и
+    прибавляет его к значению аккумулятора `r`. Аккумулятор представляет собой массив из четырех
+    64-х битных слов, содержащий сумму произведений без приведения по модулю;
+    для получения элемента поля используется функция ak_gf128_reduce().
+
+    Данная реализация вычисляет произведение с приведением, поэтому старшие слова
+    аккумулятора не изменяются.                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_gf128_mul_acc_uint64( ak_pointer r, ak_pointer x, ak_pointer y )
+{
+  ak_uint64 t[2];
+  ak_gf128_mul_uint64( t, x, y );
+#ifdef AK_LITTLE_ENDIAN
+  ((ak_uint64 *)r)[0] ^= t[0];
+  ((ak_uint64 *)r)[1] ^= t[1];
+#else
+  ((ak_uint64 *)r)[0] ^= bswap_64( t[0] );
+  ((ak_uint64 *)r)[1] ^= bswap_64( t[1] );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция приводит 128-ми битный многочлен, хранящийся в аккумуляторе `r`, по модулю
+    многочлена \f$ f(x) = x^{64} + x^4 + x^3 + x + 1 \f$ и помещает результат в `z`.
+    Совместно с функцией ak_gf64_mul_acc() позволяет вычислять сумму нескольких произведений,
+    выполняя только одно приведение.                                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_gf64_reduce( ak_pointer z, ak_pointer r )
+{
+  ak_uint64 h = ((ak_uint64 *)r)[1];
+ /* h*x^64 = h*(x^4 + x^3 + x + 1); биты, вышедшие за границу слова, приводим повторно */
+  ak_uint64 t = h ^ ( h >> 60 ) ^ ( h >> 61 ) ^ ( h >> 63 );
+  ak_uint64 v = ((ak_uint64 *)r)[0] ^ t ^ ( t << 1 ) ^ ( t << 3 ) ^ ( t << 4 );
+#ifdef AK_LITTLE_ENDIAN
+  ((ak_uint64 *)z)[0] = v;
+#else
+  ((ak_uint64 *)z)[0] = bswap_64( v );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция приводит 256-ти битный многочлен, хранящийся в аккумуляторе `r`, по модулю
+    многочлена \f$ f(x) = x^{128} + x^7 + x^2 + x + 1 \f$ и помещает результат в `z`.
+    Совместно с функцией ak_gf128_mul_acc() позволяет вычислять сумму нескольких произведений,
+    выполняя только одно приведение.                                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_gf128_reduce( ak_pointer z, ak_pointer r )
+{
+  ak_uint64 x3 = ((ak_uint64 *)r)[3],
+            d = ((ak_uint64 *)r)[2] ^ ( x3 >> 63 ) ^ ( x3 >> 62 ) ^ ( x3 >> 57 ),
+            v0 = ((ak_uint64 *)r)[0] ^ d ^ ( d << 1 ) ^ ( d << 2 ) ^ ( d << 7 ),
+            v1 = ((ak_uint64 *)r)[1] ^ x3 ^ ( x3 << 1 ) ^ ( x3 << 2 ) ^ ( x3 << 7 )
+                                                       ^ ( d >> 63 ) ^ ( d >> 62 ) ^ ( d >> 57 );
+#ifdef AK_LITTLE_ENDIAN
+  ((ak_uint64 *)z)[0] = v0;
+  ((ak_uint64 *)z)[1] = v1;
+#else
+  ((ak_uint64 *)z)[0] = bswap_64( v0 );
+  ((ak_uint64 *)z)[1] = bswap_64( v1 );
+#endif
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 #ifdef AK_HAVE_BUILTIN_CLMULEPI64
 
@@ -374,6 +457,39 @@
 #endif
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет произведение двух элементов конечного поля \f$ \mathbb F_{2^{64}}\f$
+    как многочленов (без приведения) с помощью команды PCLMULQDQ и прибавляет его
+    к значению аккумулятора `r`.                                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_gf64_mul_acc_pcmulqdq( ak_pointer r, ak_pointer x, ak_pointer y )
+{
+  __m128i xm = _mm_loadl_epi64(( __m128i *)x ), ym = _mm_loadl_epi64(( __m128i *)y );
+  __m128i rm = _mm_loadu_si128(( __m128i *)r );
+
+  rm = _mm_xor_si128( rm, _mm_clmulepi64_si128( xm, ym, 0x00 ));
+  _mm_storeu_si128(( __m128i *)r, rm );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет произведение двух элементов конечного поля \f$ \mathbb F_{2^{128}}\f$
+    как многочленов (без приведения) с помощью команды PCLMULQDQ и прибавляет его
+    к значению аккумулятора `r`.                                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_gf128_mul_acc_pcmulqdq( ak_pointer r, ak_pointer a, ak_pointer b )
+{
+  __m128i am = _mm_loadu_si128(( __m128i *)a ), bm = _mm_loadu_si128(( __m128i *)b );
+  __m128i lo = _mm_loadu_si128(( __m128i *)r ), hi = _mm_loadu_si128((( __m128i *)r ) + 1 );
+  __m128i em = _mm_xor_si128( _mm_clmulepi64_si128( am, bm, 0x10 ),
+                                                          _mm_clmulepi64_si128( am, bm, 0x01 ));
+  lo = _mm_xor_si128( lo, _mm_clmulepi64_si128( am, bm, 0x00 ));
+  hi = _mm_xor_si128( hi, _mm_clmulepi64_si128( am, bm, 0x11 ));
+  lo = _mm_xor_si128( lo, _mm_slli_si128( em, 8 ));
+  hi = _mm_xor_si128( hi, _mm_srli_si128( em, 8 ));
+  _mm_storeu_si128(( __m128i *)r, lo );
+  _mm_storeu_si128((( __m128i *)r ) + 1, hi );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция реализует операцию умножения двух элементов конечного поля \f$ \mathbb F_{2^{256}}\f$,
     порожденного неприводимым многочленом
@@ -807,7 +923,7 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
     0x6130D1DE01730130LL, 0x110E1FE9A3061C6BLL, 0x141AD569FEF4A826LL, 0x03CA3F740C2F3A97LL,
     0x3F3D8540ED565C89LL, 0xCE5E5EC6290234AELL, 0xE28CA103DEDB71FELL, 0x525EBDBB631CE618LL };
 #endif
- ak_uint64 x, y, z = 0, z1 = 0;
+ ak_uint64 x, y, z = 0, z1 = 0, acc[2];
 
  /* сравниваем исходные данные */
   for( i = 0; i < 8; i++ ) {
@@ -877,6 +993,20 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
  if( ak_log_get_level() >= ak_log_maximum )
    ak_error_message( ak_error_ok, __func__, "one thousand iterations for random values is Ok");
 #endif
+
+ /* проверка вычисления суммы произведений с одним приведением */
+ acc[0] = acc[1] = 0; z1 = 0;
+ for( i = 0; i < 7; i++ ) {
+    ak_gf64_mul( &z, &values[i], &values[i+1] );
+    z1 ^= z;
+    ak_gf64_mul_acc( acc, &values[i], &values[i+1] );
+ }
+ ak_gf64_reduce( &z, acc );
+ if( z != z1 ) {
+   ak_error_message( ak_error_not_equal_data, __func__ ,
+                                               "wrong sum of products with deferred reduction" );
+   return ak_false;
+ }
  return ak_true;
 }
 
@@ -894,6 +1024,7 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
  ak_uint8 result[16], result2[16];
 
  ak_uint128 a, b, m;
+ ak_uint64 acc[4];
 #ifdef AK_LITTLE_ENDIAN
   a.q[0] = 0x63746f725d53475dLL; a.q[1] = 0x7b5b546573745665LL;
   b.q[0] = 0x5b477565726f6e5dLL; b.q[1] = 0x4869285368617929LL;
@@ -964,6 +1095,24 @@ void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b )
    ak_error_message( ak_error_ok, __func__, "one thousand iterations for random values is Ok");
 #endif
 
+ /* проверка вычисления суммы произведений с одним приведением */
+ memset( acc, 0, sizeof( acc ));
+ memset( result2, 0, 16 );
+ for( i = 0; i < 8; i++ ) {
+   a.q[0] = b.q[1]; a.q[1] = b.q[0];
+   memcpy( b.b, result, 16 );
+
+   ak_gf128_mul( result, &a, &b );
+   ((ak_uint64 *)result2)[0] ^= ((ak_uint64 *)result)[0];
+   ((ak_uint64 *)result2)[1] ^= ((ak_uint64 *)result)[1];
+   ak_gf128_mul_acc( acc, &a, &b );
+ }
+ ak_gf128_reduce( result, acc );
+ if( !ak_ptr_is_equal_with_log( result, result2, 16 )) {
+   ak_error_message( ak_error_ok, __func__, "wrong sum of products with deferred reduction" );
+   goto lexit;
+ }
+
  return ak_true;
 
   lexit: ak_error_set_value( ak_error_not_equal_data );
@@ -6,6 +6,14 @@
 /* ----------------------------------------------------------------------------------------------- */
  #include <libakrypt-internal.h>
 
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef AK_HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Итерационные константы для алгоритма Стрибог (ГОСТ Р 34.11-2012). */
 /* ---------------------------------------------------------------------------------------------- */
@@ -1169,7 +1177,7 @@
 /*! \brief Преобразование G
     \note Мы предполагаем, что массивы n и m содержат по 64 байта.                                 */
 /* ----------------------------------------------------------------------------------------------- */
- static inline void ak_hash_context_streebog_g( ak_streebog ctx, ak_uint64 *n, const ak_uint64 *m )
+ static void ak_hash_context_streebog_g( ak_streebog ctx, ak_uint64 *n, const ak_uint64 *m )
 {
    int idx = 0;
    ak_uint64 K[8], T[8], B[8];
@@ -1195,6 +1203,222 @@
        for ( idx = 0; idx < 8; idx++ ) ctx->h[idx] ^= T[idx] ^ K[idx] ^ m[idx];
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция одновременного вычисления преобразования G для нескольких контекстов. */
+ typedef void ( ak_function_streebog_g_multi )( ak_streebog * ,
+                                                  ak_uint64 ** , const ak_uint64 ** , const size_t );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Векторные реализации преобразования G.
+    \details Преобразование LPS вычисляется для всего 512-битного состояния сразу: для каждой из
+    восьми таблиц `streebog_Areverse_expand_with_pi` выполняется одна команда выборки
+    (gather) восьми 64-битных значений по индексам, равным байтам соответствующего слова
+    состояния, после чего результаты складываются. Состояние, раундовый ключ и шифруемый
+    текст в течение всех двенадцати раундов хранятся в векторных регистрах.                        */
+/* ----------------------------------------------------------------------------------------------- */
+#if defined( AK_HAVE_BUILTIN_AVX2 ) && defined( AK_HAVE_BUILTIN_CPU_SUPPORTS )
+ #define AK_STREEBOG_SIMD
+ #include <immintrin.h>
+
+#ifdef AK_HAVE_BUILTIN_AVX512
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование LPS, реализованное с использованием инструкций AVX-512. */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx512f,avx512bw" )))
+ static inline __m512i ak_hash_context_streebog_lps_avx512( __m512i x )
+{
+  int idx = 0;
+  ak_uint64 w[8];
+  __m512i r = _mm512_setzero_si512();
+
+  _mm512_storeu_si512( w, x );
+  for( idx = 0; idx < 8; idx++ )
+     r = _mm512_xor_si512( r, _mm512_i64gather_epi64( _mm512_cvtepu8_epi64(
+                                         _mm_cvtsi64_si128(( long long int ) w[idx] )),
+                            ( const void *) streebog_Areverse_expand_with_pi[idx], 8 ));
+ return r;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование G, реализованное с использованием инструкций AVX-512. */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx512f,avx512bw" )))
+ static void ak_hash_context_streebog_g_avx512( ak_streebog ctx, ak_uint64 *n, const ak_uint64 *m )
+{
+   int idx = 0;
+   __m512i h = _mm512_loadu_si512( ctx->h ), vm = _mm512_loadu_si512( m ), K, T;
+
+   if( n != NULL ) K = ak_hash_context_streebog_lps_avx512(
+                                                     _mm512_xor_si512( h, _mm512_loadu_si512( n )));
+     else K = ak_hash_context_streebog_lps_avx512( h );
+
+   for( T = vm, idx = 0; idx < 12; idx++ ) {
+      T = ak_hash_context_streebog_lps_avx512( _mm512_xor_si512( T, K ));
+      K = ak_hash_context_streebog_lps_avx512(
+                                  _mm512_xor_si512( K, _mm512_loadu_si512( streebog_c[idx] )));
+   }
+   _mm512_storeu_si512( ctx->h, _mm512_xor_si512( h, _mm512_xor_si512( T, _mm512_xor_si512( K, vm ))));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Одновременное вычисление преобразования G для нескольких независимых контекстов,
+    реализованное с использованием инструкций AVX-512.
+    \details Вычисления для различных контекстов чередуются внутри каждого раунда, что позволяет
+    процессору совмещать по времени выполнение независимых команд выборки из таблиц.           */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx512f,avx512bw" )))
+ static inline void ak_hash_context_streebog_g_lanes_avx512( ak_streebog *ctx,
+                                           ak_uint64 **n, const ak_uint64 **m, const size_t count )
+{
+   size_t idx = 0, i = 0;
+   __m512i h[ak_streebog_lanes], vm[ak_streebog_lanes], K[ak_streebog_lanes], T[ak_streebog_lanes];
+
+   for( i = 0; i < count; i++ ) {
+      h[i] = _mm512_loadu_si512( ctx[i]->h );
+      T[i] = vm[i] = _mm512_loadu_si512( m[i] );
+      if( n[i] != NULL ) K[i] = _mm512_xor_si512( h[i], _mm512_loadu_si512( n[i] ));
+        else K[i] = h[i];
+   }
+   for( i = 0; i < count; i++ ) K[i] = ak_hash_context_streebog_lps_avx512( K[i] );
+
+   for( idx = 0; idx < 12; idx++ ) {
+      __m512i c = _mm512_loadu_si512( streebog_c[idx] );
+      for( i = 0; i < count; i++ )
+         T[i] = ak_hash_context_streebog_lps_avx512( _mm512_xor_si512( T[i], K[i] ));
+      for( i = 0; i < count; i++ )
+         K[i] = ak_hash_context_streebog_lps_avx512( _mm512_xor_si512( K[i], c ));
+   }
+   for( i = 0; i < count; i++ )
+      _mm512_storeu_si512( ctx[i]->h,
+                        _mm512_xor_si512( h[i], _mm512_xor_si512( T[i], _mm512_xor_si512( K[i], vm[i] ))));
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx512f,avx512bw" )))
+ static void ak_hash_context_streebog_g_multi_avx512( ak_streebog *ctx,
+                                           ak_uint64 **n, const ak_uint64 **m, const size_t count )
+{
+  /* при постоянном количестве контекстов все данные размещаются в регистрах */
+   if( count == ak_streebog_lanes )
+     ak_hash_context_streebog_g_lanes_avx512( ctx, n, m, ak_streebog_lanes );
+    else ak_hash_context_streebog_g_lanes_avx512( ctx, n, m, count );
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование LPS, реализованное с использованием инструкций AVX2
+    (состояние хранится в двух 256-битных регистрах). */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx2" )))
+ static inline void ak_hash_context_streebog_lps_avx2( __m256i *lo, __m256i *hi )
+{
+  int idx = 0;
+  ak_uint64 w[8];
+  __m256i rl = _mm256_setzero_si256(), rh = _mm256_setzero_si256();
+
+  _mm256_storeu_si256(( __m256i *) w, *lo );
+  _mm256_storeu_si256(( __m256i *)( w+4 ), *hi );
+  for( idx = 0; idx < 8; idx++ ) {
+     __m128i b = _mm_cvtsi64_si128(( long long int ) w[idx] );
+     const long long int *tb = ( const long long int *) streebog_Areverse_expand_with_pi[idx];
+
+     rl = _mm256_xor_si256( rl, _mm256_i64gather_epi64( tb, _mm256_cvtepu8_epi64( b ), 8 ));
+     rh = _mm256_xor_si256( rh,
+                       _mm256_i64gather_epi64( tb, _mm256_cvtepu8_epi64( _mm_srli_si128( b, 4 )), 8 ));
+  }
+  *lo = rl; *hi = rh;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Преобразование G, реализованное с использованием инструкций AVX2. */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx2" )))
+ static void ak_hash_context_streebog_g_avx2( ak_streebog ctx, ak_uint64 *n, const ak_uint64 *m )
+{
+   int idx = 0;
+   __m256i hl = _mm256_loadu_si256(( const __m256i *) ctx->h ),
+           hh = _mm256_loadu_si256(( const __m256i *)( ctx->h+4 )),
+           ml = _mm256_loadu_si256(( const __m256i *) m ),
+           mh = _mm256_loadu_si256(( const __m256i *)( m+4 )), kl = hl, kh = hh, tl = ml, th = mh;
+
+   if( n != NULL ) {
+     kl = _mm256_xor_si256( kl, _mm256_loadu_si256(( const __m256i *) n ));
+     kh = _mm256_xor_si256( kh, _mm256_loadu_si256(( const __m256i *)( n+4 )));
+   }
+   ak_hash_context_streebog_lps_avx2( &kl, &kh );
+
+   for( idx = 0; idx < 12; idx++ ) {
+      tl = _mm256_xor_si256( tl, kl );
+      th = _mm256_xor_si256( th, kh );
+      ak_hash_context_streebog_lps_avx2( &tl, &th );
+      kl = _mm256_xor_si256( kl, _mm256_loadu_si256(( const __m256i *) streebog_c[idx] ));
+      kh = _mm256_xor_si256( kh, _mm256_loadu_si256(( const __m256i *)( streebog_c[idx]+4 )));
+      ak_hash_context_streebog_lps_avx2( &kl, &kh );
+   }
+   _mm256_storeu_si256(( __m256i *) ctx->h,
+                              _mm256_xor_si256( hl, _mm256_xor_si256( tl, _mm256_xor_si256( kl, ml ))));
+   _mm256_storeu_si256(( __m256i *)( ctx->h+4 ),
+                              _mm256_xor_si256( hh, _mm256_xor_si256( th, _mm256_xor_si256( kh, mh ))));
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция выбирает реализацию преобразования G, наиболее подходящую для используемого
+    процессора. Если векторные расширения недоступны (на этапе сборки или выполнения),
+    используется табличная реализация.
+
+    @param backend Значение опции `streebog_simd_backend`: 0 - табличная реализация,
+    1 - векторная реализация только при наличии AVX-512 (на остальных процессорах
+    табличная реализация не медленнее), 2 - любая доступная векторная реализация.
+    @return Указатель на функцию, реализующую преобразование G.                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_function_streebog_g *ak_hash_context_streebog_select_g( int backend )
+{
+#ifdef AK_STREEBOG_SIMD
+  if( backend > 0 ) {
+    __builtin_cpu_init();
+   #ifdef AK_HAVE_BUILTIN_AVX512
+    if( __builtin_cpu_supports( "avx512f" ))
+      return ak_hash_context_streebog_g_avx512;
+   #endif
+    if(( backend > 1 ) && __builtin_cpu_supports( "avx2" ))
+      return ak_hash_context_streebog_g_avx2;
+  }
+#else
+  (void)backend;
+#endif
+ return ak_hash_context_streebog_g;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление преобразования G для нескольких независимых контекстов
+    (каждый контекст использует собственную реализацию преобразования). */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_hash_context_streebog_g_multi( ak_streebog *ctx,
+                                           ak_uint64 **n, const ak_uint64 **m, const size_t count )
+{
+  size_t i = 0;
+  for( i = 0; i < count; i++ ) ctx[i]->g( ctx[i], n[i], m[i] );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция выбирает реализацию одновременного вычисления преобразования G
+    для нескольких контекстов, соответствующую реализации преобразования G одного контекста.
+
+    @param g Реализация преобразования G, используемая контекстом алгоритма хеширования.
+    @return Указатель на функцию одновременного вычисления преобразования G.                      */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_function_streebog_g_multi *ak_hash_context_streebog_select_g_multi(
+                                                                        ak_function_streebog_g *g )
+{
+#if defined( AK_STREEBOG_SIMD ) && defined( AK_HAVE_BUILTIN_AVX512 )
+  if( g == ak_hash_context_streebog_g_avx512 ) return ak_hash_context_streebog_g_multi_avx512;
+#else
+  (void)g;
+#endif
+ return ak_hash_context_streebog_g_multi;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Преобразование Add (увеличение счетчика длины обработаного сообщения).                  */
 /* ----------------------------------------------------------------------------------------------- */
@@ -1272,7 +1496,7 @@
   if(( size - ( quot << 6 )) != 0 ) return ak_error_message( ak_error_wrong_length, __func__,
                                       "data length is not a multiple of the length of the block" );
   do{
-      ak_hash_context_streebog_g( cx, cx->n, dt );
+      cx->g( cx, cx->n, dt );
       ak_hash_context_streebog_add( cx, 512 );
       ak_hash_context_streebog_sadd( cx, dt );
       quot--; dt += 8;
@@ -1282,17 +1506,16 @@
 }
 
 /* ----------------------------------------------------------------------------------------------- */
- static int ak_hash_context_streebog_finalize( ak_pointer sctx,
+/*! \brief Завершение вычислений над заданным состоянием алгоритма хеширования.
+
+    Функция изменяет переданное ей состояние `sx`.                                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline int ak_hash_context_streebog_finalize_state( ak_streebog sx,
                    const ak_pointer in, const size_t size, ak_pointer out, const size_t out_size )
 {
   ak_uint64 m[8];
-  int result = ak_error_ok;
   ak_uint8 *mhide = NULL;
-  ak_streebog cx = ( ak_streebog )sctx;
-  struct streebog sx; /* структура для хранения копии текущего состояния контекста */
 
-  if( cx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
-                                               "using null pointer to internal streebog context" );
   if( out == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                    "using null pointer to externl result buffer" );
   if( size >= 64 ) return ak_error_message( ak_error_wrong_length, __func__,
@@ -1304,18 +1527,38 @@
   mhide = ( ak_uint8 * )m;
   mhide[size] = 1; /* дополнение */
 
-  /* при финализации мы изменяем копию существующей структуры */
-  memcpy( &sx, cx, sizeof( struct streebog ));
-  ak_hash_context_streebog_g( &sx, sx.n, m );
-  ak_hash_context_streebog_add( &sx, size << 3 );
-  ak_hash_context_streebog_sadd( &sx, m );
-  ak_hash_context_streebog_g( &sx, NULL, sx.n );
-  ak_hash_context_streebog_g( &sx, NULL, sx.sigma );
+  sx->g( sx, sx->n, m );
+  ak_hash_context_streebog_add( sx, size << 3 );
+  ak_hash_context_streebog_sadd( sx, m );
+  sx->g( sx, NULL, sx->n );
+  sx->g( sx, NULL, sx->sigma );
 
  /* копируем нужную часть результирующего массива или выдаем сообщение об ошибке */
-    if( cx->hsize == 64 ) memcpy( out, sx.h, ak_min( 64, out_size ));
-      else memcpy( out, sx.h+4, ak_min( 32, out_size ));
- return result;
+    if( sx->hsize == 64 ) memcpy( out, sx->h, ak_min( 64, out_size ));
+      else memcpy( out, sx->h+4, ak_min( 32, out_size ));
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hash_context_streebog_finalize( ak_pointer sctx,
+                   const ak_pointer in, const size_t size, ak_pointer out, const size_t out_size )
+{
+  struct streebog sx; /* структура для хранения копии текущего состояния контекста */
+
+  if( sctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                               "using null pointer to internal streebog context" );
+  /* при финализации мы изменяем копию существующей структуры */
+  memcpy( &sx, sctx, sizeof( struct streebog ));
+ return ak_hash_context_streebog_finalize_state( &sx, in, size, out, out_size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hash_context_streebog_finalize_inplace( ak_pointer sctx,
+                   const ak_pointer in, const size_t size, ak_pointer out, const size_t out_size )
+{
+  if( sctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                               "using null pointer to internal streebog context" );
+ return ak_hash_context_streebog_finalize_state( sctx, in, size, out, out_size );
 }
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -1333,6 +1576,8 @@
   if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                             "using null pointer to hash context" );
   hctx->data.sctx.hsize = 32;
+  hctx->data.sctx.g = ak_hash_context_streebog_select_g(
+                                (int) ak_libakrypt_get_option_by_name( "streebog_simd_backend" ));
   if(( hctx->oid = ak_oid_find_by_name( "streebog256" )) == NULL )
     return ak_error_message( ak_error_wrong_oid, __func__,
                                            "incorrect internal search of streebog256 identifier" );
@@ -1341,6 +1586,7 @@
                                              ak_hash_context_streebog_update,
                                              ak_hash_context_streebog_finalize )) != ak_error_ok )
     return ak_error_message( error, __func__, "incorrect initialization of internal mac context" );
+  hctx->mctx.finalize_inplace = ak_hash_context_streebog_finalize_inplace;
 
   return ak_hash_context_streebog_clean( &hctx->data.sctx );
 }
@@ -1358,6 +1604,8 @@
   if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                             "using null pointer to hash context" );
   hctx->data.sctx.hsize = 64;
+  hctx->data.sctx.g = ak_hash_context_streebog_select_g(
+                                (int) ak_libakrypt_get_option_by_name( "streebog_simd_backend" ));
   if(( hctx->oid = ak_oid_find_by_name( "streebog512" )) == NULL )
     return ak_error_message( ak_error_wrong_oid, __func__,
                                            "incorrect internal search of streebog256 identifier" );
@@ -1366,6 +1614,7 @@
                                              ak_hash_context_streebog_update,
                                              ak_hash_context_streebog_finalize )) != ak_error_ok )
     return ak_error_message( error, __func__, "incorrect initialization of internal mac context" );
+  hctx->mctx.finalize_inplace = ak_hash_context_streebog_finalize_inplace;
 
   return ak_hash_context_streebog_clean( &hctx->data.sctx );
 }
@@ -1476,6 +1725,247 @@
  return ak_mac_ptr( &hctx->mctx, in, size, out, out_size );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Состояние вычисления хеш-кода одного сообщения при одновременной обработке
+    нескольких сообщений. */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct streebog_lane {
+  /*! \brief Контекст, в котором вычисляется хеш-код сообщения */
+   struct streebog sx;
+  /*! \brief Последний (дополненный) блок сообщения */
+   ak_uint64 m[8];
+  /*! \brief Указатель на очередной полный блок сообщения */
+   const ak_uint8 *ptr;
+  /*! \brief Количество необработанных полных блоков сообщения */
+   size_t blocks;
+  /*! \brief Длина последнего блока сообщения (в октетах) */
+   size_t tail;
+  /*! \brief Номер выполняемого заключительного преобразования */
+   int stage;
+  /*! \brief Номер обрабатываемого сообщения */
+   size_t index;
+ } *ak_streebog_lane;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Подготовка к вычислению хеш-кода очередного сообщения. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_hash_streebog_lane_load( ak_streebog_lane lane, ak_streebog cx,
+                                                     const ak_uint8 *in, size_t size, size_t index )
+{
+  memcpy( &lane->sx, cx, sizeof( struct streebog ));
+  ak_hash_context_streebog_clean( &lane->sx );
+
+  lane->ptr = in;
+  lane->blocks = size >> 6;
+  lane->tail = size - ( lane->blocks << 6 );
+  memset( lane->m, 0, 64 );
+  if( lane->tail ) memcpy( lane->m, in + ( lane->blocks << 6 ), lane->tail );
+  (( ak_uint8 *)lane->m )[lane->tail] = 1; /* дополнение */
+  lane->stage = 1;
+  lane->index = index;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция определяет аргументы очередного вызова преобразования G. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_hash_streebog_lane_args( ak_streebog_lane lane,
+                                              ak_streebog *ctx, ak_uint64 **n, const ak_uint64 **m )
+{
+  *ctx = &lane->sx;
+  if( lane->blocks ) {
+    *n = lane->sx.n; *m = ( const ak_uint64 *) lane->ptr;
+    return;
+  }
+  switch( lane->stage ) {
+    case 1:  *n = lane->sx.n; *m = lane->m; break;
+    case 2:  *n = NULL; *m = lane->sx.n; break;
+    default: *n = NULL; *m = lane->sx.sigma; break;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция изменяет состояние после вызова преобразования G.
+    @return Функция возвращает ложь, если вычисление хеш-кода сообщения завершено.                */
+/* ----------------------------------------------------------------------------------------------- */
+ static bool_t ak_hash_streebog_lane_next( ak_streebog_lane lane )
+{
+  if( lane->blocks ) {
+    ak_hash_context_streebog_add( &lane->sx, 512 );
+    ak_hash_context_streebog_sadd( &lane->sx, ( const ak_uint64 *) lane->ptr );
+    lane->ptr += 64; lane->blocks--;
+    return ak_true;
+  }
+  switch( lane->stage ) {
+    case 1: ak_hash_context_streebog_add( &lane->sx, lane->tail << 3 );
+            ak_hash_context_streebog_sadd( &lane->sx, lane->m );
+            lane->stage = 2;
+            return ak_true;
+    case 2: lane->stage = 3;
+            return ak_true;
+    default: return ak_false;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет хеш-коды нескольких независимых сообщений. Сообщения обрабатываются
+    одновременно (до \ref ak_streebog_lanes сообщений): на каждом шаге преобразование G вычисляется
+    сразу для всех обрабатываемых сообщений, что позволяет процессору чередовать выполнение
+    независимых команд. После завершения обработки одного из сообщений его место занимает
+    следующее сообщение, поэтому длины сообщений могут существенно различаться.
+
+    Функция предназначена для хеширования большого количества коротких сообщений и
+    поддерживает только алгоритмы семейства Стрибог. Состояние контекста hctx не изменяется.
+
+    @param hctx Контекст функции хеширования
+    @param count Количество сообщений.
+    @param in Массив указателей на сообщения.
+    @param size Массив длин сообщений (в октетах).
+    @param out Массив указателей на области памяти, в которые помещаются хеш-коды сообщений.
+    @param out_size Размер каждой из областей памяти out (в октетах).
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_ptr_multi( ak_hash hctx, const size_t count, ak_pointer *in,
+                                       const size_t *size, ak_pointer *out, const size_t out_size )
+{
+  ak_streebog cx = NULL;
+  size_t i = 0, next = 0, active = 0;
+  ak_function_streebog_g_multi *gm = NULL;
+  struct streebog_lane lanes[ak_streebog_lanes];
+  ak_streebog ctx[ak_streebog_lanes];
+  ak_uint64 *n[ak_streebog_lanes];
+  const ak_uint64 *m[ak_streebog_lanes];
+
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hash context" );
+  if( !count ) return ak_error_ok;
+  if(( in == NULL ) || ( size == NULL ) || ( out == NULL ))
+    return ak_error_message( ak_error_null_pointer, __func__, "using null pointer to data arrays" );
+  if( hctx->mctx.update != ak_hash_context_streebog_update )
+    return ak_error_message( ak_error_oid_engine, __func__,
+                                         "multi-buffer hashing is supported only for streebog" );
+  for( i = 0; i < count; i++ ) {
+     if(( out[i] == NULL ) || (( in[i] == NULL ) && ( size[i] != 0 )))
+       return ak_error_message_fmt( ak_error_null_pointer, __func__,
+                                         "using null pointer to message %u", (unsigned int) i );
+  }
+
+  cx = &hctx->data.sctx;
+  gm = ak_hash_context_streebog_select_g_multi( cx->g );
+  for( active = 0; ( active < ak_streebog_lanes ) && ( next < count ); active++, next++ )
+     ak_hash_streebog_lane_load( lanes+active, cx, in[next], size[next], next );
+
+  while( active > 0 ) {
+    for( i = 0; i < active; i++ ) ak_hash_streebog_lane_args( lanes+i, ctx+i, n+i, m+i );
+    gm( ctx, n, m, active );
+
+    for( i = 0; i < active; ) {
+       if( ak_hash_streebog_lane_next( lanes+i )) { i++; continue; }
+
+      /* хеш-код сообщения вычислен, освобождаем полосу */
+       if( cx->hsize == 64 ) memcpy( out[lanes[i].index], lanes[i].sx.h, ak_min( 64, out_size ));
+         else memcpy( out[lanes[i].index], lanes[i].sx.h+4, ak_min( 32, out_size ));
+       if( next < count ) {
+         ak_hash_streebog_lane_load( lanes+i, cx, in[next], size[next], next );
+         next++; i++;
+       }
+        else if( i != --active ) memcpy( lanes+i, lanes+active, sizeof( struct streebog_lane ));
+    }
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция реализует внутренний цикл алгоритма PBKDF2 (Р 50.1.111-2016) для функции
+    HMAC-Стрибог512: для каждой из `count` независимых цепочек `iterations` раз вычисляется
+    значение \f$ U_j = \text{HMAC}(P, U_{j-1}) \f$, которое помещается в `u[i]`
+    и прибавляется к сумме `t[i]`.
+
+    Поскольку длина сообщения \f$ U_{j-1} \f$ фиксирована и равна 64 октетам, вычисление HMAC
+    сводится к восьми вызовам преобразования G без использования временного буффера
+    и проверок класса mac. Цепочки обрабатываются одновременно функцией, выбираемой
+    ak_hash_context_streebog_select_g_multi().
+
+    @param ipad Массив состояний функции хеширования после обработки блока \f$ K \oplus ipad \f$.
+    @param opad Массив состояний функции хеширования после обработки блока \f$ K \oplus opad \f$.
+    @param u Массив значений \f$ U_{j} \f$ (по 64 октета).
+    @param t Массив сумм значений \f$ U_{j} \f$ (по 64 октета).
+    @param count Количество цепочек, не более \ref ak_streebog_lanes.
+    @param iterations Количество итераций.                                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_hash_context_streebog_hmac_iterate( ak_streebog *ipad, ak_streebog *opad,
+                  ak_uint64 **u, ak_uint64 **t, const size_t count, const size_t iterations )
+{
+  size_t i = 0, j = 0, k = 0;
+  struct streebog inner[ak_streebog_lanes], outer[ak_streebog_lanes];
+  ak_streebog pin[ak_streebog_lanes], pout[ak_streebog_lanes];
+  ak_uint64 *nin[ak_streebog_lanes], *nout[ak_streebog_lanes], *zero[ak_streebog_lanes];
+  const ak_uint64 *msg[ak_streebog_lanes], *pad[ak_streebog_lanes];
+  ak_uint64 m[8] = { 0x01, 0, 0, 0, 0, 0, 0, 0 }; /* дополнение пустого последнего блока */
+  ak_function_streebog_g_multi *g_multi = NULL;
+
+  if(( count == 0 ) || ( count > ak_streebog_lanes )) return;
+ #ifndef AK_LITTLE_ENDIAN
+  m[0] = bswap_64( m[0] );
+ #endif
+  g_multi = ak_hash_context_streebog_select_g_multi( ipad[0]->g );
+  for( i = 0; i < count; i++ ) {
+     pin[i] = inner+i; nin[i] = inner[i].n;
+     pout[i] = outer+i; nout[i] = outer[i].n;
+     zero[i] = NULL; pad[i] = m;
+  }
+
+  for( j = 0; j < iterations; j++ ) {
+    /* внутреннее преобразование: H( K xor ipad || U_{j-1} ) */
+     for( i = 0; i < count; i++ ) {
+        memcpy( inner+i, ipad[i], sizeof( struct streebog ));
+        msg[i] = u[i];
+     }
+     g_multi( pin, nin, msg, count );
+     for( i = 0; i < count; i++ ) {
+        ak_hash_context_streebog_add( inner+i, 512 );
+        ak_hash_context_streebog_sadd( inner+i, u[i] );
+     }
+     g_multi( pin, nin, pad, count );
+     for( i = 0; i < count; i++ ) {
+        ak_hash_context_streebog_sadd( inner+i, m );
+        msg[i] = inner[i].n;
+     }
+     g_multi( pin, zero, msg, count );
+     for( i = 0; i < count; i++ ) msg[i] = inner[i].sigma;
+     g_multi( pin, zero, msg, count );
+
+    /* внешнее преобразование: H( K xor opad || H( K xor ipad || U_{j-1} )) */
+     for( i = 0; i < count; i++ ) {
+        memcpy( outer+i, opad[i], sizeof( struct streebog ));
+        msg[i] = inner[i].h;
+     }
+     g_multi( pout, nout, msg, count );
+     for( i = 0; i < count; i++ ) {
+        ak_hash_context_streebog_add( outer+i, 512 );
+        ak_hash_context_streebog_sadd( outer+i, inner[i].h );
+     }
+     g_multi( pout, nout, pad, count );
+     for( i = 0; i < count; i++ ) {
+        ak_hash_context_streebog_sadd( outer+i, m );
+        msg[i] = outer[i].n;
+     }
+     g_multi( pout, zero, msg, count );
+     for( i = 0; i < count; i++ ) msg[i] = outer[i].sigma;
+     g_multi( pout, zero, msg, count );
+
+    /* новое значение U_j и сумма */
+     for( i = 0; i < count; i++ )
+        for( k = 0; k < 8; k++ ) t[i][k] ^= ( u[i][k] = outer[i].h[k] );
+  }
+
+ /* очищаем промежуточные состояния */
+  memset( inner, 0, sizeof( inner ));
+  memset( outer, 0, sizeof( outer ));
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! @param hctx Контекст функции хеширования
     @param filename Имя файла, для котрого вычисляется хеш-код.
@@ -1523,6 +2013,25 @@
  return ak_mac_update( &hctx->mctx, in, size );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция обновляет состояние контекста последовательностью фрагментов данных, расположенных
+    в несвязных областях памяти. Результат совпадает с результатом последовательного вызова
+    функции ak_hash_update() для каждого фрагмента.
+
+    @param hctx Контекст функции хеширования
+    @param iov Массив фрагментов хешируемых данных.
+    @param count Количество элементов массива.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_updatev( ak_hash hctx, const struct iovector *iov, const size_t count )
+{
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                         "updating null pointer to hash context" );
+ return ak_mac_updatev( &hctx->mctx, iov, count );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! @param hctx Контекст функции хеширования
     @param in Указатель на входные данные для которых вычисляется хеш-код.
@@ -1543,6 +2052,545 @@
  return ak_mac_finalize( &hctx->mctx, in, size, out, out_size );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция аналогична функции ak_hash_finalize(), однако результат вычисляется непосредственно
+    над внутренним состоянием контекста, без создания его копии. Функция предназначена для
+    случаев, когда промежуточное состояние после вычисления хеш-кода не требуется.
+
+    \note После вызова функции контекст должен быть очищен с помощью ak_hash_clean().
+
+    @param hctx Контекст функции хеширования
+    @param in Указатель на входные данные для которых вычисляется хеш-код.
+    @param size Размер входных данных в байтах.
+    @param out Область памяти, куда будет помещен результат. Память должна быть заранее выделена.
+    @param out_size Размер области памяти (в октетах), в которую будет помещен результат.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_finalize_inplace( ak_hash hctx, const ak_pointer in, const size_t size,
+                                                           ak_pointer out, const size_t out_size )
+{
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                       "finalizing null pointer to hash context" );
+ return ak_mac_finalize_inplace( &hctx->mctx, in, size, out, out_size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                     Сохранение и восстановление промежуточного состояния                        */
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция записывает в `out` тело сохраняемого состояния длины \ref ak_hash_state_body_size
+    октетов. Формат тела:
+
+     - 1 октет  -- версия формата (значение `version`),
+     - 1 октет  -- длина хеш-кода,
+     - 1 октет  -- длина блока входных данных,
+     - 1 октет  -- количество октетов во временном буффере контекста `mctx`,
+     - 64 октета -- вектор h,
+     - 64 октета -- вектор n,
+     - 64 октета -- вектор \f$ \Sigma \f$,
+     - 64 октета -- временный буффер контекста `mctx` (неиспользуемая часть заполняется нулями).
+
+    Векторы записываются в том виде, в котором они хранятся в контексте.
+
+    @param hctx Контекст функции хеширования, внутреннее состояние которой сохраняется.
+    @param mctx Контекст итерационного сжатия, временный буффер которого сохраняется
+    (для бесключевой функции хеширования совпадает с `hctx->mctx`).
+    @param version Версия формата.
+    @param out Область памяти, в которую помещается тело состояния.
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_export_state( ak_hash hctx, ak_mac mctx, ak_uint8 version, ak_uint8 *out )
+{
+  ak_streebog cx = NULL;
+
+  if(( hctx == NULL ) || ( mctx == NULL )) return ak_error_message( ak_error_null_pointer,
+                                                   __func__, "using null pointer to hash context" );
+  if( out == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using null pointer to output buffer" );
+  if( hctx->mctx.update != ak_hash_context_streebog_update )
+    return ak_error_message( ak_error_oid_engine, __func__,
+                                     "state export is supported only for streebog hash functions" );
+  cx = &hctx->data.sctx;
+  out[0] = version;
+  out[1] = ( ak_uint8 ) cx->hsize;
+  out[2] = ( ak_uint8 ) mctx->bsize;
+  out[3] = ( ak_uint8 ) mctx->length;
+  memcpy( out +   4, cx->h, 64 );
+  memcpy( out +  68, cx->n, 64 );
+  memcpy( out + 132, cx->sigma, 64 );
+  memset( out + 196, 0, 64 );
+  memcpy( out + 196, mctx->data, mctx->length );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция восстанавливает внутреннее состояние из тела, сформированного функцией
+    ak_hash_context_export_state(). Перед изменением контекстов проверяется согласованность
+    заголовка с параметрами контекстов.
+
+    @param hctx Контекст функции хеширования, внутреннее состояние которой восстанавливается.
+    @param mctx Контекст итерационного сжатия, временный буффер которого восстанавливается.
+    @param version Ожидаемая версия формата.
+    @param in Тело сохраненного состояния.
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_context_import_state( ak_hash hctx, ak_mac mctx, ak_uint8 version, const ak_uint8 *in )
+{
+  ak_streebog cx = NULL;
+
+  if(( hctx == NULL ) || ( mctx == NULL )) return ak_error_message( ak_error_null_pointer,
+                                                   __func__, "using null pointer to hash context" );
+  if( in == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to input buffer" );
+  if( hctx->mctx.update != ak_hash_context_streebog_update )
+    return ak_error_message( ak_error_oid_engine, __func__,
+                                     "state import is supported only for streebog hash functions" );
+  cx = &hctx->data.sctx;
+  if( in[0] != version ) return ak_error_message_fmt( ak_error_undefined_value, __func__,
+                                              "unsupported state format version (%u)", in[0] );
+  if( in[1] != cx->hsize ) return ak_error_message( ak_error_wrong_oid, __func__,
+                                                "state was exported from other hash function" );
+  if(( in[2] != mctx->bsize ) || ( in[3] >= mctx->bsize ))
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                    "using state with wrong length of buffer" );
+  memcpy( cx->h, in +   4, 64 );
+  memcpy( cx->n, in +  68, 64 );
+  memcpy( cx->sigma, in + 132, 64 );
+  memset( mctx->data, 0, sizeof( mctx->data ));
+  memcpy( mctx->data, in + 196, mctx->length = in[3] );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция сохраняет промежуточное состояние контекста функции хеширования в виде
+    последовательности из \ref ak_hash_state_size октетов: тело состояния
+    (см. ak_hash_context_export_state()), за которым следует контрольная сумма Флетчера тела.
+    Состояние может быть восстановлено функцией ak_hash_import_state() в том же или другом
+    процессе, после чего вычисления могут быть продолжены. Контекст не изменяется.
+
+    @param hctx Контекст функции хеширования
+    @param out Область памяти, в которую помещается состояние.
+    @param out_size Размер области памяти (в октетах); должен быть не менее \ref ak_hash_state_size.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_export_state( ak_hash hctx, ak_pointer out, const size_t out_size )
+{
+  int error = ak_error_ok;
+  ak_uint32 icode = 0;
+  ak_uint8 *ptr = ( ak_uint8 *) out;
+
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hash context" );
+  if(( out == NULL ) || ( out_size < ak_hash_state_size ))
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                   "using output buffer with insufficient length" );
+  if(( error = ak_hash_context_export_state( hctx,
+                                    &hctx->mctx, ak_hash_state_version, ptr )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect export of hash context state" );
+
+  ak_ptr_fletcher32( ptr, ak_hash_state_body_size, &icode );
+  memcpy( ptr + ak_hash_state_body_size, &icode, 4 );
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Контекст должен быть предварительно создан для той же функции хеширования, для которой
+    было сохранено состояние.
+
+    @param hctx Контекст функции хеширования
+    @param in Область памяти, содержащая состояние, сохраненное функцией ak_hash_export_state().
+    @param size Размер области памяти (в октетах).
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_import_state( ak_hash hctx, const ak_pointer in, const size_t size )
+{
+  int error = ak_error_ok;
+  ak_uint32 icode = 0;
+  const ak_uint8 *ptr = ( const ak_uint8 *) in;
+
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hash context" );
+  if(( in == NULL ) || ( size != ak_hash_state_size ))
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                          "using state with unexpected length" );
+  ak_ptr_fletcher32( ptr, ak_hash_state_body_size, &icode );
+  if( memcmp( ptr + ak_hash_state_body_size, &icode, 4 ))
+    return ak_error_message( ak_error_not_equal_data, __func__,
+                                                    "using state with wrong integrity code" );
+  if(( error = ak_hash_context_import_state( hctx,
+                                    &hctx->mctx, ak_hash_state_version, ptr )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect import of hash context state" );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                   Древовидный режим хеширования (хеш-дерево Меркла)                             */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Длина листа хеш-дерева (в октетах). */
+ #define ak_hash_tree_leaf_size       (65536)
+/*! \brief Количество листьев, обрабатываемых одним потоком за один проход. */
+ #define ak_hash_tree_thread_leaves      (16)
+/*! \brief Максимальное количество потоков, вычисляющих хеш-коды листьев. */
+ #define ak_hash_tree_max_threads        (64)
+/*! \brief Максимальная высота хеш-дерева. */
+ #define ak_hash_tree_max_height         (64)
+
+/*! \brief Функция чтения очередного фрагмента хешируемых данных. */
+ typedef ssize_t ( ak_function_hash_tree_read )( ak_pointer , ak_uint8 * , size_t );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Стек вершин хеш-дерева, для которых еще не вычислена родительская вершина. */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct hash_tree {
+  /*! \brief Контекст функции хеширования */
+   ak_hash hctx;
+  /*! \brief Хеш-коды вершин */
+   ak_uint8 nodes[ak_hash_tree_max_height][64];
+  /*! \brief Высоты поддеревьев, соответствующих вершинам */
+   size_t levels[ak_hash_tree_max_height];
+  /*! \brief Количество вершин в стеке */
+   size_t height;
+  /*! \brief Количество обработанных листьев */
+   ak_uint64 leaves;
+ } *ak_hash_tree;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Фрагмент последовательности листьев, обрабатываемый одним потоком. */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct hash_tree_fragment {
+  /*! \brief Контекст функции хеширования */
+   ak_hash hctx;
+  /*! \brief Указатель на первый лист фрагмента (с префиксом) */
+   ak_uint8 *leaves;
+  /*! \brief Длины листьев фрагмента (с префиксом) */
+   size_t *sizes;
+  /*! \brief Количество листьев */
+   size_t count;
+  /*! \brief Область памяти для хеш-кодов листьев */
+   ak_uint8 *hashes;
+  /*! \brief Код ошибки */
+   int error;
+ #ifdef AK_HAVE_PTHREAD_H
+  /*! \brief Поток, обрабатывающий фрагмент */
+   pthread_t thread;
+ #endif
+ } *ak_hash_tree_fragment;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление хеш-кодов листьев одного фрагмента. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_hash_tree_fragment_leaves( ak_hash_tree_fragment fr )
+{
+  size_t i = 0, hsize = fr->hctx->data.sctx.hsize;
+  ak_pointer in[ak_hash_tree_thread_leaves], out[ak_hash_tree_thread_leaves];
+
+  for( i = 0; i < fr->count; i++ ) {
+     in[i] = fr->leaves + i*( ak_hash_tree_leaf_size + 1 );
+     out[i] = fr->hashes + i*hsize;
+  }
+  fr->error = ak_hash_ptr_multi( fr->hctx, fr->count, in, fr->sizes, out, hsize );
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_hash_tree_thread( void *ptr )
+{
+  ak_hash_tree_fragment_leaves(( ak_hash_tree_fragment ) ptr );
+ return NULL;
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество потоков, используемых для хеширования данных заданного объема. */
+/* ----------------------------------------------------------------------------------------------- */
+ static size_t ak_hash_tree_get_threads_count( ak_uint64 size )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  ak_uint64 count = ( ak_uint64 ) ak_libakrypt_get_option_by_name( "hash_tree_threads" );
+
+  if( count == 0 ) {
+   #if defined( AK_HAVE_UNISTD_H ) && defined( _SC_NPROCESSORS_ONLN )
+    long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+    count = ( cpus > 0 ) ? ( ak_uint64 ) cpus : 1;
+   #else
+    count = 1;
+   #endif
+  }
+  count = ak_min( count, size/( ak_hash_tree_leaf_size*ak_hash_tree_thread_leaves ));
+ return ( size_t ) ak_max( 1, ak_min( count, ak_hash_tree_max_threads ));
+#else
+  (void)size;
+ return 1;
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление хеш-кода внутренней вершины дерева: \f$ H( 01 \| left \| right ) \f$. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hash_tree_node( ak_hash_tree tree, ak_uint8 *left, ak_uint8 *right, ak_uint8 *out )
+{
+  ak_uint8 node[129];
+  size_t hsize = tree->hctx->data.sctx.hsize;
+
+  node[0] = 1;
+  memcpy( node+1, left, hsize );
+  memcpy( node+1+hsize, right, hsize );
+ return ak_hash_ptr( tree->hctx, node, 1+2*hsize, out, hsize );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Добавление хеш-кода очередного листа в дерево и объединение всех полных поддеревьев
+    одинаковой высоты. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hash_tree_push( ak_hash_tree tree, ak_uint8 *leaf )
+{
+  int error = ak_error_ok;
+
+  if( tree->height == ak_hash_tree_max_height ) return ak_error_message( ak_error_wrong_length,
+                                                          __func__, "hash tree is too high" );
+  memcpy( tree->nodes[tree->height], leaf, tree->hctx->data.sctx.hsize );
+  tree->levels[tree->height++] = 0;
+  tree->leaves++;
+
+  while(( tree->height > 1 ) &&
+                         ( tree->levels[tree->height-1] == tree->levels[tree->height-2] )) {
+    if(( error = ak_hash_tree_node( tree, tree->nodes[tree->height-2],
+                     tree->nodes[tree->height-1], tree->nodes[tree->height-2] )) != ak_error_ok )
+      return error;
+    tree->levels[tree->height-2]++;
+    tree->height--;
+  }
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление хеш-кодов листьев, размещенных в буфере, с использованием
+    нескольких потоков. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hash_tree_leaves( ak_hash hctx, ak_uint8 *buffer, size_t *sizes,
+                                             size_t count, ak_uint8 *hashes, size_t nthreads )
+{
+  int error = ak_error_ok;
+  size_t i = 0, done = 1, hsize = hctx->data.sctx.hsize;
+  struct hash_tree_fragment frs[ak_hash_tree_max_threads];
+
+  nthreads = ak_min( nthreads,
+                     ( count + ak_hash_tree_thread_leaves - 1 )/ak_hash_tree_thread_leaves );
+  for( i = 0; i < nthreads; i++ ) {
+     frs[i].hctx = hctx;
+     frs[i].leaves = buffer + i*ak_hash_tree_thread_leaves*( ak_hash_tree_leaf_size + 1 );
+     frs[i].sizes = sizes + i*ak_hash_tree_thread_leaves;
+     frs[i].count = ak_min( ak_hash_tree_thread_leaves, count - i*ak_hash_tree_thread_leaves );
+     frs[i].hashes = hashes + i*ak_hash_tree_thread_leaves*hsize;
+     frs[i].error = ak_error_ok;
+  }
+
+#ifdef AK_HAVE_PTHREAD_H
+ /* запускаем потоки, обрабатывающие все фрагменты, кроме первого */
+  for( i = 1; i < nthreads; i++, done++ )
+     if( pthread_create( &frs[i].thread, NULL, ak_hash_tree_thread, frs+i ) != 0 ) break;
+#endif
+ /* первый фрагмент, а также фрагменты, для которых не удалось создать поток,
+    обрабатываем в текущем потоке */
+  ak_hash_tree_fragment_leaves( frs );
+  for( i = done; i < nthreads; i++ ) ak_hash_tree_fragment_leaves( frs+i );
+#ifdef AK_HAVE_PTHREAD_H
+  for( i = 1; i < done; i++ ) pthread_join( frs[i].thread, NULL );
+#endif
+
+  for( i = 0; i < nthreads; i++ )
+     if( frs[i].error != ak_error_ok ) error = frs[i].error;
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление корня хеш-дерева для данных, считываемых заданной функцией. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hash_tree_compute( ak_hash hctx, ak_function_hash_tree_read *readfn,
+                     ak_pointer source, ak_uint64 size, ak_pointer out, const size_t out_size )
+{
+  ssize_t len = 0;
+  bool_t done = ak_false;
+  int error = ak_error_ok;
+  struct hash_tree tree;
+  size_t i, count, batch, *sizes = NULL, hsize = 0,
+         nthreads = ak_hash_tree_get_threads_count( size );
+  ak_uint8 *buffer = NULL, *hashes = NULL;
+
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hash context" );
+  if( out == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                       "using null pointer to output buffer" );
+  if( hctx->mctx.update != ak_hash_context_streebog_update )
+    return ak_error_message( ak_error_oid_engine, __func__,
+                                               "tree hashing is supported only for streebog" );
+  hsize = hctx->data.sctx.hsize;
+  batch = nthreads*ak_hash_tree_thread_leaves;
+  if((( buffer = malloc( batch*( ak_hash_tree_leaf_size + 1 ))) == NULL ) ||
+     (( hashes = malloc( batch*hsize )) == NULL ) ||
+     (( sizes = malloc( batch*sizeof( size_t ))) == NULL )) {
+    error = ak_error_message( ak_error_out_of_memory, __func__, "memory allocation error" );
+    goto labex;
+  }
+  memset( &tree, 0, sizeof( struct hash_tree ));
+  tree.hctx = hctx;
+
+  do{
+    /* считываем очередную группу листьев, каждый лист дополняется префиксом 00 */
+     for( count = 0; ( count < batch ) && !done; count++ ) {
+        ak_uint8 *leaf = buffer + count*( ak_hash_tree_leaf_size + 1 );
+
+        leaf[0] = 0;
+        if(( len = readfn( source, leaf+1, ak_hash_tree_leaf_size )) < 0 ) {
+          error = ak_error_message( ak_error_read_data, __func__, "incorrect reading of data" );
+          goto labex;
+        }
+        if( len < ak_hash_tree_leaf_size ) {
+          done = ak_true;
+         /* пустой лист допускается только для данных нулевой длины */
+          if(( len == 0 ) && ( count + tree.leaves > 0 )) break;
+        }
+        sizes[count] = ( size_t )len + 1;
+     }
+     if( !count ) break;
+
+     if(( error = ak_hash_tree_leaves( hctx, buffer, sizes,
+                                                 count, hashes, nthreads )) != ak_error_ok ) {
+       ak_error_message( error, __func__, "incorrect hashing of tree leaves" );
+       goto labex;
+     }
+     for( i = 0; i < count; i++ )
+        if(( error = ak_hash_tree_push( &tree, hashes + i*hsize )) != ak_error_ok ) {
+          ak_error_message( error, __func__, "incorrect hashing of tree nodes" );
+          goto labex;
+        }
+  } while( !done );
+
+ /* объединяем оставшиеся поддеревья, начиная с самых правых */
+  while( tree.height > 1 ) {
+    if(( error = ak_hash_tree_node( &tree, tree.nodes[tree.height-2],
+                          tree.nodes[tree.height-1], tree.nodes[tree.height-2] )) != ak_error_ok ) {
+      ak_error_message( error, __func__, "incorrect hashing of tree nodes" );
+      goto labex;
+    }
+    tree.height--;
+  }
+  memcpy( out, tree.nodes[0], ak_min( hsize, out_size ));
+
+  labex:
+   if( buffer != NULL ) free( buffer );
+   if( hashes != NULL ) free( hashes );
+   if( sizes != NULL ) free( sizes );
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Область памяти, из которой последовательно считываются хешируемые данные. */
+ typedef struct hash_tree_memory {
+  /*! \brief Указатель на очередной фрагмент данных */
+   const ak_uint8 *ptr;
+  /*! \brief Количество оставшихся данных */
+   size_t size;
+ } *ak_hash_tree_memory;
+
+/* ----------------------------------------------------------------------------------------------- */
+ static ssize_t ak_hash_tree_read_memory( ak_pointer source, ak_uint8 *buffer, size_t size )
+{
+  ak_hash_tree_memory mem = ( ak_hash_tree_memory ) source;
+
+  size = ak_min( size, mem->size );
+  memcpy( buffer, mem->ptr, size );
+  mem->ptr += size;
+  mem->size -= size;
+ return ( ssize_t ) size;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static ssize_t ak_hash_tree_read_file( ak_pointer source, ak_uint8 *buffer, size_t size )
+{
+  ssize_t len = 0, total = 0;
+
+ /* системный вызов может вернуть меньше данных, чем запрошено, не достигнув конца файла */
+  while( total < ( ssize_t ) size ) {
+    if(( len = ak_file_read(( ak_file ) source, buffer + total, size - ( size_t )total )) < 0 )
+      return -1;
+    if( len == 0 ) break;
+    total += len;
+  }
+ return total;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет хеш-код данных в древовидном режиме. Данные разбиваются на листья длиной
+    64 килобайта (последний лист может быть короче), для каждого листа вычисляется хеш-код
+    \f$ H( 00 \| leaf ) \f$. Затем листья объединяются в двоичное дерево: хеш-код внутренней
+    вершины равен \f$ H( 01 \| left \| right ) \f$. Дерево строится слева направо, полные
+    поддеревья одинаковой высоты объединяются сразу, а оставшиеся после обработки всех листьев
+    поддеревья объединяются, начиная с самых правых. Результатом является хеш-код корня дерева.
+
+    Хеш-коды листьев вычисляются несколькими потоками (количество определяется опцией
+    `hash_tree_threads`), однако результат не зависит от количества потоков.
+    Результат отличается от хеш-кода, вычисленного функцией ak_hash_ptr(), и
+    соответствует идентификаторам `streebog256-tree` и `streebog512-tree`.
+
+    @param hctx Контекст функции хеширования Стрибог256 или Стрибог512.
+    @param in Указатель на входные данные для которых вычисляется хеш-код.
+    @param size Размер входных данных в байтах.
+    @param out Область памяти, куда будет помещен результат.
+    @param out_size Размер области памяти (в октетах), в которую будет помещен результат.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_ptr_tree( ak_hash hctx, const ak_pointer in,
+                                         const size_t size, ak_pointer out, const size_t out_size )
+{
+  struct hash_tree_memory mem;
+
+  if(( in == NULL ) && ( size != 0 )) return ak_error_message( ak_error_null_pointer, __func__,
+                                                              "using null pointer to input data" );
+  mem.ptr = in;
+  mem.size = size;
+ return ak_hash_tree_compute( hctx, ak_hash_tree_read_memory, &mem, size, out, out_size );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вычисляет хеш-код файла в древовидном режиме (см. описание функции ak_hash_ptr_tree()).
+
+    @param hctx Контекст функции хеширования Стрибог256 или Стрибог512.
+    @param filename Имя файла, для котрого вычисляется хеш-код.
+    @param out Область памяти, куда будет помещен результат.
+    @param out_size Размер области памяти (в октетах), в которую будет помещен результат.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hash_file_tree( ak_hash hctx, const char *filename, ak_pointer out, const size_t out_size )
+{
+  struct file file;
+  int error = ak_error_ok;
+
+  if( filename == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                                "use a null pointer to filename" );
+  if(( error = ak_file_open_to_read( &file, filename )) != ak_error_ok )
+    return ak_error_message_fmt( error, __func__, "incorrect access to file %s", filename );
+
+  error = ak_hash_tree_compute( hctx, ak_hash_tree_read_file, &file,
+                                                      ( ak_uint64 ) file.size, out, out_size );
+  ak_file_close( &file );
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*                          Функции тестирования алгоритмов работы                                 */
 /* ----------------------------------------------------------------------------------------------- */
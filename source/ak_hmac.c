@@ -17,6 +17,139 @@
 #else
  #error Library cannot be compiled without string.h header
 #endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Смещение маскированного состояния после обработки блока \f$ K \oplus ipad \f$. */
+ #define ak_hmac_ipad_offset        (0)
+/*! \brief Смещение маскированного состояния после обработки блока \f$ K \oplus opad \f$. */
+ #define ak_hmac_opad_offset        (ak_hmac_pad_state_size)
+/*! \brief Смещение масок сохраненных состояний. */
+ #define ak_hmac_pads_mask_offset   (2*ak_hmac_pad_state_size)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Замена маски одного из сохраненных состояний функции хеширования.
+
+    Функция вырабатывает случайный вектор \f$ v \f$ и прибавляет его как к маскированному
+    состоянию, так и к его маске (аналогично функции ak_skey_set_mask_xor()).
+
+    \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \param offset Смещение состояния в массиве pads.
+    \return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hmac_remask_pad( ak_hmac hctx, const size_t offset )
+{
+  size_t idx = 0;
+  int error = ak_error_ok;
+  ak_uint8 newmask[ak_hmac_pad_state_size],
+           *value = hctx->pads + offset, *mask = value + ak_hmac_pads_mask_offset;
+
+  if(( error = ak_random_ptr( &hctx->key.generator, newmask, sizeof( newmask ))) != ak_error_ok )
+    return ak_error_message( error, __func__, "wrong generation a random mask for hmac state" );
+  for( idx = 0; idx < sizeof( newmask ); idx++ ) {
+     value[idx] ^= newmask[idx];
+     mask[idx] ^= newmask[idx];
+  }
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление и маскирование состояний функции хеширования после обработки
+    блоков \f$ K \oplus ipad \f$ и \f$ K \oplus opad \f$.
+
+    Функция вызывается один раз для каждого значения ключа; далее при обработке каждого
+    сообщения состояния восстанавливаются функцией ak_hmac_load_pad(), что экономит
+    два вызова функции сжатия.
+
+    \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hmac_compute_pads( ak_hmac hctx )
+{
+  int error = ak_error_ok;
+  size_t idx = 0, jdx = 0, len = 0, pad = 0;
+  ak_uint8 buffer[64], /* буффер для хранения промежуточных значений */
+           constant[2] = { 0x36, 0x5C }, *value = NULL, *mask = NULL;
+  ak_streebog sx = &hctx->ctx.data.sctx;
+
+  if( hctx->mctx.bsize > sizeof( buffer )) return ak_error_message( ak_error_wrong_length,
+                                            __func__, "using hash function with huge block size" );
+  for( pad = 0; pad < 2; pad++ ) {
+    /* фомируем маскированное значение ключа */
+     len = ak_min( hctx->mctx.bsize, jdx = hctx->key.key_size );
+     for( idx = 0; idx < len; idx++, jdx++ ) {
+        buffer[idx] = hctx->key.key[idx] ^ constant[pad];
+        buffer[idx] ^= hctx->key.key[jdx];
+     }
+     for( ; idx < hctx->mctx.bsize; idx++ ) buffer[idx] = constant[pad];
+
+    /* вычисляем состояние после обработки первого блока */
+     if(( error = ak_hash_clean( &hctx->ctx )) != ak_error_ok ) {
+       ak_error_message( error, __func__, "wrong cleaning of hash function context" );
+       break;
+     }
+     if(( error = ak_hash_update( &hctx->ctx, buffer, hctx->mctx.bsize )) != ak_error_ok ) {
+       ak_error_message( error, __func__, "invalid 1st step iteration for hmac key context" );
+       break;
+     }
+
+    /* сохраняем состояние, маскируя его случайным вектором */
+     value = hctx->pads + pad*ak_hmac_pad_state_size;
+     mask = value + ak_hmac_pads_mask_offset;
+     if(( error = ak_random_ptr( &hctx->key.generator,
+                                               mask, ak_hmac_pad_state_size )) != ak_error_ok ) {
+       ak_error_message( error, __func__, "wrong generation a random mask for hmac state" );
+       break;
+     }
+     for( idx = 0; idx < 64; idx++ ) {
+        value[idx] = (( ak_uint8 *)sx->h)[idx] ^ mask[idx];
+        value[64+idx] = (( ak_uint8 *)sx->n)[idx] ^ mask[64+idx];
+        value[128+idx] = (( ak_uint8 *)sx->sigma)[idx] ^ mask[128+idx];
+     }
+  }
+
+ /* очищаем буффер и контекст функции хеширования, перемаскируем ключ */
+  ak_ptr_wipe( buffer, sizeof( buffer ), &hctx->key.generator );
+  ak_hash_clean( &hctx->ctx );
+  hctx->key.set_mask( &hctx->key );
+
+  if( error == ak_error_ok ) hctx->key.flags |= ak_key_flag_precomputed;
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Восстановление сохраненного состояния функции хеширования и смена его маски.
+    \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \param offset Смещение состояния в массиве pads.
+    \return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hmac_load_pad( ak_hmac hctx, const size_t offset )
+{
+  size_t idx = 0;
+  int error = ak_error_ok;
+  ak_streebog sx = &hctx->ctx.data.sctx;
+  const ak_uint8 *value = NULL, *mask = NULL;
+
+  if( !((hctx->key.flags)&ak_key_flag_precomputed ))
+    if(( error = ak_hmac_compute_pads( hctx )) != ak_error_ok )
+      return ak_error_message( error, __func__, "incorrect precomputation of hmac states" );
+
+  value = hctx->pads + offset;
+  mask = value + ak_hmac_pads_mask_offset;
+  for( idx = 0; idx < 64; idx++ ) {
+     (( ak_uint8 *)sx->h)[idx] = value[idx] ^ mask[idx];
+     (( ak_uint8 *)sx->n)[idx] = value[64+idx] ^ mask[64+idx];
+     (( ak_uint8 *)sx->sigma)[idx] = value[128+idx] ^ mask[128+idx];
+  }
+  hctx->ctx.mctx.length = 0;
+
+ return ak_hmac_remask_pad( hctx, offset );
+}
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Очистка контекста алгоритма hmac.
@@ -28,8 +161,6 @@
 {
   int error = ak_error_ok;
   ak_hmac hctx = ( ak_hmac ) ctx;
-  size_t idx = 0, jdx = 0, len = 0;
-  ak_uint8 buffer[64]; /* буффер для хранения промежуточных значений */
 
   if( ctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
                                                       "using a null pointer to hmac key context" );
@@ -40,30 +171,12 @@
   if( hctx->key.resource.value.counter <= 1 ) return ak_error_message( ak_error_low_key_resource,
                                             __func__, "using hmac key context with low resource" );
                       /* нам надо два раза использовать ключ => ресурс должен быть не менее двух */
-  if( hctx->mctx.bsize > sizeof( buffer )) return ak_error_message( ak_error_wrong_length,
-                                            __func__, "using hash function with huge block size" );
 
- /* фомируем маскированное значение ключа */
-  len = ak_min( hctx->mctx.bsize, jdx = hctx->key.key_size );
-  for( idx = 0; idx < len; idx++, jdx++ ) {
-     buffer[idx] = hctx->key.key[idx] ^ 0x36;
-     buffer[idx] ^= hctx->key.key[jdx];
-  }
-  for( ; idx < hctx->mctx.bsize; idx++ ) buffer[idx] = 0x36;
-
- /* инициализируем начальное состояние контекста хеширования */
-  if(( error = ak_hash_clean( &hctx->ctx )) != ak_error_ok )
-    return ak_error_message( error, __func__, "wrong cleaning of hash function context" );
-
- /* обновляем состояние контекста хеширования */
-  if(( error = ak_hash_update( &hctx->ctx, buffer, hctx->mctx.bsize )) != ak_error_ok )
+ /* восстанавливаем состояние контекста хеширования после обработки блока K xor ipad */
+  if(( error = ak_hmac_load_pad( hctx, ak_hmac_ipad_offset )) != ak_error_ok )
     ak_error_message( error, __func__, "invalid 1st step iteration for hmac key context" );
 
- /* очищаем буффер */
-  ak_ptr_wipe( buffer, sizeof( buffer ), &hctx->key.generator );
-
- /* перемаскируем ключ и меняем его ресурс */
-  hctx->key.set_mask( &hctx->key );
+ /* меняем ресурс ключа */
   hctx->key.resource.value.counter--; /* мы использовали ключ один раз */
 
  return error;
@@ -112,9 +225,7 @@
 {
   int error = ak_error_ok;
   ak_hmac hctx = ( ak_hmac ) ctx;
-  size_t idx = 0, jdx = 0, len = 0;
-  ak_uint8 temporary[128]; /* первый буффер для хранения промежуточных значений */
-  ak_uint8 keybuffer[128]; /* второй буффер для хранения промежуточных значений */
+  ak_uint8 temporary[128]; /* буффер для хранения промежуточных значений */
 
  /* выполняем проверки */
   if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
@@ -130,35 +241,20 @@
                                                __func__ , "using hmac key with unassigned value" );
  /* обрабатываем хвост предыдущих данных */
   memset( temporary, 0, sizeof( temporary ));
-  if(( error = ak_hash_finalize( &hctx->ctx, in, size, temporary,
+  if(( error = ak_hash_finalize_inplace( &hctx->ctx, in, size, temporary,
                                                             sizeof( temporary ))) != ak_error_ok )
     return ak_error_message( error, __func__ , "wrong updating of finalized data" );
 
- /* фомируем маскированное значение ключа */
-  len = ak_min( hctx->mctx.bsize, jdx = hctx->key.key_size );
-  for( idx = 0; idx < len; idx++ , jdx++ ) {
-     keybuffer[idx] = hctx->key.key[idx] ^ 0x5C;
-     keybuffer[idx] ^= hctx->key.key[jdx];
-  }
-  for( ; idx < hctx->mctx.bsize; idx++ ) keybuffer[idx] = 0x5C;
-
- /* возвращаем контекст хеширования в начальное состояние */
-  if(( error = ak_hash_clean( &hctx->ctx )) != ak_error_ok )
-    return ak_error_message( error, __func__, "wrong cleaning of hash function context" );
-
- /* обновляем состояние контекста хеширования */
-  if(( error = ak_hash_update( &hctx->ctx, keybuffer, hctx->mctx.bsize )) != ak_error_ok )
+ /* восстанавливаем состояние контекста хеширования после обработки блока K xor opad */
+  if(( error = ak_hmac_load_pad( hctx, ak_hmac_opad_offset )) != ak_error_ok )
     return ak_error_message( error, __func__, "invalid 1st step iteration for hmac key context" );
 
- /* очищаем буффер */
-  ak_ptr_wipe( keybuffer, sizeof( keybuffer ), &hctx->key.generator );
-
  /* ресурс ключа */
-  hctx->key.set_mask( &hctx->key );
   hctx->key.resource.value.counter--; /* мы использовали ключ один раз */
 
  /* последний update/finalize и возврат результата */
-  error = ak_hash_finalize( &hctx->ctx, temporary, hctx->ctx.data.sctx.hsize, out, out_size );
+  error = ak_hash_finalize_inplace( &hctx->ctx,
+                                           temporary, hctx->ctx.data.sctx.hsize, out, out_size );
 
  /* очищаем контекст функции хеширования, ключ не трогаем */
   ak_hash_clean( &hctx->ctx );
@@ -219,6 +315,7 @@
   }
  /* доопределяем oid ключа */
   hctx->key.oid = oid;
+  memset( hctx->pads, 0, sizeof( hctx->pads ));
 
  return error;
 }
@@ -251,6 +348,7 @@
                                                             "using null pointer to hmac context" );
   if(( error = ak_hash_destroy( &hctx->ctx )) != ak_error_ok )
     ak_error_message( error, __func__, "incorrect destroying of hash context" );
+  ak_ptr_wipe( hctx->pads, sizeof( hctx->pads ), &hctx->key.generator );
   if(( error = ak_skey_destroy( &hctx->key )) != ak_error_ok )
     ak_error_message( error, __func__, "incorrect destroying of secret key context" );
   if(( error = ak_mac_destroy( &hctx->mctx )) != ak_error_ok )
@@ -398,6 +496,21 @@
  return ak_mac_update( &hctx->mctx, in, size );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \param iov Массив фрагментов данных, для которых вычисляется имитовставка.
+    \param count Количество элементов массива.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hmac_updatev( ak_hmac hctx, const struct iovector *iov, const size_t count )
+{
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                         "updating null pointer to hmac context" );
+ return ak_mac_updatev( &hctx->mctx, iov, count );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \param hctx Контекст алгоритма HMAC выработки имитовставки.
     \param in Указатель на входные данные для которых вычисляется хеш-код.
@@ -488,9 +601,358 @@
  return hctx->mctx.bsize;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Выработка маски сохраняемого состояния и проверочного значения ключа.
+
+    Маска и проверочное значение вычисляются как последовательность значений функции хеширования
+    Стрибог512 от блока \f$ K \oplus \texttt{0x6A} \f$, дополненного номером фрагмента,
+    и зависят только от значения ключа. Поэтому состояние, сохраненное в одном процессе,
+    может быть восстановлено в другом процессе, использующем тот же ключ.
+
+    \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \param mask Массив длины 192 октета, в который помещаются маска векторов h и
+    \f$ \Sigma \f$ (первые 128 октетов) и проверочное значение ключа (последние 32 октета).
+    \return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hmac_state_mask( ak_hmac hctx, ak_uint8 *mask )
+{
+  struct hash sx;
+  int error = ak_error_ok;
+  size_t idx = 0, jdx = 0, len = 0;
+  ak_uint8 buffer[65]; /* буффер для хранения маскированного ключа и номера фрагмента */
+
+  if( !((hctx->key.flags)&ak_key_flag_set_key )) return ak_error_message( ak_error_key_value,
+                                               __func__ , "using hmac key with unassigned value" );
+  if( hctx->mctx.bsize > sizeof( buffer ) - 1 ) return ak_error_message( ak_error_wrong_length,
+                                            __func__, "using hash function with huge block size" );
+  if(( error = ak_hash_create_streebog512( &sx )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect creation of hash function context" );
+
+ /* формируем ключ, сложенный с константой */
+  len = ak_min( hctx->mctx.bsize, jdx = hctx->key.key_size );
+  for( idx = 0; idx < len; idx++, jdx++ ) {
+     buffer[idx] = hctx->key.key[idx] ^ 0x6A;
+     buffer[idx] ^= hctx->key.key[jdx];
+  }
+  for( ; idx < hctx->mctx.bsize; idx++ ) buffer[idx] = 0x6A;
+
+  for( idx = 0; idx < 3; idx++ ) {
+     buffer[hctx->mctx.bsize] = ( ak_uint8 ) idx;
+     if(( error = ak_hash_ptr( &sx, buffer, hctx->mctx.bsize + 1, mask + 64*idx, 64 )) != ak_error_ok )
+       break;
+  }
+
+ /* очищаем временные данные и перемаскируем ключ */
+  ak_ptr_wipe( buffer, sizeof( buffer ), &hctx->key.generator );
+  hctx->key.set_mask( &hctx->key );
+  ak_hash_destroy( &sx );
+
+  if( error != ak_error_ok ) ak_error_message( error, __func__, "incorrect calculation of mask" );
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция сохраняет промежуточное состояние контекста алгоритма HMAC в виде последовательности
+    из \ref ak_hmac_state_size октетов. Состояние содержит тело состояния внутренней функции
+    хеширования (см. ak_hash_export_state()), в котором векторы h и \f$ \Sigma \f$ маскированы
+    значением, вырабатываемым из ключа, проверочное значение ключа и контрольную сумму.
+    Значение ключа в сохраняемое состояние не входит.
+
+    Функция может применяться для однократного вычисления начального состояния (после вызова
+    ak_hmac_clean()) с последующим его восстановлением для каждого нового сообщения,
+    а также для продолжения вычислений после прерывания работы программы.
+
+    \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \param out Область памяти, в которую помещается состояние.
+    \param out_size Размер области памяти (в октетах); должен быть не менее \ref ak_hmac_state_size.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hmac_export_state( ak_hmac hctx, ak_pointer out, const size_t out_size )
+{
+  size_t idx = 0;
+  ak_uint32 icode = 0;
+  ak_uint8 mask[192];
+  int error = ak_error_ok;
+  ak_uint8 *ptr = ( ak_uint8 *) out;
+
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hmac context" );
+  if(( out == NULL ) || ( out_size < ak_hmac_state_size ))
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                   "using output buffer with insufficient length" );
+  if(( error = ak_hmac_state_mask( hctx, mask )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect generation of state mask" );
+  if(( error = ak_hash_context_export_state( &hctx->ctx,
+                                    &hctx->mctx, ak_hmac_state_version, ptr )) != ak_error_ok ) {
+    ak_ptr_wipe( mask, sizeof( mask ), &hctx->key.generator );
+    return ak_error_message( error, __func__, "incorrect export of hash context state" );
+  }
+
+ /* маскируем векторы h и sigma, добавляем проверочное значение ключа */
+  for( idx = 0; idx < 64; idx++ ) {
+     ptr[4+idx] ^= mask[idx];
+     ptr[132+idx] ^= mask[64+idx];
+  }
+  memcpy( ptr + ak_hash_state_body_size, mask + 128, 32 );
+  ak_ptr_wipe( mask, sizeof( mask ), &hctx->key.generator );
+
+  ak_ptr_fletcher32( ptr, ak_hmac_state_size - 4, &icode );
+  memcpy( ptr + ak_hmac_state_size - 4, &icode, 4 );
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Перед вызовом функции контексту должно быть присвоено то же значение ключа, которое
+    использовалось при сохранении состояния; в противном случае функция возвращает ошибку
+    \ref ak_error_key_value и контекст не изменяется.
+
+    \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \param in Область памяти, содержащая состояние, сохраненное функцией ak_hmac_export_state().
+    \param size Размер области памяти (в октетах).
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hmac_import_state( ak_hmac hctx, const ak_pointer in, const size_t size )
+{
+  size_t idx = 0;
+  ak_uint32 icode = 0;
+  int error = ak_error_ok;
+  ak_uint8 mask[192], body[ak_hash_state_body_size];
+  const ak_uint8 *ptr = ( const ak_uint8 *) in;
+
+  if( hctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                            "using null pointer to hmac context" );
+  if(( in == NULL ) || ( size != ak_hmac_state_size ))
+    return ak_error_message( ak_error_wrong_length, __func__,
+                                                          "using state with unexpected length" );
+  ak_ptr_fletcher32( ptr, ak_hmac_state_size - 4, &icode );
+  if( memcmp( ptr + ak_hmac_state_size - 4, &icode, 4 ))
+    return ak_error_message( ak_error_not_equal_data, __func__,
+                                                    "using state with wrong integrity code" );
+  if(( error = ak_hmac_state_mask( hctx, mask )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect generation of state mask" );
+  if( !ak_ptr_is_equal( mask + 128, ptr + ak_hash_state_body_size, 32 )) {
+    ak_ptr_wipe( mask, sizeof( mask ), &hctx->key.generator );
+    return ak_error_message( ak_error_key_value, __func__,
+                                                  "state was exported with other secret key" );
+  }
+
+ /* снимаем маску и восстанавливаем состояние */
+  memcpy( body, ptr, sizeof( body ));
+  for( idx = 0; idx < 64; idx++ ) {
+     body[4+idx] ^= mask[idx];
+     body[132+idx] ^= mask[64+idx];
+  }
+  error = ak_hash_context_import_state( &hctx->ctx, &hctx->mctx, ak_hmac_state_version, body );
+  hctx->ctx.mctx.length = 0; /* внутренняя функция хеширования получает только полные блоки */
+  ak_ptr_wipe( mask, sizeof( mask ), &hctx->key.generator );
+  ak_ptr_wipe( body, sizeof( body ), &hctx->key.generator );
+
+  if( error != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect import of hash context state" );
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Получение немаскированных копий сохраненных состояний функции хеширования.
+
+    После копирования маски сохраненных в контексте состояний заменяются на новые.
+
+    \param hctx Контекст алгоритма HMAC выработки имитовставки.
+    \param ipad Состояние после обработки блока \f$ K \oplus ipad \f$.
+    \param opad Состояние после обработки блока \f$ K \oplus opad \f$.
+    \return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_hmac_get_pads( ak_hmac hctx, ak_streebog ipad, ak_streebog opad )
+{
+  size_t idx = 0, pad = 0;
+  int error = ak_error_ok;
+  ak_streebog sx[2] = { ipad, opad };
+  const ak_uint8 *value = NULL, *mask = NULL;
+
+  if( !((hctx->key.flags)&ak_key_flag_precomputed ))
+    if(( error = ak_hmac_compute_pads( hctx )) != ak_error_ok )
+      return ak_error_message( error, __func__, "incorrect precomputation of hmac states" );
+
+  for( pad = 0; pad < 2; pad++ ) {
+     memcpy( sx[pad], &hctx->ctx.data.sctx, sizeof( struct streebog ));
+     value = hctx->pads + pad*ak_hmac_pad_state_size;
+     mask = value + ak_hmac_pads_mask_offset;
+     for( idx = 0; idx < 64; idx++ ) {
+        (( ak_uint8 *)sx[pad]->h)[idx] = value[idx] ^ mask[idx];
+        (( ak_uint8 *)sx[pad]->n)[idx] = value[64+idx] ^ mask[64+idx];
+        (( ak_uint8 *)sx[pad]->sigma)[idx] = value[128+idx] ^ mask[128+idx];
+     }
+     if(( error = ak_hmac_remask_pad( hctx, pad*ak_hmac_pad_state_size )) != ak_error_ok ) break;
+  }
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Состояние одной цепочки вычислений алгоритма PBKDF2. */
+ typedef struct pbkdf2_chain {
+  /*! \brief Состояние функции хеширования после обработки блока \f$ K \oplus ipad \f$. */
+   struct streebog ipad;
+  /*! \brief Состояние функции хеширования после обработки блока \f$ K \oplus opad \f$. */
+   struct streebog opad;
+  /*! \brief Текущее значение \f$ U_j \f$. */
+   ak_uint64 u[8];
+  /*! \brief Сумма значений \f$ U_1, \ldots, U_j \f$. */
+   ak_uint64 t[8];
+ } *ak_pbkdf2_chain;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вырабатывает ключевые векторы для нескольких паролей одновременно. Для каждого пароля
+    вычисляется \f$ n = \lceil dklen/64 \rceil \f$ независимых блоков \f$ T_1, \ldots, T_n \f$;
+    все блоки всех паролей обрабатываются одновременно, группами
+    по \ref ak_streebog_lanes цепочек, функцией ak_hash_context_streebog_hmac_iterate().
+
+    \note Правило усечения результата зависит от его длины.
+    При `dklen`, превосходящем 64, результатом являются первые `dklen` октетов
+    последовательности \f$ T_1 || \ldots || T_n \f$ (Р 50.1.111-2016, раздел 4).
+    При `dklen`, не превосходящем 64, результатом являются последние `dklen`
+    октетов блока \f$ T_1 \f$; такое усечение использовалось библиотекой всегда, и его
+    сохранение позволяет вырабатывать те же самые ключи из паролей, что и ранее
+    (в частности, ключи, защищающие существующие ключевые контейнеры). При `dklen`, равном 64,
+    оба правила дают одинаковый результат.
+
+    @param count Количество паролей.
+    @param pass Массив указателей на пароли (строки символов в utf8 кодировке).
+    @param pass_size Массив длин паролей в байтах; длины должны быть отличны от нуля.
+    @param salt Массив указателей на инициализационные векторы.
+    @param salt_size Массив длин инициализационных векторов в байтах.
+    @param cnt Количество итераций алгоритма (одинаково для всех паролей).
+    @param dklen Длина вырабатываемого ключевого вектора в байтах.
+    @param out Массив указателей на области памяти, в которые помещаются результаты; под каждую
+    область должно быть заранее выделено не менее, чем dklen байт.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hmac_pbkdf2_streebog512_batch( const size_t count, const ak_pointer *pass,
+                 const size_t *pass_size, const ak_pointer *salt, const size_t *salt_size,
+                                      const size_t cnt, const size_t dklen, ak_pointer *out )
+{
+  struct hmac hctx;
+  ak_uint8 number[4];
+  int error = ak_error_ok;
+  ak_pbkdf2_chain chains = NULL;
+  size_t idx = 0, jdx = 0, blocks = 0, total = 0, tail = 0;
+  ak_streebog ipad[ak_streebog_lanes], opad[ak_streebog_lanes];
+  ak_uint64 *u[ak_streebog_lanes], *t[ak_streebog_lanes];
+
+ /* в начале, многочисленные проверки входных параметров */
+  if( !count ) return ak_error_message( ak_error_zero_length, __func__ ,
+                                                           "using zero number of passwords" );
+  if(( pass == NULL ) || ( pass_size == NULL ) || ( salt == NULL ) || ( salt_size == NULL ))
+    return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                "using null pointer to passwords or salts" );
+  if( !dklen ) return ak_error_message( ak_error_wrong_length, __func__ ,
+                                                "using a zero length for resulting key vector" );
+  if( out == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                    "using null pointer to resulting key vectors" );
+  for( idx = 0; idx < count; idx++ ) {
+     if( pass[idx] == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                                 "using null pointer to password" );
+     if( !pass_size[idx] ) return ak_error_message( ak_error_wrong_length, __func__ ,
+                                                                   "using a zero length password" );
+     if( salt[idx] == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                                     "using null pointer to salt" );
+     if( out[idx] == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                     "using null pointer to resulting key vector" );
+  }
+  blocks = ( dklen + 63 ) >> 6;
+  total = count*blocks;
+  if(( chains = malloc( total*sizeof( struct pbkdf2_chain ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__ ,
+                                                          "incorrect memory allocation for chains" );
+ /* создаем контекст алгоритма hmac */
+  if(( error = ak_hmac_create_streebog512( &hctx )) != ak_error_ok ) {
+    free( chains );
+    return ak_error_message( error, __func__, "wrong creation of hmac-streebog512 key context" );
+  }
+
+ /* вычисляем первые значения U_1 для каждого блока каждого пароля */
+  for( idx = 0; idx < count; idx++ ) {
+     ak_pbkdf2_chain chain = chains + idx*blocks;
+     if(( error = ak_hmac_set_key( &hctx, pass[idx], pass_size[idx] )) != ak_error_ok ) {
+       ak_error_message( error, __func__, "wrong initialization of hmac-streebog512 secret key" );
+       goto lab_exit;
+     }
+     if(( error = ak_hmac_get_pads( &hctx, &chain->ipad, &chain->opad )) != ak_error_ok ) {
+       ak_error_message( error, __func__, "incorrect precomputation of hmac states" );
+       goto lab_exit;
+     }
+     for( jdx = 0; jdx < blocks; jdx++ ) {
+        number[0] = ( ak_uint8 )(( jdx+1 ) >> 24 );
+        number[1] = ( ak_uint8 )(( jdx+1 ) >> 16 );
+        number[2] = ( ak_uint8 )(( jdx+1 ) >> 8 );
+        number[3] = ( ak_uint8 )( jdx+1 );
+        if( jdx > 0 ) {
+          memcpy( &chain[jdx].ipad, &chain->ipad, sizeof( struct streebog ));
+          memcpy( &chain[jdx].opad, &chain->opad, sizeof( struct streebog ));
+        }
+        if(( error = ak_hmac_clean( &hctx )) != ak_error_ok ) {
+          ak_error_message( error, __func__, "incorrect cleaning of internal hmac context");
+          goto lab_exit;
+        }
+        if(( error = ak_hmac_update( &hctx, salt[idx], salt_size[idx] )) != ak_error_ok ) {
+          ak_error_message( error, __func__, "incorrect updating of internal hmac context");
+          goto lab_exit;
+        }
+        if(( error = ak_hmac_finalize( &hctx, number, 4,
+                                               chain[jdx].u, sizeof( chain[jdx].u ))) != ak_error_ok ) {
+          ak_error_message( error, __func__, "incorrect finalizing of internal mac context");
+          goto lab_exit;
+        }
+        memcpy( chain[jdx].t, chain[jdx].u, sizeof( chain[jdx].t ));
+     }
+  }
+
+ /* теперь основной цикл по значению аргумента c, цепочки обрабатываются одновременно */
+  if( cnt > 1 ) {
+    for( idx = 0; idx < total; idx += ak_streebog_lanes ) {
+       size_t lanes = ak_min( ak_streebog_lanes, total - idx );
+       for( jdx = 0; jdx < lanes; jdx++ ) {
+          ipad[jdx] = &chains[idx+jdx].ipad;
+          opad[jdx] = &chains[idx+jdx].opad;
+          u[jdx] = chains[idx+jdx].u;
+          t[jdx] = chains[idx+jdx].t;
+       }
+       ak_hash_context_streebog_hmac_iterate( ipad, opad, u, t, lanes, cnt-1 );
+    }
+  }
+
+ /* формируем результат */
+  tail = dklen - (( blocks-1 ) << 6 );
+  for( idx = 0; idx < count; idx++ ) {
+     ak_uint8 *ptr = ( ak_uint8 *) out[idx];
+     if( blocks == 1 ) {
+       memcpy( ptr, (( ak_uint8 *)chains[idx].t ) + 64 - dklen, dklen );
+       continue;
+     }
+     for( jdx = 0; jdx < blocks-1; jdx++, ptr += 64 ) memcpy( ptr, chains[idx*blocks+jdx].t, 64 );
+     memcpy( ptr, chains[idx*blocks+jdx].t, tail );
+  }
+
+  lab_exit:
+   ak_ptr_wipe( chains, total*sizeof( struct pbkdf2_chain ), &hctx.key.generator );
+   free( chains );
+   ak_hmac_destroy( &hctx );
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Пароль должен представлять собой ненулевую строку символов в utf8
-    кодировке. Размер вырабатываемого ключевого вектора может колебаться от 32-х до 64-х байт.
+    кодировке. Размер вырабатываемого ключевого вектора может быть произвольным; при длине,
+    превышающей 64 байта, вычисляется несколько блоков, обрабатываемых одновременно.
+    Правило усечения результата, длина которого отлична от 64 байт, описано
+    в документации к функции ak_hmac_pbkdf2_streebog512_batch().
     При выработке используется алгоритм hmac-streebog512.
 
     @param pass Пароль, строка символов в utf8 кодировке.
@@ -501,8 +963,8 @@
     @param cnt Параметр, определяющий количество однотипных итераций для выработки ключа; данный
     параметр определяет время работы алгоритма; параметр не является секретным и может храниться или
     передаваться в открытом виде.
-    @param dklen Длина вырабатываемого ключевого вектора в байтах, величина должна принимать
-    значение от 32-х до 64-х.
+    @param dklen Длина вырабатываемого ключевого вектора в байтах, величина должна быть
+    отлична от нуля.
     @param out Указатель на массив, куда будет помещен результат; под данный массив должна быть
     заранее выделена память не менее, чем dklen байт.
 
@@ -513,57 +975,213 @@
          const size_t pass_size, const ak_pointer salt, const size_t salt_size, const size_t cnt,
                                                                const size_t dklen, ak_pointer out )
 {
-  struct hmac hctx;
-  ak_uint8 result[64];
-  int error = ak_error_ok;
-  size_t idx = 0, jdx = 0;
+  ak_pointer vpass = pass, vsalt = salt, vout = out;
+ return ak_hmac_pbkdf2_streebog512_batch( 1, &vpass, &pass_size,
+                                                       &vsalt, &salt_size, cnt, dklen, &vout );
+}
 
- /* в начале, многочисленные проверки входных параметров */
-  if( pass == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
-                                                                 "using null pointer to password" );
-  if( !pass_size ) return ak_error_message( ak_error_wrong_length, __func__ ,
-                                                                   "using a zero length password" );
-  if( salt == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
-                                                                     "using null pointer to salt" );
-  if(( dklen < 32 ) || ( dklen > 64 )) return ak_error_message( ak_error_wrong_length,
-                                       __func__ , "using a wrong length for resulting key vector" );
-  if( out == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
-                                                     "using null pointer to resulting key vector" );
- /* создаем контекст алгоритма hmac и определяем его ключ */
-  if(( error = ak_hmac_create_streebog512( &hctx )) != ak_error_ok )
-    return ak_error_message( error, __func__, "wrong creation of hmac-streebog512 key context" );
-  if(( error = ak_hmac_set_key( &hctx, pass, pass_size )) != ak_error_ok ) {
-    ak_error_message( error, __func__, "wrong initialization of hmac-streebog512 secret key" );
-    goto lab_exit;
+/* ----------------------------------------------------------------------------------------------- */
+/*                 функции выработки ключевой информации с большим объемом памяти                  */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество 64-х октетных слов в одном блоке памяти алгоритма mhkdf. */
+ #define ak_mhkdf_block_words       (16)
+/*! \brief Размер одного блока памяти алгоритма mhkdf (в октетах). */
+ #define ak_mhkdf_block_size        (64*ak_mhkdf_block_words)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Состояние одной полосы (lane) алгоритма mhkdf. */
+ typedef struct mhkdf_lane {
+  /*! \brief Контекст функции хеширования, содержащий реализацию преобразования G. */
+   struct streebog sctx;
+  /*! \brief Текущее значение блока полосы. */
+   ak_uint64 *block;
+  /*! \brief Область памяти полосы, содержащая `count` блоков. */
+   ak_uint64 *memory;
+  /*! \brief Количество блоков памяти полосы. */
+   size_t count;
+  /*! \brief Количество проходов по памяти полосы. */
+   size_t passes;
+ #ifdef AK_HAVE_PTHREAD_H
+  /*! \brief Поток, обрабатывающий полосу. */
+   pthread_t thread;
+ #endif
+ } *ak_mhkdf_lane;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Перемешивание блока памяти: \f$ Y = B_{15}, \; Y = G(Y, B_i), \; B_i = Y \f$
+    для \f$ i = 0, \ldots, 15 \f$. */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mhkdf_block_mix( ak_streebog sx, ak_uint64 *block )
+{
+  size_t i = 0;
+
+  memcpy( sx->h, block + 8*( ak_mhkdf_block_words - 1 ), 64 );
+  for( i = 0; i < ak_mhkdf_block_words; i++ ) {
+     sx->g( sx, NULL, block + 8*i );
+     memcpy( block + 8*i, sx->h, 64 );
   }
+}
 
- /* начальная инициализация промежуточного вектора */
-  memset( result, 0, 64 );
-  result[3] = 1;
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление значений одной полосы алгоритма mhkdf: заполнение памяти
+    последовательностью блоков и последующее чтение блоков по адресам, зависящим от пароля. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_mhkdf_lane_compute( ak_mhkdf_lane lane )
+{
+  size_t i = 0, k = 0, words = 8*ak_mhkdf_block_words;
+  ak_uint64 j = 0, *v = NULL;
+  ak_uint8 *last = NULL;
+
+ /* заполняем память полосы */
+  for( i = 0; i < lane->count; i++ ) {
+     memcpy( lane->memory + i*words, lane->block, ak_mhkdf_block_size );
+     ak_mhkdf_block_mix( &lane->sctx, lane->block );
+  }
+ /* выполняем зависящие от пароля обращения к памяти */
+  last = ( ak_uint8 *)( lane->block + 8*( ak_mhkdf_block_words - 1 ));
+  for( i = 0; i < lane->passes*lane->count; i++ ) {
+     for( j = 0, k = 0; k < 8; k++ ) j ^= (( ak_uint64 )last[k] ) << ( k << 3 );
+     v = lane->memory + ( j%lane->count )*words;
+     for( k = 0; k < words; k++ ) lane->block[k] ^= v[k];
+     ak_mhkdf_block_mix( &lane->sctx, lane->block );
+  }
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_mhkdf_lane_thread( void *ptr )
+{
+  ak_mhkdf_lane_compute(( ak_mhkdf_lane ) ptr );
+ return NULL;
+}
+#endif
 
- /* вычисляем значение первой строки U1  */
-  if(( error = ak_hmac_clean( &hctx )) != ak_error_ok ) {
-    ak_error_message( error, __func__, "incorrect cleaning of internal hmac context");
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вырабатывает ключевой вектор из пароля с использованием заданного объема оперативной
+    памяти, что делает перебор паролей на специализированных вычислителях существенно более
+    дорогим, чем при использовании алгоритма PBKDF2. Алгоритм повторяет структуру алгоритма scrypt
+    (RFC 7914), в котором функция Salsa20/8 заменена преобразованием G
+    алгоритма хеширования Стрибог (ГОСТ Р 34.11-2012).
+
+    Память объемом `memory` килобайт разбивается на `lanes` независимых полос,
+    каждая из которых содержит \f$ N = \lfloor memory/lanes \rfloor \f$ блоков по 1024 октета.
+    Алгоритм выполняет следующие шаги.
+
+    1. Вычисляется последовательность \f$ B_0 || \ldots || B_{p-1} =
+       PBKDF2( pass, salt, 1, 1024p ) \f$, где \f$ p \f$ -- количество полос.
+    2. Для каждой полосы, независимо от других полос, выполняется:
+       - \f$ V_i = X, \; X = Mix(X) \f$ для \f$ i = 0, \ldots, N-1 \f$, где \f$ X = B_l \f$,
+       - \f$ j = Integerify(X) \bmod N, \; X = Mix( X \oplus V_j ) \f$, данное преобразование
+         выполняется \f$ t \cdot N \f$ раз, где \f$ t \f$ -- значение параметра `time`,
+       - \f$ B_l = X \f$.
+    3. Результатом является значение \f$ PBKDF2( pass, B_0 || \ldots || B_{p-1}, 1, dklen ) \f$.
+
+    Преобразование `Mix` рассматривает блок как последовательность 64-х октетных слов
+    \f$ W_0, \ldots, W_{15} \f$ и вычисляет \f$ Y = W_{15} \f$,
+    \f$ W_i = Y = G_0( Y, W_i ) \f$ для \f$ i = 0, \ldots, 15 \f$.
+    Функция `Integerify` возвращает первые восемь октетов слова \f$ W_{15} \f$,
+    интерпретируемые как целое число (младший октет -- первый).
+    В качестве PBKDF2 используется функция ak_hmac_pbkdf2_streebog512().
+
+    Полосы обрабатываются одновременно в отдельных потоках (если библиотека собрана
+    с поддержкой pthreads); количество полос влияет на результат и должно храниться
+    вместе с остальными параметрами.
+
+    @param pass Пароль, строка символов в utf8 кодировке.
+    @param pass_size Размер пароля в байтах, должен быть отличен от нуля.
+    @param salt Строка с инициализационным вектором (не является секретной).
+    @param salt_size Размер инициализационного вектора в байтах.
+    @param memory Объем используемой памяти в килобайтах; должен быть не менее,
+    чем \ref ak_mhkdf_min_lane_memory килобайт на одну полосу.
+    @param time Количество проходов по памяти, должно быть отлично от нуля.
+    @param lanes Количество независимых полос, от 1 до \ref ak_mhkdf_max_lanes.
+    @param dklen Длина вырабатываемого ключевого вектора в байтах.
+    @param out Указатель на массив, куда будет помещен результат; под данный массив должна быть
+    заранее выделена память не менее, чем dklen байт.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_hmac_mhkdf_streebog512( const ak_pointer pass, const size_t pass_size,
+                       const ak_pointer salt, const size_t salt_size, const size_t memory,
+                 const size_t time, const size_t lanes, const size_t dklen, ak_pointer out )
+{
+  struct hash hctx;
+  struct random generator;
+  int error = ak_error_ok;
+  ak_uint64 *blocks = NULL, *memarea = NULL;
+  size_t idx = 0, done = 1, count = 0;
+  struct mhkdf_lane frs[ak_mhkdf_max_lanes];
+
+ /* проверяем входные параметры */
+  if(( lanes == 0 ) || ( lanes > ak_mhkdf_max_lanes ))
+    return ak_error_message( ak_error_wrong_option, __func__, "using wrong number of lanes" );
+  if( time == 0 ) return ak_error_message( ak_error_wrong_option, __func__,
+                                                               "using zero number of passes" );
+  if(( count = memory/lanes ) < ak_mhkdf_min_lane_memory )
+    return ak_error_message( ak_error_wrong_option, __func__, "using too small memory size" );
+  if( count > ((( size_t )-1 ) >> 1 )/( lanes*ak_mhkdf_block_size ))
+    return ak_error_message( ak_error_wrong_option, __func__, "using too large memory size" );
+
+ /* вырабатываем начальные значения полос */
+  if(( error = ak_random_create_lcg( &generator )) != ak_error_ok )
+    return ak_error_message( error, __func__, "incorrect creation of random generator" );
+  if(( blocks = malloc( lanes*ak_mhkdf_block_size )) == NULL ) {
+    ak_random_destroy( &generator );
+    return ak_error_message( ak_error_out_of_memory, __func__,
+                                                       "incorrect memory allocation for lanes" );
+  }
+  if(( error = ak_hmac_pbkdf2_streebog512( pass, pass_size, salt, salt_size, 1,
+                                           lanes*ak_mhkdf_block_size, blocks )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect initialization of lanes" );
     goto lab_exit;
   }
-  if(( error = ak_hmac_update( &hctx, salt, salt_size )) != ak_error_ok ) {
-    ak_error_message( error, __func__, "incorrect updating of internal hmac context");
+  if(( memarea = malloc( lanes*count*ak_mhkdf_block_size )) == NULL ) {
+    ak_error_message( error = ak_error_out_of_memory, __func__,
+                                                     "incorrect allocation of kdf memory area" );
     goto lab_exit;
   }
-  if(( error = ak_hmac_finalize( &hctx, result, 4, result, sizeof( result ))) != ak_error_ok ) {
-    ak_error_message( error, __func__, "incorrect finalizing of internal mac context");
+  if(( error = ak_hash_create_streebog512( &hctx )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "wrong creation of streebog512 context" );
     goto lab_exit;
   }
-  memcpy( out, result+64-dklen, dklen );
-
- /* теперь основной цикл по значению аргумента c */
-  for( idx = 1; idx < cnt; idx++ ) {
-     ak_hmac_ptr( &hctx, result, 64, result, sizeof( result ));
-     for( jdx = 0; jdx < dklen; jdx++ ) ((ak_uint8 *)out)[jdx] ^= result[64-dklen+jdx];
+  for( idx = 0; idx < lanes; idx++ ) {
+     memcpy( &frs[idx].sctx, &hctx.data.sctx, sizeof( struct streebog ));
+     frs[idx].block = blocks + idx*8*ak_mhkdf_block_words;
+     frs[idx].memory = memarea + idx*count*8*ak_mhkdf_block_words;
+     frs[idx].count = count;
+     frs[idx].passes = time;
   }
-  memset( result, 0, 64 );
+  ak_hash_destroy( &hctx );
+
+#ifdef AK_HAVE_PTHREAD_H
+ /* запускаем потоки, обрабатывающие все полосы, кроме первой */
+  for( idx = 1; idx < lanes; idx++, done++ )
+     if( pthread_create( &frs[idx].thread, NULL, ak_mhkdf_lane_thread, frs+idx ) != 0 ) break;
+#endif
+ /* первую полосу, а также полосы, для которых не удалось создать поток,
+    обрабатываем в текущем потоке */
+  ak_mhkdf_lane_compute( frs );
+  for( idx = done; idx < lanes; idx++ ) ak_mhkdf_lane_compute( frs+idx );
+#ifdef AK_HAVE_PTHREAD_H
+  for( idx = 1; idx < done; idx++ ) pthread_join( frs[idx].thread, NULL );
+#endif
 
-  lab_exit: ak_hmac_destroy( &hctx );
+ /* вырабатываем результирующее значение */
+  if(( error = ak_hmac_pbkdf2_streebog512( pass, pass_size, blocks,
+                                  lanes*ak_mhkdf_block_size, 1, dklen, out )) != ak_error_ok )
+    ak_error_message( error, __func__, "incorrect creation of resulting key vector" );
+
+  lab_exit:
+   if( memarea != NULL ) {
+     ak_ptr_wipe( memarea, lanes*count*ak_mhkdf_block_size, &generator );
+     free( memarea );
+   }
+   ak_ptr_wipe( blocks, lanes*ak_mhkdf_block_size, &generator );
+   free( blocks );
+  /* контексты полос содержат промежуточные значения, зависящие от пароля */
+   ak_ptr_wipe( frs, sizeof( frs ), &generator );
+   ak_random_destroy( &generator );
  return error;
 }
 
@@ -777,12 +1395,38 @@
    0x78, 0xcc, 0xb8, 0x79, 0xf6, 0x70, 0x68, 0xcd, 0xac, 0x19, 0x10, 0x74, 0x08, 0x44, 0xe8, 0x30
   };
 
+  ak_uint8 R5[64] = {
+   0xc8, 0x89, 0x4b, 0x65, 0x77, 0xf9, 0x9c, 0xd4, 0x43, 0xe3, 0x40, 0xff, 0x42, 0x62, 0x7c, 0x6d,
+   0xdb, 0x36, 0xa4, 0x4b, 0x36, 0xbd, 0xeb, 0x76, 0x8c, 0x6b, 0x17, 0x8b, 0xe6, 0xbf, 0xe5, 0xce,
+   0xe3, 0xf8, 0x25, 0xf1, 0x14, 0x38, 0x40, 0x2d, 0x62, 0xca, 0x6b, 0xcb, 0x0a, 0x97, 0xc8, 0xff,
+   0x47, 0x6f, 0x41, 0xa4, 0x1c, 0x4c, 0xc5, 0x8f, 0xec, 0x08, 0xc1, 0xea, 0x36, 0xc1, 0x0d, 0x2a
+  };
+
+  ak_uint8 R7[64] = {
+   0xb2, 0xf3, 0x05, 0xf1, 0x8c, 0x3f, 0xc7, 0x2d, 0x8a, 0x71, 0xf7, 0x6f, 0x58, 0xcc, 0x75, 0xea,
+   0x2a, 0x3c, 0x80, 0x6c, 0x30, 0x90, 0xed, 0xbe, 0x9a, 0x71, 0xb5, 0xbd, 0xa4, 0x58, 0x72, 0x30,
+   0xb7, 0xf2, 0x70, 0x41, 0xe4, 0xd7, 0x1a, 0x30, 0xfc, 0x89, 0x3e, 0xa5, 0x9b, 0x4b, 0xc2, 0xa3,
+   0x41, 0xc9, 0x51, 0xe5, 0xae, 0xe7, 0x6d, 0x9d, 0xf7, 0x56, 0xd0, 0x75, 0xbd, 0xf8, 0xa5, 0x3a
+  };
+
+  ak_uint8 R6[100] = {
+   0xb2, 0xd8, 0xf1, 0x24, 0x5f, 0xc4, 0xd2, 0x92, 0x74, 0x80, 0x20, 0x57, 0xe4, 0xb5, 0x4e, 0x0a,
+   0x07, 0x53, 0xaa, 0x22, 0xfc, 0x53, 0x76, 0x0b, 0x30, 0x1c, 0xf0, 0x08, 0x67, 0x9e, 0x58, 0xfe,
+   0x4b, 0xee, 0x9a, 0xdd, 0xca, 0xe9, 0x9b, 0xa2, 0xb0, 0xb2, 0x0f, 0x43, 0x1a, 0x9c, 0x5e, 0x50,
+   0xf3, 0x95, 0xc8, 0x93, 0x87, 0xd0, 0x94, 0x5a, 0xed, 0xec, 0xa6, 0xeb, 0x40, 0x15, 0xdf, 0xc2,
+   0xbd, 0x24, 0x21, 0xee, 0x9b, 0xb7, 0x11, 0x83, 0xba, 0x88, 0x2c, 0xee, 0xbf, 0xef, 0x25, 0x9f,
+   0x33, 0xf9, 0xe2, 0x7d, 0xc6, 0x17, 0x8c, 0xb8, 0x9d, 0xc3, 0x74, 0x28, 0xcf, 0x9c, 0xc5, 0x2a,
+   0x2b, 0xaa, 0x2d, 0x3a
+  };
+
   ak_uint8 password_one[8] = "password",
            password_two[9] = { 'p', 'a', 's', 's', 0, 'w', 'o', 'r', 'd' },
+           password_three[24] = "passwordPASSWORDpassword",
            salt_one[4]     = "salt",
-           salt_two[5]     = { 's', 'a', 0, 'l', 't' };
+           salt_two[5]     = { 's', 'a', 0, 'l', 't' },
+           salt_three[36]  = "saltSALTsaltSALTsaltSALTsaltSALTsalt";
 
-  ak_uint8 out[64];
+  ak_uint8 out[100];
   int error = ak_error_ok;
   int audit = ak_log_get_level();
 
@@ -841,6 +1485,71 @@
   }
   if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
                                              "the 4th test for pbkdf2 from R 50.1.111-2016 is Ok" );
+
+ /* пятый тест из Р 50.1.111-2016 (длина результата превышает длину блока T_1) */
+  if(( error = ak_hmac_pbkdf2_streebog512( password_three, 24,
+                                              salt_three, 36, 4096, 100, out )) != ak_error_ok ) {
+    ak_error_message( error,__func__, "incorrect transformation password to key");
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( out, R6, 100 )) {
+    ak_error_message( ak_error_not_equal_data, __func__ ,
+                                                 "wrong 5th test for pbkdf2 from R 50.1.111-2016" );
+    return ak_false;
+  }
+  if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                                             "the 5th test for pbkdf2 from R 50.1.111-2016 is Ok" );
+
+ /* третий и четвертый тесты, выполняемые одновременно */
+  {
+    ak_uint8 out2[64];
+    ak_pointer pass[2] = { password_one, password_two }, salt[2] = { salt_one, salt_two },
+               res[2] = { out, out2 };
+    size_t pass_size[2] = { 8, 9 }, salt_size[2] = { 4, 5 };
+
+    memset( out, 0, sizeof( out ));
+    memset( out2, 0, sizeof( out2 ));
+    if(( error = ak_hmac_pbkdf2_streebog512_batch( 2, pass, pass_size,
+                                            salt, salt_size, 4096, 64, res )) != ak_error_ok ) {
+      ak_error_message( error,__func__, "incorrect batch transformation passwords to keys");
+      return ak_false;
+    }
+    if( !ak_ptr_is_equal_with_log( out, R3, 64 ) || !ak_ptr_is_equal_with_log( out2, R4, 64 )) {
+      ak_error_message( ak_error_not_equal_data, __func__ ,
+                                          "wrong batch test for pbkdf2 from R 50.1.111-2016" );
+      return ak_false;
+    }
+    if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                                           "the batch test for pbkdf2 from R 50.1.111-2016 is Ok" );
+  }
+
+ /* контрольный пример для алгоритма mhkdf (128 Кб памяти, два прохода, четыре полосы) */
+  memset( out, 0, sizeof( out ));
+  if(( error = ak_hmac_mhkdf_streebog512( password_one, 8,
+                                       salt_one, 4, 128, 2, 4, 64, out )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect transformation password to key with mhkdf" );
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( out, R5, 64 )) {
+    ak_error_message( ak_error_not_equal_data, __func__ , "wrong test for mhkdf with four lanes" );
+    return ak_false;
+  }
+  if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                                                         "the test for mhkdf with four lanes is Ok" );
+
+ /* контрольный пример для алгоритма mhkdf (128 Кб памяти, два прохода, одна полоса) */
+  memset( out, 0, sizeof( out ));
+  if(( error = ak_hmac_mhkdf_streebog512( password_one, 8,
+                                       salt_one, 4, 128, 2, 1, 64, out )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect transformation password to key with mhkdf" );
+    return ak_false;
+  }
+  if( !ak_ptr_is_equal_with_log( out, R7, 64 )) {
+    ak_error_message( ak_error_not_equal_data, __func__ , "wrong test for mhkdf with one lane" );
+    return ak_false;
+  }
+  if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                                                           "the test for mhkdf with one lane is Ok" );
  return ak_true;
 }
 
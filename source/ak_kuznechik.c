@@ -255,6 +255,19 @@
        memcpy( par->dec[i][j], ib, 16 );
      }
   }
+
+ /* таблицы для векторной реализации: элемент vmul[i][j] содержит произведения
+    коэффициента матрицы, связывающего j-й входной и i-й выходной байты блока,
+    на все значения младшего и старшего полубайтов */
+  for( i = 0; i < 16; i++ ) {
+     for( j = 0; j < 16; j++ ) {
+        ak_uint8 c = oc ? par->L[15-i][15-j] : par->L[i][j];
+        for( l = 0; l < 16; l++ ) {
+           par->vmul[i][j][0][l] = ak_bckey_context_kuznechik_mul_gf256( c, ( ak_uint8 )l );
+           par->vmul[i][j][1][l] = ak_bckey_context_kuznechik_mul_gf256( c, ( ak_uint8 )( l << 4 ));
+        }
+     }
+  }
  return ak_error_ok;
 }
 
@@ -295,7 +308,7 @@
       ak_error_message( error, __func__, "incorrect wiping an internal data" );
       memset( skey->data, 0, sizeof( ak_kuznechik_expanded_keys ));
     }
-    free( skey->data );
+    ak_skey_free_data( skey->data );
     skey->data = NULL;
   }
  return error;
@@ -328,7 +341,7 @@
   if( skey->data != NULL ) ak_kuznechik_delete_keys( skey );
 
  /* далее, по-возможности, выделяем выравненную память */
-  if(( skey->data = ak_aligned_malloc( sizeof( ak_kuznechik_expanded_keys ))) == NULL )
+  if(( skey->data = ak_skey_alloc_data( skey, sizeof( ak_kuznechik_expanded_keys ))) == NULL )
     return ak_error_message( ak_error_out_of_memory, __func__ ,
                                                              "wrong allocation of internal data" );
  /* получаем указатели на области памяти */
@@ -670,6 +683,354 @@
   (( ak_uint64 *) out)[1] = x[1] ^ xkey[1];
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                 зашифрование нескольких независимых блоков информации за один вызов             */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество блоков, одновременно обрабатываемых функциями зашифрования. */
+ #define ak_kuznechik_lanes   (2)
+
+/*! \brief Извлечение n-го байта из блока, представленного 64-х битными словами x0 и x1.
+    Байт извлекается сдвигом, а не обращением к памяти, что позволяет компилятору
+    хранить обрабатываемые блоки в регистрах. */
+#ifdef AK_LITTLE_ENDIAN
+ #define ak_kuznechik_byte( x0, x1, n ) ((ak_uint8)( ((n) < 8 ? (x0) : (x1)) >> ( 8*((n)&7) )))
+#else
+ #define ak_kuznechik_byte( x0, x1, n ) ((ak_uint8)( ((n) < 8 ? (x0) : (x1)) >> ( 56 - 8*((n)&7) )))
+#endif
+
+/*! \brief Обращение к таблице для j-го столбца матрицы преобразования LS и n-го байта двух
+    одновременно обрабатываемых блоков. Блоки образуют независимые цепочки вычислений,
+    что позволяет процессору совмещать задержки загрузки табличных значений. */
+ #define ak_kuznechik_enc2( j, n ) {\
+     ta ^= kuznechik_parameters.enc[j][ak_kuznechik_byte( a0, a1, n )][0];\
+     sa ^= kuznechik_parameters.enc[j][ak_kuznechik_byte( a0, a1, n )][1];\
+     tb ^= kuznechik_parameters.enc[j][ak_kuznechik_byte( b0, b1, n )][0];\
+     sb ^= kuznechik_parameters.enc[j][ak_kuznechik_byte( b0, b1, n )][1];\
+   }
+
+/*! \brief Наложение раундового ключа (вместе с маской) на оба обрабатываемых блока. */
+ #define ak_kuznechik_add_key2( r ) {\
+     a0 ^= ekey[r]; a0 ^= mkey[r]; a1 ^= ekey[r+1]; a1 ^= mkey[r+1];\
+     b0 ^= ekey[r]; b0 ^= mkey[r]; b1 ^= ekey[r+1]; b1 ^= mkey[r+1];\
+   }
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует алгоритм зашифрования последовательности независимых блоков
+    информации шифром Кузнечик (согласно ГОСТ Р 34.12-2015).
+
+    Блоки обрабатываются парами: раундовые ключи загружаются один раз на пару, а табличные
+    преобразования двух блоков чередуются между собой. Последний непарный блок
+    зашифровывается функцией ak_kuznechik_encrypt_with_mask().
+
+    @param skey Контекст секретного ключа.
+    @param in Указатель на последовательность блоков открытого текста.
+    @param out Указатель на область памяти, куда помещается шифртекст (может совпадать с in).
+    @param blocks Количество зашифровываемых блоков.                                             */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_blocks_with_mask( ak_skey skey,
+                                                 ak_pointer in, ak_pointer out, size_t blocks )
+{
+  int i = 0;
+  ak_uint64 *ekey = ( ak_uint64 *)skey->data;
+  ak_uint64 *mkey = ( ak_uint64 *)skey->data + 40;
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+  ak_uint64 a0, a1, b0, b1, ta, sa, tb, sb;
+
+  while( blocks >= ak_kuznechik_lanes ) {
+    a0 = inptr[0]; a1 = inptr[1]; b0 = inptr[2]; b1 = inptr[3];
+    for( i = 0; i < 18; i += 2 ) {
+       ak_kuznechik_add_key2( i );
+       ta = sa = tb = sb = 0;
+       ak_kuznechik_enc2(  0,  0 );
+       ak_kuznechik_enc2(  1,  1 );
+       ak_kuznechik_enc2(  2,  2 );
+       ak_kuznechik_enc2(  3,  3 );
+       ak_kuznechik_enc2(  4,  4 );
+       ak_kuznechik_enc2(  5,  5 );
+       ak_kuznechik_enc2(  6,  6 );
+       ak_kuznechik_enc2(  7,  7 );
+       ak_kuznechik_enc2(  8,  8 );
+       ak_kuznechik_enc2(  9,  9 );
+       ak_kuznechik_enc2( 10, 10 );
+       ak_kuznechik_enc2( 11, 11 );
+       ak_kuznechik_enc2( 12, 12 );
+       ak_kuznechik_enc2( 13, 13 );
+       ak_kuznechik_enc2( 14, 14 );
+       ak_kuznechik_enc2( 15, 15 );
+       a0 = ta; a1 = sa; b0 = tb; b1 = sb;
+    }
+    ak_kuznechik_add_key2( 18 );
+    outptr[0] = a0; outptr[1] = a1; outptr[2] = b0; outptr[3] = b1;
+
+    inptr += 2*ak_kuznechik_lanes; outptr += 2*ak_kuznechik_lanes;
+    blocks -= ak_kuznechik_lanes;
+  }
+  while( blocks-- > 0 ) {
+    ak_kuznechik_encrypt_with_mask( skey, inptr, outptr );
+    inptr += 2; outptr += 2;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует алгоритм зашифрования последовательности независимых блоков
+    информации шифром Кузнечик (согласно ГОСТ Р 34.12-2015).
+
+    Реализуется симметричное преобразование, введенное для совместимости с библиотекой openssl
+    и другими реализациями.                                                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_kuznechik_encrypt_blocks_with_mask_oc( ak_skey skey,
+                                                 ak_pointer in, ak_pointer out, size_t blocks )
+{
+  int i = 0;
+  ak_uint64 *ekey = ( ak_uint64 *)skey->data;
+  ak_uint64 *mkey = ( ak_uint64 *)skey->data + 40;
+  ak_uint64 *inptr = ( ak_uint64 *)in, *outptr = ( ak_uint64 *)out;
+  ak_uint64 a0, a1, b0, b1, ta, sa, tb, sb;
+
+  while( blocks >= ak_kuznechik_lanes ) {
+    a0 = inptr[0]; a1 = inptr[1]; b0 = inptr[2]; b1 = inptr[3];
+    for( i = 0; i < 18; i += 2 ) {
+       ak_kuznechik_add_key2( i );
+       ta = sa = tb = sb = 0;
+       ak_kuznechik_enc2(  0, 15 );
+       ak_kuznechik_enc2(  1, 14 );
+       ak_kuznechik_enc2(  2, 13 );
+       ak_kuznechik_enc2(  3, 12 );
+       ak_kuznechik_enc2(  4, 11 );
+       ak_kuznechik_enc2(  5, 10 );
+       ak_kuznechik_enc2(  6,  9 );
+       ak_kuznechik_enc2(  7,  8 );
+       ak_kuznechik_enc2(  8,  7 );
+       ak_kuznechik_enc2(  9,  6 );
+       ak_kuznechik_enc2( 10,  5 );
+       ak_kuznechik_enc2( 11,  4 );
+       ak_kuznechik_enc2( 12,  3 );
+       ak_kuznechik_enc2( 13,  2 );
+       ak_kuznechik_enc2( 14,  1 );
+       ak_kuznechik_enc2( 15,  0 );
+       a0 = ta; a1 = sa; b0 = tb; b1 = sb;
+    }
+    ak_kuznechik_add_key2( 18 );
+    outptr[0] = a0; outptr[1] = a1; outptr[2] = b0; outptr[3] = b1;
+
+    inptr += 2*ak_kuznechik_lanes; outptr += 2*ak_kuznechik_lanes;
+    blocks -= ak_kuznechik_lanes;
+  }
+  while( blocks-- > 0 ) {
+    ak_kuznechik_encrypt_with_mask_oc( skey, inptr, outptr );
+    inptr += 2; outptr += 2;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*                      векторная реализация зашифрования (SSSE3, AVX2, AVX-512)                   */
+/* ----------------------------------------------------------------------------------------------- */
+/*  Блоки обрабатываются в транспонированном (bitsliced по байтам) представлении: p-й вектор
+    содержит p-е байты всех одновременно обрабатываемых блоков (16 блоков для SSSE3, 32 для AVX2
+    и 64 для AVX-512). Нелинейное преобразование вычисляется с помощью команды pshufb по
+    шестнадцати строкам таблицы pi, а линейное - как сумма произведений байтов на элементы
+    матрицы L с помощью таблиц умножения полубайтов vmul. Все обращения к памяти выполняются
+    по адресам, не зависящим от обрабатываемых данных и ключа, что устраняет зависимость
+    времени выполнения от содержимого кэш-памяти.                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+#if defined( AK_HAVE_BUILTIN_SSSE3 ) && defined( AK_HAVE_BUILTIN_CPU_SUPPORTS )
+ #define AK_KUZNECHIK_VPERM
+ #include <immintrin.h>
+
+/*! \brief Транспонирование матрицы 16x16 байт (в каждой 128-битной полосе векторов x). */
+ #define ak_kuznechik_vperm_transpose( vtype, vunpacklo, vunpackhi ) {\
+   int st, ti;\
+   vtype ty[16];\
+   for( st = 0; st < 4; st++ ) {\
+      for( ti = 0; ti < 8; ti++ ) {\
+         ty[2*ti] = vunpacklo( x[ti], x[ti+8] );\
+         ty[2*ti+1] = vunpackhi( x[ti], x[ti+8] );\
+      }\
+      for( ti = 0; ti < 16; ti++ ) x[ti] = ty[ti];\
+   }\
+ }
+
+/*! \brief Девять раундов преобразования LSX и наложение последнего раундового ключа
+    для блоков, размещенных в векторах x в транспонированном виде. */
+ #define ak_kuznechik_vperm_rounds( vtype, vxor, vor, vand,\
+                                           vshuffle, vadds, vsrli16, vset1, vtable ) {\
+   int r, p, q, h;\
+   vtype lo[16], hi[16], v, z;\
+   const vtype m0f = vset1( 0x0f ), m70 = vset1( 0x70 );\
+   for( r = 0; r < 9; r++ ) {\
+      for( p = 0; p < 16; p++ ) {\
+         v = vxor( vxor( x[p], vset1( (char) ek[16*r+p] )), vset1( (char) mk[16*r+p] ));\
+         z = vshuffle( vtable( kuznechik_parameters.pi ), vadds( v, m70 ));\
+         for( h = 1; h < 16; h++ )\
+            z = vor( z, vshuffle( vtable( kuznechik_parameters.pi + 16*h ),\
+                                                vadds( vxor( v, vset1( (char)( h << 4 ))), m70 )));\
+         lo[p] = vand( z, m0f );\
+         hi[p] = vand( vsrli16( z, 4 ), m0f );\
+      }\
+      for( q = 0; q < 16; q++ ) {\
+         z = vxor( vshuffle( vtable( kuznechik_parameters.vmul[q][0][0] ), lo[0] ),\
+                   vshuffle( vtable( kuznechik_parameters.vmul[q][0][1] ), hi[0] ));\
+         for( p = 1; p < 16; p++ )\
+            z = vxor( z, vxor( vshuffle( vtable( kuznechik_parameters.vmul[q][p][0] ), lo[p] ),\
+                               vshuffle( vtable( kuznechik_parameters.vmul[q][p][1] ), hi[p] )));\
+         x[q] = z;\
+      }\
+   }\
+   for( p = 0; p < 16; p++ )\
+      x[p] = vxor( vxor( x[p], vset1( (char) ek[144+p] )), vset1( (char) mk[144+p] ));\
+ }
+
+ #define ak_kuznechik_table128( ptr ) _mm_loadu_si128( (const __m128i *)( ptr ))
+ #define ak_kuznechik_table256( ptr ) _mm256_broadcastsi128_si256( ak_kuznechik_table128( ptr ))
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Зашифрование 16 блоков с использованием команд SSSE3. */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "ssse3" )))
+ static void ak_kuznechik_encrypt16_ssse3( ak_skey skey, ak_uint8 *in, ak_uint8 *out )
+{
+  int i;
+  __m128i x[16];
+  ak_uint8 *ek = ( ak_uint8 *)skey->data, *mk = ( ak_uint8 *)(( ak_uint64 *)skey->data + 40 );
+
+  for( i = 0; i < 16; i++ ) x[i] = _mm_loadu_si128( (const __m128i *)( in + 16*i ));
+  ak_kuznechik_vperm_transpose( __m128i, _mm_unpacklo_epi8, _mm_unpackhi_epi8 );
+  ak_kuznechik_vperm_rounds( __m128i, _mm_xor_si128, _mm_or_si128, _mm_and_si128,
+                                   _mm_shuffle_epi8, _mm_adds_epu8, _mm_srli_epi16,
+                                                             _mm_set1_epi8, ak_kuznechik_table128 );
+  ak_kuznechik_vperm_transpose( __m128i, _mm_unpacklo_epi8, _mm_unpackhi_epi8 );
+  for( i = 0; i < 16; i++ ) _mm_storeu_si128( (__m128i *)( out + 16*i ), x[i] );
+}
+
+#ifdef AK_HAVE_BUILTIN_AVX2
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Зашифрование 32 блоков с использованием команд AVX2
+    (младшие полосы векторов содержат блоки с 0 по 15, старшие - с 16 по 31). */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx2" )))
+ static void ak_kuznechik_encrypt32_avx2( ak_skey skey, ak_uint8 *in, ak_uint8 *out )
+{
+  int i;
+  __m256i x[16];
+  ak_uint8 *ek = ( ak_uint8 *)skey->data, *mk = ( ak_uint8 *)(( ak_uint64 *)skey->data + 40 );
+
+  for( i = 0; i < 16; i++ )
+     x[i] = _mm256_inserti128_si256( _mm256_castsi128_si256(
+                       _mm_loadu_si128( (const __m128i *)( in + 16*i ))),
+                       _mm_loadu_si128( (const __m128i *)( in + 256 + 16*i )), 1 );
+  ak_kuznechik_vperm_transpose( __m256i, _mm256_unpacklo_epi8, _mm256_unpackhi_epi8 );
+  ak_kuznechik_vperm_rounds( __m256i, _mm256_xor_si256, _mm256_or_si256, _mm256_and_si256,
+                                _mm256_shuffle_epi8, _mm256_adds_epu8, _mm256_srli_epi16,
+                                                          _mm256_set1_epi8, ak_kuznechik_table256 );
+  ak_kuznechik_vperm_transpose( __m256i, _mm256_unpacklo_epi8, _mm256_unpackhi_epi8 );
+  for( i = 0; i < 16; i++ ) {
+     _mm_storeu_si128( (__m128i *)( out + 16*i ), _mm256_castsi256_si128( x[i] ));
+     _mm_storeu_si128( (__m128i *)( out + 256 + 16*i ), _mm256_extracti128_si256( x[i], 1 ));
+  }
+}
+#endif
+
+#ifdef AK_HAVE_BUILTIN_AVX512
+ #define ak_kuznechik_table512( ptr ) _mm512_broadcast_i32x4( ak_kuznechik_table128( ptr ))
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Зашифрование 64 блоков с использованием команд AVX-512
+    (k-я полоса векторов содержит блоки с 16k по 16k+15). */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx512f,avx512bw" )))
+ static void ak_kuznechik_encrypt64_avx512( ak_skey skey, ak_uint8 *in, ak_uint8 *out )
+{
+  int i;
+  __m512i x[16];
+  ak_uint8 *ek = ( ak_uint8 *)skey->data, *mk = ( ak_uint8 *)(( ak_uint64 *)skey->data + 40 );
+
+  for( i = 0; i < 16; i++ ) {
+     x[i] = _mm512_castsi128_si512( _mm_loadu_si128( (const __m128i *)( in + 16*i )));
+     x[i] = _mm512_inserti32x4( x[i], _mm_loadu_si128( (const __m128i *)( in + 256 + 16*i )), 1 );
+     x[i] = _mm512_inserti32x4( x[i], _mm_loadu_si128( (const __m128i *)( in + 512 + 16*i )), 2 );
+     x[i] = _mm512_inserti32x4( x[i], _mm_loadu_si128( (const __m128i *)( in + 768 + 16*i )), 3 );
+  }
+  ak_kuznechik_vperm_transpose( __m512i, _mm512_unpacklo_epi8, _mm512_unpackhi_epi8 );
+  ak_kuznechik_vperm_rounds( __m512i, _mm512_xor_si512, _mm512_or_si512, _mm512_and_si512,
+                                _mm512_shuffle_epi8, _mm512_adds_epu8, _mm512_srli_epi16,
+                                                          _mm512_set1_epi8, ak_kuznechik_table512 );
+  ak_kuznechik_vperm_transpose( __m512i, _mm512_unpacklo_epi8, _mm512_unpackhi_epi8 );
+  for( i = 0; i < 16; i++ ) {
+     _mm_storeu_si128( (__m128i *)( out + 16*i ), _mm512_castsi512_si128( x[i] ));
+     _mm_storeu_si128( (__m128i *)( out + 256 + 16*i ), _mm512_extracti32x4_epi32( x[i], 1 ));
+     _mm_storeu_si128( (__m128i *)( out + 512 + 16*i ), _mm512_extracti32x4_epi32( x[i], 2 ));
+     _mm_storeu_si128( (__m128i *)( out + 768 + 16*i ), _mm512_extracti32x4_epi32( x[i], 3 ));
+  }
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования последовательности блоков: блоки обрабатываются группами
+    фиксированного размера векторной функцией kernel, а оставшиеся передаются функции tail. */
+/* ----------------------------------------------------------------------------------------------- */
+ #define ak_kuznechik_vperm_blocks( name, kernel, width, tail ) \
+ static void name( ak_skey skey, ak_pointer in, ak_pointer out, size_t blocks ) {\
+   ak_uint8 *inptr = ( ak_uint8 *)in, *outptr = ( ak_uint8 *)out;\
+   while( blocks >= width ) {\
+      kernel( skey, inptr, outptr );\
+      inptr += 16*width; outptr += 16*width; blocks -= width;\
+   }\
+   if( blocks ) tail( skey, inptr, outptr, blocks );\
+ }
+
+ ak_kuznechik_vperm_blocks( ak_kuznechik_encrypt_blocks_ssse3,
+                   ak_kuznechik_encrypt16_ssse3, 16, ak_kuznechik_encrypt_blocks_with_mask )
+ ak_kuznechik_vperm_blocks( ak_kuznechik_encrypt_blocks_ssse3_oc,
+                ak_kuznechik_encrypt16_ssse3, 16, ak_kuznechik_encrypt_blocks_with_mask_oc )
+#ifdef AK_HAVE_BUILTIN_AVX2
+ ak_kuznechik_vperm_blocks( ak_kuznechik_encrypt_blocks_avx2,
+                          ak_kuznechik_encrypt32_avx2, 32, ak_kuznechik_encrypt_blocks_ssse3 )
+ ak_kuznechik_vperm_blocks( ak_kuznechik_encrypt_blocks_avx2_oc,
+                       ak_kuznechik_encrypt32_avx2, 32, ak_kuznechik_encrypt_blocks_ssse3_oc )
+#endif
+#ifdef AK_HAVE_BUILTIN_AVX512
+ ak_kuznechik_vperm_blocks( ak_kuznechik_encrypt_blocks_avx512,
+                         ak_kuznechik_encrypt64_avx512, 64, ak_kuznechik_encrypt_blocks_avx2 )
+ ak_kuznechik_vperm_blocks( ak_kuznechik_encrypt_blocks_avx512_oc,
+                      ak_kuznechik_encrypt64_avx512, 64, ak_kuznechik_encrypt_blocks_avx2_oc )
+#endif
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция выбирает реализацию зашифрования последовательности блоков, наиболее
+    подходящую для используемого процессора. Если векторные расширения недоступны
+    (на этапе сборки или выполнения), используется табличная реализация.
+
+    @param oc Флаг совместимости с библиотекой openssl.
+    @param backend Значение опции `kuznechik_simd_backend`: 0 - табличная реализация,
+    1 - векторная реализация только при наличии AVX-512 (на остальных процессорах
+    табличная реализация быстрее), 2 - любая доступная векторная реализация.
+    @return Указатель на функцию зашифрования последовательности блоков.                          */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_function_bckey_blocks *ak_kuznechik_select_encrypt_blocks( int oc, int backend )
+{
+#ifdef AK_KUZNECHIK_VPERM
+  if( backend > 0 ) {
+    __builtin_cpu_init();
+   #ifdef AK_HAVE_BUILTIN_AVX512
+    if( __builtin_cpu_supports( "avx512bw" ))
+      return oc ? ak_kuznechik_encrypt_blocks_avx512_oc : ak_kuznechik_encrypt_blocks_avx512;
+   #endif
+    if( backend > 1 ) {
+     #ifdef AK_HAVE_BUILTIN_AVX2
+      if( __builtin_cpu_supports( "avx2" ))
+        return oc ? ak_kuznechik_encrypt_blocks_avx2_oc : ak_kuznechik_encrypt_blocks_avx2;
+     #endif
+      if( __builtin_cpu_supports( "ssse3" ))
+        return oc ? ak_kuznechik_encrypt_blocks_ssse3_oc : ak_kuznechik_encrypt_blocks_ssse3;
+    }
+  }
+#else
+  (void)backend;
+#endif
+ return oc ? ak_kuznechik_encrypt_blocks_with_mask_oc : ak_kuznechik_encrypt_blocks_with_mask;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! После инициализации устанавливаются обработчики (функции класса). Однако само значение
     ключу не присваивается - поле `bkey->key` остается неопределенным.
@@ -711,6 +1072,8 @@
     bkey->encrypt = ak_kuznechik_encrypt_with_mask;
     bkey->decrypt = ak_kuznechik_decrypt_with_mask;
   }
+  bkey->encrypt_blocks = ak_kuznechik_select_encrypt_blocks( oc,
+                               (int) ak_libakrypt_get_option_by_name( "kuznechik_simd_backend" ));
  return error;
 }
 
@@ -831,9 +1194,9 @@
 {
   size_t i = 0;
   struct bckey bkey;
-  ak_uint8 myout[256];
+  ak_uint8 myout[256], mbin[115*16], mbout[115*16];
   bool_t result = ak_true;
-  int error = ak_error_ok, audit = ak_log_get_level(),
+  int backend = 0, error = ak_error_ok, audit = ak_log_get_level(),
       oc = (int) ak_libakrypt_get_option_by_name( "openssl_compability" );
 
  /* тестовый ключ из ГОСТ Р 34.13-2015, приложение А.1 */
@@ -1177,6 +1540,29 @@
   }
   if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
                                           "the cmac integrity test from GOST R 34.13-2015 is Ok" );
+
+ /* --------------------------------------------------------------------------- */
+ /* 11. Сравниваем одновременное зашифрование нескольких блоков с поблочным    */
+ /*     для всех реализаций, доступных на данном процессоре. Количество блоков  */
+ /*     (115 = 64 + 32 + 16 + 3) задействует все векторные функции.             */
+ /* --------------------------------------------------------------------------- */
+  for( i = 0; i < sizeof( mbin ); i++ ) mbin[i] = (ak_uint8)( i*i + 0x35 );
+  for( backend = 0; backend < 3; backend++ ) {
+     ak_kuznechik_select_encrypt_blocks( oc, backend )( &bkey.key,
+                                                            mbin, mbout, sizeof( mbin ) >> 4 );
+     for( i = 0; i < sizeof( mbin ); i += 16 ) {
+        bkey.encrypt( &bkey.key, mbin+i, myout );
+        if( !ak_ptr_is_equal_with_log( myout, mbout+i, 16 )) {
+          ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+               "the multi-block encryption is not equal to single-block one (block %u, backend %d)",
+                                                               (unsigned int)( i >> 4 ), backend );
+          result = ak_false;
+          goto exit;
+        }
+     }
+  }
+  if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                                                        "the multi-block encryption test is Ok" );
  /* освобождаем ключ и выходим */
   exit:
   if(( error = ak_bckey_destroy( &bkey )) != ak_error_ok ) {
@@ -160,6 +160,12 @@
     return ak_false;
   }
 
+ /* тестируем корректность реализации блочного шифра TwoFish */
+  if( ak_libakrypt_test_twofish()  != ak_true ) {
+    ak_error_message( ak_error_get_value(), __func__ , "incorrect testing of twofish block cipher" );
+    return ak_false;
+  }
+
  /* тестируем дополнительные режимы работы */
   if( ak_libakrypt_test_acpkm()  != ak_true ) {
     ak_error_message( ak_error_get_value(), __func__ ,
@@ -357,6 +363,12 @@
      return ak_false;
    }
 
+ /* инициализируем таблицы пакетной реализации алгоритма Магма */
+   if(( error = ak_bckey_magma_init_tables()) != ak_error_ok ) {
+     ak_error_message( error, __func__, "initialization of magma tables is wrong" );
+     return ak_false;
+   }
+
  /* в случае, когда компилируются сетевые функции, инициализируем работу с сокетами */
 #ifdef AK_HAVE_WINDOWS_H
   #ifdef LIBAKRYPT_NETWORK
@@ -408,6 +420,11 @@
   #endif
 #endif
 
+ /* уничтожаем объекты, размещенные в менеджере контекстов */
+  ak_libakrypt_destroy_context_manager();
+ /* освобождаем защищенную область памяти, если в ней не осталось ключей */
+  ak_secure_arena_destroy();
+
   if( ak_log_get_level() != ak_log_none )
     ak_error_message( ak_error_ok, __func__ , "all crypto mechanisms successfully destroyed" );
 
@@ -6,6 +6,11 @@
 /* ----------------------------------------------------------------------------------------------- */
  #include <libakrypt.h>
 
+/* ----------------------------------------------------------------------------------------------- */
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
 /* ----------------------------------------------------------------------------------------------- */
  int ak_mac_create( ak_mac mctx, const size_t size, ak_pointer ictx,
                             ak_function_clean *clean, ak_function_update *update,
@@ -26,6 +31,7 @@
   mctx->clean = clean;
   mctx->update = update;
   mctx->finalize = finalize;
+  mctx->finalize_inplace = NULL;
 
  return ak_error_ok;
 }
@@ -46,6 +52,7 @@
   mctx->clean = NULL;
   mctx->update = NULL;
   mctx->finalize = NULL;
+  mctx->finalize_inplace = NULL;
 
  return ak_error_ok;
 }
@@ -71,29 +78,27 @@
 }
 
 /* ----------------------------------------------------------------------------------------------- */
-/*! @param mctx Указатель на контекст итерационного сжатия.
-    @param in Сжимаемые данные
-    @param size Размер сжимаемых данных в байтах. Данное значение может
-    быть произвольным, в том числе равным нулю и/или не кратным длине блока обрабатываемых данных
-    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
-    возвращается код ошибки.                                                                       */
+/*! \brief Обработка одного фрагмента данных без проверки параметров контекста.
+
+    Данные, длина которых кратна длине блока, передаются функции сжатия напрямую, минуя
+    временный буффер. Во временный буффер копируются только неполные блоки;
+    после обработки заполненного временного буффера его содержимое очищается.
+
+    @param mctx Указатель на контекст итерационного сжатия.
+    @param ptrin Сжимаемые данные.
+    @param newsize Размер сжимаемых данных в байтах.                                               */
 /* ----------------------------------------------------------------------------------------------- */
- int ak_mac_update( ak_mac mctx, const ak_pointer in, const size_t size )
+ static inline void ak_mac_update_fragment( ak_mac mctx, const ak_uint8 *ptrin, size_t newsize )
 {
-  ak_uint8 *ptrin = (ak_uint8 *) in;
-  size_t quot = 0, offset = 0, newsize = size;
+  size_t quot = 0, offset = 0;
 
-  if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
-                                                  "using a null pointer to internal mac context" );
-  if( mctx->update == NULL ) return ak_error_message( ak_error_undefined_function, __func__ ,
-                                                            "using an undefined update function" );
  /* в начале проверяем, есть ли данные во временном буфере */
   if( mctx->length != 0 ) {
    /* если новых данных мало, то добавляем во временный буффер и выходим */
     if(( mctx->length + newsize ) < mctx->bsize ) {
        memcpy( mctx->data + mctx->length, ptrin, newsize );
        mctx->length += newsize;
-       return ak_error_ok;
+       return;
     }
    /* дополняем буффер до длины, кратной bsize */
     offset = mctx->bsize - mctx->length;
@@ -112,13 +117,64 @@
     quot = newsize/mctx->bsize;
     offset = quot*mctx->bsize;
    /* обрабатываем часть, кратную величине bsize */
-    if( quot > 0 ) mctx->update( mctx->ctx, ptrin, offset );
+    if( quot > 0 ) mctx->update( mctx->ctx, ( ak_pointer )ptrin, offset );
    /* хвост оставляем на следующий раз */
     if( offset < newsize ) {
       mctx->length = newsize - offset;
       memcpy( mctx->data, ptrin + offset, mctx->length );
     }
   }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param mctx Указатель на контекст итерационного сжатия.
+    @param in Сжимаемые данные
+    @param size Размер сжимаемых данных в байтах. Данное значение может
+    быть произвольным, в том числе равным нулю и/или не кратным длине блока обрабатываемых данных
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_mac_update( ak_mac mctx, const ak_pointer in, const size_t size )
+{
+  if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to internal mac context" );
+  if( mctx->update == NULL ) return ak_error_message( ak_error_undefined_function, __func__ ,
+                                                            "using an undefined update function" );
+  if( size != 0 ) ak_mac_update_fragment( mctx, ( const ak_uint8 * )in, size );
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция последовательно обрабатывает несколько фрагментов данных, расположенных
+    в несвязных областях памяти. Результат совпадает с результатом последовательного вызова
+    функции ak_mac_update() для каждого фрагмента, однако проверка контекста выполняется
+    только один раз. Функция предназначена для обработки большого количества
+    коротких фрагментов (например, полей записи журнала).
+
+    @param mctx Указатель на контекст итерационного сжатия.
+    @param iov Массив фрагментов сжимаемых данных. Фрагменты могут иметь нулевую длину.
+    @param count Количество элементов массива.
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_mac_updatev( ak_mac mctx, const struct iovector *iov, const size_t count )
+{
+  size_t i = 0;
+
+  if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                  "using a null pointer to internal mac context" );
+  if( mctx->update == NULL ) return ak_error_message( ak_error_undefined_function, __func__ ,
+                                                            "using an undefined update function" );
+  if( !count ) return ak_error_ok;
+  if( iov == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                          "using a null pointer to input vector" );
+  for( i = 0; i < count; i++ ) {
+     if( !iov[i].size ) continue;
+     if( iov[i].data == NULL ) return ak_error_message_fmt( ak_error_null_pointer, __func__,
+                                                "using a null pointer to fragment %u", (unsigned int) i );
+     ak_mac_update_fragment( mctx, ( const ak_uint8 * )iov[i].data, iov[i].size );
+  }
 
  return ak_error_ok;
 }
@@ -156,6 +212,41 @@
  return mctx->finalize( mctx->ctx, mctx->data, mctx->length, out, out_size );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция аналогична функции ak_mac_finalize(), однако, если алгоритм сжатия предоставляет
+    функцию finalize_inplace, то вычисление результата производится непосредственно
+    над внутренним состоянием, без создания его копии.
+
+    \note После вызова функции внутреннее состояние контекста не определено; перед
+    обработкой нового сообщения контекст должен быть очищен с помощью ak_mac_clean().
+
+    @param mctx Указатель на контекст итерационного сжатия.
+    @param in Указатель на входные данные для которых вычисляется хеш-код.
+    @param size Размер входных данных в байтах.
+    @param out Область памяти, куда будет помещен результат. Память должна быть заранее выделена.
+    @param out_size Размер области памяти (в октетах), в которую будет помещен результат.
+
+    @return В случае успеха функция возвращает ноль (\ref ak_error_ok). В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_mac_finalize_inplace( ak_mac mctx,
+                    const ak_pointer in, const size_t size, ak_pointer out, const size_t out_size )
+{
+  int error = ak_error_ok;
+
+  if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                   "using a null pointer to internal mac context" );
+  if( mctx->finalize_inplace == NULL ) return ak_mac_finalize( mctx, in, size, out, out_size );
+
+  if( ak_mac_update( mctx, in, size ) != ak_error_ok )
+    return ak_error_message( ak_error_get_value(), __func__ , "incorrect updating input data" );
+
+  error = mctx->finalize_inplace( mctx->ctx, mctx->data, mctx->length, out, out_size );
+  memset( mctx->data, 0, mctx->length );
+  mctx->length = 0;
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \note Внутренняя структура, хранящая промежуточные данные, не очищается. Это позволяет повторно
     примененять функцию finalize к текущему состоянию.
@@ -186,10 +277,130 @@
  return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Фрагмент файла, считываемый отдельным потоком во время обработки предыдущего фрагмента. */
+ typedef struct mac_file_fragment {
+  /*! \brief Контекст файла. */
+   ak_file file;
+  /*! \brief Область памяти для считываемых данных. */
+   ak_uint8 *buffer;
+  /*! \brief Размер области памяти. */
+   size_t size;
+  /*! \brief Количество считанных октетов (отрицательное значение означает ошибку чтения). */
+   ssize_t len;
+ #ifdef AK_HAVE_PTHREAD_H
+  /*! \brief Поток, выполняющий чтение. */
+   pthread_t thread;
+ #endif
+ } *ak_mac_file_fragment;
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Считывание фрагмента файла; функция читает данные до тех пор, пока не будет заполнена
+    вся область памяти или не будет достигнут конец файла. */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_mac_file_read_fragment( ak_mac_file_fragment fr )
+{
+  ssize_t len = 0;
+
+  fr->len = 0;
+  while(( size_t )fr->len < fr->size ) {
+    if(( len = ak_file_read( fr->file, fr->buffer + fr->len, fr->size - ( size_t )fr->len )) <= 0 )
+      break;
+    fr->len += len;
+  }
+  if( len < 0 ) fr->len = -1;
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_mac_file_read_thread( void *ptr )
+{
+  ak_mac_file_read_fragment(( ak_mac_file_fragment ) ptr );
+ return NULL;
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Обработка файла, отображенного в память. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_mac_file_mmap( ak_mac mctx, ak_file file, ak_pointer out, const size_t out_size )
+{
+  int error = ak_error_ok;
+  ak_pointer ptr = NULL;
+
+  if(( ptr = ak_file_mmap( file, NULL, readonly, 0 )) == NULL ) return ak_error_mmap_file;
+  error = ak_mac_finalize( mctx, ptr, ( size_t )file->size, out, out_size );
+  ak_file_unmap( file, ptr );
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Обработка файла, считываемого двумя чередующимися фрагментами: пока текущий поток
+    обрабатывает очередной фрагмент, дополнительный поток считывает следующий. */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_mac_file_read( ak_mac mctx, ak_file file, ak_pointer out, const size_t out_size )
+{
+  int error = ak_error_ok;
+  ak_uint8 *localbuffer = NULL; /* место для локального считывания информации */
+  size_t idx = 0, qcnt = 0, tail = 0,
+         block_size = ( size_t ) ak_libakrypt_get_option_by_name( "mac_file_buffer_size" ) << 10;
+  struct mac_file_fragment frs[2];
+  bool_t threaded = ak_false;
+
+ /* для небольших файлов ограничиваем размер буффера длиной файла,
+    размер буффера всегда кратен длине блока обрабатываемых данных */
+  if(( ak_uint64 )file->size < ( ak_uint64 )block_size ) block_size = ( size_t )file->size + 1;
+  block_size = mctx->bsize*(( block_size + mctx->bsize - 1 )/mctx->bsize );
+
+ /* здесь мы выделяем локальные буфферы для считывания/обработки данных */
+  if(( localbuffer = ( ak_uint8 * ) ak_aligned_malloc( 2*block_size )) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__ ,
+                                                      "memory allocation error for local buffer" );
+  for( idx = 0; idx < 2; idx++ ) {
+     frs[idx].file = file;
+     frs[idx].buffer = localbuffer + idx*block_size;
+     frs[idx].size = block_size;
+  }
+
+ /* теперь обрабатываем файл с данными */
+  idx = 0;
+  ak_mac_file_read_fragment( frs );
+  while( frs[idx].len == ( ssize_t )block_size ) {
+   /* запускаем чтение следующего фрагмента */
+   #ifdef AK_HAVE_PTHREAD_H
+    threaded = ( pthread_create( &frs[idx^1].thread, NULL,
+                                           ak_mac_file_read_thread, frs+(idx^1) ) == 0 );
+   #endif
+    if( !threaded ) ak_mac_file_read_fragment( frs+(idx^1) );
+    ak_mac_update( mctx, frs[idx].buffer, block_size ); /* добавляем считанные данные */
+   #ifdef AK_HAVE_PTHREAD_H
+    if( threaded ) pthread_join( frs[idx^1].thread, NULL );
+   #endif
+    idx ^= 1;
+  }
+  if( frs[idx].len < 0 ) {
+    ak_error_message( error = ak_error_read_data, __func__, "incorrect reading of file" );
+  } else {
+      qcnt = ( size_t )frs[idx].len / mctx->bsize;
+      tail = ( size_t )frs[idx].len - qcnt*mctx->bsize;
+      if( qcnt ) ak_mac_update( mctx, frs[idx].buffer, qcnt*mctx->bsize );
+      error = ak_mac_finalize( mctx,
+                                         frs[idx].buffer + qcnt*mctx->bsize, tail, out, out_size );
+    }
+  free( localbuffer );
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция вычисляет результат сжимающего отображения для заданного файла и помещает
     его в область памяти, на которую указывает out.
 
+    Если значение опции `mac_file_use_mmap` отлично от нуля, то файл отображается в память
+    с помощью функции ak_file_mmap(). Если отображение невозможно (или запрещено),
+    файл считывается фрагментами, размер которых (в килобайтах) определяется
+    опцией `mac_file_buffer_size`; при этом считывание очередного фрагмента выполняется
+    отдельным потоком одновременно с обработкой предыдущего фрагмента.
+
     @param mctx Указатель на контекст итерационного сжатия.
     @param filename имя сжимаемого файла
     @param out Область памяти, куда будет помещен результат. Память должна быть заранее выделена.
@@ -202,11 +413,8 @@
 /* ----------------------------------------------------------------------------------------------- */
  int ak_mac_file( ak_mac mctx, const char* filename, ak_pointer out, const size_t out_size )
 {
-  size_t len = 0;
   struct file file;
   int error = ak_error_ok;
-  size_t block_size = 4096; /* оптимальная длина блока для Windows пока не ясна */
-  ak_uint8 *localbuffer = NULL; /* место для локального считывания информации */
 
  /* выполняем необходимые проверки */
   if( mctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
@@ -225,31 +433,17 @@
     return ak_mac_finalize( mctx, "", 0, out, out_size );
   }
 
- /* готовим область для хранения данных */
-  block_size = ak_max( ( size_t )file.blksize, mctx->bsize );
- /* здесь мы выделяем локальный буффер для считывания/обработки данных */
-  if(( localbuffer = ( ak_uint8 * ) ak_aligned_malloc( block_size )) == NULL ) {
-    ak_file_close( &file );
-    return ak_error_message( ak_error_out_of_memory, __func__ ,
-                                                      "memory allocation error for local buffer" );
-  }
- /* теперь обрабатываем файл с данными */
-  read_label: len = ( size_t ) ak_file_read( &file, localbuffer, block_size );
-  if( len == block_size ) {
-    ak_mac_update( mctx, localbuffer, block_size ); /* добавляем считанные данные */
-    goto read_label;
-  } else {
-           size_t qcnt = len / mctx->bsize,
-                  tail = len - qcnt*mctx->bsize;
-           if( qcnt ) ak_mac_update( mctx, localbuffer, qcnt*mctx->bsize );
-           error = ak_mac_finalize( mctx,
-                                             localbuffer + qcnt*mctx->bsize, tail, out, out_size );
-         }
+ /* обрабатываем файл, отображая его в память или считывая его фрагментами */
+  error = ak_error_mmap_file;
+  if( ak_libakrypt_get_option_by_name( "mac_file_use_mmap" ) &&
+                                                     ( ak_file_or_directory( filename ) == DT_REG ))
+    error = ak_mac_file_mmap( mctx, &file, out, out_size );
+  if( error == ak_error_mmap_file ) error = ak_mac_file_read( mctx, &file, out, out_size );
+
  /* очищаем за собой данные, содержащиеся в контексте */
   ak_mac_clean( mctx );
  /* закрываем данные */
   ak_file_close( &file );
-  free( localbuffer );
  return error;
 }
 
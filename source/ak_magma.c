@@ -639,6 +639,268 @@
 #endif
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                   зашифрование последовательности блоков (пакетная реализация)                  */
+/* ----------------------------------------------------------------------------------------------- */
+/*  Блоки обрабатываются группами по ak_magma_batch блоков: для всех блоков группы вырабатывается
+    одна случайная траектория (вектор раундовых инверсий), а ключи и маски каждого такта
+    загружаются один раз на всю группу. Преобразование F вычисляется с помощью таблиц
+    magma_xboxes, объединяющих замену байта и циклический сдвиг на 11 бит, что позволяет
+    векторной реализации (AVX2) обрабатывать восемь блоков одной командой выборки из памяти.     */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество блоков, зашифровываемых с использованием одной случайной траектории. */
+ #define ak_magma_batch  (16)
+
+/*! \brief Таблицы преобразования F для каждого из четырех байтов аргумента
+    (с учетом инверсий входа и выхода, определяемых траекторией). */
+ static ak_uint32 magma_xboxes[2][2][4][256];
+
+/*! \brief Порядок использования раундовых ключей при зашифровании. */
+ static const ak_uint8 magma_encrypt_order[32] = {
+   7, 6, 5, 4, 3, 2, 1, 0, 7, 6, 5, 4, 3, 2, 1, 0, 7, 6, 5, 4, 3, 2, 1, 0, 0, 1, 2, 3, 4, 5, 6, 7
+ };
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вырабатывает таблицы, используемые при пакетном зашифровании
+    последовательности блоков алгоритмом Магма.
+
+    @return Функция возвращает \ref ak_error_ok.                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_magma_init_tables( void )
+{
+  ak_uint32 i, j, k, x;
+
+  for( j = 0; j < 2; j++ )
+     for( i = 0; i < 2; i++ )
+        for( k = 0; k < 4; k++ )
+           for( x = 0; x < 256; x++ ) {
+              ak_uint32 v = ( ak_uint32 )magma_boxes[j][i][k][x] << ( 8*k );
+              magma_xboxes[j][i][k][x] = v << 11 | v >> ( 32-11 );
+           }
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция вырабатывает случайную траекторию для группы блоков.
+
+    @param skey Контекст секретного ключа.
+    @param m Массив из 34 элементов, в который помещается вектор раундовых инверсий.
+    @param oc Флаг совместимости с библиотекой openssl.                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_magma_random_walk( ak_skey skey, ak_uint8 *m, int oc )
+{
+  ak_uint32 i, mv = 0;
+
+  skey->generator.random( &skey->generator, &mv, sizeof( ak_uint32 ));
+  m[0] = m[33] = 0;
+  for( i = 0; i < 32; i++ ) m[i+1] = (ak_uint8)(( mv >> i) & 0x01 );
+  if( oc ) m[1] = m[32] = 0;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует 32 такта зашифрования для группы блоков, использующих
+    одну траекторию.
+
+    @param skey Контекст секретного ключа.
+    @param m Вектор раундовых инверсий.
+    @param n3 Массив младших половин блоков.
+    @param n4 Массив старших половин блоков.
+    @param count Количество блоков в группе (не более ak_magma_batch).                            */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_magma_batch_rounds( ak_skey skey, const ak_uint8 *m,
+                                                  ak_uint32 *n3, ak_uint32 *n4, size_t count )
+{
+  size_t l;
+  int r;
+  ak_uint32 (*kp)[8] = ((struct magma_encrypted_keys *)skey->data)->inkey;
+  ak_uint32 (*mp)[8] = ((struct magma_encrypted_keys *)skey->data)->inmask;
+
+  for( r = 1; r < 33; r++ ) {
+     const ak_uint32 msk = mp[m[r]][magma_encrypt_order[r-1]],
+                     key = kp[m[r]][magma_encrypt_order[r-1]] + m[r];
+     ak_uint32 (*t)[256] = magma_xboxes[m[r]][m[r+1] ^ m[r-1]];
+     ak_uint32 *x = ( r&1 ) ? n3 : n4, *y = ( r&1 ) ? n4 : n3;
+
+     for( l = 0; l < count; l++ ) {
+        ak_uint32 p = x[l] - msk;
+        p += key;
+        y[l] ^= t[0][p & 255] ^ t[1][p >> 8 & 255] ^ t[2][p >> 16 & 255] ^ t[3][p >> 24];
+     }
+  }
+}
+
+#if defined( AK_HAVE_BUILTIN_AVX2 ) && defined( AK_HAVE_BUILTIN_CPU_SUPPORTS )
+ #define AK_MAGMA_GATHER
+ #include <immintrin.h>
+
+/*! \brief Вычисление преобразования F для восьми блоков с помощью выборок из таблиц. */
+ #define ak_magma_gostf_gather( t, p ) \
+   _mm256_xor_si256(\
+    _mm256_xor_si256(\
+      _mm256_i32gather_epi32( (const int *)t[0], _mm256_and_si256( p, ff ), 4 ),\
+      _mm256_i32gather_epi32( (const int *)t[1],\
+                                         _mm256_and_si256( _mm256_srli_epi32( p, 8 ), ff ), 4 )),\
+    _mm256_xor_si256(\
+      _mm256_i32gather_epi32( (const int *)t[2],\
+                                          _mm256_and_si256( _mm256_srli_epi32( p, 16 ), ff ), 4 ),\
+      _mm256_i32gather_epi32( (const int *)t[3], _mm256_srli_epi32( p, 24 ), 4 )))
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует 32 такта зашифрования для группы блоков с использованием
+    команд AVX2 (два вектора по восемь блоков); неполные группы обрабатываются функцией
+    ak_magma_batch_rounds().                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ __attribute__(( target( "avx2" )))
+ static void ak_magma_batch_rounds_avx2( ak_skey skey, const ak_uint8 *m,
+                                                  ak_uint32 *n3, ak_uint32 *n4, size_t count )
+{
+  int r;
+  __m256i a0, a1, b0, b1, p0, p1, k, v;
+  const __m256i ff = _mm256_set1_epi32( 0xff );
+  ak_uint32 (*kp)[8] = ((struct magma_encrypted_keys *)skey->data)->inkey;
+  ak_uint32 (*mp)[8] = ((struct magma_encrypted_keys *)skey->data)->inmask;
+
+  if( count < ak_magma_batch ) {
+    ak_magma_batch_rounds( skey, m, n3, n4, count );
+    return;
+  }
+  a0 = _mm256_loadu_si256( (const __m256i *) n3 );
+  a1 = _mm256_loadu_si256( (const __m256i *)( n3 + 8 ));
+  b0 = _mm256_loadu_si256( (const __m256i *) n4 );
+  b1 = _mm256_loadu_si256( (const __m256i *)( n4 + 8 ));
+
+  for( r = 1; r < 33; r += 2 ) {
+    /* нечетный такт: изменяется старшая половина блока */
+     ak_uint32 (*t)[256] = magma_xboxes[m[r]][m[r+1] ^ m[r-1]];
+     v = _mm256_set1_epi32( (int) mp[m[r]][magma_encrypt_order[r-1]] );
+     k = _mm256_set1_epi32( (int)( kp[m[r]][magma_encrypt_order[r-1]] + m[r] ));
+     p0 = _mm256_add_epi32( _mm256_sub_epi32( a0, v ), k );
+     p1 = _mm256_add_epi32( _mm256_sub_epi32( a1, v ), k );
+     b0 = _mm256_xor_si256( b0, ak_magma_gostf_gather( t, p0 ));
+     b1 = _mm256_xor_si256( b1, ak_magma_gostf_gather( t, p1 ));
+
+    /* четный такт: изменяется младшая половина блока */
+     t = magma_xboxes[m[r+1]][m[r+2] ^ m[r]];
+     v = _mm256_set1_epi32( (int) mp[m[r+1]][magma_encrypt_order[r]] );
+     k = _mm256_set1_epi32( (int)( kp[m[r+1]][magma_encrypt_order[r]] + m[r+1] ));
+     p0 = _mm256_add_epi32( _mm256_sub_epi32( b0, v ), k );
+     p1 = _mm256_add_epi32( _mm256_sub_epi32( b1, v ), k );
+     a0 = _mm256_xor_si256( a0, ak_magma_gostf_gather( t, p0 ));
+     a1 = _mm256_xor_si256( a1, ak_magma_gostf_gather( t, p1 ));
+  }
+
+  _mm256_storeu_si256( (__m256i *) n3, a0 );
+  _mm256_storeu_si256( (__m256i *)( n3 + 8 ), a1 );
+  _mm256_storeu_si256( (__m256i *) n4, b0 );
+  _mm256_storeu_si256( (__m256i *)( n4 + 8 ), b1 );
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования последовательности блоков: блоки разбиваются на группы,
+    для каждой группы вырабатывается случайная траектория, после чего группа обрабатывается
+    функцией rounds.
+
+    @param skey Контекст секретного ключа.
+    @param in Указатель на последовательность блоков открытого текста.
+    @param out Указатель на область памяти для шифртекста.
+    @param blocks Количество зашифровываемых блоков.
+    @param oc Флаг совместимости с библиотекой openssl.
+    @param rounds Функция, реализующая такты зашифрования для одной группы блоков.                */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_magma_encrypt_blocks_batch( ak_skey skey, ak_pointer in, ak_pointer out,
+              size_t blocks, int oc, void (*rounds)( ak_skey, const ak_uint8 *,
+                                                          ak_uint32 *, ak_uint32 *, size_t ))
+{
+  size_t l, count;
+  ak_uint8 m[34];
+  ak_uint32 n3[ak_magma_batch], n4[ak_magma_batch],
+                  *inptr = ( ak_uint32 *)in, *outptr = ( ak_uint32 *)out;
+
+  while( blocks > 0 ) {
+     count = ak_min( blocks, ak_magma_batch );
+     ak_magma_random_walk( skey, m, oc );
+
+     for( l = 0; l < count; l++ ) {
+     #ifdef AK_LITTLE_ENDIAN
+        if( oc ) { n4[l] = bswap_32( inptr[2*l] ); n3[l] = bswap_32( inptr[2*l+1] ); }
+          else { n3[l] = inptr[2*l]; n4[l] = inptr[2*l+1]; }
+     #else
+        if( oc ) { n4[l] = inptr[2*l]; n3[l] = inptr[2*l+1]; }
+          else { n3[l] = bswap_32( inptr[2*l] ); n4[l] = bswap_32( inptr[2*l+1] ); }
+     #endif
+        if( oc ) n4[l] ^= m[1] * 0xffffffff;
+          else n3[l] ^= m[1] * 0xffffffff;
+     }
+
+     rounds( skey, m, n3, n4, count );
+
+     for( l = 0; l < count; l++ ) {
+        n4[l] ^= m[32] * 0xffffffff;
+     #ifdef AK_LITTLE_ENDIAN
+        if( oc ) { outptr[2*l+1] = bswap_32( n4[l] ); outptr[2*l] = bswap_32( n3[l] ); }
+          else { outptr[2*l] = n4[l]; outptr[2*l+1] = n3[l]; }
+     #else
+        if( oc ) { outptr[2*l+1] = n4[l]; outptr[2*l] = n3[l]; }
+          else { outptr[2*l] = bswap_32( n4[l] ); outptr[2*l+1] = bswap_32( n3[l] ); }
+     #endif
+     }
+     inptr += 2*count; outptr += 2*count; blocks -= count;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_magma_encrypt_blocks_with_random_walk( ak_skey skey,
+                                                 ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_magma_encrypt_blocks_batch( skey, in, out, blocks, 0, ak_magma_batch_rounds );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_magma_encrypt_blocks_with_random_walk_oc( ak_skey skey,
+                                                 ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_magma_encrypt_blocks_batch( skey, in, out, blocks, 1, ak_magma_batch_rounds );
+}
+
+#ifdef AK_MAGMA_GATHER
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_magma_encrypt_blocks_avx2( ak_skey skey,
+                                                 ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_magma_encrypt_blocks_batch( skey, in, out, blocks, 0, ak_magma_batch_rounds_avx2 );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_magma_encrypt_blocks_avx2_oc( ak_skey skey,
+                                                 ak_pointer in, ak_pointer out, size_t blocks )
+{
+  ak_magma_encrypt_blocks_batch( skey, in, out, blocks, 1, ak_magma_batch_rounds_avx2 );
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция выбирает реализацию пакетного зашифрования последовательности блоков.
+
+    @param oc Флаг совместимости с библиотекой openssl.
+    @param simd Флаг использования векторной реализации (если она доступна
+    на этапе сборки и поддерживается процессором).
+    @return Указатель на функцию зашифрования последовательности блоков.                          */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_function_bckey_blocks *ak_magma_select_encrypt_blocks( int oc, int simd )
+{
+#ifdef AK_MAGMA_GATHER
+  if( simd ) {
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports( "avx2" ))
+      return oc ? ak_magma_encrypt_blocks_avx2_oc : ak_magma_encrypt_blocks_avx2;
+  }
+#else
+  (void)simd;
+#endif
+ return oc ? ak_magma_encrypt_blocks_with_random_walk_oc : ak_magma_encrypt_blocks_with_random_walk;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Функция уничтожения развернутых ключей для маскированной магмы
 
@@ -657,7 +919,7 @@
  /* если ключ был создан, но ему не было присвоено значение, здесь возникнет ошибка */
   if( skey->data != NULL ) {
     ak_ptr_wipe( skey->data, sizeof( struct magma_encrypted_keys ), &skey->generator );
-    free( skey->data );
+    ak_skey_free_data( skey->data );
     skey->data = NULL;
   }
  return ak_error_ok;
@@ -684,7 +946,7 @@
  /* удаляем былое */
   if( skey->data != NULL ) ak_magma_delete_keys( skey );
 
-  if(( data = ak_aligned_malloc( sizeof( struct magma_encrypted_keys ))) == NULL )
+  if(( data = ak_skey_alloc_data( skey, sizeof( struct magma_encrypted_keys ))) == NULL )
     return ak_error_message( ak_error_out_of_memory, __func__, "incorrect memory allocation" );
 
  /* выставляем флаги того, что память выделена */
@@ -737,6 +999,8 @@
                                                  __func__ , "using a null pointer to key buffer" );
   if( skey->key_size == 0 ) return ak_error_message( ak_error_zero_length, __func__ ,
                                                            "using a key buffer with zero length" );
+ /* маска ключа, используемого несколькими потоками, не изменяется */
+  if(( skey->flags&ak_key_flag_set_mask ) && ( skey->flags&ak_key_flag_shared )) return ak_error_ok;
  /* проверяем, установлена ли маска ранее */
   if((( skey->flags)&ak_key_flag_set_mask ) == 0 ) {
 
@@ -954,6 +1218,37 @@
   return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция инициализирует контекст ключа алгоритма блочного шифрования Магма, в котором
+    зашифрование последовательности блоков (режимы простой замены, гаммирования и т.п.)
+    выполняется пакетно: одна случайная траектория вырабатывается для группы из 16 блоков,
+    а при наличии поддержки процессором используются команды AVX2.
+    Зашифрование и расшифрование отдельных блоков выполняются так же,
+    как и для ключа, созданного функцией ak_bckey_create_magma().
+
+    @param bkey Контекст секретного ключа алгоритма блочного шифрования.
+
+    @return Функция возвращает код ошибки. В случаее успеха возвращается \ref ak_error_ok.         */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_create_magma_batch( ak_bckey bkey )
+{
+  int error = ak_error_ok, oc = (int) ak_libakrypt_get_option_by_name( "openssl_compability" );
+
+  if(( error = ak_bckey_create_magma( bkey )) != ak_error_ok )
+    return ak_error_message( error, __func__, "wrong initalization of block cipher key context" );
+
+ /* устанавливаем OID пакетной реализации */
+  if(( bkey->key.oid = ak_oid_find_by_name( "magma-batch" )) == NULL ) {
+    error = ak_error_get_value();
+    ak_error_message( error, __func__, "wrong search of predefined magma block cipher OID" );
+    ak_bckey_destroy( bkey );
+    return error;
+  }
+  bkey->encrypt_blocks = ak_magma_select_encrypt_blocks( oc, ak_true );
+
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
  static bool_t ak_libakrypt_test_magma_complete( void )
 {
@@ -1102,9 +1397,9 @@
   struct bckey mkey;
   ak_uint8 icode[8];
   size_t i = 0, j = 0;
-  ak_uint8 myout[256];
+  ak_uint8 myout[256], mbin[67*8], mbout[67*8];
   bool_t result = ak_true;
-  int error = ak_error_ok, audit = ak_log_get_level(),
+  int simd, error = ak_error_ok, audit = ak_log_get_level(),
       oc = (int) ak_libakrypt_get_option_by_name( "openssl_compability" );
 
  /* Проверка используемого режима совместимости */
@@ -1425,6 +1720,28 @@
   if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
                                               "the ctr-hmac integrity test for random data is Ok" );
 
+ /* --------------------------------------------------------------------------- */
+ /* 13. Сравниваем пакетное зашифрование последовательности блоков с поблочным */
+ /*     для скалярной и векторной реализаций. Количество блоков (67 = 4*16 + 3) */
+ /*     задействует как полные, так и неполную группы блоков.                   */
+ /* --------------------------------------------------------------------------- */
+  for( i = 0; i < sizeof( mbin ); i++ ) mbin[i] = (ak_uint8)( i*i + 0x35 );
+  for( simd = 0; simd < 2; simd++ ) {
+     ak_magma_select_encrypt_blocks( oc, simd )( &mkey.key, mbin, mbout, sizeof( mbin ) >> 3 );
+     for( i = 0; i < sizeof( mbin ); i += 8 ) {
+        mkey.encrypt( &mkey.key, mbin+i, myout );
+        if( !ak_ptr_is_equal_with_log( myout, mbout+i, 8 )) {
+          ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                 "the multi-block encryption is not equal to single-block one (block %u, simd %d)",
+                                                                   (unsigned int)( i >> 3 ), simd );
+          result = ak_false;
+          goto exit;
+        }
+     }
+  }
+  if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                                                        "the multi-block encryption test is Ok" );
+
  /* освобождаем ключ и выходим */
   exit:
   if(( error = ak_bckey_destroy( &mkey )) != ak_error_ok ) {
@@ -104,13 +104,12 @@
  if(( authenticationKey->key.flags&ak_key_flag_set_key ) == 0 )
    return ak_error_message( ak_error_key_value, __func__,
                                          "using block cipher key context with undefined key value");
- if( authenticationKey->key.resource.value.counter <= 0 )
-   return ak_error_message( ak_error_low_key_resource, __func__, "using key with low key resource");
-
  if( iv == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
                                                             "using null pointer to initial vector");
  if( !iv_size ) return ak_error_message( ak_error_zero_length, __func__,
                                                             "using initial vector of zero length" );
+ if( ak_skey_reserve_resource( &authenticationKey->key, 1 ) != ak_error_ok )
+   return ak_error_message( ak_error_low_key_resource, __func__, "using key with low key resource");
  /* обнуляем необходимое */
   ctx->abitlen = 0;
   ctx->flags = 0;
@@ -124,7 +123,6 @@
 
  /* зашифровываем необходимое и удаляемся */
   authenticationKey->encrypt( &authenticationKey->key, ivector, &ctx->zcount );
-  authenticationKey->key.resource.value.counter--;
 
  return ak_error_ok;
 }
@@ -159,6 +157,109 @@
 
 #endif
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество блоков, обрабатываемых за одну итерацию пакетными функциями режима MGM.
+    \details Значение выбрано равным максимальному количеству блоков, обрабатываемых векторными
+    реализациями функции ak_bckey_encrypt_blocks() за один проход; при меньших значениях
+    векторные реализации не используются.                                                          */
+ #define ak_mgm_batch_blocks  (64)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция формирует последовательные значения счетчика и продвигает его значение.
+
+    Для 128-битного шифра увеличивается младшее (`half` = 0) или старшее (`half` = 1)
+    64-х битное слово счетчика, для 64-битного шифра - соответствующее 32-х битное слово.
+
+    @param cnt Счетчик (изменяется функцией).
+    @param bsize Длина блока в байтах.
+    @param half Номер половины блока, в которой расположен счетчик.
+    @param buf Массив, куда помещаются значения счетчика.
+    @param count Количество значений.                                                              */
+/* ----------------------------------------------------------------------------------------------- */
+ static inline void ak_mgm_counters( ak_uint128 *cnt, const size_t bsize, const size_t half,
+                                                                   ak_uint64 *buf, size_t count )
+{
+  size_t i;
+  if( bsize == 16 ) {
+    for( i = 0; i < count; i++, buf += 2 ) {
+       buf[0] = cnt->q[0]; buf[1] = cnt->q[1];
+     #ifdef AK_LITTLE_ENDIAN
+       cnt->q[half]++;
+     #else
+       cnt->q[half] = bswap_64( bswap_64( cnt->q[half] ) + 1 );
+     #endif
+    }
+  } else {
+     for( i = 0; i < count; i++ ) {
+        buf[i] = cnt->q[0];
+      #ifdef AK_LITTLE_ENDIAN
+        cnt->w[half]++;
+      #else
+        cnt->w[half] = bswap_32( bswap_32( cnt->w[half] ) + 1 );
+      #endif
+     }
+    }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция гаммирует последовательность полных блоков; значения счетчика
+    \f$ Y_i \f$ зашифровываются пакетами за один вызов функции ak_bckey_encrypt_blocks().          */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_mgm_gamma_blocks( ak_mgm_ctx ctx, ak_bckey encryptionKey,
+                                               ak_uint64 *inp, ak_uint64 *outp, size_t blocks )
+{
+  size_t i, count, words = encryptionKey->bsize >> 3;
+  ak_uint64 ybuf[2*ak_mgm_batch_blocks], gbuf[2*ak_mgm_batch_blocks];
+
+  while( blocks > 0 ) {
+    count = ak_min( blocks, ak_mgm_batch_blocks );
+    ak_mgm_counters( &ctx->ycount, encryptionKey->bsize, 0, ybuf, count );
+    ak_bckey_encrypt_blocks( encryptionKey, ybuf, gbuf, count );
+    for( i = 0; i < words*count; i++ ) outp[i] = inp[i] ^ gbuf[i];
+    inp += words*count; outp += words*count; blocks -= count;
+  }
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция добавляет к имитовставке последовательность полных блоков.
+
+    Значения \f$ H_i = E_K(Z_i) \f$ вырабатываются пакетами за один вызов функции
+    ak_bckey_encrypt_blocks(), произведения \f$ H_i \otimes A_i \f$ накапливаются без приведения
+    по модулю, и приведение выполняется один раз для всего пакета.                                 */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_mgm_hash_blocks( ak_mgm_ctx ctx, ak_bckey authenticationKey,
+                                                                  ak_uint64 *data, size_t blocks )
+{
+  size_t i, count;
+  ak_uint128 sum;
+  ak_uint64 acc[4], zbuf[2*ak_mgm_batch_blocks], hbuf[2*ak_mgm_batch_blocks];
+
+  if( authenticationKey->bsize == 16 ) {
+    while( blocks > 0 ) {
+      count = ak_min( blocks, ak_mgm_batch_blocks );
+      ak_mgm_counters( &ctx->zcount, 16, 1, zbuf, count );
+      ak_bckey_encrypt_blocks( authenticationKey, zbuf, hbuf, count );
+      acc[0] = acc[1] = acc[2] = acc[3] = 0;
+      for( i = 0; i < count; i++, data += 2 ) ak_gf128_mul_acc( acc, hbuf + 2*i, data );
+      ak_gf128_reduce( &sum, acc );
+      ctx->sum.q[0] ^= sum.q[0];
+      ctx->sum.q[1] ^= sum.q[1];
+      blocks -= count;
+    }
+  } else {
+     while( blocks > 0 ) {
+       count = ak_min( blocks, ak_mgm_batch_blocks );
+       ak_mgm_counters( &ctx->zcount, 8, 1, zbuf, count );
+       ak_bckey_encrypt_blocks( authenticationKey, zbuf, hbuf, count );
+       acc[0] = acc[1] = 0;
+       for( i = 0; i < count; i++, data++ ) ak_gf64_mul_acc( acc, hbuf + i, data );
+       ak_gf64_reduce( &sum, acc );
+       ctx->sum.q[0] ^= sum.q[0];
+       blocks -= count;
+     }
+    }
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция обрабатывает очередной блок дополнительных данных и
     обновляет внутреннее состояние переменных алгоритма MGM, участвующих в алгоритме
@@ -196,15 +297,16 @@
   if(( adata == NULL ) || ( adata_size == 0 )) return ak_error_ok;
 
  /* проверка ресурса ключа */
-  if( authenticationKey->key.resource.value.counter <= (resource = blocks + (tail > 0)))
+  if( ak_skey_reserve_resource( &authenticationKey->key,
+                                           resource = blocks + ( tail > 0 )) != ak_error_ok )
    return ak_error_message( ak_error_low_key_resource, __func__, "using key with low key resource");
-  else authenticationKey->key.resource.value.counter -= resource;
 
  /* теперь основной цикл */
  if( absize == 16 ) { /* обработка 128-битным шифром */
 
    ctx->abitlen += ( blocks  << 7 );
-   for( ; blocks > 0; blocks--, aptr += 16 ) { astep128( aptr ); }
+   ak_mgm_hash_blocks( ctx, authenticationKey, (ak_uint64 *)aptr, (size_t)blocks );
+   aptr += 16*blocks;
    if( tail ) {
     memset( temp, 0, 16 );
     memcpy( temp+absize-tail, aptr, (size_t)tail );
@@ -217,7 +319,8 @@
  } else { /* обработка 64-битным шифром */
 
    ctx->abitlen += ( blocks << 6 );
-   for( ; blocks > 0; blocks--, aptr += 8 ) { astep64( aptr ); }
+   ak_mgm_hash_blocks( ctx, authenticationKey, (ak_uint64 *)aptr, (size_t)blocks );
+   aptr += 8*blocks;
    if( tail ) {
     memset( temp, 0, 8 );
     memcpy( temp+absize-tail, aptr, (size_t)tail );
@@ -257,10 +360,9 @@
   if( absize > 16 ) return ak_error_message( ak_error_wrong_length, __func__,
                                                                "using key with large block size" );
  /* традиционная проверка ресурса */
-  if( authenticationKey->key.resource.value.counter <= 0 )
+  if( ak_skey_reserve_resource( &authenticationKey->key, 1 ) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource, __func__,
                                                                 "using key with low key resource");
-   else authenticationKey->key.resource.value.counter--;
 
  /* закрываем добавление шифруемых данных */
    ak_aead_set_bit( ctx->flags, ak_aead_encrypted_data_bit );
@@ -327,13 +429,12 @@
  if(( encryptionKey->key.flags&ak_key_flag_set_key ) == 0 )
            return ak_error_message( ak_error_key_value, __func__,
                                                "using secret key context with undefined key value");
- if( encryptionKey->key.resource.value.counter <= 0 )
-   return ak_error_message( ak_error_low_key_resource, __func__, "using key with low key resource");
-
  if( iv == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
                                                             "using null pointer to initial vector");
  if( !iv_size ) return ak_error_message( ak_error_zero_length,
                                                  __func__, "using initial vector with zero length");
+ if( ak_skey_reserve_resource( &encryptionKey->key, 1 ) != ak_error_ok )
+   return ak_error_message( ak_error_low_key_resource, __func__, "using key with low key resource");
  /* обнуляем необходимое */
   ctx->flags &= ak_aead_assosiated_data_bit;
   ctx->pbitlen = 0;
@@ -345,36 +446,10 @@
 
  /* зашифровываем необходимое и удаляемся */
   encryptionKey->encrypt( &encryptionKey->key, ivector, &ctx->ycount );
-  encryptionKey->key.resource.value.counter--;
 
  return ak_error_ok;
 }
 
-/* ----------------------------------------------------------------------------------------------- */
-#ifdef AK_LITTLE_ENDIAN
- #define estep64  encryptionKey->encrypt( &encryptionKey->key, &ctx->ycount, &e ); \
-                  outp[0] = inp[0] ^ e.q[0]; \
-                  ctx->ycount.w[0]++;
-
- #define estep128 encryptionKey->encrypt( &encryptionKey->key, &ctx->ycount, &e ); \
-                  outp[0] = inp[0] ^ e.q[0]; \
-                  outp[1] = inp[1] ^ e.q[1]; \
-                  ctx->ycount.q[0]++;
-
-#else
- #define estep64  encryptionKey->encrypt( &encryptionKey->key, &ctx->ycount, &e ); \
-                  outp[0] = inp[0] ^ e.q[0]; \
-                  ctx->ycount.w[0] = bswap_32( ctx->ycount.w[0] ); \
-                  ctx->ycount.w[0]++; \
-                  ctx->ycount.w[0] = bswap_32( ctx->ycount.w[0] );
-
- #define estep128 encryptionKey->encrypt( &encryptionKey->key, &ctx->ycount, &e ); \
-                  outp[0] = inp[0] ^ e.q[0]; \
-                  outp[1] = inp[1] ^ e.q[1]; \
-                  ctx->ycount.q[0] = bswap_64( ctx->ycount.q[0] ); \
-                  ctx->ycount.q[0]++; \
-                  ctx->ycount.q[0] = bswap_64( ctx->ycount.q[0] );
-#endif
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция зашифровывает очередной фрагмент данных и
@@ -399,7 +474,7 @@
 {
   ak_uint128 e, h;
   ak_uint8 temp[16];
-  size_t i = 0, absize = encryptionKey->bsize;
+  size_t i = 0, count = 0, absize = encryptionKey->bsize;
   ak_uint64 *inp = (ak_uint64 *)in, *outp = (ak_uint64 *)out;
   size_t resource = 0,
          tail = size%absize,
@@ -416,18 +491,17 @@
   if(( in == NULL ) || ( size == 0 )) return ak_error_ok;
 
  /* проверка ресурса ключа выработки имитовставки */
+  resource = blocks + ( tail > 0 );
   if( authenticationKey != NULL ) {
-    if( authenticationKey->key.resource.value.counter <= ( ssize_t )(resource = blocks + (tail > 0)))
+    if( ak_skey_reserve_resource( &authenticationKey->key, ( ssize_t )resource ) != ak_error_ok )
       return ak_error_message( ak_error_low_key_resource, __func__,
                                                 "using authentication key with low key resource");
-    else authenticationKey->key.resource.value.counter -= resource;
   }
 
  /* проверка ресурса ключа шифрования */
-  if( encryptionKey->key.resource.value.counter <= ( ssize_t )resource )
+  if( ak_skey_reserve_resource( &encryptionKey->key, ( ssize_t )resource ) != ak_error_ok )
    return ak_error_message( ak_error_low_key_resource, __func__,
                                                    "using encryption key with low key resource");
-  else encryptionKey->key.resource.value.counter -= resource;
 
  /* теперь обработка данных */
   memset( &e, 0, 16 );
@@ -436,9 +510,8 @@
 
     if( absize&0x10 ) { /* режим работы для 128-битного шифра */
      /* основная часть */
-      for( ; blocks > 0; blocks--, inp += 2, outp += 2 ) {
-         estep128;
-      }
+      ak_mgm_gamma_blocks( ctx, encryptionKey, inp, outp, blocks );
+      inp += 2*blocks; outp += 2*blocks;
       /* хвост */
       if( tail ) {
         encryptionKey->encrypt( &encryptionKey->key, &ctx->ycount, &e );
@@ -451,9 +524,8 @@
 
     } else { /* режим работы для 64-битного шифра */
        /* основная часть */
-        for( ; blocks > 0; blocks--, inp++, outp++ ) {
-           estep64;
-        }
+        ak_mgm_gamma_blocks( ctx, encryptionKey, inp, outp, blocks );
+        inp += blocks; outp += blocks;
        /* хвост */
         if( tail ) {
           encryptionKey->encrypt( &encryptionKey->key, &ctx->ycount, &e );
@@ -469,9 +541,10 @@
 
      if( absize&0x10 ) { /* режим работы для 128-битного шифра */
       /* основная часть */
-      for( ; blocks > 0; blocks--, inp += 2, outp += 2 ) {
-         estep128;
-         astep128( outp );
+      for( ; blocks > 0; blocks -= count, inp += 2*count, outp += 2*count ) {
+         count = ak_min( blocks, ak_mgm_batch_blocks );
+         ak_mgm_gamma_blocks( ctx, encryptionKey, inp, outp, count );
+         ak_mgm_hash_blocks( ctx, authenticationKey, outp, count );
       }
       /* хвост */
       if( tail ) {
@@ -489,9 +562,10 @@
 
     } else { /* режим работы для 64-битного шифра */
       /* основная часть */
-       for( ; blocks > 0; blocks--, inp++, outp++ ) {
-          estep64;
-          astep64( outp );
+       for( ; blocks > 0; blocks -= count, inp += count, outp += count ) {
+          count = ak_min( blocks, ak_mgm_batch_blocks );
+          ak_mgm_gamma_blocks( ctx, encryptionKey, inp, outp, count );
+          ak_mgm_hash_blocks( ctx, authenticationKey, outp, count );
        }
        /* хвост */
        if( tail ) {
@@ -535,7 +609,7 @@
 {
   ak_uint8 temp[16];
   ak_uint128 e, h;
-  size_t i = 0, absize = encryptionKey->bsize;
+  size_t i = 0, count = 0, absize = encryptionKey->bsize;
   ak_uint64 *inp = (ak_uint64 *)in, *outp = (ak_uint64 *)out;
   size_t resource = 0,
          tail = size%absize,
@@ -552,18 +626,17 @@
   if(( in == NULL ) || ( size == 0 )) return ak_error_ok;
 
  /* проверка ресурса ключа выработки имитовставки */
+  resource = blocks + ( tail > 0 );
   if( authenticationKey != NULL ) {
-    if( authenticationKey->key.resource.value.counter <= ( ssize_t )(resource = blocks + (tail > 0)))
+    if( ak_skey_reserve_resource( &authenticationKey->key, ( ssize_t )resource ) != ak_error_ok )
       return ak_error_message( ak_error_low_key_resource, __func__,
                                                 "using authentication key with low key resource");
-    else authenticationKey->key.resource.value.counter -= resource;
   }
 
  /* проверка ресурса ключа шифрования */
-  if( encryptionKey->key.resource.value.counter <= ( ssize_t )resource )
+  if( ak_skey_reserve_resource( &encryptionKey->key, ( ssize_t )resource ) != ak_error_ok )
    return ak_error_message( ak_error_low_key_resource, __func__,
                                                    "using encryption key with low key resource");
-  else encryptionKey->key.resource.value.counter -= resource;
 
  /* теперь обработка данных */
   memset( &e, 0, 16 );
@@ -572,9 +645,8 @@
                                     /* это полная копия кода, содержащегося в функции .. _encryption_ ... */
     if( absize&0x10 ) { /* режим работы для 128-битного шифра */
      /* основная часть */
-      for( ; blocks > 0; blocks--, inp += 2, outp += 2 ) {
-         estep128;
-      }
+      ak_mgm_gamma_blocks( ctx, encryptionKey, inp, outp, blocks );
+      inp += 2*blocks; outp += 2*blocks;
       /* хвост */
       if( tail ) {
         encryptionKey->encrypt( &encryptionKey->key, &ctx->ycount, &e );
@@ -587,9 +659,8 @@
 
     } else { /* режим работы для 64-битного шифра */
        /* основная часть */
-        for( ; blocks > 0; blocks--, inp++, outp++ ) {
-           estep64;
-        }
+        ak_mgm_gamma_blocks( ctx, encryptionKey, inp, outp, blocks );
+        inp += blocks; outp += blocks;
        /* хвост */
         if( tail ) {
           encryptionKey->encrypt( &encryptionKey->key, &ctx->ycount, &e );
@@ -605,9 +676,10 @@
 
      if( absize&0x10 ) { /* режим работы для 128-битного шифра */
       /* основная часть */
-      for( ; blocks > 0; blocks--, inp += 2, outp += 2 ) {
-         astep128( inp );
-         estep128;
+      for( ; blocks > 0; blocks -= count, inp += 2*count, outp += 2*count ) {
+         count = ak_min( blocks, ak_mgm_batch_blocks );
+         ak_mgm_hash_blocks( ctx, authenticationKey, inp, count );
+         ak_mgm_gamma_blocks( ctx, encryptionKey, inp, outp, count );
       }
       /* хвост */
       if( tail ) {
@@ -625,9 +697,10 @@
 
     } else { /* режим работы для 64-битного шифра */
       /* основная часть */
-       for( ; blocks > 0; blocks--, inp++, outp++ ) {
-          astep64( inp );
-          estep64;
+       for( ; blocks > 0; blocks -= count, inp += count, outp += count ) {
+          count = ak_min( blocks, ak_mgm_batch_blocks );
+          ak_mgm_hash_blocks( ctx, authenticationKey, inp, count );
+          ak_mgm_gamma_blocks( ctx, encryptionKey, inp, outp, count );
        }
        /* хвост */
        if( tail ) {
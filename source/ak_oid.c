@@ -44,6 +44,7 @@
     "aead",
     "xcrypt",
     "descriptor",
+    "hash tree",
     "undefined mode"
 };
 
@@ -86,11 +87,19 @@
   - `1.2.643.2.52.1.1` генераторы псевдо-случайных чисел,
   - `1.2.643.2.52.1.2` алгоритмы поточного шифрования,
   - `1.2.643.2.52.1.3` режимы работы поточных шифров,
-  - `1.2.643.2.52.1.4` алгоритмы блочного шифрования,
+  - `1.2.643.2.52.1.4` алгоритмы блочного шифрования (номер последней дуги совпадает с номером
+    шифра в поддеревьях режимов: 1 -- Магма, 2 -- Кузнечик, 3 -- Twofish; дуги с номерами 1 и 2
+    не используются, поскольку идентификаторы этих шифров определены рекомендациями ТК 26),
+    в том числе `1.2.643.2.52.1.4.100` альтернативные реализации шифров, например,
+    `1.2.643.2.52.1.4.100.1` пакетная реализация шифра Магма (magma-batch),
   - `1.2.643.2.52.1.5` базовые режимы работы блочных шифров,
   - `1.2.643.2.52.1.6` расширенные режимы работы блочных шифров,
+    в том числе `1.2.643.2.52.1.6.4` режим MGM для блочных шифров, идентификаторы которых
+    не определены рекомендациями ТК 26 (номер последней дуги совпадает с номером шифра
+    в поддеревьях базовых режимов, например, `1.2.643.2.52.1.6.4.3` для шифра Twofish),
   - `1.2.643.2.52.1.7` алгоритмы выработки имитовставки,
-
+  - `1.2.643.2.52.1.8` режимы работы функций хеширования,
+  - `1.2.643.2.52.1.9` алгоритмы выработки производной ключевой информации,
   - `1.2.643.2.52.1.10` алгоритмы выработки электронной подписи,
   - `1.2.643.2.52.1.11` алгоритмы проверки электронной подписи,
   - `1.2.643.2.52.1.12` параметры эллиптических кривых
@@ -112,6 +121,8 @@
 /*! Константные значения имен идентификаторов */
  static const char *asn1_lcg_n[] =         { "lcg", NULL };
  static const char *asn1_lcg_i[] =         { "1.2.643.2.52.1.1.1", NULL };
+ static const char *asn1_chacha20_n[] =    { "chacha20", NULL };
+ static const char *asn1_chacha20_i[] =    { "1.2.643.2.52.1.1.5", NULL };
 #if defined(__unix__) || defined(__APPLE__)
  static const char *asn1_dev_random_n[] =  { "dev-random", "/dev/random", NULL };
  static const char *asn1_dev_random_i[] =  { "1.2.643.2.52.1.1.2", NULL };
@@ -127,14 +138,24 @@
  static const char *asn1_streebog256_i[] = { "1.2.643.7.1.1.2.2", NULL };
  static const char *asn1_streebog512_n[] = { "streebog512", "md_gost12_512", NULL };
  static const char *asn1_streebog512_i[] = { "1.2.643.7.1.1.2.3", NULL };
+ static const char *asn1_streebog256_tree_n[] = { "streebog256-tree", NULL };
+ static const char *asn1_streebog256_tree_i[] = { "1.2.643.2.52.1.8.1", NULL };
+ static const char *asn1_streebog512_tree_n[] = { "streebog512-tree", NULL };
+ static const char *asn1_streebog512_tree_i[] = { "1.2.643.2.52.1.8.2", NULL };
+ static const char *asn1_mhkdf_streebog512_n[] = { "mhkdf-streebog512", NULL };
+ static const char *asn1_mhkdf_streebog512_i[] = { "1.2.643.2.52.1.9.1", NULL };
  static const char *asn1_hmac_streebog256_n[] = { "hmac-streebog256", "HMAC-md_gost12_256", NULL };
  static const char *asn1_hmac_streebog256_i[] = { "1.2.643.7.1.1.4.1", NULL };
  static const char *asn1_hmac_streebog512_n[] = { "hmac-streebog512", "HMAC-md_gost12_512", NULL };
  static const char *asn1_hmac_streebog512_i[] = { "1.2.643.7.1.1.4.2", NULL };
  static const char *asn1_magma_n[] =       { "magma", NULL };
  static const char *asn1_magma_i[] =       { "1.2.643.7.1.1.5.1", NULL };
+ static const char *asn1_magma_batch_n[] = { "magma-batch", NULL };
+ static const char *asn1_magma_batch_i[] = { "1.2.643.2.52.1.4.100.1", NULL };
  static const char *asn1_kuznechik_n[] =   { "kuznechik", "kuznyechik", "grasshopper", NULL };
  static const char *asn1_kuznechik_i[] =   { "1.2.643.7.1.1.5.2", NULL };
+ static const char *asn1_twofish_n[] =     { "twofish", NULL };
+ static const char *asn1_twofish_i[] =     { "1.2.643.2.52.1.4.3", NULL };
 
  static const char *asn1_ctr_magma_n[] =   { "ctr-magma", NULL };
  static const char *asn1_ctr_magma_i[] =   { "1.2.643.2.52.1.5.1.1", NULL };
@@ -142,6 +163,8 @@
                                            { "ctr-kuznechik", "ctr-kuznyechik", NULL };
  static const char *asn1_ctr_kuznechik_i[] =
                                            { "1.2.643.2.52.1.5.1.2", NULL };
+ static const char *asn1_ctr_twofish_n[] = { "ctr-twofish", NULL };
+ static const char *asn1_ctr_twofish_i[] = { "1.2.643.2.52.1.5.1.3", NULL };
  static const char *asn1_ofb_magma_n[] =   { "ofb-magma", NULL };
  static const char *asn1_ofb_magma_i[] =   { "1.2.643.2.52.1.5.2.1", NULL };
  static const char *asn1_ofb_kuznechik_n[] =
@@ -160,6 +183,8 @@
                                            { "cbc-kuznechik", "cbc-kuznyechik", NULL };
  static const char *asn1_cbc_kuznechik_i[] =
                                            { "1.2.643.2.52.1.5.4.2", NULL };
+ static const char *asn1_cbc_twofish_n[] = { "cbc-twofish", NULL };
+ static const char *asn1_cbc_twofish_i[] = { "1.2.643.2.52.1.5.4.3", NULL };
 
  static const char *asn1_xts_magma_n[] =   { "xts-magma", NULL };
  static const char *asn1_xts_magma_i[] =   { "1.2.643.2.52.1.5.5.1", NULL };
@@ -195,6 +220,8 @@
                                              "id-tc26-cipher-gostr3412-2015-kuznyechik-mgm", NULL };
  static const char *asn1_mgm_kuznechik_i[] =
                                            { "1.2.643.7.1.1.5.2.3", NULL };
+ static const char *asn1_mgm_twofish_n[] = { "mgm-twofish", NULL };
+ static const char *asn1_mgm_twofish_i[] = { "1.2.643.2.52.1.6.4.3", NULL };
  static const char *asn1_ctr_cmac_magma_n[] =
                                            { "ctr-cmac-magma", NULL };
  static const char *asn1_ctr_cmac_magma_i[] =
@@ -294,6 +321,8 @@
  static const char *asn1_sdhkey_i[] =      { "1.2.643.2.52.1.127.2.2", NULL };
  static const char *asn1_extkey_n[] =      { "external-basic-key", NULL };
  static const char *asn1_extkey_i[] =      { "1.2.643.2.52.1.127.2.3", NULL };
+ static const char *asn1_mhkdfkey_n[] =    { "mhkdf-basic-key", NULL };
+ static const char *asn1_mhkdfkey_i[] =    { "1.2.643.2.52.1.127.2.4", NULL };
 
  static const char *asn1_symkmd_n[] =      { "symmetric-key-content", NULL };
  static const char *asn1_symkmd_i[] =      { "1.2.643.2.52.1.127.3.1", NULL };
@@ -405,6 +434,13 @@
                            ( ak_function_set_key_random_object *)ak_bckey_set_key_random, \
                       ( ak_function_set_key_from_password_object *)ak_bckey_set_key_from_password }
 
+ #define ak_object_bckey_magma_batch { sizeof( struct bckey ), \
+                           ( ak_function_create_object *) ak_bckey_create_magma_batch, \
+                           ( ak_function_destroy_object *) ak_bckey_destroy, \
+                           ( ak_function_set_key_object *)ak_bckey_set_key, \
+                           ( ak_function_set_key_random_object *)ak_bckey_set_key_random, \
+                      ( ak_function_set_key_from_password_object *)ak_bckey_set_key_from_password }
+
  #define ak_object_bckey_kuznechik { sizeof( struct bckey ), \
                            ( ak_function_create_object *) ak_bckey_create_kuznechik, \
                            ( ak_function_destroy_object *) ak_bckey_destroy, \
@@ -412,6 +448,13 @@
                            ( ak_function_set_key_random_object *)ak_bckey_set_key_random, \
                       ( ak_function_set_key_from_password_object *)ak_bckey_set_key_from_password }
 
+ #define ak_object_bckey_twofish { sizeof( struct bckey ), \
+                           ( ak_function_create_object *) ak_bckey_create_twofish, \
+                           ( ak_function_destroy_object *) ak_bckey_destroy, \
+                           ( ak_function_set_key_object *)ak_bckey_set_key, \
+                           ( ak_function_set_key_random_object *)ak_bckey_set_key_random, \
+                      ( ak_function_set_key_from_password_object *)ak_bckey_set_key_from_password }
+
  #define ak_object_hmac_streebog256 { sizeof( struct hmac ), \
                            ( ak_function_create_object *) ak_hmac_create_streebog256, \
                            ( ak_function_destroy_object *) ak_hmac_destroy, \
@@ -457,6 +500,10 @@ static struct oid libakrypt_oids[] =
   {{ sizeof( struct random ), (ak_function_create_object *)ak_random_create_lcg,
                               (ak_function_destroy_object *)ak_random_destroy, NULL, NULL, NULL },
                                                                 ak_object_undefined, NULL, NULL }},
+ { random_generator, algorithm, asn1_chacha20_i, asn1_chacha20_n, NULL,
+  {{ sizeof( struct random ), (ak_function_create_object *)ak_random_create_chacha20,
+                              (ak_function_destroy_object *)ak_random_destroy, NULL, NULL, NULL },
+                                                                ak_object_undefined, NULL, NULL }},
 #if defined(__unix__) || defined(__APPLE__)
  { random_generator, algorithm, asn1_dev_random_i, asn1_dev_random_n, NULL,
   {{ sizeof( struct random ), (ak_function_create_object *)ak_random_create_random,
@@ -485,6 +532,19 @@ static struct oid libakrypt_oids[] =
                               ( ak_function_destroy_object *) ak_hash_destroy, NULL, NULL, NULL },
                               ak_object_undefined, (ak_function_run_object *) ak_hash_ptr, NULL }},
 
+ { hash_function, hash_tree, asn1_streebog256_tree_i, asn1_streebog256_tree_n, NULL,
+  {{ sizeof( struct hash ), ( ak_function_create_object *) ak_hash_create_streebog256,
+                              ( ak_function_destroy_object *) ak_hash_destroy, NULL, NULL, NULL },
+                         ak_object_undefined, (ak_function_run_object *) ak_hash_ptr_tree, NULL }},
+
+ { hash_function, hash_tree, asn1_streebog512_tree_i, asn1_streebog512_tree_n, NULL,
+  {{ sizeof( struct hash ), ( ak_function_create_object *) ak_hash_create_streebog512,
+                              ( ak_function_destroy_object *) ak_hash_destroy, NULL, NULL, NULL },
+                         ak_object_undefined, (ak_function_run_object *) ak_hash_ptr_tree, NULL }},
+
+ { identifier, algorithm, asn1_mhkdf_streebog512_i, asn1_mhkdf_streebog512_n,
+                                                           NULL, ak_functional_objects_undefined },
+
  { hmac_function, algorithm, asn1_hmac_streebog256_i, asn1_hmac_streebog256_n, NULL,
                             { ak_object_hmac_streebog256,
                               ak_object_undefined, (ak_function_run_object *) ak_hmac_ptr, NULL }},
@@ -496,9 +556,15 @@ static struct oid libakrypt_oids[] =
  { block_cipher, algorithm, asn1_magma_i, asn1_magma_n, NULL,
                                        { ak_object_bckey_magma, ak_object_undefined, NULL, NULL }},
 
+ { block_cipher, algorithm, asn1_magma_batch_i, asn1_magma_batch_n, NULL,
+                                 { ak_object_bckey_magma_batch, ak_object_undefined, NULL, NULL }},
+
  { block_cipher, algorithm, asn1_kuznechik_i, asn1_kuznechik_n, NULL,
                                    { ak_object_bckey_kuznechik, ak_object_undefined, NULL, NULL }},
 
+ { block_cipher, algorithm, asn1_twofish_i, asn1_twofish_n, NULL,
+                                     { ak_object_bckey_twofish, ak_object_undefined, NULL, NULL }},
+
 /* базовые режимы блочного шифрования */
  { block_cipher, encrypt_mode, asn1_ctr_magma_i, asn1_ctr_magma_n, NULL,
   { ak_object_bckey_magma, ak_object_undefined, ( ak_function_run_object *) ak_bckey_ctr,
@@ -508,6 +574,10 @@ static struct oid libakrypt_oids[] =
   { ak_object_bckey_kuznechik, ak_object_undefined, ( ak_function_run_object *) ak_bckey_ctr,
                                                        ( ak_function_run_object *) ak_bckey_ctr }},
 
+ { block_cipher, encrypt_mode, asn1_ctr_twofish_i, asn1_ctr_twofish_n, NULL,
+  { ak_object_bckey_twofish, ak_object_undefined, ( ak_function_run_object *) ak_bckey_ctr,
+                                                       ( ak_function_run_object *) ak_bckey_ctr }},
+
  { block_cipher, encrypt_mode, asn1_ofb_magma_i, asn1_ofb_magma_n, NULL,
   { ak_object_bckey_magma, ak_object_undefined, ( ak_function_run_object *) ak_bckey_ofb,
                                                        ( ak_function_run_object *) ak_bckey_ofb }},
@@ -534,6 +604,11 @@ static struct oid libakrypt_oids[] =
                                                 ( ak_function_run_object *) ak_bckey_encrypt_cbc,
                                                ( ak_function_run_object *) ak_bckey_decrypt_cbc }},
 
+ { block_cipher, encrypt_mode, asn1_cbc_twofish_i, asn1_cbc_twofish_n, NULL,
+  { ak_object_bckey_twofish, ak_object_undefined,
+                                                ( ak_function_run_object *) ak_bckey_encrypt_cbc,
+                                               ( ak_function_run_object *) ak_bckey_decrypt_cbc }},
+
  { block_cipher, encrypt2k_mode, asn1_xts_magma_i, asn1_xts_magma_n, NULL,
   { ak_object_bckey_magma, ak_object_bckey_magma,
                                                 ( ak_function_run_object *) ak_bckey_encrypt_xts,
@@ -571,6 +646,11 @@ static struct oid libakrypt_oids[] =
                                                ( ak_function_run_object *) ak_bckey_encrypt_mgm,
                                                ( ak_function_run_object *) ak_bckey_decrypt_mgm }},
 
+ { block_cipher, aead, asn1_mgm_twofish_i, asn1_mgm_twofish_n, NULL,
+  { ak_object_bckey_twofish, ak_object_bckey_twofish,
+                                               ( ak_function_run_object *) ak_bckey_encrypt_mgm,
+                                               ( ak_function_run_object *) ak_bckey_decrypt_mgm }},
+
  { block_cipher, aead, asn1_ctr_cmac_magma_i, asn1_ctr_cmac_magma_n, NULL,
   { ak_object_bckey_magma, ak_object_bckey_magma,
                                           ( ak_function_run_object *) ak_bckey_encrypt_ctr_cmac,
@@ -663,6 +743,8 @@ static struct oid libakrypt_oids[] =
                                                            NULL, ak_functional_objects_undefined },
  { identifier, descriptor, asn1_sdhkey_i, asn1_sdhkey_n, NULL, ak_functional_objects_undefined },
  { identifier, descriptor, asn1_extkey_i, asn1_extkey_n, NULL, ak_functional_objects_undefined },
+ { identifier, descriptor, asn1_mhkdfkey_i, asn1_mhkdfkey_n,
+                                                           NULL, ak_functional_objects_undefined },
 
  { identifier, parameter, asn1_symkmd_i, asn1_symkmd_n,
                              (ak_pointer) symmetric_key_content, ak_functional_objects_undefined },
@@ -32,10 +32,31 @@
  static struct option options[] = {
      { "log_level", ak_log_standard, 0, 2 },
      { "context_manager_size", 32, 32, 65536 },
-     { "context_manager_max_size", 4096, 4096, 2147483648 },
+     { "context_manager_max_size", 4096, 4096, 16777216 },
      { "pbkdf2_iteration_count", 2000, 1000, 65536 },
+  /* алгоритм выработки ключей из пароля при экспорте ключевых контейнеров:
+     0 - pbkdf2, 1 - mhkdf (использующий заданный объем памяти) */
+     { "key_container_kdf", 0, 0, 1 },
+  /* объем памяти (в килобайтах), количество проходов по памяти и количество полос,
+     обрабатываемых в отдельных потоках, алгоритма mhkdf */
+     { "mhkdf_memory_size", 16384, 128, 4194304 },
+     { "mhkdf_time_cost", 1, 1, 64 },
+     { "mhkdf_parallelism", 4, 1, 16 },
      { "hmac_key_count_resource", 65536, 1024, 2147483648 },
      { "digital_signature_count_resource", 65536, 1024, 2147483648 },
+  /* периодичность проверки контрольной суммы секретных ключей: контрольная сумма
+     проверяется при каждом n-ом использовании ключа режимами шифрования и имитозащиты */
+     { "key_icode_check_period", 1, 1, 65536 },
+  /* политика смены маски секретных ключей после использования: 0 - после каждого использования,
+     1 - после каждого n-го использования, 2 - после обработки n октетов, 3 - через n секунд;
+     значение n определяется опцией key_remask_period */
+     { "key_remask_policy", 0, 0, 3 },
+     { "key_remask_period", 1, 1, 2147483648 },
+  /* способ выделения памяти для секретных ключей: 0 - стандартная функция malloc(),
+     1 - защищенная область, закрепленная в оперативной памяти (см. ak_secure_arena_malloc());
+     размер защищенной области (в килобайтах) определяется опцией secure_arena_size */
+     { "key_memory_policy", 0, 0, 1 },
+     { "secure_arena_size", 1024, 64, 65536 },
 
   /* значение константы задает максимальный объем зашифрованной информации на одном ключе в 4 Mб:
                                  524288 блока x 8 байт на блок = 4.194.304 байт = 4096 Кб = 4 Mб   */
@@ -50,6 +71,25 @@
 
   /* при значении равным единицы, формат шифрования данных соответствует варианту OpenSSL */
      { "openssl_compability", 0, 0, 1 },
+  /* реализация зашифрования последовательности блоков алгоритмом Кузнечик:
+     0 - табличная, 1 - векторная, если она быстрее табличной (AVX-512),
+     2 - любая доступная векторная (время выполнения не зависит от данных и ключа) */
+     { "kuznechik_simd_backend", 1, 0, 2 },
+  /* реализация преобразования G алгоритма хеширования Стрибог:
+     0 - табличная, 1 - векторная, если она быстрее табличной (AVX-512),
+     2 - любая доступная векторная (AVX-512 или AVX2) */
+     { "streebog_simd_backend", 1, 0, 2 },
+  /* количество потоков, используемых при расшифровании больших объемов данных
+     в режимах с зацеплением: 0 - по числу доступных процессоров, 1 - без распараллеливания */
+     { "block_cipher_threads", 0, 0, 64 },
+  /* количество потоков, используемых при хешировании в древовидном режиме:
+     0 - по числу доступных процессоров, 1 - без распараллеливания */
+     { "hash_tree_threads", 0, 0, 64 },
+  /* флаг отображения в память файлов при вычислении хеш-кодов и имитовставок */
+     { "mac_file_use_mmap", 1, 0, 1 },
+  /* размер фрагмента (в килобайтах), считываемого из файла при вычислении хеш-кодов
+     и имитовставок без отображения файла в память */
+     { "mac_file_buffer_size", 4096, 1024, 8192 },
   /* флаг использования цвета при выводе сообщений библиотеки */
      { "use_color_output", 1, 0, 1 },
      { NULL, 0, 0, 0 } /* завершающая константа, должна всегда принимать нулевые значения */
@@ -136,6 +176,26 @@
  return result;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция используется для проверки параметров, считываемых из внешних источников
+    (например, из ключевых контейнеров), перед их использованием.
+
+    \param name Имя опции
+    \param value Проверяемое значение
+    \return Функция возвращает \ref ak_true, если значение не меньше минимально допустимого
+    и не больше максимально допустимого значения опции. Если значение лежит вне допустимых
+    границ или имя опции указано неверно, то возвращается \ref ak_false.                           */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_libakrypt_check_option_bounds( const char *name, const ak_int64 value )
+{
+  size_t i = 0;
+  for( i = 0; i < ak_libakrypt_options_count(); i++ ) {
+     if( strncmp( name, options[i].name, strlen( options[i].name )) == 0 )
+       return (( value >= options[i].min ) && ( value <= options[i].max )) ? ak_true : ak_false;
+  }
+ return ak_false;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! При выводе используется текущая функция аудита.                                                */
 /* ----------------------------------------------------------------------------------------------- */
@@ -16,6 +16,9 @@
 #ifdef AK_HAVE_FCNTL_H
  #include <fcntl.h>
 #endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Инициализация генератора псевдо-случайных чисел.
@@ -283,6 +286,203 @@
  return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                                 реализация класса rng_chacha20                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ #define ak_chacha20_rotl( x, n ) ((( x ) << ( n ))|(( x ) >> ( 32 - ( n ))))
+ #define ak_chacha20_quarter_round( a, b, c, d ) \
+   a += b; d ^= a; d = ak_chacha20_rotl( d, 16 ); \
+   c += d; b ^= c; b = ak_chacha20_rotl( b, 12 ); \
+   a += b; d ^= a; d = ak_chacha20_rotl( d,  8 ); \
+   c += d; b ^= c; b = ak_chacha20_rotl( b,  7 );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Общий генератор, используемый для выработки начальных значений генераторов chacha20. */
+ static struct random chacha20_seed_generator;
+/*! \brief Флаг инициализации общего генератора. */
+ static bool_t chacha20_seed_generator_ready = ak_false;
+#ifdef AK_HAVE_PTHREAD_H
+ static pthread_mutex_t chacha20_seed_generator_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление следующего блока выходной последовательности генератора chacha20. */
+ static int ak_random_chacha20_next( ak_random rnd )
+{
+  int i;
+  ak_uint32 x[16], *state = NULL;
+
+  if( rnd == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                      "use a null pointer to a random generator" );
+  state = rnd->data.chacha20.state;
+  memcpy( x, state, sizeof( x ));
+  for( i = 0; i < 10; i++ ) {
+     ak_chacha20_quarter_round( x[0], x[4], x[ 8], x[12] )
+     ak_chacha20_quarter_round( x[1], x[5], x[ 9], x[13] )
+     ak_chacha20_quarter_round( x[2], x[6], x[10], x[14] )
+     ak_chacha20_quarter_round( x[3], x[7], x[11], x[15] )
+     ak_chacha20_quarter_round( x[0], x[5], x[10], x[15] )
+     ak_chacha20_quarter_round( x[1], x[6], x[11], x[12] )
+     ak_chacha20_quarter_round( x[2], x[7], x[ 8], x[13] )
+     ak_chacha20_quarter_round( x[3], x[4], x[ 9], x[14] )
+  }
+  for( i = 0; i < 16; i++ ) {
+    #ifdef AK_BIG_ENDIAN
+     rnd->data.chacha20.block[i] = bswap_32( x[i] + state[i] );
+    #else
+     rnd->data.chacha20.block[i] = x[i] + state[i];
+    #endif
+  }
+ /* 64-х битный счетчик блоков */
+  if( ++state[12] == 0 ) state[13]++;
+  rnd->data.chacha20.offset = 0;
+  memset( x, 0, sizeof( x ));
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Установка ключа и синхропосылки генератора chacha20. */
+ static void ak_random_chacha20_set_state( ak_random rnd, const ak_uint8 *key, const ak_uint64 nonce )
+{
+  int i;
+  ak_uint32 *state = rnd->data.chacha20.state;
+
+  state[0] = 0x61707865; state[1] = 0x3320646e; /* константа "expand 32-byte k" */
+  state[2] = 0x79622d32; state[3] = 0x6b206574;
+  for( i = 0; i < 8; i++ )
+     state[4+i] = ( ak_uint32 )key[4*i] ^ (( ak_uint32 )key[4*i+1] << 8 ) ^
+                           (( ak_uint32 )key[4*i+2] << 16 ) ^ (( ak_uint32 )key[4*i+3] << 24 );
+  state[12] = state[13] = 0;
+  state[14] = ( ak_uint32 )nonce;
+  state[15] = ( ak_uint32 )( nonce >> 32 );
+  rnd->data.chacha20.offset = sizeof( rnd->data.chacha20.block );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_chacha20_randomize_ptr( ak_random rnd, const ak_pointer ptr, const ssize_t size )
+{
+  ssize_t idx = 0;
+  ak_uint8 key[32];
+
+  if( rnd == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                      "use a null pointer to a random generator" );
+  if( ptr == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                          "use a null pointer to initial vector" );
+  if( size <= 0 ) return ak_error_message( ak_error_wrong_length, __func__ ,
+                                                          "use initial vector with wrong length" );
+ /* ключ генератора образуется сложением по модулю два фрагментов начального значения,
+    длина начального значения учитывается в синхропосылке */
+  memset( key, 0, sizeof( key ));
+  for( idx = 0; idx < size; idx++ ) key[idx&0x1f] ^= (( ak_uint8 *)ptr)[idx];
+  ak_random_chacha20_set_state( rnd, key, ( ak_uint64 )size );
+  memset( key, 0, sizeof( key ));
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_random_chacha20_random( ak_random rnd, const ak_pointer ptr, const ssize_t size )
+{
+  size_t len = 0, offset = 0, count = ( size_t )size;
+  ak_uint8 *value = ptr;
+
+  if( rnd == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                      "use a null pointer to a random generator" );
+  if( ptr == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                                    "use a null pointer to data" );
+  if( size <= 0 ) return ak_error_message( ak_error_wrong_length, __func__ ,
+                                                           "use a data vector with wrong length" );
+  while( count ) {
+    if(( offset = rnd->data.chacha20.offset ) == sizeof( rnd->data.chacha20.block ))
+      ak_random_chacha20_next( rnd ), offset = 0;
+    len = ak_min( count, sizeof( rnd->data.chacha20.block ) - offset );
+    memcpy( value, ( ak_uint8 *)rnd->data.chacha20.block + offset, len );
+   /* выданные значения сразу удаляются из внутреннего буффера */
+    memset(( ak_uint8 *)rnd->data.chacha20.block + offset, 0, len );
+    rnd->data.chacha20.offset = offset + len;
+    value += len; count -= len;
+  }
+
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Выработка начального значения для нового генератора chacha20.
+
+    Начальные значения вырабатываются общим генератором chacha20, ключ которого при первом
+    вызове функции считывается из /dev/urandom (при отсутствии устройства используется
+    функция ak_random_value()). Таким образом, при создании генератора не выполняется
+    обращений к операционной системе.                                                              */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_random_chacha20_seed( ak_uint8 *key, const size_t size )
+{
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &chacha20_seed_generator_mutex );
+#endif
+  if( !chacha20_seed_generator_ready ) {
+    size_t idx = 0;
+    ak_uint64 value = 0;
+    ak_uint8 seed[32];
+   #if defined(__unix__) || defined(__APPLE__)
+    struct random urandom;
+    bool_t done = ak_false;
+
+    if( ak_random_create_urandom( &urandom ) == ak_error_ok ) {
+      done = ( ak_random_ptr( &urandom, seed, sizeof( seed )) == ak_error_ok );
+      ak_random_destroy( &urandom );
+    }
+    if( !done )
+   #endif
+    for( idx = 0; idx < sizeof( seed ); idx += sizeof( value )) {
+       value = ak_random_value();
+       memcpy( seed + idx, &value, sizeof( value ));
+    }
+    ak_random_create( &chacha20_seed_generator );
+    ak_random_chacha20_set_state( &chacha20_seed_generator, seed, ak_random_value( ));
+    memset( seed, 0, sizeof( seed ));
+    chacha20_seed_generator_ready = ak_true;
+  }
+  ak_random_chacha20_random( &chacha20_seed_generator, key, ( ssize_t )size );
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &chacha20_seed_generator_mutex );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Генератор вырабатывает ключевую последовательность поточного шифра ChaCha20 (20 раундов,
+    64-х битный счетчик блоков и 64-х битная синхропосылка). Внутреннее состояние генератора
+    хранится в его контексте, поэтому создание генератора не требует выделения памяти.
+
+    Ключ генератора вырабатывается общим для всех генераторов данного типа генератором,
+    ключ которого, в свою очередь, считывается из /dev/urandom. Генератор используется
+    для выработки масок секретных ключей: в отличие от линейного конгруэнтного генератора
+    он является криптографически стойким, а за счет выработки данных блоками по 64 октета
+    не уступает ему в скорости.
+
+    @param generator Контекст создаваемого генератора.
+    \return В случае успеха, функция возвращает \ref ak_error_ok. В противном случае
+            возвращается код ошибки.                                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_random_create_chacha20( ak_random generator )
+{
+  int error = ak_error_ok;
+  ak_uint8 key[32];
+
+  if(( error = ak_random_create( generator )) != ak_error_ok )
+    return ak_error_message( error, __func__ , "wrong initialization of random generator" );
+
+  generator->oid = ak_oid_find_by_name("chacha20");
+  generator->next = ak_random_chacha20_next;
+  generator->randomize_ptr = ak_random_chacha20_randomize_ptr;
+  generator->random = ak_random_chacha20_random;
+
+  ak_random_chacha20_seed( key, sizeof( key ));
+  ak_random_chacha20_set_state( generator, key, ak_random_value( ));
+  memset( key, 0, sizeof( key ));
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*                                 реализация класса rng_file                                      */
 /* ----------------------------------------------------------------------------------------------- */
@@ -766,6 +766,36 @@
  return ak_signkey_sign_hash( sctx, generator, hash, sctx->ctx.data.sctx.hsize, out, out_size );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция предназначена для использования совместно с ak_file_async() и имеет
+    сигнатуру \ref ak_function_file_async. Для выработки случайного числа используется
+    собственный генератор ключа `sctx->key.generator`, поэтому каждый поток, обрабатывающий
+    файлы, должен использовать отдельный контекст секретного ключа.
+
+\code
+    struct signkey skey[4];
+    ak_pointer ptr[4] = { skey, skey+1, skey+2, skey+3 };
+
+    ak_file_async( ak_signkey_sign_file_async, ptr, 4, filenames, count, out, 64, errors );
+\endcode
+
+    @param sctx Kонтекст секретного ключа алгоритма электронной подписи.
+    @param filename Строка с именем файла для которого вычисляется электронная подпись.
+    @param out Область памяти, куда будет помещен результат. Память должна быть заранее выделена.
+    @param out_size Размер выделенной под выработанную ЭП памяти.
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль).
+    В противном случае возвращается код ошибки.                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_signkey_sign_file_async( ak_pointer sctx, const char *filename,
+                                                             ak_pointer out, const size_t out_size )
+{
+  if( sctx == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                                 "using null pointer to secret key context" );
+ return ak_signkey_sign_file( sctx, &(( ak_signkey )sctx)->key.generator,
+                                                                       filename, out, out_size );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*                     функции для работы с открытыми ключами электронной подписи                  */
 /* ----------------------------------------------------------------------------------------------- */
@@ -4,7 +4,7 @@
 /*  Файл ak_skey.c                                                                                 */
 /*  - содержит реализации функций, предназначенных для хранения и обработки ключевой информации.   */
 /* ----------------------------------------------------------------------------------------------- */
- #include <libakrypt.h>
+ #include <libakrypt-internal.h>
 
 /* ----------------------------------------------------------------------------------------------- */
 #ifdef AK_HAVE_TIME_H
@@ -28,6 +28,15 @@
 #ifdef AK_HAVE_PTHREAD_H
  #include <pthread.h>
 #endif
+#ifdef AK_HAVE_ERRNO_H
+ #include <errno.h>
+#endif
+#ifdef AK_HAVE_UNISTD_H
+ #include <unistd.h>
+#endif
+#if !defined( AK_HAVE_WINDOWS_H ) && defined( AK_HAVE_SYSMMAN_H )
+ #include <sys/mman.h>
+#endif
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Переменная определяет порядковый номер ключа в рамках одной сессии.
@@ -38,6 +47,48 @@
  static pthread_mutex_t session_unique_number_mutex = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Мьютекс, используемый для изменения счетчиков ключа при отсутствии атомарных операций. */
+#if !defined( AK_HAVE_BUILTIN_ATOMIC_GCC ) && defined( AK_HAVE_PTHREAD_H )
+ static pthread_mutex_t skey_counters_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Атомарное увеличение счетчика на единицу, функция возвращает новое значение. */
+ static inline ak_uint32 ak_skey_atomic_increment( ak_uint32 *value )
+{
+#ifdef AK_HAVE_BUILTIN_ATOMIC_GCC
+ return __atomic_add_fetch( value, 1, __ATOMIC_RELAXED );
+#else
+  ak_uint32 result = 0;
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &skey_counters_mutex );
+ #endif
+  result = ++(*value);
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &skey_counters_mutex );
+ #endif
+ return result;
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Атомарное присвоение значения счетчику. */
+ static inline void ak_skey_atomic_store( ak_uint32 *value, const ak_uint32 x )
+{
+#ifdef AK_HAVE_BUILTIN_ATOMIC_GCC
+  __atomic_store_n( value, x, __ATOMIC_RELAXED );
+#else
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &skey_counters_mutex );
+ #endif
+  *value = x;
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &skey_counters_mutex );
+ #endif
+#endif
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \param rt Тип криптографического ресурса.
     \return Функция возвращает константную строку на человеко читаемое имя ключеовго ресурса.      */
@@ -138,6 +189,248 @@
  return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                         защищенная область памяти для хранения ключей                           */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество различных размеров ячеек защищенной области памяти. */
+ #define ak_secure_arena_classes   (5)
+
+/*! \brief Размеры ячеек (в октетах): ключи длиной 32 и 64 октета вместе с масками,
+    а также развернутые ключи алгоритмов блочного шифрования. */
+ static const size_t secure_arena_slot_size[ ak_secure_arena_classes ] =
+                                                                     { 64, 128, 256, 512, 1024 };
+
+/*! \brief Фрагмент защищенной области памяти, содержащий ячейки одного размера. */
+ struct secure_arena_slab {
+  /*! \brief Начало и конец фрагмента. */
+   ak_uint8 *begin, *end;
+  /*! \brief Первая ячейка фрагмента, которая еще ни разу не выделялась. */
+   ak_uint8 *next;
+  /*! \brief Односвязный список освобожденных ячеек. */
+   ak_pointer freed;
+  /*! \brief Количество выделенных ячеек. */
+   size_t used;
+ };
+
+/*! \brief Защищенная область памяти для хранения ключевой информации. */
+ static struct secure_arena {
+  /*! \brief Указатель на отображенную область памяти (вместе с охранными страницами). */
+   ak_uint8 *base;
+  /*! \brief Размер отображенной области памяти. */
+   size_t size;
+  /*! \brief Фрагменты, содержащие ячейки фиксированного размера. */
+   struct secure_arena_slab slab[ ak_secure_arena_classes ];
+  /*! \brief Состояние области: 0 - не создана, 1 - создана, -1 - создание невозможно. */
+   int state;
+ } secure_arena;
+
+#ifdef AK_HAVE_PTHREAD_H
+ static pthread_mutex_t secure_arena_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция отображает в память защищенную область, размер которой задается опцией
+    `secure_arena_size`.
+
+    Область разбивается на фрагменты, содержащие ячейки одного размера; перед первым фрагментом,
+    между фрагментами и после последнего фрагмента размещаются охранные страницы, доступ к которым
+    запрещен. Фрагменты закрепляются в оперативной памяти (вызов `mlock()`) и исключаются
+    из дампа памяти процесса (вызов `madvise( MADV_DONTDUMP )`). Если закрепление невозможно,
+    например, из-за ограничения `RLIMIT_MEMLOCK`, область используется без закрепления.
+
+    Функция вызывается при заблокированном мьютексе защищенной области.
+    \return В случае успеха возвращается \ref ak_error_ok. В противном случае
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_secure_arena_create( void )
+{
+#if !defined( AK_HAVE_WINDOWS_H ) && defined( AK_HAVE_SYSMMAN_H ) && defined( AK_HAVE_UNISTD_H )
+  size_t i = 0, page = 4096, region = 0;
+  bool_t locked = ak_true;
+  long value = sysconf( _SC_PAGESIZE );
+  ak_uint8 *ptr = NULL;
+
+  if( value > 0 ) page = ( size_t )value;
+  region = ( size_t )ak_libakrypt_get_option_by_name( "secure_arena_size" ) << 10;
+  region = (( region/ak_secure_arena_classes + page - 1 )/page )*page;
+  secure_arena.size = ak_secure_arena_classes*( region + page ) + page;
+
+  if(( ptr = mmap( NULL, secure_arena.size, PROT_READ | PROT_WRITE,
+                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 )) == MAP_FAILED ) {
+    secure_arena.size = 0;
+    return ak_error_message_fmt( ak_error_out_of_memory, __func__,
+                                       "wrong mapping of secure arena [%s]", strerror( errno ));
+  }
+ #ifdef MADV_DONTDUMP
+  madvise( ptr, secure_arena.size, MADV_DONTDUMP );
+ #endif
+
+  for( i = 0; i <= ak_secure_arena_classes; i++ ) {
+    if( mprotect( ptr + i*( region + page ), page, PROT_NONE ) != 0 ) {
+      munmap( ptr, secure_arena.size );
+      secure_arena.size = 0;
+      return ak_error_message_fmt( ak_error_out_of_memory, __func__,
+                                   "wrong protection of secure arena guard page [%s]",
+                                                                                strerror( errno ));
+    }
+    if( i == ak_secure_arena_classes ) break;
+    secure_arena.slab[i].begin = secure_arena.slab[i].next = ptr + i*( region + page ) + page;
+    secure_arena.slab[i].end = secure_arena.slab[i].begin + region;
+    secure_arena.slab[i].freed = NULL;
+    secure_arena.slab[i].used = 0;
+    if( mlock( secure_arena.slab[i].begin, region ) != 0 ) locked = ak_false;
+  }
+
+  if(( locked != ak_true ) && ( ak_log_get_level() >= ak_log_maximum ))
+    ak_error_message( ak_error_ok, __func__ , "secure arena is not locked in memory" );
+  secure_arena.base = ptr;
+ return ak_error_ok;
+#else
+ return ak_error_message( ak_error_undefined_function, __func__,
+                                                   "secure arena is not supported on this system" );
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! При первом вызове функции создается защищенная область памяти. Выделение памяти производится
+    за фиксированное время из фрагмента с ячейками наименьшего подходящего размера; память,
+    выделенная функцией, всегда обнулена и выровнена по границе 64 октетов.
+
+    \param size Размер выделяемой памяти в октетах (не более 1024).
+    \return Указатель на выделенную память. Если размер слишком велик, фрагмент исчерпан или
+    защищенная область не может быть создана, то возвращается `NULL`. Код ошибки
+    при этом не устанавливается.                                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ ak_pointer ak_secure_arena_malloc( size_t size )
+{
+  size_t i = 0;
+  ak_uint8 *ptr = NULL;
+  struct secure_arena_slab *slab = NULL;
+
+  if( size == 0 ) return NULL;
+  while(( i < ak_secure_arena_classes ) && ( secure_arena_slot_size[i] < size )) i++;
+  if( i == ak_secure_arena_classes ) return NULL;
+
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &secure_arena_mutex );
+#endif
+  if( secure_arena.state == 0 )
+    secure_arena.state = ( ak_secure_arena_create() == ak_error_ok ) ? 1 : -1;
+  if( secure_arena.state == 1 ) {
+    slab = &secure_arena.slab[i];
+    if( slab->freed != NULL ) {
+      ptr = slab->freed;
+      slab->freed = *( ak_pointer *)ptr;
+      *( ak_pointer *)ptr = NULL;
+    } else
+       if( slab->next + secure_arena_slot_size[i] <= slab->end ) {
+         ptr = slab->next;
+         slab->next += secure_arena_slot_size[i];
+       }
+    if( ptr != NULL ) slab->used++;
+  }
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &secure_arena_mutex );
+#endif
+ return ptr;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Перед возвратом в защищенную область ячейка памяти обнуляется.
+
+    \param ptr Указатель на память, выделенную функцией ak_secure_arena_malloc().
+    \return Функция возвращает \ref ak_true, если память принадлежит защищенной области
+    и была возвращена в нее. В противном случае возвращается \ref ak_false.                     */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_secure_arena_free( ak_pointer ptr )
+{
+  size_t i = 0;
+  bool_t result = ak_false;
+  ak_uint8 *cptr = ptr;
+
+  if( ptr == NULL ) return ak_false;
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &secure_arena_mutex );
+#endif
+  if( secure_arena.state == 1 ) {
+    for( i = 0; i < ak_secure_arena_classes; i++ ) {
+       struct secure_arena_slab *slab = &secure_arena.slab[i];
+       if(( cptr < slab->begin ) || ( cptr >= slab->next )) continue;
+       memset( ptr, 0, secure_arena_slot_size[i] );
+       *( ak_pointer *)ptr = slab->freed;
+       slab->freed = ptr;
+       slab->used--;
+       result = ak_true;
+       break;
+    }
+  }
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &secure_arena_mutex );
+#endif
+ return result;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вызывается при завершении работы с библиотекой. Защищенная область освобождается,
+    только если в ней не осталось выделенных ячеек; в противном случае область сохраняется
+    до завершения процесса.
+
+    \return Функция возвращает \ref ak_error_ok.                                                  */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_secure_arena_destroy( void )
+{
+  size_t i = 0, used = 0;
+
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &secure_arena_mutex );
+#endif
+  if( secure_arena.state == 1 ) {
+    for( i = 0; i < ak_secure_arena_classes; i++ ) used += secure_arena.slab[i].used;
+    if( used == 0 ) {
+     /* все ячейки уже обнулены при освобождении */
+#if !defined( AK_HAVE_WINDOWS_H ) && defined( AK_HAVE_SYSMMAN_H )
+      munmap( secure_arena.base, secure_arena.size );
+#endif
+      memset( &secure_arena, 0, sizeof( struct secure_arena ));
+    } else
+       if( ak_log_get_level() >= ak_log_maximum )
+         ak_error_message_fmt( ak_error_ok, __func__,
+                                "secure arena holds %u allocated key buffers", (unsigned int)used );
+  }
+   else secure_arena.state = 0;
+#ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &secure_arena_mutex );
+#endif
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Если для ключа задан способ выделения памяти \ref secure_arena_policy, то память выделяется
+    из защищенной области; если это невозможно, то используется функция ak_aligned_malloc().
+
+    \param skey Контекст секретного ключа
+    \param size Размер выделяемой памяти в октетах
+    \return Указатель на выделенную память или `NULL` в случае ошибки.                           */
+/* ----------------------------------------------------------------------------------------------- */
+ ak_pointer ak_skey_alloc_data( ak_skey skey, size_t size )
+{
+  ak_pointer ptr = NULL;
+
+  if(( skey != NULL ) && ( skey->policy == secure_arena_policy ))
+    ptr = ak_secure_arena_malloc( size );
+  if( ptr == NULL ) ptr = ak_aligned_malloc( size );
+ return ptr;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \param ptr Указатель на память, выделенную функцией ak_skey_alloc_data().                    */
+/* ----------------------------------------------------------------------------------------------- */
+ void ak_skey_free_data( ak_pointer ptr )
+{
+  if( ptr == NULL ) return;
+  if( ak_secure_arena_free( ptr ) != ak_true ) free( ptr );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \details Функция выделяет массив памяти, достаточный для размещения секретного ключа и
     его маски (размер выделяемой памяти в точности равен удвленному разхмеру секретного ключа).
@@ -145,7 +438,8 @@
 
     \param skey Контекст секретного ключа
     \param size Размер секретного ключа (в октетах)
-    \param policy Метод выделения памяти.
+    \param policy Метод выделения памяти. Если защищенная область памяти исчерпана или
+    не может быть создана, то вместо \ref secure_arena_policy используется \ref malloc_policy.
     \return В случае успеха возвращается значение \ref ak_error_ok. В случае возникновения
      ошибки возвращается ее код.                                                                   */
 /* ----------------------------------------------------------------------------------------------- */
@@ -162,6 +456,14 @@
   if( size > ((size_t)-1 ) >> 1 ) return ak_error_message( ak_error_wrong_length, __func__,
                                                                 "using a very huge length value" );
   switch( policy ) {
+    case secure_arena_policy:
+      if(( ptr = ak_secure_arena_malloc( size << 1 )) != NULL ) {
+        if( skey->key != NULL ) ak_skey_free_memory( skey );
+        skey->key = ptr;
+        break;
+      }
+      policy = malloc_policy;
+     /* fall through */
     case malloc_policy:
      /* выделяем новую память (под ключ и его маску) */
       if(( ptr = ak_aligned_malloc( size << 1 )) == NULL )
@@ -211,6 +513,11 @@
       free( skey->key );
       break;
 
+    case secure_arena_policy:
+      skey->policy = undefined_policy;
+      if( ak_secure_arena_free( skey->key ) != ak_true ) free( skey->key );
+      break;
+
     default:
       return ak_error_message( ak_error_undefined_value, __func__,
                                     "using secret key conetxt with unexpected allocation policy" );
@@ -283,18 +590,26 @@
                                                               "using a zero length for key size" );
  /* Инициализируем данные базовыми значениями */
   skey->key = NULL;
-  if(( error = ak_skey_alloc_memory( skey, size, malloc_policy )) != ak_error_ok ) {
+  if(( error = ak_skey_alloc_memory( skey, size,
+                   ak_libakrypt_get_option_by_name( "key_memory_policy" ) == 1 ?
+                                         secure_arena_policy : malloc_policy )) != ak_error_ok ) {
     ak_error_message( error, __func__ ,"wrong allocation memory of internal secret key buffer" );
     ak_skey_destroy( skey );
     return error;
   }
 
   skey->icode = 0; /* контрольная сумма ключа не задана */
+  skey->icode_period = ( ak_uint32 ) ak_libakrypt_get_option_by_name( "key_icode_check_period" );
+  skey->icode_calls = 0;
+  skey->remask_policy = ( key_remask_policy_t ) ak_libakrypt_get_option_by_name( "key_remask_policy" );
+  skey->remask_period = ( ak_uint64 ) ak_libakrypt_get_option_by_name( "key_remask_period" );
+  skey->remask_counter = 0;
+  skey->remask_time = time( NULL );
   skey->data = NULL; /* внутренние данные ключа не определены */
   memset( &(skey->resource), 0, sizeof( struct resource )); /* ресурс ключа не определен */
 
  /* инициализируем генератор масок */
-  if(( error = ak_random_create_lcg( &skey->generator )) != ak_error_ok ) {
+  if(( error = ak_random_create_chacha20( &skey->generator )) != ak_error_ok ) {
     ak_error_message( error, __func__ , "wrong creation of random generator" );
     ak_skey_destroy( skey );
     return error;
@@ -356,7 +671,7 @@
   ak_random_destroy( &skey->generator );
   if( skey->data != NULL ) {
    /* при установленном флаге память не очищаем */
-    if( !((skey->flags)&ak_key_flag_data_not_free )) free( skey->data );
+    if( !((skey->flags)&ak_key_flag_data_not_free )) ak_skey_free_data( skey->data );
   }
   skey->oid = NULL;
   skey->flags = ak_key_flag_undefined;
@@ -369,6 +684,51 @@
  return ak_error_ok;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция уничтожает значение ключа и его маски, а также возвращает контекст в состояние,
+    в котором он находится сразу после вызова функции ak_skey_create(). При этом память,
+    выделенная под ключ, и генератор масок не освобождаются, что позволяет повторно использовать
+    контекст для нового ключа того же алгоритма (см. ak_handle_delete()).
+
+    Внутренние данные ключа (развернутые ключи) функцией не уничтожаются.
+
+    \param skey Контекст секретного ключа
+    \return В случае успеха возвращается значение \ref ak_error_ok. В случае возникновения
+     ошибки возвращается ее код.                                                                   */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_skey_reset( ak_skey skey )
+{
+  int error = ak_error_ok, result = ak_error_ok;
+
+  if( skey == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                    "using a null pointer to secret key context" );
+  if( skey->key != NULL ) {
+    if(( error = ak_ptr_wipe( skey->key, skey->key_size << 1,
+                                                             &skey->generator )) != ak_error_ok ) {
+      ak_error_message( error, __func__, "incorrect wiping a key buffer" );
+      memset( skey->key, 0, skey->key_size << 1 );
+    }
+  }
+  if(( result = ak_skey_set_unique_number( skey )) != ak_error_ok )
+    error = ak_error_message( result, __func__, "invalid creation of key number" );
+  skey->icode = 0;
+  skey->icode_period = ( ak_uint32 ) ak_libakrypt_get_option_by_name( "key_icode_check_period" );
+  skey->icode_calls = 0;
+  skey->remask_policy = ( key_remask_policy_t ) ak_libakrypt_get_option_by_name( "key_remask_policy" );
+  skey->remask_period = ( ak_uint64 ) ak_libakrypt_get_option_by_name( "key_remask_period" );
+  skey->remask_counter = 0;
+  skey->remask_time = time( NULL );
+  memset( &(skey->resource), 0, sizeof( struct resource ));
+  if( skey->label != NULL ) {
+    free( skey->label );
+    skey->label = NULL;
+  }
+ /* сохраняем только флаг, определяемый способом хранения внутренних данных */
+  skey->flags &= ak_key_flag_data_not_free;
+
+ return error;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция вырабатывает случайный вектор \f$ v \f$ длины, совпадающей с длиной ключа,
     и заменяет значение ключа \f$ k \f$ на величину \f$ k \oplus v \f$.
@@ -390,6 +750,8 @@
                                                  __func__ , "using a null pointer to key buffer" );
   if( skey->key_size == 0 ) return ak_error_message( ak_error_zero_length, __func__ ,
                                                            "using a key buffer with zero length" );
+ /* маска ключа, используемого несколькими потоками, не изменяется */
+  if(( skey->flags&ak_key_flag_set_mask ) && ( skey->flags&ak_key_flag_shared )) return ak_error_ok;
  /* проверяем, установлена ли маска ранее */
   if((( skey->flags)&ak_key_flag_set_mask ) == 0 ) {
     /* создаем маску*/
@@ -529,6 +891,216 @@
     else return ak_false;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вызывается режимами шифрования и выработки имитовставки при каждом использовании
+    ключа. Собственно проверка контрольной суммы (вызов метода `check_icode`) выполняется
+    только при каждом `icode_period`-ом использовании ключа, что позволяет уменьшить
+    накладные расходы при обработке большого количества коротких сообщений; нарушение
+    целостности ключа обнаруживается не позднее, чем через `icode_period` использований.
+    После обнаружения нарушения целостности проверка выполняется при каждом вызове.
+
+    Значение `icode_period` устанавливается при создании ключа равным значению опции
+    `key_icode_check_period` и может быть изменено функцией ak_skey_set_icode_check_period().
+
+    Счетчик `icode_calls` изменяется атомарно, поэтому функция может вызываться одновременно
+    из нескольких потоков, использующих один и тот же ключ.
+
+    @param skey Контекст секретного ключа.
+    @return Функция возвращает ложь (\ref ak_false), если контрольная сумма была проверена
+    и не совпала. В противном случае возвращается истина (\ref ak_true).                          */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_skey_check_icode( ak_skey skey )
+{
+  if( skey == NULL ) { ak_error_message( ak_error_null_pointer,
+                                         __func__ , "using a null pointer to secret key context" );
+    return ak_false;
+  }
+  if( ak_skey_atomic_increment( &skey->icode_calls ) < skey->icode_period ) return ak_true;
+  if( skey->check_icode( skey ) != ak_true ) {
+   /* следующий вызов также выполнит проверку */
+    ak_skey_atomic_store( &skey->icode_calls, skey->icode_period );
+    return ak_false;
+  }
+  ak_skey_atomic_store( &skey->icode_calls, 0 );
+ return ak_true;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param skey Контекст секретного ключа.
+    @param period Количество использований ключа, после которого проверяется контрольная сумма;
+    значение 1 означает проверку при каждом использовании ключа.
+    @return Функция возвращает \ref ak_error_ok (ноль) в случае успеха, в случае неудачи
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_skey_set_icode_check_period( ak_skey skey, const ak_uint32 period )
+{
+  if( skey == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                      "using a null pointer to secret key context" );
+  if( !period ) return ak_error_message( ak_error_zero_length, __func__ ,
+                                                          "using zero period of icode checking" );
+  skey->icode_period = period;
+  skey->icode_calls = 0;
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция атомарно проверяет, что оставшийся ресурс ключа не меньше `count`, и уменьшает его
+    на `count`. Проверка и уменьшение ресурса выполняются как одна операция (цикл
+    сравнения с обменом), поэтому при одновременном использовании одного ключа несколькими
+    потоками суммарный объем обработанных данных никогда не превышает установленного ресурса.
+    Если ресурса недостаточно, его значение не изменяется.
+
+    Функция не выводит сообщение об ошибке: это делает вызывающая функция, которой известно,
+    для какого ключа (шифрования или имитозащиты) не хватило ресурса.
+
+    @param skey Контекст секретного ключа.
+    @param count Резервируемый ресурс (количество блоков или использований ключа).
+    @return Функция возвращает \ref ak_error_ok (ноль) в случае успеха, \ref ak_error_low_key_resource,
+    если ресурс ключа недостаточен, или иной код ошибки.                                           */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_skey_reserve_resource( ak_skey skey, const ssize_t count )
+{
+  ssize_t *counter = NULL;
+#ifdef AK_HAVE_BUILTIN_ATOMIC_GCC
+  ssize_t value = 0;
+#else
+  int error = ak_error_ok;
+#endif
+
+  if( skey == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                      "using a null pointer to secret key context" );
+  if( count < 0 ) return ak_error_message( ak_error_wrong_length, __func__ ,
+                                                              "using negative value of resource" );
+  counter = &skey->resource.value.counter;
+#ifdef AK_HAVE_BUILTIN_ATOMIC_GCC
+  value = __atomic_load_n( counter, __ATOMIC_RELAXED );
+  do{
+     if( value < count ) return ak_error_low_key_resource;
+  } while( !__atomic_compare_exchange_n( counter, &value, value - count, 1,
+                                                             __ATOMIC_RELAXED, __ATOMIC_RELAXED ));
+ return ak_error_ok;
+#else
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_lock( &skey_counters_mutex );
+ #endif
+  if( *counter < count ) error = ak_error_low_key_resource;
+    else *counter -= count;
+ #ifdef AK_HAVE_PTHREAD_H
+  pthread_mutex_unlock( &skey_counters_mutex );
+ #endif
+ return error;
+#endif
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Флаг \ref ak_key_flag_shared сообщает библиотеке, что ключ одновременно используется
+    несколькими потоками. Для такого ключа
+
+    - смена маски после каждого использования (вызов метода `set_mask`) не выполняется,
+      значение ключа, его маска и развернутые раундовые ключи изменяются только при
+      присвоении ключу нового значения;
+    - обработка одного фрагмента данных выполняется только в вызывающем потоке
+      (см. ak_bckey_process_fragments()), поскольку создание копий ключа требует снятия маски;
+    - ресурс ключа и счетчик проверок контрольной суммы изменяются атомарно
+      (см. ak_skey_reserve_resource() и ak_skey_check_icode()).
+
+    Таким образом, после установки флага доступ к ключевой информации выполняется только
+    на чтение, и функции, не хранящие промежуточное состояние в контексте ключа,
+    могут вызываться одновременно из разных потоков. Для ключей алгоритмов блочного шифрования
+    это ak_bckey_encrypt_ecb(), ak_bckey_decrypt_ecb(), ak_bckey_ctr_at_offset(), ak_bckey_cmac(),
+    а также методы `encrypt` и `decrypt`. Функции, сохраняющие синхропосылку или промежуточные
+    значения в контексте ключа (например, ak_bckey_ctr() или ak_bckey_cmac_update()),
+    а также функции, изменяющие значение ключа или снимающие с него маску, по-прежнему требуют
+    монопольного доступа к контексту.
+
+    @param skey Контекст секретного ключа.
+    @param shared Истина, если ключ будет использоваться несколькими потоками, и ложь в
+    противном случае.
+    @return Функция возвращает \ref ak_error_ok (ноль) в случае успеха, в случае неудачи
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_skey_set_shared( ak_skey skey, const bool_t shared )
+{
+  if( skey == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                      "using a null pointer to secret key context" );
+  if( shared ) skey->flags |= ak_key_flag_shared;
+    else skey->flags &= ~ak_key_flag_shared;
+ return ak_error_ok;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция вызывается режимами шифрования после каждого использования ключа вместо
+    непосредственного вызова метода `set_mask`. Смена маски требует выработки новой
+    случайной маски и перезаписи ключа (а для некоторых алгоритмов и развернутых раундовых
+    ключей), поэтому при обработке большого количества коротких сообщений ее стоимость
+    сопоставима со стоимостью самого шифрования. Функция позволяет выполнять смену маски
+
+    - после каждого использования ключа (\ref key_remask_every_call, значение по-умолчанию),
+    - после каждого `remask_period`-го использования (\ref key_remask_by_calls),
+    - после обработки не менее `remask_period` октетов (\ref key_remask_by_bytes),
+    - не чаще одного раза в `remask_period` секунд (\ref key_remask_by_timer).
+
+    Политика устанавливается при создании ключа значениями опций `key_remask_policy`
+    и `key_remask_period` и может быть изменена функцией ak_skey_set_remask_policy().
+    Для ключей, используемых несколькими потоками (флаг \ref ak_key_flag_shared),
+    маска не меняется.
+
+    @param skey Контекст секретного ключа.
+    @param size Количество октетов, обработанных при последнем использовании ключа.
+    @return Функция возвращает \ref ak_error_ok (ноль) в случае успеха, в случае неудачи
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_skey_remask( ak_skey skey, const size_t size )
+{
+  time_t now = 0;
+
+  if( skey == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                      "using a null pointer to secret key context" );
+  if( skey->flags&ak_key_flag_shared ) return ak_error_ok;
+  switch( skey->remask_policy ) {
+    case key_remask_by_calls:
+      if( ++skey->remask_counter < skey->remask_period ) return ak_error_ok;
+      break;
+    case key_remask_by_bytes:
+      if(( skey->remask_counter += size ) < skey->remask_period ) return ak_error_ok;
+      break;
+    case key_remask_by_timer:
+      if(( now = time( NULL )) - skey->remask_time < ( time_t )skey->remask_period )
+        return ak_error_ok;
+      skey->remask_time = now;
+      break;
+    default:
+      break;
+  }
+  skey->remask_counter = 0;
+ return skey->set_mask( skey );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! @param skey Контекст секретного ключа.
+    @param policy Политика смены маски ключа.
+    @param period Количество использований ключа, количество октетов или количество секунд
+    (в зависимости от политики), после которого меняется маска ключа; для политики
+    \ref key_remask_every_call значение игнорируется.
+    @return Функция возвращает \ref ak_error_ok (ноль) в случае успеха, в случае неудачи
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_skey_set_remask_policy( ak_skey skey, const key_remask_policy_t policy,
+                                                                         const ak_uint64 period )
+{
+  if( skey == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                      "using a null pointer to secret key context" );
+  if(( policy < key_remask_every_call ) || ( policy > key_remask_by_timer ))
+    return ak_error_message( ak_error_wrong_option, __func__ , "using wrong remasking policy" );
+  if(( policy != key_remask_every_call ) && ( !period ))
+    return ak_error_message( ak_error_zero_length, __func__ , "using zero period of remasking" );
+  skey->remask_policy = policy;
+  skey->remask_period = period;
+  skey->remask_counter = 0;
+  skey->remask_time = time( NULL );
+ return ak_error_ok;
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! Присвоение времени происходит следующим образом. Если `not_before` равно нулю, то
     устанавливается текущее время. Если `not_after` равно нулю или меньше, чем `not_before`,
@@ -694,7 +1266,7 @@
   memset( skey->key+size, 0, size ); /* обнуляем массив масок */
 
  /* очищаем флаг начальной инициализации */
-  skey->flags &= (0xFFFFFFFFFFFFFFFFLL ^ ak_key_flag_set_mask );
+  skey->flags &= (0xFFFFFFFFFFFFFFFFLL ^ ( ak_key_flag_set_mask | ak_key_flag_precomputed ));
 
  /* маскируем ключ и вычисляем контрольную сумму */
   if(( error = skey->set_mask( skey )) != ak_error_ok ) return  ak_error_message( error,
@@ -742,7 +1314,7 @@
     return ak_error_message( error, __func__ , "wrong generation a secret key" );
 
  /* меняем значение флага маски на установленное */
-  skey->flags |= ak_key_flag_set_mask;
+  skey->flags = ( skey->flags&( ~ak_key_flag_precomputed ))|ak_key_flag_set_mask;
   if(( error = skey->set_icode( skey )) != ak_error_ok ) return ak_error_message( error,
                                                  __func__ , "wrong calculation of integrity code" );
 
@@ -795,7 +1367,7 @@
   memset( skey->key+skey->key_size, 0, skey->key_size ); /* обнуляем массив масок */
 
  /* очищаем флаг начальной инициализации */
-  skey->flags &= (0xFFFFFFFFFFFFFFFFLL ^ ak_key_flag_set_mask );
+  skey->flags &= (0xFFFFFFFFFFFFFFFFLL ^ ( ak_key_flag_set_mask | ak_key_flag_precomputed ));
 
  /* маскируем ключ и вычисляем контрольную сумму */
   if(( error = skey->set_mask( skey )) != ak_error_ok ) return  ak_error_message( error,
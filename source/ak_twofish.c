@@ -1,282 +1,559 @@
 /* ----------------------------------------------------------------------------------------------- */
-/*      Реализация блочного алгоритма шифрования TwoFish (128-bit), author: Bruce Schneier         */
-/* ----------------------------------------------------------------------------------------------- */
-
-#include <math.h>
-#include <libakrypt.h>
-#include <assert.h>
-
-
-#define RHO 0x01010101L
-/*----------------------------------------------------------------
- *  FUNCTIONAL STRUCT
- -----------------------------------------------------------------*/
-typedef struct {
-    UINT Kkey[40];
-    UINT Skey[2];
-} ak_key_shedule;
-
-/*----------------------------------------------------------------
- *  CIRCULAR SHIFTS
- -----------------------------------------------------------------*/
-#define ROL(x,n) (((x) << ((n) & 0x1F)) | ((x) >> (32-((n) & 0x1F))))
-#define ROR(x,n) (((x) >> ((n) & 0x1F)) | ((x) << (32-((n) & 0x1F))))
-//Right circular shift for 4 least significant bits
-ak_uint8 ROR4(ak_uint8 x){
-    return (((x << 3) & 0xF) | ( (x & 0xF) >> 1));
-}
-/*----------------------------------------------------------------
- *  CONST MATRIX 
- -----------------------------------------------------------------*/
-const ak_uint8 MDS[4][4] = {
-        {0x01, 0xEF, 0x5B, 0x5B},
-        {0x5B, 0xEF, 0xEF, 0x01},
-        {0xEF, 0x5B, 0x01, 0xEF},
-        {0xEF, 0x01, 0xEF, 0x5B}
-};
-const ak_uint8 qt[2][4][16] = {
-        //permutation table for q0 operation
-        {
-                { 0x8, 0x1, 0x7, 0xD, 0x6, 0xF, 0x3, 0x2, 0x0, 0xB, 0x5, 0x9, 0xE, 0xC, 0xA, 0x4 },
-                { 0xE, 0xC, 0xB, 0x8, 0x1, 0x2, 0x3, 0x5, 0xF, 0x4, 0xA, 0x6, 0x7, 0x0, 0x9, 0xD },
-                { 0xB, 0xA, 0x5, 0xE, 0x6, 0xD, 0x9, 0x0, 0xC, 0x8, 0xF, 0x3, 0x2, 0x4, 0x7, 0x1 },
-                { 0xD, 0x7, 0xF, 0x4, 0x1, 0x2, 0x6, 0xE, 0x9, 0xB, 0x3, 0x0, 0x8, 0x5, 0xC, 0xA }
-        },
-
-        //permutation table for q1 operation
-        {
-                { 0x2, 0x8, 0xB, 0xD, 0xF, 0x7, 0x6, 0xE, 0x3, 0x1, 0x9, 0x4, 0x0, 0xA, 0xC, 0x5 },
-                { 0x1, 0xE, 0x2, 0xB, 0x4, 0xC, 0x3, 0x7, 0x6, 0xD, 0xA, 0x5, 0xF, 0x9, 0x0, 0x8 },
-                { 0x4, 0xC, 0x7, 0x5, 0x1, 0x6, 0x9, 0xA, 0x0, 0xE, 0xD, 0x8, 0x2, 0xB, 0x3, 0xF },
-                { 0xB, 0x9, 0x5, 0x1, 0xC, 0x3, 0xD, 0xE, 0x6, 0x4, 0x7, 0xF, 0x2, 0x0, 0x8, 0xA }
-        },
-};
-const ak_uint8 RSMatrix[4][8] = {
-        {0x01, 0xA4, 0x55, 0x87, 0x5A, 0x58, 0xDB, 0x9E},
-        {0xA4, 0x56, 0x82, 0xF3, 0x1E, 0xC6, 0x68, 0xE5},
-        {0x02, 0xA1, 0xFC, 0xC1, 0x47, 0xAE, 0x3D, 0x19},
-        {0xA4, 0x55, 0x87, 0x5A, 0x58, 0xDB, 0x9E, 0x03},
-};
-/*----------------------------------------------------------------
- *  FUNCTIONS FOR MUTATION TYPES ak_uint8, ak_uint32
- -----------------------------------------------------------------*/
-ak_uint8 ak_b0(ak_uint32 x){
-    return x & 0xFF;
-}
-ak_uint8 ak_b1(ak_uint32 x){
-    return  (x >> 8) & 0xFF;
-}
-ak_uint8  ak_b2(ak_uint32 x){
-    return  (x >> 16) & 0xFF;
-}
-ak_uint8  ak_b3(ak_uint32 x){
-    return  (x >> 24) & 0xFF;
-}
-ak_uint32 ak_uint8_to_uint32(ak_uint8 x0, ak_uint8 x1, ak_uint8 x2, ak_uint8 x3){
-    return ((x0 << 24) ^ (x1 << 16) ^ (x2 << 8) ^ x3);
-}
-ak_uint32 ak_auint8_to_uint32(const ak_uint8 *x){
-    return ((x[0] << 24) ^ (x[1] << 16) ^ (x[2] << 8) ^ x[3]);
-}
+/*  Copyright (c) 2020 by Axel Kenzo, axelkenzo@mail.ru                                            */
+/*                                                                                                 */
+/*  Файл ak_twofish.c                                                                              */
+/*  - содержит реализацию алгоритма блочного шифрования TwoFish (длина блока 128 бит,              */
+/*    длина ключа 256 бит), авторы: B. Schneier, J. Kelsey, D. Whiting, D. Wagner, C. Hall,        */
+/*    N. Ferguson, "Twofish: A 128-Bit Block Cipher", 1998.                                        */
+/* ----------------------------------------------------------------------------------------------- */
+ #include <libakrypt-internal.h>
 
-/*----------------------------------------------------------------
- *  FUNCTIONS FOR POLYNOMIAL MULTIPLYING, MODing, MulMODing
- -----------------------------------------------------------------*/
-ak_uint32 polyMul(ak_uint32 A, ak_uint32 B){
-    ak_uint32 t=0;
-    while (A)
-    {
-        if (A&1) t^=B;
-        B <<= 1;
-        A >>= 1;
-    }
-    return t;
-}
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Таблицы перестановок полубайтов t0, ..., t3, определяющие подстановки q0 и q1. */
+ static const ak_uint8 twofish_qt[2][4][16] = {
+  {
+    { 0x8, 0x1, 0x7, 0xD, 0x6, 0xF, 0x3, 0x2, 0x0, 0xB, 0x5, 0x9, 0xE, 0xC, 0xA, 0x4 },
+    { 0xE, 0xC, 0xB, 0x8, 0x1, 0x2, 0x3, 0x5, 0xF, 0x4, 0xA, 0x6, 0x7, 0x0, 0x9, 0xD },
+    { 0xB, 0xA, 0x5, 0xE, 0x6, 0xD, 0x9, 0x0, 0xC, 0x8, 0xF, 0x3, 0x2, 0x4, 0x7, 0x1 },
+    { 0xD, 0x7, 0xF, 0x4, 0x1, 0x2, 0x6, 0xE, 0x9, 0xB, 0x3, 0x0, 0x8, 0x5, 0xC, 0xA }
+  },
+  {
+    { 0x2, 0x8, 0xB, 0xD, 0xF, 0x7, 0x6, 0xE, 0x3, 0x1, 0x9, 0x4, 0x0, 0xA, 0xC, 0x5 },
+    { 0x1, 0xE, 0x2, 0xB, 0x4, 0xC, 0x3, 0x7, 0x6, 0xD, 0xA, 0x5, 0xF, 0x9, 0x0, 0x8 },
+    { 0x4, 0xC, 0x7, 0x5, 0x1, 0x6, 0x9, 0xA, 0x0, 0xE, 0xD, 0x8, 0x2, 0xB, 0x3, 0xF },
+    { 0xB, 0x9, 0x5, 0x1, 0xC, 0x3, 0xD, 0xE, 0x6, 0x4, 0x7, 0xF, 0x2, 0x0, 0x8, 0xA }
+  }
+ };
+
+/*! \brief Матрица MDS (умножение выполняется в поле с многочленом \f$ x^8+x^6+x^5+x^3+1 \f$). */
+ static const ak_uint8 twofish_mds[4][4] = {
+    { 0x01, 0xEF, 0x5B, 0x5B },
+    { 0x5B, 0xEF, 0xEF, 0x01 },
+    { 0xEF, 0x5B, 0x01, 0xEF },
+    { 0xEF, 0x01, 0xEF, 0x5B }
+ };
+
+/*! \brief Матрица кода Рида-Соломона (умножение выполняется в поле
+    с многочленом \f$ x^8+x^6+x^3+x^2+1 \f$). */
+ static const ak_uint8 twofish_rs[4][8] = {
+    { 0x01, 0xA4, 0x55, 0x87, 0x5A, 0x58, 0xDB, 0x9E },
+    { 0xA4, 0x56, 0x82, 0xF3, 0x1E, 0xC6, 0x68, 0xE5 },
+    { 0x02, 0xA1, 0xFC, 0xC1, 0x47, 0xAE, 0x3D, 0x19 },
+    { 0xA4, 0x55, 0x87, 0x5A, 0x58, 0xDB, 0x9E, 0x03 }
+ };
 
-ak_uint32 gfMOD(ak_uint32 A, ak_uint32 modulus){
-    ak_uint32 tt;
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Структура для хранения развернутых ключей алгоритма TwoFish. */
+ struct twofish_expanded_keys {
+  /*! \brief Ключи забеливания (с 0 по 7) и раундовые ключи (с 8 по 39). */
+   ak_uint32 k[40];
+  /*! \brief Ключезависимые подстановки, объединенные с умножением на столбцы матрицы MDS. */
+   ak_uint32 s[4][256];
+ };
 
-    modulus <<= 7;
-    for (int i = 0; i < 8; i++)
-    {
-        tt = A ^ modulus;
-        if (tt < A) A = tt;
-        modulus >>= 1;
-    }
-    return A;
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Умножение элементов поля \f$ GF(2^8) \f$, заданного многочленом poly. */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_uint8 ak_twofish_mul( ak_uint8 a, ak_uint8 b, ak_uint32 poly )
+{
+  ak_uint32 x = a, z = 0;
+
+  while( b ) {
+    if( b&1 ) z ^= x;
+    x <<= 1; if( x&0x100 ) x ^= poly;
+    b >>= 1;
+  }
+ return ( ak_uint8 )z;
 }
 
-#define     gfMul(a, b, modulus)    gfMOD(polyMul(a, b), modulus)
-/*----------------------------------------------------------------
- *             TwoFish - IN-ROUND FUNCTIONS
- -----------------------------------------------------------------*/
-ak_uint8 q(ak_uint8 x, int op){
-    assert( (op == 0) || (op == 1));
-    //splitting ak_uint8 into two nibbles
-    ak_uint8 a0 = x / 16;
-    ak_uint8 b0 = x % 16;
-
-    ak_uint8 a1 = a0 ^ b0;
-    ak_uint8 b1 = a0 ^ ROR4(b0) ^ ((8 * a0) % 16); //ROR4
-
-    ak_uint8 a2 = qt[op][0][a1];
-    ak_uint8 b2 = qt[op][1][b1];
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Вычисление значения подстановки q0 (n = 0) или q1 (n = 1). */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_uint8 ak_twofish_q( ak_uint8 x, int n )
+{
+  ak_uint8 a = x >> 4, b = x&0x0f, c;
 
-    ak_uint8 a3 = a2 ^ b2;
-    ak_uint8 b3 = a2 ^ ROR4(b2) ^ ((8 * a2) % 16);  //ROR4
-    ak_uint8 a4 = qt[op][2][a3];
-    ak_uint8 b4 = qt[op][3][b3];
+  c = a^b; b = a^(( b >> 1 | b << 3 )&0x0f )^(( a << 3 )&0x0f ); a = c;
+  a = twofish_qt[n][0][a]; b = twofish_qt[n][1][b];
+  c = a^b; b = a^(( b >> 1 | b << 3 )&0x0f )^(( a << 3 )&0x0f ); a = c;
+  a = twofish_qt[n][2][a]; b = twofish_qt[n][3][b];
 
-    return (16*b4 + a4);
+ return ( ak_uint8 )( b << 4 | a );
 }
 
-ak_uint32 g(ak_uint32 X, ak_uint32 S[2]){
-    ak_uint8 x0, x1, x2, x3;
-    x0 = ak_b0(X);
-    x1 = ak_b1(X);
-    x2 = ak_b2(X);
-    x3 = ak_b3(X);
-
-    x0 = q(q(q(x0,0)^ak_b0(S[0]), 0)^ak_b0(S[1]), 1);
-    x1 = q(q(q(x1,1)^ak_b1(S[0]), 0)^ak_b1(S[1]), 0);
-    x2 = q(q(q(x2,0)^ak_b2(S[0]), 1)^ak_b2(S[1]), 1);
-    x3 = q(q(q(x3,1)^ak_b3(S[0]), 1)^ak_b3(S[1]), 0);
-
-    ak_uint8 x[4] = {x1, x2, x3, x0};
-
-    ak_uint8 t;
-    ak_uint8 result[4];
-
-    for (int j = 0; j < 4; j++)
-    {
-        t = 0;
-        for (int k = 0; k < 4; k++)
-        {
-            t ^= gfMul(MDS[j][k], x[k], 0x169);
-        }
-        result[3-j] = t;
-    }
-    return ak_auint8_to_uint32(result);
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Нелинейная часть функции h: преобразование четырех байт y с использованием
+    подстановок q и ключевых слов l[0], ..., l[3] (длина ключа 256 бит). */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_twofish_h_bytes( ak_uint8 q[2][256], ak_uint8 *y, const ak_uint32 *l )
+{
+ #define ak_twofish_lb( w, j ) (( ak_uint8 )(( w ) >> ( 8*( j ))))
+  y[0] = q[1][y[0]]^ak_twofish_lb( l[3], 0 ); y[1] = q[0][y[1]]^ak_twofish_lb( l[3], 1 );
+  y[2] = q[0][y[2]]^ak_twofish_lb( l[3], 2 ); y[3] = q[1][y[3]]^ak_twofish_lb( l[3], 3 );
+
+  y[0] = q[1][y[0]]^ak_twofish_lb( l[2], 0 ); y[1] = q[1][y[1]]^ak_twofish_lb( l[2], 1 );
+  y[2] = q[0][y[2]]^ak_twofish_lb( l[2], 2 ); y[3] = q[0][y[3]]^ak_twofish_lb( l[2], 3 );
+
+  y[0] = q[1][ q[0][ q[0][y[0]]^ak_twofish_lb( l[1], 0 )]^ak_twofish_lb( l[0], 0 )];
+  y[1] = q[0][ q[0][ q[1][y[1]]^ak_twofish_lb( l[1], 1 )]^ak_twofish_lb( l[0], 1 )];
+  y[2] = q[1][ q[1][ q[0][y[2]]^ak_twofish_lb( l[1], 2 )]^ak_twofish_lb( l[0], 2 )];
+  y[3] = q[0][ q[1][ q[1][y[3]]^ak_twofish_lb( l[1], 3 )]^ak_twofish_lb( l[0], 3 )];
+ #undef ak_twofish_lb
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Умножение j-го столбца матрицы MDS на байт y. */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_uint32 ak_twofish_mds_column( int j, ak_uint8 y )
+{
+  return ( ak_uint32 )ak_twofish_mul( twofish_mds[0][j], y, 0x169 ) |
+         ( ak_uint32 )ak_twofish_mul( twofish_mds[1][j], y, 0x169 ) << 8 |
+         ( ak_uint32 )ak_twofish_mul( twofish_mds[2][j], y, 0x169 ) << 16 |
+         ( ak_uint32 )ak_twofish_mul( twofish_mds[3][j], y, 0x169 ) << 24;
+}
 
-/*----------------------------------------------------------------
- *             TwoFish - ROUND FUNCTIONS
- -----------------------------------------------------------------*/
-void ROUNDENCRYPT(ak_uint32 R[4], int round, ak_key_shedule keys){
-    ak_uint32 T0, T1;
-    T0 = g(R[0], keys.Skey);
-    T1 = g(ROL(R[1], 8), keys.Skey);
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция h алгоритма TwoFish. */
+/* ----------------------------------------------------------------------------------------------- */
+ static ak_uint32 ak_twofish_h( ak_uint8 q[2][256], ak_uint32 x, const ak_uint32 *l )
+{
+  int j;
+  ak_uint32 z = 0;
+  ak_uint8 y[4] = { ( ak_uint8 )x, ( ak_uint8 )( x >> 8 ),
+                                                   ( ak_uint8 )( x >> 16 ), ( ak_uint8 )( x >> 24 )};
+  ak_twofish_h_bytes( q, y, l );
+  for( j = 0; j < 4; j++ ) z ^= ak_twofish_mds_column( j, y[j] );
+ return z;
+}
 
-    R[2] = R[0];
-    R[3] = R[1];
-    //adding keys from keyShedule
-    R[0] = ROR(R[2] ^ (T1 + T0 + keys.Kkey[2*round + 8]), 1);
-    R[1] = ROL(R[3], 1) ^ (2*T1 + T0 + keys.Kkey[2*round + 9]);
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция освобождает память, занимаемую развернутыми ключами алгоритма TwoFish.
 
+    @param skey Указатель на контекст секретного ключа.
+    @return В случае успеха функция возвращает \ref ak_error_ok. В противном случае,
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_twofish_delete_keys( ak_skey skey )
+{
+  int error = ak_error_ok;
+
+ /* выполняем стандартные проверки */
+  if( skey == NULL ) return ak_error_message( ak_error_null_pointer,
+                                                 __func__ , "using a null pointer to secret key" );
+  if( skey->data != NULL ) {
+   /* теперь очистка и освобождение памяти */
+    if(( error = ak_ptr_wipe( skey->data, sizeof( struct twofish_expanded_keys ),
+                                                             &skey->generator )) != ak_error_ok ) {
+      ak_error_message( error, __func__, "incorrect wiping an internal data" );
+      memset( skey->data, 0, sizeof( struct twofish_expanded_keys ));
+    }
+    ak_skey_free_data( skey->data );
+    skey->data = NULL;
+  }
+ return error;
 }
 
-void ROUNDDECRYPT(ak_uint32 R[4], int round, ak_key_shedule keys){
-    ak_uint32 T0, T1;
-    T0 = g(R[0], keys.Skey);
-    T1 = g(ROL(R[1], 8), keys.Skey);
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует развертку ключей для алгоритма TwoFish.
+
+    Помимо раундовых ключей вырабатываются четыре таблицы, каждая из которых содержит
+    значения ключезависимой подстановки для одного байта аргумента функции g, умноженные
+    на соответствующий столбец матрицы MDS. Это позволяет вычислять функцию g с помощью
+    четырех обращений к памяти вместо многократного вычисления подстановок q0, q1 и
+    умножений в конечном поле.
 
-    R[2] = R[0];
-    R[3] = R[1];
-    //adding keys from keyShedule
-    R[0] = ROL(R[2], 1) ^ (T1 + T0 + keys.Kkey[2*round + 8]);
-    R[1] = ROR(R[3] ^ (2*T1 + T0 + keys.Kkey[2*round + 9]), 1);
+    @param skey Указатель на контекст секретного ключа.
+    @return В случае успеха функция возвращает \ref ak_error_ok. В противном случае,
+    возвращается код ошибки.                                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_twofish_schedule_keys( ak_skey skey )
+{
+  int i, j, x;
+  ak_uint8 m[32], q[2][256], y[4];
+  ak_uint32 me[4], mo[4], sv[4], a, b;
+  struct twofish_expanded_keys *ekey = NULL;
+
+ /* выполняем стандартные проверки */
+  if( skey == NULL ) return ak_error_message( ak_error_null_pointer, __func__ ,
+                                                            "using a null pointer to secret key" );
+  if( skey->key_size != 32 ) return ak_error_message( ak_error_wrong_length, __func__ ,
+                                                              "unsupported length of secret key" );
+ /* проверяем целостность ключа */
+  if( skey->check_icode( skey ) != ak_true ) return ak_error_message( ak_error_wrong_key_icode,
+                                                __func__ , "using key with wrong integrity code" );
+ /* удаляем былое */
+  if( skey->data != NULL ) ak_twofish_delete_keys( skey );
+
+ /* далее, по-возможности, выделяем выравненную память */
+  if(( skey->data = ak_skey_alloc_data( skey, sizeof( struct twofish_expanded_keys ))) == NULL )
+    return ak_error_message( ak_error_out_of_memory, __func__ ,
+                                                             "wrong allocation of internal data" );
+  ekey = ( struct twofish_expanded_keys *)skey->data;
+
+ /* подстановки q0 и q1 */
+  for( x = 0; x < 256; x++ ) {
+     q[0][x] = ak_twofish_q( ( ak_uint8 )x, 0 );
+     q[1][x] = ak_twofish_q( ( ak_uint8 )x, 1 );
+  }
+
+ /* снимаем маску с ключа и формируем векторы Me, Mo и S */
+  for( i = 0; i < 32; i++ ) m[i] = skey->key[i]^skey->key[32+i];
+  for( i = 0; i < 4; i++ ) {
+     me[i] = ( ak_uint32 )m[8*i] | ( ak_uint32 )m[8*i+1] << 8 |
+                                  ( ak_uint32 )m[8*i+2] << 16 | ( ak_uint32 )m[8*i+3] << 24;
+     mo[i] = ( ak_uint32 )m[8*i+4] | ( ak_uint32 )m[8*i+5] << 8 |
+                                  ( ak_uint32 )m[8*i+6] << 16 | ( ak_uint32 )m[8*i+7] << 24;
+     sv[3-i] = 0;
+     for( j = 0; j < 4; j++ ) {
+        ak_uint8 t = 0;
+        for( x = 0; x < 8; x++ ) t ^= ak_twofish_mul( twofish_rs[j][x], m[8*i+x], 0x14d );
+        sv[3-i] |= ( ak_uint32 )t << ( 8*j );
+     }
+  }
+
+ /* вырабатываем ключи забеливания и раундовые ключи */
+  for( i = 0; i < 20; i++ ) {
+     a = ak_twofish_h( q, ( ak_uint32 )( 2*i )*0x01010101, me );
+     b = ak_twofish_h( q, ( ak_uint32 )( 2*i+1 )*0x01010101, mo );
+     b = b << 8 | b >> 24;
+     ekey->k[2*i] = a + b;
+     a += 2*b;
+     ekey->k[2*i+1] = a << 9 | a >> 23;
+  }
+
+ /* вырабатываем ключезависимые таблицы */
+  for( x = 0; x < 256; x++ ) {
+     y[0] = y[1] = y[2] = y[3] = ( ak_uint8 )x;
+     ak_twofish_h_bytes( q, y, sv );
+     for( j = 0; j < 4; j++ ) ekey->s[j][x] = ak_twofish_mds_column( j, y[j] );
+  }
+
+ /* удаляем промежуточные значения */
+  ak_ptr_wipe( m, sizeof( m ), &skey->generator );
+  ak_ptr_wipe( me, sizeof( me ), &skey->generator );
+  ak_ptr_wipe( mo, sizeof( mo ), &skey->generator );
+  ak_ptr_wipe( sv, sizeof( sv ), &skey->generator );
+  ak_ptr_wipe( y, sizeof( y ), &skey->generator );
+
+ return ak_error_ok;
 }
 
-void ak_twofish_encrypt(const ak_uint32 plain[4], ak_key_shedule keys, ak_uint32 R[4]){
-    R[0] = plain[0]^keys.Kkey[0];
-    R[1] = plain[1]^keys.Kkey[1];
-    R[2] = plain[2]^keys.Kkey[2];
-    R[3] = plain[3]^keys.Kkey[3];
+/* ----------------------------------------------------------------------------------------------- */
+/*                             зашифрование и расшифрование блоков                                 */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Чтение и запись 32-х битного слова блока (слова блока хранятся в порядке little endian). */
+#ifdef AK_LITTLE_ENDIAN
+ #define ak_twofish_load( p, i ) ((( ak_uint32 *)( p ))[i] )
+ #define ak_twofish_store( p, i, v ) ((( ak_uint32 *)( p ))[i] = ( v ))
+#else
+ #define ak_twofish_load( p, i ) ( bswap_32((( ak_uint32 *)( p ))[i] ))
+ #define ak_twofish_store( p, i, v ) ((( ak_uint32 *)( p ))[i] = bswap_32( v ))
+#endif
+
+/*! \brief Функция g, вычисляемая с помощью ключезависимых таблиц, для аргумента x
+    и для аргумента, циклически сдвинутого на 8 бит влево. */
+ #define ak_twofish_g0( x ) ( s[0][( x )&0xff]^s[1][( x ) >> 8&0xff]^\
+                                                         s[2][( x ) >> 16&0xff]^s[3][( x ) >> 24] )
+ #define ak_twofish_g1( x ) ( s[0][( x ) >> 24]^s[1][( x )&0xff]^\
+                                                          s[2][( x ) >> 8&0xff]^s[3][( x ) >> 16&0xff] )
+
+/*! \brief Раунд зашифрования: слова x0, x1 определяют значение функции F,
+    которое накладывается на слова x2, x3; n - номер первого используемого раундового ключа. */
+ #define ak_twofish_encrypt_round( x0, x1, x2, x3, t0, t1, n ) {\
+   t0 = ak_twofish_g0( x0 ); t1 = ak_twofish_g1( x1 );\
+   x2 ^= t0 + t1 + k[n]; x2 = x2 >> 1 | x2 << 31;\
+   x3 = ( x3 << 1 | x3 >> 31 )^( t0 + 2*t1 + k[n+1] );\
+ }
+
+/*! \brief Раунд расшифрования, обратный раунду ak_twofish_encrypt_round. */
+ #define ak_twofish_decrypt_round( x0, x1, x2, x3, t0, t1, n ) {\
+   t0 = ak_twofish_g0( x0 ); t1 = ak_twofish_g1( x1 );\
+   x3 ^= t0 + 2*t1 + k[n+1]; x3 = x3 >> 1 | x3 << 31;\
+   x2 = ( x2 << 1 | x2 >> 31 )^( t0 + t1 + k[n] );\
+ }
 
-    for(int i=0; i<16; i++){
-        ROUNDENCRYPT(R, i, keys);
-    }
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования одного блока информации алгоритмом TwoFish.
 
-    R[0] = R[0]^keys.Kkey[4];
-    R[1] = R[1]^keys.Kkey[5];
-    R[2] = R[2]^keys.Kkey[6];
-    R[3] = R[3]^keys.Kkey[7];
+    @param skey Контекст секретного ключа.
+    @param in Блок входной информации (открытый текст).
+    @param out Блок выходной информации (шифртекст).                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_twofish_encrypt( ak_skey skey, ak_pointer in, ak_pointer out )
+{
+  int n;
+  ak_uint32 x0, x1, x2, x3, t0, t1;
+  ak_uint32 *k = (( struct twofish_expanded_keys *)skey->data )->k;
+  ak_uint32 (*s)[256] = (( struct twofish_expanded_keys *)skey->data )->s;
+
+  x0 = ak_twofish_load( in, 0 )^k[0]; x1 = ak_twofish_load( in, 1 )^k[1];
+  x2 = ak_twofish_load( in, 2 )^k[2]; x3 = ak_twofish_load( in, 3 )^k[3];
+  for( n = 8; n < 40; n += 4 ) {
+     ak_twofish_encrypt_round( x0, x1, x2, x3, t0, t1, n );
+     ak_twofish_encrypt_round( x2, x3, x0, x1, t0, t1, n+2 );
+  }
+  ak_twofish_store( out, 0, x2^k[4] ); ak_twofish_store( out, 1, x3^k[5] );
+  ak_twofish_store( out, 2, x0^k[6] ); ak_twofish_store( out, 3, x1^k[7] );
 }
 
-void ak_twofish_decrypt(const ak_uint32 chipher[4], ak_key_shedule keys, ak_uint32 R[4]){
-    R[0] = chipher[0]^keys.Kkey[4];
-    R[1] = chipher[1]^keys.Kkey[5];
-    R[2] = chipher[2]^keys.Kkey[6];
-    R[3] = chipher[3]^keys.Kkey[7];
-
-    for(int i=15; i>=0; i--){
-        ROUNDDECRYPT(R, i, keys);
-    }
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования одного блока информации алгоритмом TwoFish.
 
-    R[0] = R[0]^keys.Kkey[0];
-    R[1] = R[1]^keys.Kkey[1];
-    R[2] = R[2]^keys.Kkey[2];
-    R[3] = R[3]^keys.Kkey[3];
+    @param skey Контекст секретного ключа.
+    @param in Блок входной информации (шифртекст).
+    @param out Блок выходной информации (открытый текст).                                          */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_twofish_decrypt( ak_skey skey, ak_pointer in, ak_pointer out )
+{
+  int n;
+  ak_uint32 x0, x1, x2, x3, t0, t1;
+  ak_uint32 *k = (( struct twofish_expanded_keys *)skey->data )->k;
+  ak_uint32 (*s)[256] = (( struct twofish_expanded_keys *)skey->data )->s;
+
+  x2 = ak_twofish_load( in, 0 )^k[4]; x3 = ak_twofish_load( in, 1 )^k[5];
+  x0 = ak_twofish_load( in, 2 )^k[6]; x1 = ak_twofish_load( in, 3 )^k[7];
+  for( n = 36; n >= 8; n -= 4 ) {
+     ak_twofish_decrypt_round( x2, x3, x0, x1, t0, t1, n+2 );
+     ak_twofish_decrypt_round( x0, x1, x2, x3, t0, t1, n );
+  }
+  ak_twofish_store( out, 0, x0^k[0] ); ak_twofish_store( out, 1, x1^k[1] );
+  ak_twofish_store( out, 2, x2^k[2] ); ak_twofish_store( out, 3, x3^k[3] );
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифрования последовательности независимых блоков алгоритмом TwoFish.
 
+    Блоки обрабатываются парами: вычисления для двух блоков образуют независимые цепочки,
+    что позволяет процессору совмещать задержки обращений к таблицам.
 
-/*----------------------------------------------------------------
- *             TwoFish - MATRIX-MUL FUNCTIONS
- -----------------------------------------------------------------*/
-ak_uint32 RSM(ak_uint8 sd[8])
+    @param skey Контекст секретного ключа.
+    @param in Указатель на последовательность блоков открытого текста.
+    @param out Указатель на область памяти для шифртекста (может совпадать с in).
+    @param blocks Количество блоков.                                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_twofish_encrypt_blocks( ak_skey skey, ak_pointer in, ak_pointer out, size_t blocks )
 {
-    int j, k;
-    ak_uint8 t;
-    ak_uint8 result[4];
-
-    for (j = 0; j < 4; j++)
-    {
-        t = 0;
-        for (k = 0; k < 8; k++)
-        {
-            t ^= gfMul(RSMatrix[j][k], sd[k], 0x14D);
-        }
-        result[3-j] = t;
-    }
-    return ak_auint8_to_uint32(result);
+  int n;
+  ak_uint8 *inptr = ( ak_uint8 *)in, *outptr = ( ak_uint8 *)out;
+  ak_uint32 a0, a1, a2, a3, b0, b1, b2, b3, ta0, ta1, tb0, tb1;
+  ak_uint32 *k = (( struct twofish_expanded_keys *)skey->data )->k;
+  ak_uint32 (*s)[256] = (( struct twofish_expanded_keys *)skey->data )->s;
+
+  for( ; blocks > 1; blocks -= 2, inptr += 32, outptr += 32 ) {
+     a0 = ak_twofish_load( inptr, 0 )^k[0]; a1 = ak_twofish_load( inptr, 1 )^k[1];
+     a2 = ak_twofish_load( inptr, 2 )^k[2]; a3 = ak_twofish_load( inptr, 3 )^k[3];
+     b0 = ak_twofish_load( inptr, 4 )^k[0]; b1 = ak_twofish_load( inptr, 5 )^k[1];
+     b2 = ak_twofish_load( inptr, 6 )^k[2]; b3 = ak_twofish_load( inptr, 7 )^k[3];
+     for( n = 8; n < 40; n += 4 ) {
+        ak_twofish_encrypt_round( a0, a1, a2, a3, ta0, ta1, n );
+        ak_twofish_encrypt_round( b0, b1, b2, b3, tb0, tb1, n );
+        ak_twofish_encrypt_round( a2, a3, a0, a1, ta0, ta1, n+2 );
+        ak_twofish_encrypt_round( b2, b3, b0, b1, tb0, tb1, n+2 );
+     }
+     ak_twofish_store( outptr, 0, a2^k[4] ); ak_twofish_store( outptr, 1, a3^k[5] );
+     ak_twofish_store( outptr, 2, a0^k[6] ); ak_twofish_store( outptr, 3, a1^k[7] );
+     ak_twofish_store( outptr, 4, b2^k[4] ); ak_twofish_store( outptr, 5, b3^k[5] );
+     ak_twofish_store( outptr, 6, b0^k[6] ); ak_twofish_store( outptr, 7, b1^k[7] );
+  }
+  if( blocks ) ak_twofish_encrypt( skey, inptr, outptr );
 }
 
-/*----------------------------------------------------------------
- *             TwoFish - KEY-GEN FUNCTIONS
- -----------------------------------------------------------------*/
-void pushSkeys(const ak_uint8 globalkey[16], ak_key_shedule key){
-    ak_uint8 m07[8] = {globalkey[0], globalkey[1], globalkey[2], globalkey[3],
-                   globalkey[4], globalkey[5], globalkey[6], globalkey[7]};
-    ak_uint8 m816[8] = {globalkey[8], globalkey[9], globalkey[10], globalkey[11],
-                    globalkey[12], globalkey[13], globalkey[14], globalkey[15]};
-    ak_uint32 S0 = RSM(m07);
-    ak_uint32 S1 = RSM(m816);
-
-    for(int i = 0; i < 2; i++){
-        key.Skey[i] = (i==0) ? S0 : S1;
-    }
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция расшифрования последовательности независимых блоков алгоритмом TwoFish
+    (блоки обрабатываются парами).
+
+    @param skey Контекст секретного ключа.
+    @param in Указатель на последовательность блоков шифртекста.
+    @param out Указатель на область памяти для открытого текста (может совпадать с in).
+    @param blocks Количество блоков.                                                               */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_twofish_decrypt_blocks( ak_skey skey, ak_pointer in, ak_pointer out, size_t blocks )
+{
+  int n;
+  ak_uint8 *inptr = ( ak_uint8 *)in, *outptr = ( ak_uint8 *)out;
+  ak_uint32 a0, a1, a2, a3, b0, b1, b2, b3, ta0, ta1, tb0, tb1;
+  ak_uint32 *k = (( struct twofish_expanded_keys *)skey->data )->k;
+  ak_uint32 (*s)[256] = (( struct twofish_expanded_keys *)skey->data )->s;
+
+  for( ; blocks > 1; blocks -= 2, inptr += 32, outptr += 32 ) {
+     a2 = ak_twofish_load( inptr, 0 )^k[4]; a3 = ak_twofish_load( inptr, 1 )^k[5];
+     a0 = ak_twofish_load( inptr, 2 )^k[6]; a1 = ak_twofish_load( inptr, 3 )^k[7];
+     b2 = ak_twofish_load( inptr, 4 )^k[4]; b3 = ak_twofish_load( inptr, 5 )^k[5];
+     b0 = ak_twofish_load( inptr, 6 )^k[6]; b1 = ak_twofish_load( inptr, 7 )^k[7];
+     for( n = 36; n >= 8; n -= 4 ) {
+        ak_twofish_decrypt_round( a2, a3, a0, a1, ta0, ta1, n+2 );
+        ak_twofish_decrypt_round( b2, b3, b0, b1, tb0, tb1, n+2 );
+        ak_twofish_decrypt_round( a0, a1, a2, a3, ta0, ta1, n );
+        ak_twofish_decrypt_round( b0, b1, b2, b3, tb0, tb1, n );
+     }
+     ak_twofish_store( outptr, 0, a0^k[0] ); ak_twofish_store( outptr, 1, a1^k[1] );
+     ak_twofish_store( outptr, 2, a2^k[2] ); ak_twofish_store( outptr, 3, a3^k[3] );
+     ak_twofish_store( outptr, 4, b0^k[0] ); ak_twofish_store( outptr, 5, b1^k[1] );
+     ak_twofish_store( outptr, 6, b2^k[2] ); ak_twofish_store( outptr, 7, b3^k[3] );
+  }
+  if( blocks ) ak_twofish_decrypt( skey, inptr, outptr );
 }
 
-void pushKkeys(const ak_uint8 M[16], ak_key_shedule key){
-
-    ak_uint32 Me[2] = {ak_uint8_to_uint32(M[8], M[9], M[10], M[11]),
-                  ak_uint8_to_uint32(M[0], M[1], M[2], M[3])};
-    ak_uint32 Mo[2] = {ak_uint8_to_uint32(M[12], M[13], M[14], M[15]),
-                  ak_uint8_to_uint32(M[4], M[5], M[6], M[7])};
-//H
-    for(int i=0; i < 20; i++){
-        ak_uint32 K2i, K2i1;
-        K2i = g(2*i*RHO, Me);
-        K2i1 = ROL(g(2*i*RHO + RHO, Mo), 8);
-        key.Kkey[2*i] = K2i + K2i1;
-        key.Kkey[2*i + 1] = ROL(K2i + 2*K2i1, 9);
-    }
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция инициализирует контекст ключа алгоритма блочного шифрования TwoFish
+    (длина блока 128 бит, длина ключа 256 бит). После инициализации устанавливаются
+    обработчики (функции класса). Однако само значение ключу не присваивается -
+    поле `bkey->key` остается неопределенным.
+
+    \note Развернутые ключи и ключезависимые таблицы хранятся в памяти в незамаскированном виде.
+
+    @param bkey Контекст секретного ключа алгоритма блочного шифрования.
+    @return Функция возвращает код ошибки. В случаее успеха возвращается \ref ak_error_ok.         */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_create_twofish( ak_bckey bkey )
+{
+  int error = ak_error_ok;
+
+  if( bkey == NULL ) return ak_error_message( ak_error_null_pointer, __func__,
+                                               "using null pointer to block cipher key context" );
+
+ /* создаем ключ алгоритма шифрования и определяем его методы */
+  if(( error = ak_bckey_create( bkey, 32, 16 )) != ak_error_ok )
+    return ak_error_message( error, __func__, "wrong initalization of block cipher key context" );
+
+ /* устанавливаем OID алгоритма шифрования */
+  if(( bkey->key.oid = ak_oid_find_by_name( "twofish" )) == NULL ) {
+    error = ak_error_get_value();
+    ak_error_message( error, __func__, "wrong search of predefined twofish block cipher OID" );
+    ak_bckey_destroy( bkey );
+    return error;
+  }
+
+ /* ресурс ключа устанавливается в момент присвоения ключа */
+
+ /* устанавливаем методы */
+  bkey->schedule_keys = ak_twofish_schedule_keys;
+  bkey->delete_keys = ak_twofish_delete_keys;
+  bkey->encrypt = ak_twofish_encrypt;
+  bkey->decrypt = ak_twofish_decrypt;
+  bkey->encrypt_blocks = ak_twofish_encrypt_blocks;
+  bkey->decrypt_blocks = ak_twofish_decrypt_blocks;
+
+ return error;
 }
 
-void ak_create_key_shedule(const ak_uint8 M[16], ak_key_shedule key){
-    pushSkeys(&M[16], key);
-    pushKkeys(&M[16], key);
+/* ----------------------------------------------------------------------------------------------- */
+/*                                      функции тестирования                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ bool_t ak_libakrypt_test_twofish( void )
+{
+ /* тестовые примеры для ключа длины 256 бит из описания алгоритма TwoFish */
+  ak_uint8 key1[32] = {
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+  };
+  ak_uint8 key2[32] = {
+     0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef, 0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10,
+     0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+  };
+  ak_uint8 in[16] = {
+     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+  };
+  ak_uint8 out1[16] = {
+     0x57, 0xff, 0x73, 0x9d, 0x4d, 0xc9, 0x2c, 0x1b, 0xd7, 0xfc, 0x01, 0x70, 0x0c, 0xc8, 0x21, 0x6f
+  };
+  ak_uint8 out2[16] = {
+     0x37, 0x52, 0x7b, 0xe0, 0x05, 0x23, 0x34, 0xb8, 0x9f, 0x0c, 0xfc, 0xca, 0xe8, 0x7c, 0xfa, 0x20
+  };
+
+  size_t i = 0;
+  struct bckey bkey;
+  bool_t result = ak_true;
+  ak_uint8 myout[16], mbin[35*16], mbout[35*16], mbdec[35*16];
+  int error = ak_error_ok, audit = ak_log_get_level();
+
+ /* 1. Создаем контекст ключа алгоритма TwoFish и проверяем тестовые примеры */
+  if(( error = ak_bckey_create_twofish( &bkey )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "incorrect initialization of twofish secret key context");
+    return ak_false;
+  }
+
+  if(( error = ak_bckey_set_key( &bkey, key1, sizeof( key1 ))) != ak_error_ok ) {
+    ak_error_message( error, __func__, "wrong creation of test key" );
+    result = ak_false;
+    goto exit;
+  }
+  bkey.encrypt( &bkey.key, in, myout );
+  if( !ak_ptr_is_equal_with_log( myout, out1, sizeof( out1 ))) {
+    ak_error_message( ak_error_not_equal_data, __func__ ,
+                                          "the one block encryption test with zero key is wrong" );
+    result = ak_false;
+    goto exit;
+  }
+  bkey.decrypt( &bkey.key, out1, myout );
+  if( !ak_ptr_is_equal_with_log( myout, in, sizeof( in ))) {
+    ak_error_message( ak_error_not_equal_data, __func__ ,
+                                          "the one block decryption test with zero key is wrong" );
+    result = ak_false;
+    goto exit;
+  }
+
+  if(( error = ak_bckey_set_key( &bkey, key2, sizeof( key2 ))) != ak_error_ok ) {
+    ak_error_message( error, __func__, "wrong creation of test key" );
+    result = ak_false;
+    goto exit;
+  }
+  bkey.encrypt( &bkey.key, in, myout );
+  if( !ak_ptr_is_equal_with_log( myout, out2, sizeof( out2 ))) {
+    ak_error_message( ak_error_not_equal_data, __func__ , "the one block encryption test is wrong" );
+    result = ak_false;
+    goto exit;
+  }
+  bkey.decrypt( &bkey.key, out2, myout );
+  if( !ak_ptr_is_equal_with_log( myout, in, sizeof( in ))) {
+    ak_error_message( ak_error_not_equal_data, __func__ , "the one block decryption test is wrong" );
+    result = ak_false;
+    goto exit;
+  }
+  if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                                                   "the one block encryption/decryption test is Ok" );
+
+ /* 2. Сравниваем одновременную обработку нескольких блоков с поблочной */
+  for( i = 0; i < sizeof( mbin ); i++ ) mbin[i] = (ak_uint8)( i*i + 0x35 );
+  if(( error = ak_bckey_encrypt_ecb( &bkey, mbin, mbout, sizeof( mbin ))) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong ecb mode encryption" );
+    result = ak_false;
+    goto exit;
+  }
+  if(( error = ak_bckey_decrypt_ecb( &bkey, mbout, mbdec, sizeof( mbout ))) != ak_error_ok ) {
+    ak_error_message( error, __func__ , "wrong ecb mode decryption" );
+    result = ak_false;
+    goto exit;
+  }
+  for( i = 0; i < sizeof( mbin ); i += 16 ) {
+     bkey.encrypt( &bkey.key, mbin+i, myout );
+     if( !ak_ptr_is_equal_with_log( myout, mbout+i, 16 )) {
+       ak_error_message_fmt( ak_error_not_equal_data, __func__ ,
+                      "the multi-block encryption is not equal to single-block one (block %u)",
+                                                                        (unsigned int)( i >> 4 ));
+       result = ak_false;
+       goto exit;
+     }
+  }
+  if( !ak_ptr_is_equal_with_log( mbdec, mbin, sizeof( mbin ))) {
+    ak_error_message( ak_error_not_equal_data, __func__ , "the multi-block decryption is wrong" );
+    result = ak_false;
+    goto exit;
+  }
+  if( audit >= ak_log_maximum ) ak_error_message( ak_error_ok, __func__ ,
+                                              "the multi-block encryption/decryption test is Ok" );
+ /* освобождаем ключ и выходим */
+  exit:
+  if(( error = ak_bckey_destroy( &bkey )) != ak_error_ok ) {
+    ak_error_message( error, __func__, "wrong destroying of secret key" );
+    return ak_false;
+  }
+  if(( result == ak_true ) && ( audit >= ak_log_maximum ))
+    ak_error_message( ak_error_ok, __func__ , "testing of twofish block cipher is Ok" );
+
+ return result;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                                                                                   ak_twofish.c  */
+/* ----------------------------------------------------------------------------------------------- */
@@ -11,6 +11,74 @@
 #ifdef AK_HAVE_STDALIGN_H
  #include <stdalign.h>
 #endif
+#ifdef AK_HAVE_PTHREAD_H
+ #include <pthread.h>
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Количество блоков, обрабатываемых за одну итерацию в режиме XTS (должно быть четным). */
+ #define ak_xts_batch_blocks  (64)
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифровывает (расшифровывает) последовательность блоков в режиме XTS.
+
+    Для очередной группы блоков сначала вырабатываются все необходимые значения tweak
+    (последовательным умножением на примитивный элемент поля \f$ \mathbb F_{2^{128}}\f$),
+    после чего вся группа маскируется, обрабатывается за один вызов многоблочного метода
+    `encrypt_blocks` (`decrypt_blocks`) и маскируется повторно. Если многоблочный метод
+    для алгоритма не определен, блоки обрабатываются по одному.
+
+    Для шифров с длиной блока 64 бита одно 128-ми битное значение tweak маскирует
+    два последовательных блока, поэтому массив значений tweak имеет ту же длину в словах,
+    что и обрабатываемые данные.
+
+    @param bkey Ключ, используемый для шифрования информации.
+    @param tweak Текущее значение tweak (изменяется функцией).
+    @param inptr Указатель на входные данные.
+    @param outptr Указатель на выходные данные.
+    @param blocks Количество блоков.
+    @param encrypt Если значение истинно, то выполняется зашифрование, иначе расшифрование.        */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_xts_process_blocks( ak_bckey bkey, ak_uint64 *tweak,
+                     ak_uint64 *inptr, ak_uint64 *outptr, ak_int64 blocks, const bool_t encrypt )
+{
+  size_t i, count, words, step = bkey->bsize >> 3;
+  ak_uint64 t0, t1, tbuf[2*ak_xts_batch_blocks], buf[2*ak_xts_batch_blocks];
+  ak_function_bckey_blocks *blocksfn = encrypt ? bkey->encrypt_blocks : bkey->decrypt_blocks;
+  ak_function_bckey *blockfn = encrypt ? bkey->encrypt : bkey->decrypt;
+
+  while( blocks > 0 ) {
+    count = ( size_t )ak_min( blocks, ak_xts_batch_blocks );
+    words = count*( bkey->bsize >> 3 );
+
+   /* вырабатываем значения tweak для всей группы блоков */
+    for( i = 0; i < words; i += 2 ) {
+       tbuf[i] = tweak[0]; tbuf[i+1] = tweak[1];
+       t0 = tweak[0] >> 63; t1 = tweak[1] >> 63;
+       tweak[0] <<= 1; tweak[1] <<= 1;
+       tweak[1] ^= t0;
+       if( t1 ) tweak[0] ^= 0x87;
+    }
+
+   /* маскируем, шифруем и снова маскируем */
+    if( blocksfn != NULL ) {
+      for( i = 0; i < words; i++ ) buf[i] = inptr[i]^tbuf[i];
+      blocksfn( &bkey->key, buf, buf, count );
+      for( i = 0; i < words; i++ ) outptr[i] = buf[i]^tbuf[i];
+    } else { /* многоблочная реализация отсутствует: обрабатываем блоки по одному */
+       for( i = 0; i < words; i += step ) {
+          buf[0] = inptr[i]^tbuf[i];
+          if( step == 2 ) buf[1] = inptr[i+1]^tbuf[i+1];
+          blockfn( &bkey->key, buf, buf );
+          outptr[i] = buf[0]^tbuf[i];
+          if( step == 2 ) outptr[i+1] = buf[1]^tbuf[i+1];
+       }
+      }
+
+    inptr += words; outptr += words;
+    blocks -= ( ak_int64 )count;
+  }
+}
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! Функция реализует алгоритм двухключевого шифрования, описываемый в стандарте IEEE P 1619.
@@ -37,26 +105,26 @@
                         ak_pointer in, ak_pointer out, size_t size, ak_pointer iv, size_t iv_size )
 {
   int error = ak_error_ok;
-  ak_int64 jcnt = 0, blocks = 0;
+  ak_int64 blocks = 0;
   ak_uint64 *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
 #ifdef AK_HAVE_STDALIGN_H
   alignas(16)
 #endif
-  ak_uint64 tweak[2], t[2], *tptr = t;
+  ak_uint64 tweak[2];
 
  /* проверяем целостность ключа */
-  if( encryptionKey->key.check_icode( &encryptionKey->key ) != ak_true )
+  if( ak_skey_check_icode( &encryptionKey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode, __func__,
                                                "incorrect integrity code of encryption key value" );
-  if( authenticationKey->key.check_icode( &authenticationKey->key ) != ak_true )
+  if( ak_skey_check_icode( &authenticationKey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode, __func__,
                                            "incorrect integrity code of authentication key value" );
 
  /* проверяем ресурс ключа аутентификации */
-  if( authenticationKey->key.resource.value.counter < (ssize_t)( authenticationKey->bsize >> 3 ))
+  if( ak_skey_reserve_resource( &authenticationKey->key,
+                                        ( ssize_t )( authenticationKey->bsize >> 3 )) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource,
                                               __func__ , "low resource of authentication cipher key" );
-   else authenticationKey->key.resource.value.counter -= ( authenticationKey->bsize >> 3 );
 
  /* вырабатываем начальное состояние вектора */
   memset( tweak, 0, sizeof( tweak ));
@@ -76,61 +144,21 @@
                             __func__ , "the length of input data is not divided by block length" );
 
  /* изменяем ресурс ключа */
-  if( encryptionKey->key.resource.value.counter < blocks )
+  if( ak_skey_reserve_resource( &encryptionKey->key, blocks ) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource,
                                               __func__ , "low resource of encryption cipher key" );
-   else encryptionKey->key.resource.value.counter -= blocks;
 
  /* запускаем основной цикл обработки блоков информации */
-   switch( encryptionKey->bsize ) {
-     case  8: /* шифр с длиной блока 64 бита */
-       while( blocks > 0 ) {
-          *tptr = *inptr^*(tweak+jcnt); inptr++;
-          encryptionKey->encrypt( &encryptionKey->key, tptr, tptr );
-          *outptr = *tptr ^ *(tweak+jcnt); outptr++;
-          --blocks;
-          tptr++;
-
-          if( !(jcnt = 1 - jcnt)) { /* изменяем значение tweak */
-            tptr = t;
-            t[0] = tweak[0] >> 63; t[1] = tweak[1] >> 63;
-            tweak[0] <<= 1; tweak[1] <<= 1;
-            tweak[1] ^= t[0];
-            if( t[1] ) tweak[0] ^= 0x87;
-          }
-       }
-       break;
-
-     case 16: /* шифр с длиной блока 128 бит */
-       while( blocks > 0 ) {
-         /* шифруем */
-          t[0] = *inptr^*tweak; inptr++;
-          t[1] = *inptr^*(tweak+1); inptr++;
-
-          encryptionKey->encrypt( &encryptionKey->key, t, t );
-          *outptr = t[0]^*tweak; outptr++;
-          *outptr = t[1]^*(tweak+1); outptr++;
-          --blocks;
-
-         /* изменяем значение tweak */
-          t[0] = tweak[0] >> 63;
-          t[1] = tweak[1] >> 63;
-          tweak[0] <<= 1;
-          tweak[1] <<= 1;
-          tweak[1] ^= t[0];
-          if( t[1] ) tweak[0] ^= 0x87;
-       }
-       break;
-   }
+  ak_xts_process_blocks( encryptionKey, tweak, inptr, outptr, blocks, ak_true );
 
  /* очищаем */
   if(( error = ak_ptr_wipe( tweak, sizeof( tweak ), &encryptionKey->key.generator )) != ak_error_ok )
    ak_error_message( error, __func__ , "wrong wiping of tweak value" );
 
  /* перемаскируем ключ */
-  if(( error = encryptionKey->key.set_mask( &encryptionKey->key )) != ak_error_ok )
+  if(( error = ak_skey_remask( &encryptionKey->key, size )) != ak_error_ok )
     ak_error_message( error, __func__ , "wrong remasking of encryption key" );
-  if(( error = authenticationKey->key.set_mask( &authenticationKey->key )) != ak_error_ok )
+  if(( error = ak_skey_remask( &authenticationKey->key, size )) != ak_error_ok )
     ak_error_message( error, __func__ , "wrong remasking of authentication key" );
 
   return error;
@@ -172,26 +200,26 @@
                         ak_pointer in, ak_pointer out, size_t size, ak_pointer iv, size_t iv_size )
 {
   int error = ak_error_ok;
-  ak_int64 jcnt = 0, blocks = 0;
+  ak_int64 blocks = 0;
   ak_uint64 *inptr = (ak_uint64 *)in, *outptr = (ak_uint64 *)out;
 #ifdef AK_HAVE_STDALIGN_H
   alignas(16)
 #endif
-  ak_uint64 tweak[2], t[2], *tptr = t;
+  ak_uint64 tweak[2];
 
  /* проверяем целостность ключа */
-  if( encryptionKey->key.check_icode( &encryptionKey->key ) != ak_true )
+  if( ak_skey_check_icode( &encryptionKey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode, __func__,
                                                "incorrect integrity code of encryption key value" );
-  if( authenticationKey->key.check_icode( &authenticationKey->key ) != ak_true )
+  if( ak_skey_check_icode( &authenticationKey->key ) != ak_true )
     return ak_error_message( ak_error_wrong_key_icode, __func__,
                                            "incorrect integrity code of authentication key value" );
 
  /* проверяем ресурс ключа аутентификации */
-  if( authenticationKey->key.resource.value.counter < (ssize_t)( authenticationKey->bsize >> 3 ))
+  if( ak_skey_reserve_resource( &authenticationKey->key,
+                                        ( ssize_t )( authenticationKey->bsize >> 3 )) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource,
                                               __func__ , "low resource of authentication cipher key" );
-   else authenticationKey->key.resource.value.counter -= ( authenticationKey->bsize >> 3 );
 
  /* вырабатываем начальное состояние вектора */
   memset( tweak, 0, sizeof( tweak ));
@@ -211,66 +239,318 @@
                             __func__ , "the length of input data is not divided by block length" );
 
  /* изменяем ресурс ключа */
-  if( encryptionKey->key.resource.value.counter < blocks )
+  if( ak_skey_reserve_resource( &encryptionKey->key, blocks ) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource,
                                               __func__ , "low resource of encryption cipher key" );
-   else encryptionKey->key.resource.value.counter -= blocks;
 
  /* запускаем основной цикл обработки блоков информации */
-   switch( encryptionKey->bsize ) {
-     case  8: /* шифр с длиной блока 64 бита */
-       while( blocks > 0 ) {
-          *tptr = *inptr^*(tweak+jcnt); inptr++;
-          encryptionKey->decrypt( &encryptionKey->key, tptr, tptr );
-          *outptr = *tptr ^ *(tweak+jcnt); outptr++;
-          --blocks;
-          tptr++;
-
-          if( !(jcnt = 1 - jcnt)) { /* изменяем значение tweak */
-            tptr = t;
-            t[0] = tweak[0] >> 63; t[1] = tweak[1] >> 63;
-            tweak[0] <<= 1; tweak[1] <<= 1;
-            tweak[1] ^= t[0];
-            if( t[1] ) tweak[0] ^= 0x87;
-          }
-       }
-       break;
-
-     case 16: /* шифр с длиной блока 128 бит */
-       while( blocks > 0 ) {
-         /* шифруем */
-          t[0] = *inptr^*tweak; inptr++;
-          t[1] = *inptr^*(tweak+1); inptr++;
-
-          encryptionKey->decrypt( &encryptionKey->key, t, t );
-          *outptr = t[0]^*tweak; outptr++;
-          *outptr = t[1]^*(tweak+1); outptr++;
-          --blocks;
-
-         /* изменяем значение tweak */
-          t[0] = tweak[0] >> 63;
-          t[1] = tweak[1] >> 63;
-          tweak[0] <<= 1;
-          tweak[1] <<= 1;
-          tweak[1] ^= t[0];
-          if( t[1] ) tweak[0] ^= 0x87;
-       }
-       break;
-   }
+  ak_xts_process_blocks( encryptionKey, tweak, inptr, outptr, blocks, ak_false );
 
  /* очищаем */
   if(( error = ak_ptr_wipe( tweak, sizeof( tweak ), &encryptionKey->key.generator )) != ak_error_ok )
    ak_error_message( error, __func__ , "wrong wiping of tweak value" );
 
  /* перемаскируем ключ */
-  if(( error = encryptionKey->key.set_mask( &encryptionKey->key )) != ak_error_ok )
+  if(( error = ak_skey_remask( &encryptionKey->key, size )) != ak_error_ok )
     ak_error_message( error, __func__ , "wrong remasking of encryption key" );
-  if(( error = authenticationKey->key.set_mask( &authenticationKey->key )) != ak_error_ok )
+  if(( error = ak_skey_remask( &authenticationKey->key, size )) != ak_error_ok )
     ak_error_message( error, __func__ , "wrong remasking of authentication key" );
 
   return error;
 }
 
+/* ----------------------------------------------------------------------------------------------- */
+/*                 обработка последовательности секторов в режиме xts                              */
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция зашифровывает (расшифровывает) последовательность секторов в режиме XTS,
+    не выполняя проверок ключей и их ресурса.
+
+    Начальные значения tweak вырабатываются группами: номера секторов зашифровываются
+    ключом аутентификации за один вызов функции ak_bckey_encrypt_blocks().
+
+    @param encryptionKey Ключ, используемый для шифрования информации.
+    @param authenticationKey Ключ, используемый для выработки значений tweak.
+    @param in Указатель на входные данные.
+    @param out Указатель на выходные данные.
+    @param sector_size Размер сектора в октетах.
+    @param sector Младшие 64 бита номера первого сектора.
+    @param high Старшие 64 бита номера первого сектора.
+    @param nsectors Количество секторов.
+    @param encrypt Если значение истинно, то выполняется зашифрование, иначе расшифрование.        */
+/* ----------------------------------------------------------------------------------------------- */
+ static void ak_xts_process_sectors( ak_bckey encryptionKey, ak_bckey authenticationKey,
+                               ak_uint8 *in, ak_uint8 *out, size_t sector_size, ak_uint64 sector,
+                                         ak_uint64 high, size_t nsectors, const bool_t encrypt )
+{
+  size_t i, count;
+  ak_uint64 lo, hi;
+  ak_int64 blocks = ( ak_int64 )( sector_size/encryptionKey->bsize );
+#ifdef AK_HAVE_STDALIGN_H
+  alignas(16)
+#endif
+  ak_uint64 tweaks[2*ak_xts_batch_blocks], tweak[2];
+
+  while( nsectors > 0 ) {
+    count = ak_min( nsectors, ak_xts_batch_blocks );
+
+   /* вырабатываем начальные значения tweak для группы секторов:
+      номер сектора записывается как 128-ми битное число в формате little endian,
+      при переполнении младших 64 бит выполняется перенос в старшие 64 бита */
+    if( authenticationKey->bsize == 8 ) {
+      for( i = 0; i < count; i++ ) {
+         lo = sector + i; hi = high + ( lo < sector );
+       #ifdef AK_LITTLE_ENDIAN
+         tweaks[i] = lo; tweaks[count+i] = hi;
+       #else
+         tweaks[i] = bswap_64( lo ); tweaks[count+i] = bswap_64( hi );
+       #endif
+      }
+      ak_bckey_encrypt_blocks( authenticationKey, tweaks, tweaks, count );
+     /* вторая половина tweak равна E( старшая половина номера ^ E( младшая половина номера )) */
+      for( i = 0; i < count; i++ ) tweaks[count+i] ^= tweaks[i];
+      ak_bckey_encrypt_blocks( authenticationKey, tweaks + count, tweaks + count, count );
+    } else {
+       for( i = 0; i < count; i++ ) {
+          lo = sector + i; hi = high + ( lo < sector );
+        #ifdef AK_LITTLE_ENDIAN
+          tweaks[2*i] = lo; tweaks[2*i+1] = hi;
+        #else
+          tweaks[2*i] = bswap_64( lo ); tweaks[2*i+1] = bswap_64( hi );
+        #endif
+       }
+       ak_bckey_encrypt_blocks( authenticationKey, tweaks, tweaks, count );
+      }
+
+   /* обрабатываем сектора */
+    for( i = 0; i < count; i++ ) {
+       if( authenticationKey->bsize == 8 ) {
+         tweak[0] = tweaks[i]; tweak[1] = tweaks[count+i];
+       } else {
+          tweak[0] = tweaks[2*i]; tweak[1] = tweaks[2*i+1];
+         }
+       ak_xts_process_blocks( encryptionKey, tweak,
+                                        (ak_uint64 *)in, (ak_uint64 *)out, blocks, encrypt );
+       in += sector_size; out += sector_size;
+    }
+    lo = sector + count;
+    if( lo < sector ) high++;
+    sector = lo; nsectors -= count;
+  }
+  memset( tweak, 0, sizeof( tweak ));
+  memset( tweaks, 0, sizeof( tweaks ));
+}
+
+#ifdef AK_HAVE_PTHREAD_H
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Контекст потока, обрабатывающего непрерывную последовательность секторов. */
+ typedef struct xts_sectors_fragment {
+  /*! \brief Копия ключа шифрования. */
+   struct bckey ekey;
+  /*! \brief Копия ключа выработки значений tweak. */
+   struct bckey akey;
+  /*! \brief Указатель на входные данные. */
+   ak_uint8 *in;
+  /*! \brief Указатель на выходные данные. */
+   ak_uint8 *out;
+  /*! \brief Размер сектора в октетах. */
+   size_t sector_size;
+  /*! \brief Младшие 64 бита номера первого сектора. */
+   ak_uint64 sector;
+  /*! \brief Старшие 64 бита номера первого сектора. */
+   ak_uint64 high;
+  /*! \brief Количество секторов. */
+   size_t nsectors;
+  /*! \brief Направление преобразования. */
+   bool_t encrypt;
+  /*! \brief Дескриптор потока. */
+   pthread_t thread;
+ } *ak_xts_sectors_fragment;
+
+/* ----------------------------------------------------------------------------------------------- */
+ static void *ak_xts_sectors_thread( void *ptr )
+{
+  ak_xts_sectors_fragment fr = ( ak_xts_sectors_fragment ) ptr;
+  ak_xts_process_sectors( &fr->ekey, &fr->akey, fr->in, fr->out,
+                             fr->sector_size, fr->sector, fr->high, fr->nsectors, fr->encrypt );
+ return NULL;
+}
+#endif
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Функция реализует зашифрование и расшифрование последовательности секторов.
+
+    Последовательность секторов разбивается на непрерывные фрагменты, которые обрабатываются
+    одновременно на копиях ключей; количество потоков определяется опцией
+    `block_cipher_threads` и объемом данных.                                                       */
+/* ----------------------------------------------------------------------------------------------- */
+ static int ak_bckey_xts_sectors( ak_bckey encryptionKey, ak_bckey authenticationKey,
+                                 ak_pointer in, ak_pointer out, size_t sector_size,
+                              ak_uint64 first_sector_number, size_t nsectors, const bool_t encrypt )
+{
+  int error = ak_error_ok;
+  ak_int64 blocks = 0;
+  size_t nthreads = 1, start = 0;
+  ak_uint8 *inptr = (ak_uint8 *)in, *outptr = (ak_uint8 *)out;
+#ifdef AK_HAVE_PTHREAD_H
+  size_t idx = 0, per = 0, started = 0;
+  ak_xts_sectors_fragment frs = NULL;
+#endif
+
+  if(( encryptionKey == NULL ) || ( authenticationKey == NULL ))
+    return ak_error_message( ak_error_null_pointer, __func__ , "using null pointer to key" );
+  if(( in == NULL ) || ( out == NULL ))
+    return ak_error_message( ak_error_null_pointer, __func__ , "using null pointer to data" );
+  if( nsectors == 0 ) return ak_error_ok;
+
+ /* проверяем размер сектора */
+  if(( sector_size == 0 ) || ( sector_size%encryptionKey->bsize != 0 ))
+    return ak_error_message( ak_error_wrong_block_cipher_length,
+                            __func__ , "the length of sector is not divided by block length" );
+  if(( authenticationKey->bsize != 8 ) && ( authenticationKey->bsize != 16 ))
+    return ak_error_message( ak_error_wrong_block_cipher,
+                                          __func__ , "incorrect block size of block cipher key" );
+
+ /* проверяем целостность ключей */
+  if( ak_skey_check_icode( &encryptionKey->key ) != ak_true )
+    return ak_error_message( ak_error_wrong_key_icode, __func__,
+                                               "incorrect integrity code of encryption key value" );
+  if( ak_skey_check_icode( &authenticationKey->key ) != ak_true )
+    return ak_error_message( ak_error_wrong_key_icode, __func__,
+                                           "incorrect integrity code of authentication key value" );
+
+ /* проверяем и изменяем ресурс ключей (один раз для всей последовательности секторов) */
+  if( ak_skey_reserve_resource( &authenticationKey->key,
+                            ( ssize_t )( nsectors*( authenticationKey->bsize >> 3 ))) != ak_error_ok )
+    return ak_error_message( ak_error_low_key_resource,
+                                          __func__ , "low resource of authentication cipher key" );
+  blocks = ( ak_int64 )( nsectors*( sector_size/encryptionKey->bsize ));
+  if( ak_skey_reserve_resource( &encryptionKey->key, blocks ) != ak_error_ok )
+    return ak_error_message( ak_error_low_key_resource,
+                                              __func__ , "low resource of encryption cipher key" );
+
+#ifdef AK_HAVE_PTHREAD_H
+ /* распределяем сектора между потоками */
+  nthreads = ak_min( ak_bckey_get_threads_count( nsectors*sector_size ), nsectors );
+ /* копии ключей, используемых несколькими потоками, не создаются */
+  if(( encryptionKey->key.flags|authenticationKey->key.flags )&ak_key_flag_shared ) nthreads = 1;
+  if(( nthreads > 1 ) &&
+     (( frs = calloc( nthreads - 1, sizeof( struct xts_sectors_fragment ))) != NULL )) {
+    per = nsectors/nthreads;
+    start = nsectors - ( nthreads - 1 )*per; /* основной поток обрабатывает первый фрагмент */
+    for( idx = 0; idx < nthreads - 1; idx++ ) {
+       ak_xts_sectors_fragment fr = frs + idx;
+       size_t first = start + idx*per;
+
+       fr->in = inptr + first*sector_size;
+       fr->out = outptr + first*sector_size;
+       fr->sector_size = sector_size;
+       fr->sector = first_sector_number + first;
+       fr->high = ( fr->sector < first_sector_number );
+       fr->nsectors = per;
+       fr->encrypt = encrypt;
+       if( ak_bckey_create_and_set_bckey( &fr->ekey, encryptionKey ) != ak_error_ok ) break;
+       if( ak_bckey_create_and_set_bckey( &fr->akey, authenticationKey ) != ak_error_ok ) {
+         ak_bckey_destroy( &fr->ekey );
+         break;
+       }
+       if( pthread_create( &fr->thread, NULL, ak_xts_sectors_thread, fr ) != 0 ) {
+         ak_bckey_destroy( &fr->akey );
+         ak_bckey_destroy( &fr->ekey );
+         break;
+       }
+       started++;
+    }
+   /* фрагменты, для которых не удалось запустить поток, обрабатываем сами */
+    for( idx = started; idx < nthreads - 1; idx++ )
+       ak_xts_process_sectors( encryptionKey, authenticationKey, frs[idx].in, frs[idx].out,
+                     sector_size, frs[idx].sector, frs[idx].high, frs[idx].nsectors, encrypt );
+  } else start = nsectors;
+#else
+  start = nsectors;
+  (void)nthreads;
+#endif
+
+  ak_xts_process_sectors( encryptionKey, authenticationKey,
+                                inptr, outptr, sector_size, first_sector_number, 0, start, encrypt );
+#ifdef AK_HAVE_PTHREAD_H
+  if( frs != NULL ) {
+    for( idx = 0; idx < started; idx++ ) {
+       pthread_join( frs[idx].thread, NULL );
+       ak_bckey_destroy( &frs[idx].akey );
+       ak_bckey_destroy( &frs[idx].ekey );
+    }
+    free( frs );
+  }
+#endif
+
+ /* перемаскируем ключи */
+  if(( error = ak_skey_remask( &encryptionKey->key, nsectors*sector_size )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of encryption key" );
+  if(( error = ak_skey_remask( &authenticationKey->key, nsectors*sector_size )) != ak_error_ok )
+    ak_error_message( error, __func__ , "wrong remasking of authentication key" );
+
+ return error;
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция зашифровывает `nsectors` последовательно расположенных в памяти секторов
+    одинакового размера. Каждый сектор зашифровывается в режиме XTS независимо от остальных,
+    синхропосылкой служит номер сектора, записанный как 128-ми битное целое число
+    в формате little endian (так же, как это предусмотрено стандартом IEEE P 1619).
+    Результат зашифрования сектора с номером \f$ n \f$ совпадает с результатом вызова
+    функции ak_bckey_encrypt_xts(), которой в качестве синхропосылки передано значение \f$ n \f$.
+    Номера секторов \f$ n+i \f$ вычисляются как 128-ми битные числа, поэтому для
+    последовательности секторов, пересекающей границу \f$ 2^{64} \f$, выполняется перенос
+    в старшие 64 бита номера.
+
+    Проверка целостности ключей и изменение их ресурса выполняются один раз для всей
+    последовательности секторов. Если библиотека собрана с поддержкой потоков,
+    сектора обрабатываются одновременно несколькими потоками.
+
+    @param encryptionKey Ключ, используемый для шифрования информации
+    @param authenticationKey Ключ, используемый для выработки значений tweak
+    @param in Указатель на область памяти, где хранятся входные (открытые) данные
+    @param out Указатель на область памяти, куда будут помещены зашифрованные данные
+    (может совпадать с `in`)
+    @param sector_size Размер сектора в октетах, должен быть кратен длине блока
+    @param first_sector_number Номер первого сектора
+    @param nsectors Количество секторов
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). В случае возникновения
+    ошибки возвращается ее код.                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_encrypt_xts_sectors( ak_bckey encryptionKey, ak_bckey authenticationKey,
+                                 ak_pointer in, ak_pointer out, size_t sector_size,
+                                                    ak_uint64 first_sector_number, size_t nsectors )
+{
+  return ak_bckey_xts_sectors( encryptionKey, authenticationKey, in, out,
+                                           sector_size, first_sector_number, nsectors, ak_true );
+}
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! Функция реализует обратное преобразование к алгоритму, реализуемому с помощью
+    функции ak_bckey_encrypt_xts_sectors().
+
+    @param encryptionKey Ключ, используемый для шифрования информации
+    @param authenticationKey Ключ, используемый для выработки значений tweak
+    @param in Указатель на область памяти, где хранятся входные (зашифрованные) данные
+    @param out Указатель на область памяти, куда будут помещены расшифрованные данные
+    (может совпадать с `in`)
+    @param sector_size Размер сектора в октетах, должен быть кратен длине блока
+    @param first_sector_number Номер первого сектора
+    @param nsectors Количество секторов
+
+    @return В случае успеха функция возвращает \ref ak_error_ok (ноль). В случае возникновения
+    ошибки возвращается ее код.                                                                    */
+/* ----------------------------------------------------------------------------------------------- */
+ int ak_bckey_decrypt_xts_sectors( ak_bckey encryptionKey, ak_bckey authenticationKey,
+                                 ak_pointer in, ak_pointer out, size_t sector_size,
+                                                    ak_uint64 first_sector_number, size_t nsectors )
+{
+  return ak_bckey_xts_sectors( encryptionKey, authenticationKey, in, out,
+                                          sector_size, first_sector_number, nsectors, ak_false );
+}
+
 /* ----------------------------------------------------------------------------------------------- */
 /*                 реализация режима аутентифицирующего шифрования xtsmac                          */
 /* ----------------------------------------------------------------------------------------------- */
@@ -470,9 +750,8 @@
     return ak_error_message( ak_error_wrong_block_cipher_function, __func__ ,
                                               "attemp to update previously closed xtsmac context");
  /* проверка ресурса ключа */
-  if( authenticationKey->key.resource.value.counter < resource )
+  if( ak_skey_reserve_resource( &authenticationKey->key, resource ) != ak_error_ok )
    return ak_error_message( ak_error_low_key_resource, __func__, "using key with low key resource");
-  else authenticationKey->key.resource.value.counter -= resource;
 
  /* теперь основной цикл */
   switch( authenticationKey->bsize ) {
@@ -554,10 +833,9 @@
   if( authenticationKey->bsize > 16 ) return ak_error_message( ak_error_wrong_length, __func__,
                                                                "using key with large block size" );
   /* традиционная проверка ресурса */
-  if( authenticationKey->key.resource.value.counter <= 0 )
+  if( ak_skey_reserve_resource( &authenticationKey->key, 1 ) != ak_error_ok )
     return ak_error_message( ak_error_low_key_resource, __func__,
                                                                 "using key with low key resource");
-   else authenticationKey->key.resource.value.counter--;
 
  /* закрываем добавление шифруемых данных */
    ak_aead_set_bit( ctx->flags, ak_aead_encrypted_data_bit );
@@ -634,9 +912,8 @@
     return ak_error_message( ak_error_wrong_block_cipher_function, __func__ ,
                                               "attemp to update previously closed xtsmac context");
  /* проверка ресурса ключа */
-  if( encryptionKey->key.resource.value.counter < resource )
+  if( ak_skey_reserve_resource( &encryptionKey->key, resource ) != ak_error_ok )
    return ak_error_message( ak_error_low_key_resource, __func__, "using key with low key resource");
-  else encryptionKey->key.resource.value.counter -= resource;
 
  /* теперь основной цикл */
   switch( encryptionKey->bsize ) {
@@ -708,9 +985,8 @@
     return ak_error_message( ak_error_wrong_block_cipher_function, __func__ ,
                                               "attemp to update previously closed xtsmac context");
  /* проверка ресурса ключа */
-  if( encryptionKey->key.resource.value.counter < resource )
+  if( ak_skey_reserve_resource( &encryptionKey->key, resource ) != ak_error_ok )
    return ak_error_message( ak_error_low_key_resource, __func__, "using key with low key resource");
-  else encryptionKey->key.resource.value.counter -= resource;
 
  /* теперь основной цикл */
   switch( encryptionKey->bsize ) {
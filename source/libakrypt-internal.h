@@ -16,6 +16,20 @@
  extern const ak_uint64 streebog_Areverse_expand_with_pi[8][256];
 /** @} */
 
+/* ----------------------------------------------------------------------------------------------- */
+/** \addtogroup options-doc
+ @{ */
+/*! \brief Проверка того, что значение лежит в допустимых границах для заданной опции. */
+ bool_t ak_libakrypt_check_option_bounds( const char * , const ak_int64 );
+/** @} */
+
+/* ----------------------------------------------------------------------------------------------- */
+/** \addtogroup oid-doc
+ @{ */
+/*! \brief Уничтожение менеджера контекстов и всех размещенных в нем объектов. */
+ int ak_libakrypt_destroy_context_manager( void );
+/** @} */
+
 /* ----------------------------------------------------------------------------------------------- */
 /** \addtogroup skey-doc Cекретные ключи криптографических механизмов
  @{ */
@@ -24,6 +38,11 @@
 /*! \brief Формирование имени файла, в который будет помещаться секретный или открытый ключ. */
  int ak_skey_generate_file_name_from_buffer( ak_uint8 * , const size_t ,
                                                          char * , const size_t , export_format_t );
+/*! \brief Выделение памяти для развернутых ключей в соответствии со способом выделения
+    памяти, заданным для секретного ключа. */
+ ak_pointer ak_skey_alloc_data( ak_skey , size_t );
+/*! \brief Освобождение памяти, выделенной функцией ak_skey_alloc_data(). */
+ void ak_skey_free_data( ak_pointer );
 /*! \brief Инициализация секретного ключа алгоритма блочного шифрования. */
  int ak_bckey_create( ak_bckey , size_t , size_t );
 /*! \brief Инициализация ключа алгоритма блочного шифрования значением другого ключа */
@@ -31,12 +50,38 @@
 /*! \brief Процедура вычисления производного ключа в соответствии с алгоритмом ACPKM
     из рекомендаций Р 1323565.1.012-2018. */
  int ak_bckey_next_acpkm_key( ak_bckey );
+/*! \brief Зашифрование последовательности независимых блоков информации. */
+ void ak_bckey_encrypt_blocks( ak_bckey , ak_pointer , ak_pointer , size_t );
+/*! \brief Расшифрование последовательности независимых блоков информации. */
+ void ak_bckey_decrypt_blocks( ak_bckey , ak_pointer , ak_pointer , size_t );
+/*! \brief Функция последовательной обработки фрагмента данных в режиме шифрования с регистром. */
+ typedef void ( ak_function_bckey_fragment )( ak_bckey ,
+                                               ak_uint8 * , ak_uint8 * , size_t , ak_uint8 * , size_t );
+/*! \brief Функция вычисления значения регистра для фрагмента данных, начинающегося
+    с блока с заданным номером. */
+ typedef void ( ak_function_bckey_fragment_seek )( ak_bckey ,
+                                               ak_uint8 * , size_t , ak_uint8 * , size_t , ak_uint8 * );
+/*! \brief Максимальное количество потоков, используемых при обработке одного фрагмента данных. */
+ #define ak_bckey_max_threads      (64)
+/*! \brief Количество потоков, используемых для обработки данных заданного объема. */
+ size_t ak_bckey_get_threads_count( size_t );
+/*! \brief Вычисление значения регистра в режимах с зацеплением по шифртексту. */
+ void ak_bckey_chain_seek( ak_bckey , ak_uint8 * , size_t , ak_uint8 * , size_t , ak_uint8 * );
+/*! \brief Многопоточная обработка последовательности блоков, разбитой на фрагменты. */
+ void ak_bckey_process_fragments( ak_bckey , ak_function_bckey_fragment * ,
+           ak_function_bckey_fragment_seek * , ak_uint8 * , ak_uint8 * , size_t , ak_uint8 * ,
+                                                                                size_t , size_t );
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Функция вырабатывает пару ключей алгоритма блочного шифрования из заданного
    пользователем пароля. */
  int ak_bckey_create_key_pair_from_password( ak_bckey , ak_bckey , ak_oid ,
                             const char * , const size_t , ak_uint8 *, const size_t, const size_t );
+/*! \brief Функция вырабатывает пару ключей алгоритма блочного шифрования из заданного
+   пользователем пароля с использованием алгоритма mhkdf. */
+ int ak_bckey_create_key_pair_from_password_mhkdf( ak_bckey , ak_bckey , ak_oid ,
+                            const char * , const size_t , ak_uint8 * , const size_t ,
+                                                     const size_t , const size_t , const size_t );
 
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Выработка матрицы, соответствующей 16 тактам работы линейного региста сдвига. */
@@ -51,6 +96,8 @@
                                                                 const sbox , ak_kuznechik_params );
 /*! \brief Инициализация внутренних переменных значениями, регламентируемыми ГОСТ Р 34.12-2015. */
  int ak_bckey_kuznechik_init_gost_tables( void );
+/*! \brief Инициализация таблиц, используемых при пакетном зашифровании алгоритмом Магма. */
+ int ak_bckey_magma_init_tables( void );
 /** @} */
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -66,8 +113,31 @@
  int ak_mac_clean( ak_mac );
 /*! \brief Обновление состояния контекста сжимающего отображения. */
  int ak_mac_update( ak_mac , const ak_pointer , const size_t );
+/*! \brief Обновление состояния контекста сжимающего отображения последовательностью фрагментов. */
+ int ak_mac_updatev( ak_mac , const struct iovector * , const size_t );
 /*! \brief Обновление состояния и вычисление результата применения сжимающего отображения. */
  int ak_mac_finalize( ak_mac , const ak_pointer , const size_t , ak_pointer , const size_t );
+/*! \brief Вычисление результата применения сжимающего отображения без сохранения
+    внутреннего состояния. */
+ int ak_mac_finalize_inplace( ak_mac , const ak_pointer , const size_t ,
+                                                                       ak_pointer , const size_t );
+/*! \brief Максимальное количество контекстов функции хеширования Стрибог, обрабатываемых
+    одновременно (функциями ak_hash_ptr_multi() и ak_hash_context_streebog_hmac_iterate()). */
+ #define ak_streebog_lanes                  (4)
+/*! \brief Вычисление последовательности значений HMAC-Стрибог512 от 64-х октетных сообщений
+    для нескольких независимых цепочек (внутренний цикл алгоритма PBKDF2). */
+ void ak_hash_context_streebog_hmac_iterate( ak_streebog * , ak_streebog * ,
+                              ak_uint64 ** , ak_uint64 ** , const size_t , const size_t );
+/*! \brief Версия формата сохраненного состояния функции хеширования. */
+ #define ak_hash_state_version              (0x01)
+/*! \brief Версия формата сохраненного состояния алгоритма HMAC. */
+ #define ak_hmac_state_version              (0x81)
+/*! \brief Размер тела сохраненного состояния функции хеширования (в октетах). */
+ #define ak_hash_state_body_size            (260)
+/*! \brief Сохранение тела промежуточного состояния функции хеширования. */
+ int ak_hash_context_export_state( ak_hash , ak_mac , ak_uint8 , ak_uint8 * );
+/*! \brief Восстановление тела промежуточного состояния функции хеширования. */
+ int ak_hash_context_import_state( ak_hash , ak_mac , ak_uint8 , const ak_uint8 * );
 /*! \brief Применение сжимающего отображения к заданной области памяти. */
  int ak_mac_ptr( ak_mac , ak_pointer , const size_t , ak_pointer , const size_t );
 /*! \brief Применение сжимающего отображения к заданному файлу. */
@@ -311,6 +311,8 @@ extern "C" {
      xcrypt,
    /*! \brief описатель для типов данных, помещаемых в asn1 дерево */
      descriptor,
+   /*! \brief древовидный режим хеширования */
+     hash_tree,
    /*! \brief неопределенный режим, может возвращаться как ошибка */
      undefined_mode
 } oid_modes_t;
@@ -355,6 +357,17 @@ extern "C" {
 /*! \brief Удаление второго объекта из кучи */
  dll_export ak_pointer ak_oid_delete_second_object( ak_oid , ak_pointer );
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Дескриптор объекта, размещенного в менеджере контекстов; отрицательное значение
+    дескриптора является кодом ошибки. */
+ typedef ssize_t ak_handle;
+/*! \brief Получение из менеджера контекстов объекта с заданным идентификатором. */
+ dll_export ak_handle ak_handle_new( ak_oid );
+/*! \brief Получение указателя на объект по его дескриптору. */
+ dll_export ak_pointer ak_handle_get_context( ak_handle , oid_engines_t * );
+/*! \brief Возврат объекта в менеджер контекстов. */
+ dll_export int ak_handle_delete( ak_handle );
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Функция возвращает количество идентификаторов библиотеки. */
  dll_export size_t ak_libakrypt_oids_count( void );
@@ -408,6 +421,15 @@ extern "C" {
        ak_uint64 val;
      /*! \brief Внутреннее состояние xorshift32 генератора */
        ak_uint32 value;
+     /*! \brief Внутреннее состояние генератора chacha20 */
+       struct {
+        /*! \brief Состояние (ключ, счетчик блоков и синхропосылка) */
+         ak_uint32 state[16];
+        /*! \brief Текущий блок выходной последовательности */
+         ak_uint32 block[16];
+        /*! \brief Количество использованных октетов текущего блока */
+         size_t offset;
+       } chacha20;
      /*! \brief Файловый дескриптор */
        int fd;
     #ifdef AK_HAVE_WINDOWS_H
@@ -422,6 +444,8 @@ extern "C" {
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Инициализация контекста линейного конгруэнтного генератора псевдо-случайных чисел. */
  dll_export int ak_random_create_lcg( ak_random );
+/*! \brief Инициализация контекста генератора, основанного на поточном шифре ChaCha20. */
+ dll_export int ak_random_create_chacha20( ak_random );
  /*! \brief Инициализация контекста генератора, считывающего случайные значения из заданного файла. */
  dll_export int ak_random_create_file( ak_random , const char * );
 #if defined(__unix__) || defined(__APPLE__)
@@ -489,16 +513,41 @@ extern "C" {
 /*! \brief Флаг, который определяет, можно ли использовать значение внутреннего буффера в режиме omac. */
  #define ak_key_flag_omac_buffer_used   (0x0000000000000200ULL)
 
+/*! \brief Флаг, который определяет, что для текущего значения ключа выработаны производные
+    данные (например, начальные состояния алгоритма HMAC); флаг сбрасывается при изменении
+    значения ключа. */
+ #define ak_key_flag_precomputed        (0x0000000000000400ULL)
+
+/*! \brief Флаг, который определяет, что ключ одновременно используется несколькими потоками;
+    для такого ключа не выполняется смена маски после использования (см. ak_skey_set_shared()). */
+ #define ak_key_flag_shared             (0x0000000000000800ULL)
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Способ выделения памяти для хранения секретной информации. */
  typedef enum {
   /*! \brief Механизм выделения памяти не определен. */
    undefined_policy,
   /*! \brief Выделение памяти через стандартный malloc */
-   malloc_policy
+   malloc_policy,
+  /*! \brief Выделение памяти из защищенной области, закрепленной в оперативной памяти
+      и окруженной охранными страницами (см. ak_secure_arena_malloc()). */
+   secure_arena_policy
 
 } memory_allocation_policy_t;
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Политика смены маски секретного ключа после его использования. */
+ typedef enum {
+  /*! \brief Маска ключа меняется после каждого использования. */
+   key_remask_every_call,
+  /*! \brief Маска ключа меняется после заданного количества использований. */
+   key_remask_by_calls,
+  /*! \brief Маска ключа меняется после обработки заданного количества октетов. */
+   key_remask_by_bytes,
+  /*! \brief Маска ключа меняется по истечении заданного количества секунд. */
+   key_remask_by_timer
+} key_remask_policy_t;
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Тип ключа шифрования контента. */
  typedef enum {
@@ -573,6 +622,18 @@ extern "C" {
    ak_uint8 number[32];
   /*! \brief контрольная сумма ключа */
    ak_uint32 icode;
+  /*! \brief количество использований ключа, после которого проверяется контрольная сумма */
+   ak_uint32 icode_period;
+  /*! \brief количество использований ключа без проверки контрольной суммы */
+   ak_uint32 icode_calls;
+  /*! \brief политика смены маски ключа */
+   key_remask_policy_t remask_policy;
+  /*! \brief количество использований, октетов или секунд, после которого меняется маска */
+   ak_uint64 remask_period;
+  /*! \brief количество использований или октетов, обработанных с текущей маской */
+   ak_uint64 remask_counter;
+  /*! \brief время последней смены маски */
+   time_t remask_time;
   /*! \brief генератор случайных масок ключа */
    struct random generator;
   /*! \brief ресурс использования ключа */
@@ -600,6 +661,12 @@ extern "C" {
  dll_export int ak_libakrypt_generate_unique_number( ak_pointer , const size_t );
 /*! \brief Получение человекочитаемого имени для типа ключевого ресурса. */
  dll_export const char *ak_libakrypt_get_counter_resource_name( const counter_resource_t );
+/*! \brief Выделение памяти из защищенной области для хранения ключевой информации. */
+ dll_export ak_pointer ak_secure_arena_malloc( size_t );
+/*! \brief Очистка и возврат памяти в защищенную область. */
+ dll_export bool_t ak_secure_arena_free( ak_pointer );
+/*! \brief Освобождение защищенной области памяти. */
+ dll_export int ak_secure_arena_destroy( void );
 /*! \brief Функция выделения памяти для ключевой информации. */
  dll_export int ak_skey_alloc_memory( ak_skey , size_t , memory_allocation_policy_t );
 /*! \brief Функция освобождения выделенной ранее памяти. */
@@ -608,6 +675,8 @@ extern "C" {
  dll_export int ak_skey_create( ak_skey , size_t );
 /*! \brief Очистка структуры секретного ключа. */
  dll_export int ak_skey_destroy( ak_skey );
+/*! \brief Уничтожение значения секретного ключа с сохранением выделенной памяти. */
+ dll_export int ak_skey_reset( ak_skey );
 /*! \brief Присвоение секретному ключу уникального номера. */
  dll_export int ak_skey_set_unique_number( ak_skey );
 /*! \brief Присвоение секретному ключу заданного номера. */
@@ -628,6 +697,18 @@ extern "C" {
  dll_export int ak_skey_set_icode_xor( ak_skey );
 /*! \brief Проверка значения контрольной суммы ключа. */
  dll_export bool_t ak_skey_check_icode_xor( ak_skey );
+/*! \brief Проверка контрольной суммы ключа в соответствии с заданной периодичностью. */
+ dll_export bool_t ak_skey_check_icode( ak_skey );
+/*! \brief Установка периодичности проверки контрольной суммы ключа. */
+ dll_export int ak_skey_set_icode_check_period( ak_skey , const ak_uint32 );
+/*! \brief Смена маски ключа после его использования в соответствии с заданной политикой. */
+ dll_export int ak_skey_remask( ak_skey , const size_t );
+/*! \brief Установка политики смены маски ключа. */
+ dll_export int ak_skey_set_remask_policy( ak_skey , const key_remask_policy_t , const ak_uint64 );
+/*! \brief Атомарное резервирование ресурса ключа. */
+ dll_export int ak_skey_reserve_resource( ak_skey , const ssize_t );
+/*! \brief Разрешение одновременного использования ключа несколькими потоками. */
+ dll_export int ak_skey_set_shared( ak_skey , const bool_t );
 /*! \brief Функция устанавливает ресурс ключа. */
  dll_export int ak_skey_set_resource( ak_skey , ak_resource );
 /*! \brief Функция устанавливает временной интервал действия ключа. */
@@ -650,6 +731,9 @@ extern "C" {
  typedef int ( ak_function_bckey_create ) ( ak_bckey );
 /*! \brief Функция зашифрования/расширования одного блока информации. */
  typedef void ( ak_function_bckey )( ak_skey, ak_pointer, ak_pointer );
+/*! \brief Функция зашифрования/расшифрования последовательности из нескольких независимых
+    блоков информации. */
+ typedef void ( ak_function_bckey_blocks )( ak_skey, ak_pointer, ak_pointer, size_t );
 /*! \brief Функция, предназначенная для зашифрования/расшифрования области памяти заданного размера */
  typedef int ( ak_function_bckey_encrypt )( ak_bckey, ak_pointer, ak_pointer, size_t,
                                                                                 ak_pointer, size_t );
@@ -670,6 +754,12 @@ extern "C" {
    ak_function_bckey *encrypt;
   /*! \brief Функция расширования одного блока информации. */
    ak_function_bckey *decrypt;
+  /*! \brief Функция зашифрования нескольких независимых блоков информации за один вызов.
+      \details Может принимать значение NULL; в этом случае используется функция encrypt. */
+   ak_function_bckey_blocks *encrypt_blocks;
+  /*! \brief Функция расшифрования нескольких независимых блоков информации за один вызов.
+      \details Может принимать значение NULL; в этом случае используется функция decrypt. */
+   ak_function_bckey_blocks *decrypt_blocks;
   /*! \brief Функция развертки ключа. */
    ak_function_skey *schedule_keys;
   /*! \brief Функция уничтожения развернутых ключей. */
@@ -679,6 +769,9 @@ extern "C" {
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Инициализация секретного ключа алгоритма блочного шифрования Магма. */
  dll_export int ak_bckey_create_magma( ak_bckey );
+/*! \brief Инициализация секретного ключа алгоритма блочного шифрования Магма
+    с пакетной реализацией зашифрования последовательности блоков. */
+ dll_export int ak_bckey_create_magma_batch( ak_bckey );
 /*! \brief Инициализация секретного ключа алгоритма блочного шифрования Кузнечик. */
  dll_export int ak_bckey_create_kuznechik( ak_bckey );
 /*! \brief Инициализация секретного ключа алгоритма блочного шифрования TwoFish (128-bit). */
@@ -725,6 +818,9 @@ extern "C" {
    sbox pinv;
   /*! \brief Развернутые таблицы, используемые для эффективного расшифрования */
    expanded_table dec;
+  /*! \brief Таблицы умножения младших и старших полубайтов на элементы матрицы L,
+      используемые векторной реализацией зашифрования */
+   ak_uint8 vmul[16][16][2][16];
  } *ak_kuznechik_params;
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -743,6 +839,12 @@ extern "C" {
 /*! \brief Шифрование данных в режиме гаммирования из ГОСТ Р 34.13-2015
    (counter mode, ctr). */
  dll_export int ak_bckey_ctr( ak_bckey , ak_pointer , ak_pointer , size_t , ak_pointer , size_t );
+/*! \brief Многопоточное шифрование данных в режиме гаммирования из ГОСТ Р 34.13-2015. */
+ dll_export int ak_bckey_ctr_parallel( ak_bckey , ak_pointer , ak_pointer , size_t ,
+                                                                     ak_pointer , size_t , size_t );
+/*! \brief Шифрование фрагмента данных в режиме гаммирования с произвольного смещения. */
+ dll_export int ak_bckey_ctr_at_offset( ak_bckey , ak_pointer , ak_pointer , size_t ,
+                                                                    ak_pointer , size_t , size_t );
 /*! \brief Шифрование данных в режиме гаммирования с обратной связью по выходу
    (output feedback, ofb). */
  dll_export int ak_bckey_ofb( ak_bckey , ak_pointer , ak_pointer , size_t , ak_pointer , size_t );
@@ -757,12 +859,21 @@ extern "C" {
 /*! \brief Шифрование данных в режиме `CTR-ACPKM` из Р 1323565.1.017—2018. */
  dll_export int ak_bckey_ctr_acpkm( ak_bckey , ak_pointer , ak_pointer , size_t , size_t ,
                                                                              ak_pointer , size_t );
+/*! \brief Многопоточное шифрование данных в режиме `CTR-ACPKM` из Р 1323565.1.017—2018. */
+ dll_export int ak_bckey_ctr_acpkm_parallel( ak_bckey , ak_pointer , ak_pointer , size_t , size_t ,
+                                                                     ak_pointer , size_t , size_t );
 /*! \brief Зашифрование данных в режиме `XTS`. */
  dll_export int ak_bckey_encrypt_xts( ak_bckey ,  ak_bckey , ak_pointer , ak_pointer , size_t ,
                                                                              ak_pointer , size_t );
 /*! \brief Расшифрование данных в режиме `XTS`. */
  dll_export int ak_bckey_decrypt_xts( ak_bckey ,  ak_bckey , ak_pointer , ak_pointer , size_t ,
                                                                              ak_pointer , size_t );
+/*! \brief Зашифрование последовательности секторов в режиме `XTS`. */
+ dll_export int ak_bckey_encrypt_xts_sectors( ak_bckey , ak_bckey , ak_pointer , ak_pointer ,
+                                                                  size_t , ak_uint64 , size_t );
+/*! \brief Расшифрование последовательности секторов в режиме `XTS`. */
+ dll_export int ak_bckey_decrypt_xts_sectors( ak_bckey , ak_bckey , ak_pointer , ak_pointer ,
+                                                                  size_t , ak_uint64 , size_t );
 /** @} */
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -793,6 +904,17 @@ extern "C" {
 /*! \brief Максимальный размер блока входных данных в октетах (байтах). */
  #define ak_mac_max_buffer_size (64)
 
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Фрагмент сжимаемых данных, используемый при обработке несвязной последовательности
+    областей памяти. */
+/* ----------------------------------------------------------------------------------------------- */
+ typedef struct iovector {
+  /*! \brief Указатель на начало фрагмента данных. */
+   ak_pointer data;
+  /*! \brief Размер фрагмента данных (в октетах). */
+   size_t size;
+ } *ak_iovector;
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Контекст алгоритма итерационного сжатия. */
 /*! Класс предоставляет интерфейс для реализации процедруры сжатия данных фрагментами произвольной длины.
@@ -813,6 +935,9 @@ extern "C" {
    ak_function_update *update;
   /*! \brief Функция завершения вычислений и получения конечного результата */
    ak_function_finalize *finalize;
+  /*! \brief Функция завершения вычислений, изменяющая внутреннее состояние контекста ctx
+      (может быть не определена). */
+   ak_function_finalize *finalize_inplace;
  } *ak_mac;
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -827,8 +952,13 @@ extern "C" {
   ak_uint64 sigma[8];
  /*! \brief Размер блока выходных данных (хеш-кода)*/
   size_t hsize;
+ /*! \brief Реализация преобразования G, выбираемая при создании контекста */
+  void ( *g )( struct streebog *, ak_uint64 *, const ak_uint64 * );
 } *ak_streebog;
 
+/*! \brief Функция, реализующая преобразование G алгоритма хеширования Стрибог. */
+ typedef void ( ak_function_streebog_g )( ak_streebog , ak_uint64 * , const ak_uint64 * );
+
 /* ----------------------------------------------------------------------------------------------- */
 /*! \brief Контекст бесключевой функции хеширования. */
 /*! \details Класс предоставляет интерфейс для реализации бесключевых функций хеширования, построенных
@@ -874,17 +1004,43 @@ extern "C" {
  dll_export int ak_hash_clean( ak_hash );
 /*! \brief Обновление состояния контекста хеширования. */
  dll_export int ak_hash_update( ak_hash , const ak_pointer , const size_t );
+/*! \brief Обновление состояния контекста хеширования последовательностью фрагментов данных. */
+ dll_export int ak_hash_updatev( ak_hash , const struct iovector * , const size_t );
 /*! \brief Обновление состояния и вычисление результата применения алгоритма хеширования. */
  dll_export int ak_hash_finalize( ak_hash , const ak_pointer , const size_t , ak_pointer , const size_t );
+/*! \brief Вычисление результата применения алгоритма хеширования без сохранения
+    внутреннего состояния контекста. */
+ dll_export int ak_hash_finalize_inplace( ak_hash , const ak_pointer , const size_t ,
+                                                                       ak_pointer , const size_t );
 /*! \brief Хеширование заданной области памяти. */
  dll_export int ak_hash_ptr( ak_hash , const ak_pointer , const size_t , ak_pointer , const size_t );
+/*! \brief Хеширование нескольких независимых сообщений. */
+ dll_export int ak_hash_ptr_multi( ak_hash , const size_t , ak_pointer * , const size_t * ,
+                                                                       ak_pointer * , const size_t );
 /*! \brief Хеширование заданного файла. */
  dll_export int ak_hash_file( ak_hash , const char*, ak_pointer , const size_t );
+/*! \brief Хеширование заданной области памяти в древовидном режиме. */
+ dll_export int ak_hash_ptr_tree( ak_hash , const ak_pointer , const size_t ,
+                                                                       ak_pointer , const size_t );
+/*! \brief Хеширование заданного файла в древовидном режиме. */
+ dll_export int ak_hash_file_tree( ak_hash , const char* , ak_pointer , const size_t );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Размер сохраненного состояния контекста функции хеширования (в октетах). */
+ #define ak_hash_state_size                 (264)
+/*! \brief Сохранение промежуточного состояния контекста функции хеширования. */
+ dll_export int ak_hash_export_state( ak_hash , ak_pointer , const size_t );
+/*! \brief Восстановление промежуточного состояния контекста функции хеширования. */
+ dll_export int ak_hash_import_state( ak_hash , const ak_pointer , const size_t );
 /** @} */
 
 /* ----------------------------------------------------------------------------------------------- */
 /** \addtogroup skey-doc Cекретные ключи криптографических механизмов
  @{ */
+/*! \brief Размер сохраняемого состояния функции хеширования в контексте алгоритма HMAC (в октетах). */
+ #define ak_hmac_pad_state_size             (192)
+
+/* ----------------------------------------------------------------------------------------------- */
 /*! \brief Секретный ключ алгоритма выработки имитовставки HMAC. */
 /*!  Алгоритм выработки имитовставки HMAC основан на двукратном применении бесключевой функции
      хеширования. Алгоритм описывается рекомендациями IETF RFC 2104 (см. также RFC 7836) и
@@ -907,6 +1063,9 @@ extern "C" {
    struct mac mctx;
   /*! \brief Контекст функции хеширования */
    struct hash ctx;
+  /*! \brief Маскированные состояния (векторы h, n и \f$ \Sigma \f$) функции хеширования после
+      обработки блоков \f$ K \oplus ipad \f$ и \f$ K \oplus opad \f$, за которыми следуют маски. */
+   ak_uint8 pads[4*ak_hmac_pad_state_size];
 } *ak_hmac;
 
 /*! \brief Создание секретного ключа алгоритма выработки имитовставки HMAC на основе функции Стрибог256. */
@@ -939,6 +1098,9 @@ extern "C" {
  dll_export int ak_hmac_clean( ak_hmac );
 /*! \brief Обновление текущего состояния контекста алгоритма выработки имитовставки HMAC. */
  dll_export int ak_hmac_update( ak_hmac , const ak_pointer , const size_t );
+/*! \brief Обновление текущего состояния контекста алгоритма выработки имитовставки HMAC
+    последовательностью фрагментов данных. */
+ dll_export int ak_hmac_updatev( ak_hmac , const struct iovector * , const size_t );
 /*! \brief Завершение алгоритма выработки имитовставки HMAC. */
  dll_export int ak_hmac_finalize( ak_hmac , const ak_pointer , const size_t ,
                                                                        ak_pointer , const size_t );
@@ -950,6 +1112,27 @@ extern "C" {
 /*! \brief Развертка ключевого вектора из пароля (согласно Р 50.1.111-2016, раздел 4) */
  dll_export int ak_hmac_pbkdf2_streebog512( const ak_pointer , const size_t ,
                    const ak_pointer , const size_t, const size_t , const size_t , ak_pointer );
+/*! \brief Одновременная развертка ключевых векторов из нескольких паролей
+    (согласно Р 50.1.111-2016, раздел 4). */
+ dll_export int ak_hmac_pbkdf2_streebog512_batch( const size_t , const ak_pointer * ,
+                    const size_t * , const ak_pointer * , const size_t * , const size_t ,
+                                                                 const size_t , ak_pointer * );
+/*! \brief Максимальное количество полос алгоритма mhkdf. */
+ #define ak_mhkdf_max_lanes                 (16)
+/*! \brief Минимальный объем памяти одной полосы алгоритма mhkdf (в килобайтах). */
+ #define ak_mhkdf_min_lane_memory           (8)
+/*! \brief Выработка ключевого вектора из пароля с использованием заданного объема памяти
+    и нескольких потоков. */
+ dll_export int ak_hmac_mhkdf_streebog512( const ak_pointer , const size_t , const ak_pointer ,
+        const size_t , const size_t , const size_t , const size_t , const size_t , ak_pointer );
+
+/* ----------------------------------------------------------------------------------------------- */
+/*! \brief Размер сохраненного состояния контекста алгоритма HMAC (в октетах). */
+ #define ak_hmac_state_size                 (296)
+/*! \brief Сохранение маскированного промежуточного состояния контекста алгоритма HMAC. */
+ dll_export int ak_hmac_export_state( ak_hmac , ak_pointer , const size_t );
+/*! \brief Восстановление маскированного промежуточного состояния контекста алгоритма HMAC. */
+ dll_export int ak_hmac_import_state( ak_hmac , const ak_pointer , const size_t );
 /** @} */
 
 /* ----------------------------------------------------------------------------------------------- */
@@ -1243,6 +1426,14 @@ extern "C" {
  dll_export void ak_gf256_mul_uint64( ak_pointer z, ak_pointer x, ak_pointer y );
 /*! \brief Умножение двух элементов поля \f$ \mathbb F_{2^{512}}\f$. */
  dll_export void ak_gf512_mul_uint64( ak_pointer z, ak_pointer x, ak_pointer y );
+/*! \brief Умножение двух элементов поля \f$ \mathbb F_{2^{64}}\f$ с накоплением суммы. */
+ dll_export void ak_gf64_mul_acc_uint64( ak_pointer r, ak_pointer x, ak_pointer y );
+/*! \brief Умножение двух элементов поля \f$ \mathbb F_{2^{128}}\f$ с накоплением суммы. */
+ dll_export void ak_gf128_mul_acc_uint64( ak_pointer r, ak_pointer x, ak_pointer y );
+/*! \brief Приведение накопленной суммы произведений в поле \f$ \mathbb F_{2^{64}}\f$. */
+ dll_export void ak_gf64_reduce( ak_pointer z, ak_pointer r );
+/*! \brief Приведение накопленной суммы произведений в поле \f$ \mathbb F_{2^{128}}\f$. */
+ dll_export void ak_gf128_reduce( ak_pointer z, ak_pointer r );
 
 #ifdef AK_HAVE_BUILTIN_CLMULEPI64
 /*! \brief Умножение двух элементов поля \f$ \mathbb F_{2^{64}}\f$. */
@@ -1253,17 +1444,25 @@ extern "C" {
  dll_export void ak_gf256_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b );
 /*! \brief Умножение двух элементов поля \f$ \mathbb F_{2^{512}}\f$. */
  dll_export void ak_gf512_mul_pcmulqdq( ak_pointer z, ak_pointer a, ak_pointer b );
+/*! \brief Умножение двух элементов поля \f$ \mathbb F_{2^{64}}\f$ с накоплением суммы. */
+ dll_export void ak_gf64_mul_acc_pcmulqdq( ak_pointer r, ak_pointer x, ak_pointer y );
+/*! \brief Умножение двух элементов поля \f$ \mathbb F_{2^{128}}\f$ с накоплением суммы. */
+ dll_export void ak_gf128_mul_acc_pcmulqdq( ak_pointer r, ak_pointer a, ak_pointer b );
 
  #define ak_gf64_mul ak_gf64_mul_pcmulqdq
  #define ak_gf128_mul ak_gf128_mul_pcmulqdq
  #define ak_gf256_mul ak_gf256_mul_pcmulqdq
  #define ak_gf512_mul ak_gf512_mul_pcmulqdq
+ #define ak_gf64_mul_acc ak_gf64_mul_acc_pcmulqdq
+ #define ak_gf128_mul_acc ak_gf128_mul_acc_pcmulqdq
 #else
 
  #define ak_gf64_mul ak_gf64_mul_uint64
  #define ak_gf128_mul ak_gf128_mul_uint64
  #define ak_gf256_mul ak_gf256_mul_uint64
  #define ak_gf512_mul ak_gf512_mul_uint64
+ #define ak_gf64_mul_acc ak_gf64_mul_acc_uint64
+ #define ak_gf128_mul_acc ak_gf128_mul_acc_uint64
 #endif
 
 /* Размеры конечных полей (в октетах) */
@@ -1831,6 +2030,9 @@ extern "C" {
 /*! \brief Выработка электронной подписи для заданного файла. */
  dll_export int ak_signkey_sign_file( ak_signkey , ak_random ,
                                                               const char * , ak_pointer , size_t );
+/*! \brief Выработка электронной подписи для заданного файла с использованием собственного
+    генератора ключа (функция совместима с ak_file_async()). */
+ dll_export int ak_signkey_sign_file_async( ak_pointer , const char * , ak_pointer , const size_t );
 /*! \brief Проверка электронной подписи для вычисленного заранее значения хеш-функции. */
  dll_export bool_t ak_verifykey_verify_hash( ak_verifykey , const ak_pointer ,
                                                                        const size_t , ak_pointer );